@@ -32,7 +32,7 @@ extern "C" {
  */
 #define BLE_ADV_DEF(instance)                                                                      \
 	static struct ble_adv instance;                                                            \
-	NRF_SDH_BLE_OBSERVER(ble_adv_##instance, ble_adv_on_ble_evt, &instance, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(ble_adv_##instance, ble_adv_on_ble_evt, &instance, HIGH, GAP)
 
 /**
  * @brief Advertising modes.
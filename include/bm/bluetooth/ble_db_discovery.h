@@ -26,9 +26,38 @@
  * @param _name Name of the instance.
  */
 #define BLE_DB_DISCOVERY_DEF(_name)                                                                \
-	static struct ble_db_discovery _name = {.discovery_in_progress = 0,                        \
-						.conn_handle = BLE_CONN_HANDLE_INVALID};           \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_db_discovery_on_ble_evt, &_name, HIGH)
+	static struct ble_db_discovery _name;                                                      \
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_db_discovery_on_ble_evt, &_name, HIGH, GAP, GATTC)
+
+/**
+ * @brief Length of the Database Hash characteristic value.
+ */
+#define BLE_DB_DISCOVERY_DB_HASH_LEN 16
+
+/**
+ * @brief Number of service records a link takes from the pool when
+ *        @c CONFIG_BLE_DB_DISCOVERY_MAX_SRV services are registered.
+ *
+ * With @c CONFIG_BLE_DB_DISCOVERY_CACHE, one more record holds the Database Hash of the peer.
+ */
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+#define BLE_DB_DISCOVERY_LINK_SRV_RECS (CONFIG_BLE_DB_DISCOVERY_MAX_SRV + 1)
+#else
+#define BLE_DB_DISCOVERY_LINK_SRV_RECS (CONFIG_BLE_DB_DISCOVERY_MAX_SRV)
+#endif
+
+/**
+ * @brief Number of service records in the pool of an instance.
+ *
+ * If @c CONFIG_BLE_DB_DISCOVERY_SRV_POOL_SIZE is 0, the pool holds the records of
+ * @c CONFIG_BLE_DB_DISCOVERY_LINK_COUNT links.
+ */
+#if CONFIG_BLE_DB_DISCOVERY_SRV_POOL_SIZE > 0
+#define BLE_DB_DISCOVERY_SRV_POOL_SIZE (CONFIG_BLE_DB_DISCOVERY_SRV_POOL_SIZE)
+#else
+#define BLE_DB_DISCOVERY_SRV_POOL_SIZE                                                             \
+	(BLE_DB_DISCOVERY_LINK_SRV_RECS * CONFIG_BLE_DB_DISCOVERY_LINK_COUNT)
+#endif
 
 /**
  * @brief Bluetooth LE database discovery event type.
@@ -93,8 +122,9 @@ struct ble_db_discovery_evt {
 	};
 };
 
-/* Forward declaration. */
+/* Forward declarations. */
 struct ble_db_discovery;
+struct pm_evt;
 
 /**
  * @brief DB discovery event handler type.
@@ -117,31 +147,23 @@ struct ble_db_discovery_config {
 };
 
 /**
- * @brief Bluetooth LE database discovery.
+ * @brief Bluetooth LE database discovery state of one link.
+ *
+ * This is intended for internal use during service discovery.
  */
-struct ble_db_discovery {
+struct ble_db_discovery_link {
 	/**
-	 * @brief Information related to the current service being discovered.
-	 *
-	 * This is intended for internal use during service discovery.
+	 * @brief Connection handle of the link, or @c BLE_CONN_HANDLE_INVALID if the link is free.
 	 */
-	struct ble_gatt_db_srv services[CONFIG_BLE_DB_DISCOVERY_MAX_SRV];
-	/**
-	 * @brief UUID of registered handlers
-	 */
-	ble_uuid_t registered_uuids[CONFIG_BLE_DB_DISCOVERY_MAX_SRV];
-	/**
-	 * @brief Instance event handler.
-	 */
-	ble_db_discovery_evt_handler evt_handler;
+	uint16_t conn_handle;
 	/**
-	 * @brief Bluetooth LE GATT Queue instance.
+	 * @brief Index of the first service record of the link in the pool of the instance.
 	 */
-	const struct ble_gq *gatt_queue;
+	uint8_t srv_rec_idx;
 	/**
-	 * @brief The number of UUIDs registered with the DB Discovery library.
+	 * @brief Number of service records the link has taken from the pool of the instance.
 	 */
-	uint32_t num_registered_uuids;
+	uint8_t srv_rec_count;
 	/**
 	 * @brief Number of services at the peer's GATT database.
 	 */
@@ -166,21 +188,88 @@ struct ble_db_discovery {
 	 * @brief Variable to indicate whether there is a service discovery in progress.
 	 */
 	bool discovery_in_progress;
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
 	/**
-	 * @brief Connection handle on which the discovery is started.
+	 * @brief The services were loaded from the remote database of the peer.
 	 */
-	uint16_t conn_handle;
+	bool cache_loaded;
 	/**
-	 * @brief The index to the pending user event array, pointing to the last added pending
-	 *        user event.
+	 * @brief The Database Hash of the peer is being read.
 	 */
-	uint32_t pending_usr_evt_idx;
+	bool db_hash_pending;
 	/**
-	 * @brief Whenever a discovery related event is to be raised, it is stored in this array
-	 *        first. When all registered services have been attempted discovered, all pending
-	 *        events are sent to the user.
+	 * @brief The Database Hash of the peer was read, the services can be stored.
 	 */
-	struct ble_db_discovery_evt pending_usr_evts[CONFIG_BLE_DB_DISCOVERY_MAX_SRV];
+	bool db_hash_valid;
+#endif
+};
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+/**
+ * @brief Service records being stored in the remote database of a peer.
+ *
+ * This is intended for internal use during service discovery.
+ */
+struct ble_db_discovery_cache_store {
+	/**
+	 * @brief Peer ID of the peer whose services are being stored.
+	 */
+	uint16_t peer_id;
+	/**
+	 * @brief Index of the first service record being stored in the pool of the instance.
+	 */
+	uint8_t srv_rec_idx;
+	/**
+	 * @brief Number of service records held until the store is complete, or 0 if none.
+	 */
+	uint8_t srv_rec_count;
+};
+#endif
+
+/**
+ * @brief Bluetooth LE database discovery.
+ *
+ * One instance discovers the registered services on up to
+ * @c CONFIG_BLE_DB_DISCOVERY_LINK_COUNT links in parallel. The links share a pool of
+ * @ref BLE_DB_DISCOVERY_SRV_POOL_SIZE service records.
+ */
+struct ble_db_discovery {
+	/**
+	 * @brief Pool of service records, shared by the links being discovered.
+	 *
+	 * This is intended for internal use during service discovery.
+	 */
+	struct ble_gatt_db_srv services[BLE_DB_DISCOVERY_SRV_POOL_SIZE];
+	/**
+	 * @brief State of the links being discovered.
+	 *
+	 * This is intended for internal use during service discovery.
+	 */
+	struct ble_db_discovery_link links[CONFIG_BLE_DB_DISCOVERY_LINK_COUNT];
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	/**
+	 * @brief Service records being stored in the remote database of the peers.
+	 *
+	 * This is intended for internal use during service discovery.
+	 */
+	struct ble_db_discovery_cache_store cache_stores[CONFIG_BLE_DB_DISCOVERY_LINK_COUNT];
+#endif
+	/**
+	 * @brief UUID of registered handlers
+	 */
+	ble_uuid_t registered_uuids[CONFIG_BLE_DB_DISCOVERY_MAX_SRV];
+	/**
+	 * @brief Instance event handler.
+	 */
+	ble_db_discovery_evt_handler evt_handler;
+	/**
+	 * @brief Bluetooth LE GATT Queue instance.
+	 */
+	const struct ble_gq *gatt_queue;
+	/**
+	 * @brief The number of UUIDs registered with the DB Discovery library.
+	 */
+	uint32_t num_registered_uuids;
 };
 
 /**
@@ -199,6 +288,20 @@ uint32_t ble_db_discovery_init(struct ble_db_discovery *db_discovery,
 /**
  * @brief Start the discovery of the GATT database at the server.
  *
+ * @details The discovery of each link runs independently of the discoveries on other links. When
+ *          it starts, the link takes one service record for each registered service from the
+ *          pool of the instance, and it returns them once the
+ *          @ref BLE_DB_DISCOVERY_AVAILABLE event is sent.
+ *
+ *          If @c CONFIG_BLE_DB_DISCOVERY_CACHE is enabled and the peer is bonded, the Database
+ *          Hash of the peer is read first. If it matches the Database Hash stored with the
+ *          services in the remote database of the peer, the services are restored from there
+ *          instead of being discovered. Otherwise, the services are discovered, and stored in
+ *          the remote database of the peer when the discovery is complete. The discovery of a
+ *          bonded peer takes one more service record, to hold the Database Hash. When the
+ *          services are stored, the records are written from there, and are kept until
+ *          @ref ble_db_discovery_on_pm_evt is called with the event that completes the store.
+ *
  * @param[in,out] db_discovery DB Discovery instance.
  * @param[in] conn_handle The handle of the connection for which the discovery should be started.
  *
@@ -207,9 +310,13 @@ uint32_t ble_db_discovery_init(struct ble_db_discovery *db_discovery,
  * @retval NRF_ERROR_INVALID_STATE If this function is called without calling the
  *                                 @ref ble_db_discovery_init, or without calling the
  *                                 @ref ble_db_discovery_service_register.
- * @retval NRF_ERROR_BUSY If a discovery is already in progress using @p db_discovery.
- *                        Use a different database discovery instance,
- *                        or wait for a DB Discovery event before retrying.
+ * @retval NRF_ERROR_BUSY If a discovery is already in progress on @p conn_handle, or if
+ *                        @c CONFIG_BLE_DB_DISCOVERY_LINK_COUNT other links are being
+ *                        discovered. Wait for a @ref BLE_DB_DISCOVERY_AVAILABLE event before
+ *                        retrying.
+ * @retval NRF_ERROR_NO_MEM If there are not enough free service records in the pool. Wait for a
+ *                          @ref BLE_DB_DISCOVERY_AVAILABLE event, or for the services of
+ *                          another link to be stored, before retrying.
  * @return In addition, this function may return any error
  *         returned by the following functions:
  *         - @ref ble_gq_conn_handle_register
@@ -255,6 +362,24 @@ uint32_t ble_db_discovery_service_register(struct ble_db_discovery *db_discovery
  */
 void ble_db_discovery_on_ble_evt(const ble_evt_t *ble_evt, void *ble_db_discovery);
 
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+/**
+ * @brief Peer Manager event handler for the Database Discovery library.
+ *
+ * @details Returns the service records that were stored in the remote database of a peer to
+ *          the pool, once the Peer Manager reports that the store has succeeded or failed.
+ *
+ * @note The application must call this function from its Peer Manager event handler when
+ *       @c CONFIG_BLE_DB_DISCOVERY_CACHE is enabled. Otherwise, the service records of each
+ *       store are never returned to the pool.
+ *
+ * @param[in,out] db_discovery DB Discovery instance.
+ * @param[in] pm_evt Peer Manager event.
+ */
+void ble_db_discovery_on_pm_evt(struct ble_db_discovery *db_discovery,
+				const struct pm_evt *pm_evt);
+#endif
+
 #endif /* BLE_DB_DISCOVERY_H__ */
 
 /** @} */
@@ -48,7 +48,8 @@ extern "C" {
  * @param _name            Name of the instance.
  * @param _max_conns       Maximum number of connection handles that can be registered.
  * @param _heap_size       Size of heap used for storing additional data for
- *                         write, notify and indicate operations.
+ *                         write, notify and indicate operations, when the data is longer than
+ *                         @c CONFIG_BLE_GQ_INLINE_DATA_SIZE.
  * @param _max_req_blocks  Maximum number of requests that can be held at any point in time.
  */
 #define BLE_GQ_CUSTOM_DEF(_name, _max_conns, _heap_size, _max_req_blocks)                          \
@@ -64,7 +65,8 @@ extern "C" {
 		LISTIFY(_max_conns, BLE_GQ_REQ_QUEUE_INIT, (,), _name),                            \
 	};                                                                                         \
 	BUILD_ASSERT(ARRAY_SIZE(CONCAT(_name, _req_queues)) == (_max_conns));                      \
-	K_MEM_SLAB_DEFINE_STATIC(_name##_req_blocks, sizeof(struct ble_gq_req), (_max_req_blocks), \
+	static struct ble_gq_conn_tx CONCAT(_name, _conn_tx)[(_max_conns)];                        \
+	K_MEM_SLAB_DEFINE_STATIC(_name##_req_blocks, BLE_GQ_REQ_BLOCK_SIZE, (_max_req_blocks),     \
 				 sizeof(void *));                                                  \
 	static K_HEAP_DEFINE(_name##_heap, (_heap_size));                                          \
 	static const struct ble_gq _name = {                                                       \
@@ -72,10 +74,22 @@ extern "C" {
 		.conn_handles = CONCAT(_name, _conn_handles_arr),                                  \
 		.purge_list = CONCAT(_name, _purge_arr),                                           \
 		.req_queue = (sys_slist_t *)&CONCAT(_name, _req_queues),                           \
+		.conn_tx = CONCAT(_name, _conn_tx),                                                \
 		.req_blocks = &CONCAT(_name, _req_blocks),                                         \
 		.data_pool = &CONCAT(_name, _heap),                                                \
 	};                                                                                         \
-	NRF_SDH_BLE_OBSERVER(CONCAT(_name, _obs), ble_gq_on_ble_evt, (void *)&_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(CONCAT(_name, _obs), ble_gq_on_ble_evt, (void *)&_name, HIGH,     \
+				 GAP, GATTC, GATTS)
+
+/**
+ * @brief Size of a request block. Used in @ref BLE_GQ_CUSTOM_DEF.
+ *
+ * A request block holds a request, followed by up to @c CONFIG_BLE_GQ_INLINE_DATA_SIZE bytes of
+ * its data and the length of a notification or indication.
+ */
+#define BLE_GQ_REQ_BLOCK_SIZE                                                                      \
+	ROUND_UP(sizeof(struct ble_gq_req) + sizeof(uint16_t) + CONFIG_BLE_GQ_INLINE_DATA_SIZE,   \
+		 sizeof(void *))
 
 /**
  * @brief Helper macro for initializing connection handle array. Used in @ref BLE_GQ_CUSTOM_DEF.
@@ -100,6 +114,11 @@ enum ble_gq_req_type {
 	 * @brief GATTC Read Request. See @ref sd_ble_gattc_read.
 	 */
 	BLE_GQ_REQ_GATTC_READ,
+	/**
+	 * @brief GATTC Read Using Characteristic UUID Request.
+	 *        See @ref sd_ble_gattc_char_value_by_uuid_read.
+	 */
+	BLE_GQ_REQ_GATTC_READ_BY_UUID,
 	/**
 	 * @brief GATTC Write Request. See @ref sd_ble_gattc_write.
 	 */
@@ -178,7 +197,8 @@ struct ble_gq_req {
 	/**
 	 * @brief Extra payload data that cannot be contained in the request queue.
 	 *
-	 * Used internally by the GATT queue to manage additional memory allocations.
+	 * Used internally by the GATT queue to manage additional memory, in the request block or
+	 * allocated from the data pool.
 	 */
 	uint8_t *data;
 	/**
@@ -201,6 +221,14 @@ struct ble_gq_req {
 			uint16_t handle;
 			uint16_t offset;
 		} gattc_read;
+		/**
+		 * @brief GATTC read using characteristic UUID parameters.
+		 *        Type @ref BLE_GQ_REQ_GATTC_READ_BY_UUID.
+		 */
+		struct {
+			ble_uuid_t uuid;
+			ble_gattc_handle_range_t handle_range;
+		} gattc_read_by_uuid;
 		/**
 		 * @brief GATTC write parameters.
 		 *        Type @ref BLE_GQ_REQ_GATTC_WRITE.
@@ -232,6 +260,44 @@ struct ble_gq_req {
 	};
 };
 
+/**
+ * @brief TX credits of a SoftDevice TX queue of a connection.
+ *
+ * Notifications and write commands are put in TX queues of the SoftDevice, which accept packets
+ * until they are full. The number of packets a TX queue holds is learned when the SoftDevice
+ * first returns @c NRF_ERROR_RESOURCES on the connection. Every
+ * @c CONFIG_BLE_GQ_TX_PROBE_INTERVAL TX complete events, one more packet is submitted to find
+ * out whether the TX queue holds more packets than learned.
+ */
+struct ble_gq_tx_credits {
+	/**
+	 * @brief Number of packets in the TX queue, not yet transmitted.
+	 */
+	uint8_t queued;
+	/**
+	 * @brief Number of packets the TX queue holds, or 0 if not known yet.
+	 */
+	uint8_t size;
+	/**
+	 * @brief Number of TX complete events before one more packet than @ref size is submitted.
+	 */
+	uint8_t probe_countdown;
+};
+
+/**
+ * @brief TX credits of a connection.
+ */
+struct ble_gq_conn_tx {
+	/**
+	 * @brief Credits of the notification TX queue.
+	 */
+	struct ble_gq_tx_credits hvn;
+	/**
+	 * @brief Credits of the write command TX queue.
+	 */
+	struct ble_gq_tx_credits write_cmd;
+};
+
 /**
  * @brief Bluetooth LE GATT Queue.
  */
@@ -252,6 +318,10 @@ struct ble_gq {
 	 * @brief Pointer to array of lists used to hold pending requests.
 	 */
 	sys_slist_t *const req_queue;
+	/**
+	 * @brief Pointer to array of TX credits, one for each connection.
+	 */
+	struct ble_gq_conn_tx *const conn_tx;
 	/**
 	 * @brief Pointer to memory slabs used to hold GATT requests.
 	 */
@@ -268,7 +338,9 @@ struct ble_gq {
  * @details This function adds a request to the BGQ instance and allocates necessary memory
  *          for data that can be held within the request descriptor. If the SoftDevice is free,
  *          this request will be processed immediately. Otherwise, the request remains in the
- *          queue and is processed later.
+ *          queue and is processed later. Queued requests are submitted in order, as many at a
+ *          time as the SoftDevice accepts, so that notifications and write commands can fill
+ *          the connection events.
  *
  * @param[in] gatt_queue   Pointer to the @ref ble_gq instance.
  * @param[in] req          Pointer to the request.
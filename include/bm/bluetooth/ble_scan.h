@@ -42,7 +42,7 @@ extern "C" {
  */
 #define BLE_SCAN_DEF(_name)                                                                        \
 	static struct ble_scan _name;                                                              \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_scan_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_scan_on_ble_evt, &_name, HIGH, GAP)
 
 /**
  * @brief Scan events.
@@ -26,6 +26,21 @@ extern "C" {
 /** @brief Peer OOB Data handler prototype. */
 typedef ble_gap_lesc_oob_data_t *(*nrf_ble_lesc_peer_oob_data_handler)(uint16_t conn_handle);
 
+/** @brief Result of responding to a DH key request. */
+struct nrf_ble_lesc_dhkey_result {
+	/** @brief Connection handle of the peer that requested the DH key. */
+	uint16_t conn_handle;
+	/** @brief Result of the reply, as returned by @ref nrf_ble_lesc_request_handler. */
+	uint32_t nrf_err;
+	/** @brief Time from the DH key request event until the reply, in microseconds. */
+	uint32_t latency_us;
+	/** @brief Time spent computing the DH key and replying, in microseconds. */
+	uint32_t compute_us;
+};
+
+/** @brief DH key handler prototype, called after responding to a DH key request. */
+typedef void (*nrf_ble_lesc_dhkey_handler)(const struct nrf_ble_lesc_dhkey_result *result);
+
 /**
  * @brief Initialize the LESC module.
  *
@@ -45,6 +60,9 @@ uint32_t nrf_ble_lesc_init(void);
  *          Keys are generated using ECC and are used to create LESC DH key during authentication
  *          procedures.
  *
+ *          If @c CONFIG_PM_LESC_KEY_POOL is enabled, a key pair generated in advance is used if
+ *          available, and the next key pair is generated from the scheduler.
+ *
  * @retval NRF_SUCCESS         If the operation was successful.
  * @retval NRF_ERROR_BUSY      If any pending request needs to be processed by @ref
  *                             nrf_ble_lesc_request_handler.
@@ -95,6 +113,16 @@ ble_gap_lesc_oob_data_t *nrf_ble_lesc_own_oob_data_get(void);
  */
 void nrf_ble_lesc_peer_oob_data_handler_set(nrf_ble_lesc_peer_oob_data_handler handler);
 
+/**
+ * @brief Set the handler called after responding to each DH key request.
+ *
+ * @details The handler receives the result of the reply and how long the reply took, which can be
+ *          used to measure the time LESC pairing spends computing DH keys.
+ *
+ * @param[in] handler  Function called after each DH key reply, or NULL to remove the handler.
+ */
+void nrf_ble_lesc_dhkey_handler_set(nrf_ble_lesc_dhkey_handler handler);
+
 /**
  * @brief Respond to DH key requests.
  *
@@ -102,7 +130,9 @@ void nrf_ble_lesc_peer_oob_data_handler_set(nrf_ble_lesc_peer_oob_data_handler h
  *          pending requests for keys.
  *
  * @note This function should be called systematically (e.g. in the main application loop) to handle
- *       any pending DH key requests.
+ *       any pending DH key requests. If @c CONFIG_PM_LESC_DHKEY_DEFERRED is enabled, each DH key
+ *       is computed in its own scheduler event instead, and this function only handles the
+ *       requests that could not be scheduled. It must still be called to detect internal errors.
  *
  * @retval NRF_SUCCESS         If the operation was successful.
  * @retval NRF_ERROR_INTERNAL  If the LESC module encountered an internal error. The only way to
@@ -420,6 +420,9 @@ uint32_t pm_privacy_get(ble_gap_privacy_params_t *privacy_params);
 /**
  * @brief Resolve a resolvable address with an identity resolution key (IRK).
  *
+ * @note To find out which bonded peer, if any, uses an address, use @ref pm_peer_id_get_by_addr
+ *       instead of calling this function for the IRK of each bonded peer.
+ *
  * @param[in] addr  A private random resolvable address.
  * @param[in] irk   An identity resolution key (IRK).
  *
@@ -456,6 +459,27 @@ uint32_t pm_conn_handle_get(uint16_t peer_id, uint16_t *conn_handle);
  */
 uint32_t pm_peer_id_get(uint16_t conn_handle, uint16_t *peer_id);
 
+/**
+ * @brief Retrieve the ID of a bonded peer, given an address used by the peer.
+ *
+ * @details Public and static random addresses are matched against the identity addresses of the
+ *          bonded peers. Resolvable private addresses are resolved against the IRKs of all bonded
+ *          peers, which makes this function suitable for identifying bonded peers in advertising
+ *          reports. Non-resolvable private addresses never match a bonded peer.
+ *
+ *          When @c CONFIG_PM_BOND_INDEX is enabled, the IRKs are read from RAM, and the
+ *          @c CONFIG_PM_RPA_CACHE_SIZE most recently resolved addresses are remembered, so that
+ *          they are resolved without any encryption.
+ *
+ * @param[in]  addr     The address of the peer.
+ * @param[out] peer_id  The peer ID, or @ref PM_PEER_ID_INVALID if no bonded peer uses @p addr.
+ *
+ * @retval NRF_SUCCESS              If the peer ID was retrieved successfully.
+ * @retval NRF_ERROR_NULL           If @p addr or @p peer_id was NULL.
+ * @retval NRF_ERROR_INVALID_STATE  If the Peer Manager is not initialized.
+ */
+uint32_t pm_peer_id_get_by_addr(const ble_gap_addr_t *addr, uint16_t *peer_id);
+
 /**
  * @brief Retrieve a filtered list of peer IDs.
  *
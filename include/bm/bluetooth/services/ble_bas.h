@@ -29,7 +29,7 @@ extern "C" {
  */
 #define BLE_BAS_DEF(_name)                                                                         \
 	static struct ble_bas _name;                                                               \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_bas_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_bas_on_ble_evt, &_name, HIGH, GATTS)
 
 /** @brief Default security configuration. */
 #define BLE_BAS_CONFIG_SEC_MODE_DEFAULT                                                            \
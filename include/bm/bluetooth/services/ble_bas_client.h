@@ -31,7 +31,7 @@ extern "C" {
  */
 #define BLE_BAS_CLIENT_DEF(_name)                                                                  \
 	static struct ble_bas_client _name;                                                        \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_bas_client_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_bas_client_on_ble_evt, &_name, HIGH, GAP, GATTC)
 
 /**
  * @brief Battery Service Client event type.
@@ -41,7 +41,7 @@ extern "C" {
  */
 #define BLE_BMS_DEF(_name)                                                                         \
 	static struct ble_bms _name;                                                               \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_bms_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_bms_on_ble_evt, &_name, HIGH, GATTS)
 
 /** @brief Default security configuration. */
 #define BLE_BMS_CONFIG_SEC_MODE_DEFAULT                                                            \
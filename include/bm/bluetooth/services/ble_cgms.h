@@ -42,7 +42,7 @@ extern "C" {
  */
 #define BLE_CGMS_DEF(_name)                                                                        \
 	static struct ble_cgms _name;                                                              \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_cgms_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_cgms_on_ble_evt, &_name, HIGH, GAP, GATTS)
 
 /** @brief Default security configuration. */
 #define BLE_CGMS_CONFIG_SEC_MODE_DEFAULT                                                           \
@@ -39,7 +39,7 @@ extern "C" {
 			.link_ctx_size = sizeof(uint32_t) * BYTES_TO_WORDS(BLE_HIDS_LINK_CTX_SIZE),\
 		},                                                                                 \
 	};                                                                                         \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_hids_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_hids_on_ble_evt, &_name, HIGH, GAP, GATTS)
 
 /** @brief Default mouse security configuration. */
 #define BLE_HIDS_CONFIG_SEC_MODE_DEFAULT_MOUSE                                                     \
@@ -29,7 +29,7 @@ extern "C" {
  */
 #define BLE_HRS_DEF(_name)                                                                         \
 	static struct ble_hrs _name;                                                               \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_hrs_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_hrs_on_ble_evt, &_name, HIGH, GAP, GATTS)
 
 /** @brief Default security configuration. */
 #define BLE_HRS_CONFIG_SEC_MODE_DEFAULT                                                            \
@@ -193,6 +193,13 @@ struct ble_hrs {
 	 * @brief Whether sensor contact has been detected.
 	 */
 	bool is_sensor_contact_detected;
+	/**
+	 * @brief Cached state of the heart rate measurement CCCD.
+	 *
+	 * Read from the SoftDevice when the first measurement of a connection is sent,
+	 * and then tracked from the writes of the peer.
+	 */
+	uint8_t hrm_cccd;
 };
 
 /**
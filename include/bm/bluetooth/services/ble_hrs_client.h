@@ -44,7 +44,7 @@ extern "C" {
  */
 #define BLE_HRS_CLIENT_DEF(_name)                                                                  \
 	static struct ble_hrs_client _name;                                                        \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_hrs_client_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_hrs_client_on_ble_evt, &_name, HIGH, GAP, GATTC)
 
 /**
  * @brief HRS Client event type.
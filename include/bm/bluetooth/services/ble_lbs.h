@@ -37,7 +37,7 @@ struct ble_lbs;
  */
 #define BLE_LBS_DEF(_name)                                                                         \
 	static struct ble_lbs _name;                                                               \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_lbs_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_lbs_on_ble_evt, &_name, HIGH, GATTS)
 
 /** @brief Default security configuration. */
 #define BLE_LBS_CONFIG_SEC_MODE_DEFAULT                                                            \
@@ -19,6 +19,10 @@
 #include <ble.h>
 #include <bm/bluetooth/ble_common.h>
 #include <bm/softdevice_handler/nrf_sdh_ble.h>
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/ring_buffer.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,7 +47,7 @@ extern "C" {
  */
 #define BLE_NUS_DEF(_name)                                                                         \
 	static struct ble_nus _name;                                                               \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_nus_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_nus_on_ble_evt, &_name, HIGH, GAP, GATTS)
 
 /** @brief Default security configuration. */
 #define BLE_NUS_CONFIG_SEC_MODE_DEFAULT                                                            \
@@ -154,6 +158,22 @@ struct ble_nus_config {
 	} sec_mode;
 };
 
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+/** @brief Nordic UART Service TX stream of a link. */
+struct ble_nus_tx_stream {
+	/** Data written with @ref ble_nus_write and not yet notified. */
+	struct ring_buf rb;
+	/** Ring buffer storage. */
+	uint8_t buf[CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE];
+	/** Connection handle of the link, or @c BLE_CONN_HANDLE_INVALID if it is not connected. */
+	uint16_t conn_handle;
+	/** Number of notifications queued in the SoftDevice. */
+	uint8_t hvn_queued;
+	/** Stream state flags. */
+	atomic_t flags;
+};
+#endif
+
 /**
  * @brief Nordic UART Service structure.
  *
@@ -170,6 +190,12 @@ struct ble_nus {
 	ble_gatts_char_handles_t rx_handles;
 	/** Event handler to be called for handling received data. */
 	ble_nus_evt_handler_t evt_handler;
+	/** Cached TX characteristic CCCD state of each link, indexed by @ref nrf_sdh_ble_idx_get. */
+	uint8_t tx_cccd[CONFIG_NRF_SDH_BLE_TOTAL_LINK_COUNT];
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+	/** TX stream of each link, indexed by @ref nrf_sdh_ble_idx_get. */
+	struct ble_nus_tx_stream tx_stream[CONFIG_NRF_SDH_BLE_TOTAL_LINK_COUNT];
+#endif
 };
 
 /**
@@ -227,6 +253,52 @@ void ble_nus_on_ble_evt(const ble_evt_t *ble_evt, void *ble_nus);
 uint32_t ble_nus_data_send(struct ble_nus *nus, uint8_t *data, uint16_t *length,
 			   uint16_t conn_handle);
 
+/**
+ * @brief Write data to the NUS TX stream of a link.
+ *
+ * @details The data is copied to the TX buffer of the link and sent in notifications of up to
+ *          ATT MTU - 3 bytes as the SoftDevice accepts them. While notifications are queued in
+ *          the SoftDevice, shorter notifications are held back until at least
+ *          @c CONFIG_BLE_NUS_TX_STREAM_THRESHOLD bytes are buffered, so that data written in
+ *          small pieces is packed into fewer notifications. When the SoftDevice queue is empty,
+ *          buffered data is sent right away. Use @ref ble_nus_flush to send all buffered data
+ *          without waiting.
+ *
+ *          Data is buffered also when the peer has not enabled notifications, or when the system
+ *          attributes of the link are not set yet, and is sent once the peer enables
+ *          notifications. Buffered data is discarded on disconnection.
+ *
+ *          The @ref BLE_NUS_EVT_TX_RDY event signals that buffered data has been sent.
+ *
+ * @param[in] nus Pointer to the Nordic UART Service structure.
+ * @param[in] data Data to be written.
+ * @param[in,out] length In: Length of the @p data. Out: Number of bytes written to the buffer.
+ * @param[in] conn_handle Connection handle of the destination client.
+ *
+ * @retval NRF_SUCCESS If some or all of the data was written to the buffer.
+ * @retval NRF_ERROR_NULL If @p nus, @p data, or @p length are @c NULL.
+ * @retval NRF_ERROR_INVALID_PARAM If @p conn_handle is not a connected link.
+ * @retval NRF_ERROR_RESOURCES If the TX buffer of the link is full.
+ */
+uint32_t ble_nus_write(struct ble_nus *nus, const uint8_t *data, uint16_t *length,
+		       uint16_t conn_handle);
+
+/**
+ * @brief Send all data buffered in the NUS TX stream of a link.
+ *
+ * @details Sends the buffered data without waiting for
+ *          @c CONFIG_BLE_NUS_TX_STREAM_THRESHOLD bytes to accumulate. The data that does not fit
+ *          in the SoftDevice queue is sent as it frees up.
+ *
+ * @param[in] nus Pointer to the Nordic UART Service structure.
+ * @param[in] conn_handle Connection handle of the destination client.
+ *
+ * @retval NRF_SUCCESS On success.
+ * @retval NRF_ERROR_NULL If @p nus is @c NULL.
+ * @retval NRF_ERROR_INVALID_PARAM If @p conn_handle is not a connected link.
+ */
+uint32_t ble_nus_flush(struct ble_nus *nus, uint16_t conn_handle);
+
 #ifdef __cplusplus
 }
 #endif
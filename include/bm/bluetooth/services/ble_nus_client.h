@@ -32,7 +32,7 @@ extern "C" {
  */
 #define BLE_NUS_CLIENT_DEF(_name)                                                                  \
 	static struct ble_nus_client _name;                                                        \
-	NRF_SDH_BLE_OBSERVER(_name##_obs, ble_nus_client_on_ble_evt, &_name, HIGH)
+	NRF_SDH_BLE_EVT_OBSERVER(_name##_obs, ble_nus_client_on_ble_evt, &_name, HIGH, GAP, GATTC)
 
 /** Vendor-specific UUID base for the Nordic UART Service. */
 #define BLE_NUS_UUID_BASE { 0x9E, 0xCA, 0xDC, 0x24, 0x0E, 0xE5, 0xA9, 0xE0,                        \
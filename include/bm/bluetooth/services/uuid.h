@@ -70,6 +70,8 @@ extern "C" {
 #define BLE_UUID_REMOVABLE_CHAR 0x2A3A
 /** Service Required characteristic UUID. */
 #define BLE_UUID_SERVICE_REQUIRED_CHAR 0x2A3B
+/** Database Hash characteristic UUID. */
+#define BLE_UUID_DATABASE_HASH_CHAR 0x2B2A
 /** Alert Category Id characteristic UUID. */
 #define BLE_UUID_ALERT_CATEGORY_ID_CHAR 0x2A43
 /** Alert Category Id Bit Mask characteristic UUID. */
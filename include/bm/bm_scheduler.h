@@ -14,12 +14,32 @@
 #define BM_SCHEDULER_H__
 
 #include <stdint.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/slist.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Highest event priority.
+ */
+#define BM_SCHEDULER_PRIO_HIGHEST 0
+
+/**
+ * @brief Lowest event priority.
+ */
+#if defined(CONFIG_BM_SCHEDULER_PRIO_LEVELS)
+#define BM_SCHEDULER_PRIO_LOWEST (CONFIG_BM_SCHEDULER_PRIO_LEVELS - 1)
+#else
+#define BM_SCHEDULER_PRIO_LOWEST 0
+#endif
+
+/**
+ * @brief Number of buckets in the event handler execution time histogram.
+ */
+#define BM_SCHEDULER_STATS_HIST_BUCKETS 8
+
 /**
  * @brief Event handler prototype.
  */
@@ -43,16 +63,69 @@ struct bm_scheduler_event {
 	 * @brief Event length.
 	 */
 	size_t len;
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+	/**
+	 * @brief Reserved.
+	 */
+	uint32_t timestamp;
+#endif
 	/**
 	 * @brief Event data.
 	 */
 	uint8_t data[];
 };
 
+/**
+ * @brief A coalescing event.
+ *
+ * A coalescing event is pending at most once. Deferring it while it is already pending
+ * does not schedule another event, and the handler is dispatched only once.
+ * This is useful for handlers that process all the work available when dispatched,
+ * such as polling a peripheral for events.
+ *
+ * Use @ref BM_SCHEDULER_COALESCE_DEFINE to define a coalescing event.
+ */
+struct bm_scheduler_coalesce {
+	/**
+	 * @brief Event handler. Called with no event data.
+	 */
+	bm_scheduler_fn_t handler;
+	/**
+	 * @brief Event priority.
+	 */
+	uint8_t prio;
+	/**
+	 * @brief Reserved.
+	 */
+	atomic_t pending;
+	/**
+	 * @brief Number of times the event was deferred while already pending.
+	 */
+	atomic_t coalesced;
+	/**
+	 * @brief Number of times the event handler has been dispatched.
+	 */
+	atomic_t dispatched;
+};
+
+/**
+ * @brief Define a coalescing event.
+ *
+ * @param _name Name of the coalescing event.
+ * @param _handler Event handler.
+ * @param _prio Event priority.
+ */
+#define BM_SCHEDULER_COALESCE_DEFINE(_name, _handler, _prio)                                       \
+	struct bm_scheduler_coalesce _name = {                                                     \
+		.handler = _handler,                                                               \
+		.prio = _prio,                                                                     \
+	}
+
 /**
  * @brief Schedule an event for execution in the main thread.
  *
  * This function can be called from an ISR to defer code execution to the main thread.
+ * The event is scheduled with the lowest priority, @ref BM_SCHEDULER_PRIO_LOWEST.
  *
  * @param handler Event handler.
  * @param data Event data.
@@ -66,14 +139,171 @@ struct bm_scheduler_event {
 int bm_scheduler_defer(bm_scheduler_fn_t handler, void *data, size_t len);
 
 /**
- * @brief Process deferred events.
+ * @brief Schedule an event with a given priority for execution in the main thread.
  *
- * Process deferred events in the main thread.
+ * This function can be called from an ISR to defer code execution to the main thread.
+ * Events with a higher priority are dispatched before events with a lower priority.
+ * Events with the same priority are dispatched in the order they were scheduled.
+ *
+ * @param handler Event handler.
+ * @param data Event data.
+ * @param len Event data length.
+ * @param prio Event priority, from @ref BM_SCHEDULER_PRIO_HIGHEST
+ *             to @ref BM_SCHEDULER_PRIO_LOWEST.
  *
  * @retval 0 On success.
+ * @retval -EFAULT @p handler is @c NULL.
+ * @retval -EINVAL Invalid @p data and @p len combination, or invalid @p prio.
+ * @retval -ENOMEM No memory to schedule this event.
+ */
+int bm_scheduler_defer_prio(bm_scheduler_fn_t handler, void *data, size_t len, uint8_t prio);
+
+/**
+ * @brief Schedule a coalescing event for execution in the main thread.
+ *
+ * This function can be called from an ISR to defer code execution to the main thread.
+ * If the event is already pending, it is not scheduled again and
+ * @ref bm_scheduler_coalesce.coalesced is incremented instead.
+ * The event stops being pending right before its handler is called, so deferring
+ * the event while its handler runs schedules a new dispatch.
+ *
+ * @param evt Coalescing event.
+ *
+ * @retval 0 On success, or if the event is already pending.
+ * @retval -EFAULT @p evt or its handler is @c NULL.
+ * @retval -EINVAL Invalid event priority.
+ * @retval -ENOMEM No memory to schedule this event.
+ */
+int bm_scheduler_defer_coalesce(struct bm_scheduler_coalesce *evt);
+
+/**
+ * @brief Process deferred events.
+ *
+ * Process deferred events in the main thread, highest priority first.
+ * The processing time is bounded by the @c CONFIG_BM_SCHEDULER_PROCESS_TIME_BUDGET_US
+ * Kconfig option.
+ *
+ * @retval 0 On success. All events have been processed.
+ * @retval -EAGAIN The time budget was exceeded and more events are pending.
+ *                 Call this function again before putting the CPU to sleep.
  */
 int bm_scheduler_process(void);
 
+/**
+ * @brief Process deferred events within a time budget.
+ *
+ * Process deferred events in the main thread, highest priority first,
+ * until no events are pending or @p budget_us has elapsed.
+ * At least one event is processed, if any are pending.
+ *
+ * @param budget_us Time budget in microseconds, or 0 for no limit.
+ *
+ * @retval 0 On success. All events have been processed.
+ * @retval -EAGAIN The time budget was exceeded and more events are pending.
+ *                 Call this function again before putting the CPU to sleep.
+ */
+int bm_scheduler_process_budget(uint32_t budget_us);
+
+/**
+ * @brief Event scheduler statistics.
+ *
+ * Times are measured in hardware cycles (GRTC ticks on nRF54L Series devices).
+ */
+struct bm_scheduler_stats {
+	/**
+	 * @brief Number of events currently pending.
+	 */
+	uint32_t queue_depth;
+	/**
+	 * @brief Peak number of pending events.
+	 */
+	uint32_t queue_depth_peak;
+	/**
+	 * @brief Peak usage of the dedicated heap, in bytes.
+	 */
+	size_t heap_peak;
+	/**
+	 * @brief Number of dispatched events.
+	 */
+	uint32_t dispatched;
+	/**
+	 * @brief Maximum latency from scheduling to dispatching an event.
+	 */
+	uint32_t latency_max;
+	/**
+	 * @brief Average latency from scheduling to dispatching an event.
+	 */
+	uint32_t latency_avg;
+	/**
+	 * @brief Number of dispatched events whose handler statistics were not recorded,
+	 *        because @c CONFIG_BM_SCHEDULER_STATS_HANDLERS handlers are already tracked.
+	 */
+	uint32_t untracked;
+};
+
+/**
+ * @brief Event handler statistics.
+ *
+ * Times are measured in hardware cycles (GRTC ticks on nRF54L Series devices).
+ */
+struct bm_scheduler_handler_stats {
+	/**
+	 * @brief Event handler.
+	 */
+	bm_scheduler_fn_t handler;
+	/**
+	 * @brief Number of times the handler has been dispatched.
+	 */
+	uint32_t count;
+	/**
+	 * @brief Maximum execution time of the handler.
+	 */
+	uint32_t exec_max;
+	/**
+	 * @brief Execution time histogram.
+	 *
+	 * Bucket @c i counts executions shorter than 4^(i + 1) cycles,
+	 * and longer than the upper bound of the previous bucket.
+	 * The last bucket counts all longer executions.
+	 */
+	uint32_t hist[BM_SCHEDULER_STATS_HIST_BUCKETS];
+};
+
+/**
+ * @brief Get event scheduler statistics.
+ *
+ * Requires @c CONFIG_BM_SCHEDULER_STATS.
+ *
+ * @param[out] stats Statistics.
+ *
+ * @retval 0 On success.
+ * @retval -EFAULT @p stats is @c NULL.
+ */
+int bm_scheduler_stats_get(struct bm_scheduler_stats *stats);
+
+/**
+ * @brief Get the statistics of an event handler.
+ *
+ * Requires @c CONFIG_BM_SCHEDULER_STATS.
+ * Handlers are recorded in the order they are first dispatched.
+ *
+ * @param idx Index of the handler, starting from 0.
+ * @param[out] stats Handler statistics.
+ *
+ * @retval 0 On success.
+ * @retval -EFAULT @p stats is @c NULL.
+ * @retval -ENOENT No handler recorded at @p idx.
+ */
+int bm_scheduler_handler_stats_get(size_t idx, struct bm_scheduler_handler_stats *stats);
+
+/**
+ * @brief Reset event scheduler statistics.
+ *
+ * Requires @c CONFIG_BM_SCHEDULER_STATS.
+ * The peak values restart from the current values.
+ */
+void bm_scheduler_stats_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/dlist.h>
 #include <zephyr/sys/time_units.h>
 #include <zephyr/sys/util.h>
 
@@ -69,7 +70,30 @@ typedef void (*bm_timer_timeout_handler_t)(void *context);
  * @brief Timer instance structure.
  */
 struct bm_timer {
+#if defined(CONFIG_BM_TIMER_BACKEND_WHEEL)
+	/** Reserved. */
+	sys_dnode_t node;
+	/** Reserved. Expiry time, in absolute ticks. */
+	uint64_t expiry;
+	/** Reserved. Period, in ticks. */
+	uint32_t period;
+	/** Reserved. Slack, in ticks. */
+	uint32_t slack;
+	/** Reserved. Timer wheel position. */
+	uint8_t level;
+	/** Reserved. Timer wheel position. */
+	uint8_t slot;
+	/** Reserved. */
+	void *context;
+#else
 	struct k_timer timer;
+	/** Reserved. Nominal expiry time of a lazy timer, in absolute ticks. */
+	uint64_t expiry;
+	/** Reserved. Period of a lazy timer, in ticks. */
+	uint32_t period;
+	/** Reserved. Slack, in ticks. */
+	uint32_t slack;
+#endif
 	enum bm_timer_mode mode;
 	bm_timer_timeout_handler_t handler;
 };
@@ -101,6 +125,31 @@ int bm_timer_init(struct bm_timer *timer, enum bm_timer_mode mode,
  */
 int bm_timer_start(struct bm_timer *timer, uint32_t timeout_ticks, void *context);
 
+/**
+ * @brief Start a timer that tolerates a late expiry.
+ *
+ * The timer expires at any time within @p slack_ticks after its nominal expiry.
+ * The expiry is aligned to a grid that depends on the slack, so that timers with
+ * overlapping tolerance windows expire together and wake up the CPU only once.
+ * A repeated timer keeps its nominal period and does not drift. The slack must be
+ * smaller than the timeout, or a repeated timer can skip expiries.
+ *
+ * Calling this function with a @p slack_ticks of zero is equivalent to calling
+ * @ref bm_timer_start.
+ *
+ * @param timer Pointer to timer instance.
+ * @param timeout_ticks Number of ticks to time-out event.
+ * @param slack_ticks Number of ticks the time-out event can be delayed by.
+ * @param context General purpose pointer. Will be passed to the time-out handler when
+ *                when the timer expires.
+ *
+ * @retval 0 On success.
+ * @retval -EFAULT If @p timer is @c NULL.
+ * @retval -EINVAL If @p timeout_ticks is less than @ref BM_TIMER_MIN_TIMEOUT_TICKS.
+ */
+int bm_timer_start_lazy(struct bm_timer *timer, uint32_t timeout_ticks, uint32_t slack_ticks,
+			void *context);
+
 /**
  * @brief Stop a timer.
  *
@@ -42,6 +42,10 @@ enum bm_zms_evt_type {
 	BM_ZMS_EVT_DELETE,
 	/** Event for @ref bm_zms_clear. */
 	BM_ZMS_EVT_CLEAR,
+	/** Event for @ref bm_zms_write_batch. */
+	BM_ZMS_EVT_WRITE_BATCH,
+	/** Event for the completion of a garbage collection started by @ref bm_zms_gc_step. */
+	BM_ZMS_EVT_GC,
 };
 
 /**@brief A BM_ZMS event. */
@@ -60,11 +64,75 @@ struct bm_zms_evt {
 	 */
 	int result;
 	/** The ID of the entry as specified in the corresponding
-	 *  write/delete operation.
+	 *  write/delete operation. For a batch write, the ID of its first entry.
 	 */
 	uint32_t id;
 };
 
+/** An entry of a batch write. */
+struct bm_zms_batch_entry {
+	/** ID of the entry. */
+	uint32_t id;
+	/** Pointer to the data to be written, NULL to delete the entry. */
+	const void *data;
+	/** Number of bytes to be written, 0 to delete the entry. */
+	size_t len;
+};
+
+/** A reference to the data of an entry, in place in non-volatile storage. */
+struct bm_zms_ref {
+	/** Pointer to the data of the entry. */
+	const void *data;
+	/** Length of the data of the entry. */
+	size_t len;
+	/** Generation of the file system when the reference was taken. */
+	uint32_t generation;
+};
+
+/** An iterator over the IDs stored in a file system. */
+struct bm_zms_iter {
+	/** Bits of the ID that are compared with @ref bm_zms_iter.id_prefix. */
+	uint32_t id_mask;
+	/** Value of the masked bits of the IDs to return. */
+	uint32_t id_prefix;
+	/** Internal state: address of the next ATE to examine. */
+	uint64_t addr;
+	/** Internal state: address at which the iteration ends. */
+	uint64_t end_addr;
+	/** Internal state: generation of the file system when the iteration started. */
+	uint32_t generation;
+	/** Internal state: sector of the last ATE examined. */
+	int sector_num;
+	/** Internal state: cycle counter of that sector. */
+	uint8_t sector_cycle;
+	/** Internal state: true once all ATEs have been examined. */
+	bool done;
+#if CONFIG_BM_ZMS_ITER_SEEN_IDS > 0
+	/** Internal state: true if more IDs were found than fit in @ref bm_zms_iter.seen_ids. */
+	bool seen_ids_full;
+	/** Internal state: number of IDs in @ref bm_zms_iter.seen_ids. */
+	uint8_t seen_id_count;
+	/** Internal state: IDs found so far, up to @c CONFIG_BM_ZMS_ITER_SEEN_IDS. */
+	uint32_t seen_ids[CONFIG_BM_ZMS_ITER_SEEN_IDS];
+#endif
+};
+
+#if defined(CONFIG_BM_ZMS_STATS)
+/** Wear statistics of a file system, since it was mounted. */
+struct bm_zms_stats {
+	/** Number of bytes written by write and delete operations, ATEs included. */
+	uint32_t bytes_written;
+	/** Number of bytes moved by garbage collection, ATEs included. */
+	uint32_t gc_bytes_moved;
+	/** Number of garbage collections. */
+	uint32_t gc_count;
+	/** Number of writes skipped because the stored value was unchanged. */
+	uint32_t writes_skipped;
+	/** Number of erases of each sector, up to @c CONFIG_BM_ZMS_STATS_MAX_SECTORS. */
+	uint32_t sector_erase_count[CONFIG_BM_ZMS_STATS_MAX_SECTORS];
+};
+#endif
+
 /** Init flags. */
 struct bm_zms_init_flags {
 	/** true when the storage is initialized. */
@@ -80,6 +148,8 @@ struct bm_zms_init_flags {
  */
 typedef void (*bm_zms_evt_handler_t)(const struct bm_zms_evt *evt);
 
+struct bm_zms_op_queue;
+
 /** Zephyr Memory Storage file system structure */
 struct bm_zms_fs {
 	/** File system offset in non-volatile storage. */
@@ -114,10 +184,18 @@ struct bm_zms_fs {
 	atomic_t ongoing_writes;
 	/** Event handler for propagating events. */
 	bm_zms_evt_handler_t evt_handler;
+	/** Operation queue of the file system, assigned at mount. */
+	struct bm_zms_op_queue *op_queue;
+	/** Incremented each time a sector is erased, to invalidate @ref bm_zms_ref. */
+	atomic_t generation;
 #if CONFIG_BM_ZMS_LOOKUP_CACHE
 	/** Lookup table used to cache ATE addresses of written IDs. */
 	uint64_t lookup_cache[CONFIG_BM_ZMS_LOOKUP_CACHE_SIZE];
 #endif
+#if CONFIG_BM_ZMS_STATS
+	/** Wear statistics, see @ref bm_zms_stats_get. */
+	struct bm_zms_stats stats;
+#endif
 };
 
 /** Configuration for Zephyr Memory Storage file system structure initialization. */
@@ -157,7 +235,8 @@ struct bm_zms_fs_config {
  *
  * @retval 0 If the initialization is queued successfully.
  * @retval -EFAULT if @p fs or @p config are NULL.
- * @retval -ENOMEM if the internal fifo is full.
+ * @retval -ENOMEM if the internal fifo is full, or if @c CONFIG_BM_ZMS_MAX_FS file
+ *                 systems are already mounted.
  * @retval -EBUSY if an initialization is already executing.
  * @retval -EINVAL if any of the sector layout is invalid.
  * @retval -EIO if the backend storage initialization failed.
@@ -188,6 +267,11 @@ int bm_zms_clear(struct bm_zms_fs *fs);
  * deleted entry and an entry with data of length 0.
  * Once the write operation is completed, a @ref BM_ZMS_EVT_WRITE event will be propagated
  * to the configured event handler.
+ * @note With @c CONFIG_BM_ZMS_NO_DOUBLE_WRITE, a write of the value that is already stored for
+ * @p id completes without writing anything.
+ * @note The data is not copied, and must be kept until the write event, unless
+ * @c CONFIG_BM_ZMS_WRITE_COPY is enabled and @p len is at most
+ * @c CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE.
  *
  * @param fs Pointer to the file system.
  * @param id ID of the entry to be written.
@@ -201,9 +285,38 @@ int bm_zms_clear(struct bm_zms_fs *fs);
  * @retval -EACCES if BM_ZMS is still not initialized.
  * @retval -EIO if there is an internal error.
  * @retval -EINVAL if @p len is invalid.
+ * @retval -ENOMEM if the operation queue, or the pool of write copy blocks, is full.
  */
 ssize_t bm_zms_write(struct bm_zms_fs *fs, uint32_t id, const void *data, size_t len);
 
+/**
+ * @brief Write several entries to the file system in a single transaction.
+ *
+ * The entries are written in one sector, after a single check for free space, and become
+ * visible together when the transaction is committed. If the write is interrupted by a power
+ * loss, none of the entries are visible after the next mount. Entries with a length of `0` are
+ * deleted.
+ *
+ * @note Once all entries are written, a single @ref BM_ZMS_EVT_WRITE_BATCH event will be
+ *       propagated to the configured event handler. The @p entries array and the data it points
+ *       to must remain valid until then.
+ * @note If the transaction fails after it has started writing, the file system must be mounted
+ *       again, which rolls back the entries written so far.
+ *
+ * @param fs Pointer to the file system.
+ * @param entries Array of entries to be written, in order.
+ * @param count Number of entries in @p entries.
+ *
+ * @retval 0 if the batch write is queued.
+ * @retval -EFAULT if @p fs or @p entries are NULL.
+ * @retval -EACCES if BM_ZMS is still not initialized.
+ * @retval -EINVAL if @p count is 0, if an entry length is invalid or if the entries do not
+ *                 fit in a sector.
+ * @retval -ENOMEM if the internal fifo is full.
+ */
+int bm_zms_write_batch(struct bm_zms_fs *fs, const struct bm_zms_batch_entry *entries,
+		       size_t count);
+
 /**
  * @brief Delete an entry from the file system.
  *
@@ -261,6 +374,82 @@ ssize_t bm_zms_read(struct bm_zms_fs *fs, uint32_t id, void *data, size_t len);
  */
 ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t len, uint32_t cnt);
 
+/**
+ * @brief Get a reference to the data of an entry, without copying it.
+ *
+ * The reference points to the latest entry with the given @p id, in place in the memory-mapped
+ * non-volatile storage. The data remains valid until the sector holding it is erased by garbage
+ * collection or by @ref bm_zms_clear, which can happen whenever an operation is processed.
+ * Use @ref bm_zms_ref_valid after the data has been consumed to verify that it was not
+ * overwritten in the meantime, and take a new reference if it was.
+ *
+ * @note Requires a storage backend that sets @ref bm_storage_info.is_memory_mapped.
+ *
+ * @param fs Pointer to the file system.
+ * @param id ID of the entry to be referenced.
+ * @param ref Reference to the data of the entry.
+ *
+ * @retval 0 on success.
+ * @retval -EFAULT if @p fs or @p ref is NULL.
+ * @retval -EACCES if BM_ZMS is still not initialized.
+ * @retval -ENOTSUP if the storage backend is not memory-mapped.
+ * @retval -EIO if there is a memory read error or the data CRC does not match.
+ * @retval -ENOENT if there is no entry with the given @p id.
+ */
+int bm_zms_read_ref(struct bm_zms_fs *fs, uint32_t id, struct bm_zms_ref *ref);
+
+/**
+ * @brief Check whether a reference obtained with @ref bm_zms_read_ref is still valid.
+ *
+ * @param fs Pointer to the file system.
+ * @param ref Reference to check.
+ *
+ * @retval true if no sector has been erased since the reference was taken.
+ * @retval false otherwise, or if @p fs or @p ref is NULL.
+ */
+bool bm_zms_ref_valid(struct bm_zms_fs *fs, const struct bm_zms_ref *ref);
+
+/**
+ * @brief Start iterating over the IDs stored in the file system.
+ *
+ * The iteration returns the IDs whose latest entry is not deleted, from the most recently
+ * written to the oldest, each of them once. Only the IDs for which
+ * `(id & id_mask) == id_prefix` are returned; use an @p id_mask of 0 to return all of them.
+ * All entries are walked through once, which is faster than reading each candidate ID.
+ * When more than @c CONFIG_BM_ZMS_ITER_SEEN_IDS IDs are found, each of the next IDs is
+ * looked up in the file system to find out whether the entry is its latest one.
+ *
+ * @param fs Pointer to the file system.
+ * @param iter Iterator to initialize.
+ * @param id_mask Bits of the ID to compare with @p id_prefix.
+ * @param id_prefix Value of the masked bits of the IDs to return.
+ *
+ * @retval 0 on success.
+ * @retval -EFAULT if @p fs or @p iter is NULL.
+ * @retval -EACCES if BM_ZMS is still not initialized.
+ */
+int bm_zms_iter_init(struct bm_zms_fs *fs, struct bm_zms_iter *iter, uint32_t id_mask,
+		     uint32_t id_prefix);
+
+/**
+ * @brief Get the next ID of an iteration started with @ref bm_zms_iter_init.
+ *
+ * IDs written after the iteration started might not be returned. If a sector is erased
+ * during the iteration, the iteration must be started again.
+ *
+ * @param fs Pointer to the file system.
+ * @param iter Iterator.
+ * @param id ID of the next entry.
+ *
+ * @retval 0 on success.
+ * @retval -EFAULT if @p fs, @p iter or @p id is NULL.
+ * @retval -EACCES if BM_ZMS is still not initialized.
+ * @retval -ENOENT if there are no more IDs.
+ * @retval -EAGAIN if a sector has been erased since the iteration started.
+ * @retval -EIO if there is a memory read error.
+ */
+int bm_zms_iter_next(struct bm_zms_fs *fs, struct bm_zms_iter *iter, uint32_t *id);
+
 /**
  * @brief Gets the length of the data that is stored in an entry with a given `id`
  *
@@ -304,6 +493,48 @@ ssize_t bm_zms_calc_free_space(struct bm_zms_fs *fs);
  */
 ssize_t bm_zms_active_sector_free_space(struct bm_zms_fs *fs);
 
+/**
+ * @brief Get the wear statistics of the file system.
+ *
+ * The statistics are counted from the mount of the file system. The write amplification is
+ * `(bytes_written + gc_bytes_moved) / bytes_written`.
+ *
+ * @note Requires @c CONFIG_BM_ZMS_STATS.
+ *
+ * @param fs Pointer to the file system.
+ * @param stats Statistics of the file system.
+ *
+ * @retval 0 on success.
+ * @retval -EFAULT if @p fs or @p stats is NULL.
+ * @retval -EACCES if BM_ZMS is still not initialized.
+ */
+int bm_zms_stats_get(struct bm_zms_fs *fs, struct bm_zms_stats *stats);
+
+/**
+ * @brief Run a step of background garbage collection.
+ *
+ * When the free space in the active sector is below @c CONFIG_BM_ZMS_GC_BACKGROUND_THRESHOLD
+ * percent of the sector size, the active sector is closed and garbage is collected ahead of
+ * time, so that a later write does not have to. Each step examines at most
+ * @c CONFIG_BM_ZMS_GC_STEP_ATES entries of the sector being collected, and the next call
+ * continues where the previous step stopped. If an operation is queued while the garbage
+ * collection is paused between steps, the garbage collection is completed before it.
+ *
+ * @note Once the garbage collection is completed, a @ref BM_ZMS_EVT_GC event will be
+ *       propagated to the configured event handler.
+ * @note Requires @c CONFIG_BM_ZMS_GC_BACKGROUND.
+ *
+ * @param fs Pointer to the file system.
+ *
+ * @retval 0 if a step was started.
+ * @retval -EFAULT if @p fs is NULL.
+ * @retval -EACCES if BM_ZMS is still not initialized.
+ * @retval -EALREADY if there is enough free space in the active sector.
+ * @retval -EBUSY if other operations are queued.
+ * @retval -ENOMEM if the internal fifo is full.
+ */
+int bm_zms_gc_step(struct bm_zms_fs *fs);
+
 /**
  * @}
  */
@@ -48,9 +48,84 @@ struct nrf_sdh_ble_evt_observer {
 	void *context;
 };
 
+/**
+ * @defgroup nrf_sdh_ble_evt_groups Bluetooth LE event groups
+ *
+ * A Bluetooth LE event observer can register for the events of selected groups only, so that
+ * it is not called for the events it does not handle. The groups are the SoftDevice event ID
+ * ranges: common, GAP, GATT client and GATT server events.
+ * These can be selected using the tokens COMMON, GAP, GATTC, and GATTS respectively.
+ *
+ * Each group has its own observer section, sorted by priority, and an event is only dispatched
+ * to the observers in the section of its group.
+ *
+ * @{
+ */
+
+/* Helper macros to check for validity */
+
+#define H_NRF_SDH_BLE_EVT_GROUP_COMMON 1
+#define H_NRF_SDH_BLE_EVT_GROUP_GAP 1
+#define H_NRF_SDH_BLE_EVT_GROUP_GATTC 1
+#define H_NRF_SDH_BLE_EVT_GROUP_GATTS 1
+
+/**
+ * @brief Utility macro to check for event group validity.
+ * @internal
+ */
+#define EVT_GROUP_IS_VALID(_group)                                                                 \
+	COND_CODE_1(H_NRF_SDH_BLE_EVT_GROUP_##_group, (),                                          \
+		    (BUILD_ASSERT(0, "Invalid event group")))
+
+/**
+ * @brief Utility macro to register an observer in the section of one event group.
+ * @internal
+ */
+#define Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER(_group, _observer, _handler, _ctx, _prio)                 \
+	EVT_GROUP_IS_VALID(_group);                                                                \
+	static const TYPE_SECTION_ITERABLE(struct nrf_sdh_ble_evt_observer, _observer##_##_group,  \
+					   nrf_sdh_ble_evt_observers_##_group,                     \
+					   PRIO_LEVEL_ORD(_prio)) = {                              \
+		.handler = _handler,                                                               \
+		.context = _ctx,                                                                   \
+	}
+
+/**
+ * @brief Utility macro to unpack the arguments of @ref Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER.
+ * @internal
+ */
+#define Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER_ARGS(_group, _args)                                       \
+	Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER_EXPAND(_group, __DEBRACKET _args)
+#define Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER_EXPAND(...) Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER(__VA_ARGS__)
+
+/**
+ * @}
+ */
+
+/**
+ * @brief Register a SoftDevice Bluetooth LE event observer for selected event groups.
+ *
+ * The observer receives only the Bluetooth LE events of the given groups.
+ *
+ * @param _observer Name of the observer.
+ * @param _handler State request handler.
+ * @param _ctx A context passed to the state request handler.
+ * @param _prio Priority of the observer's event handler.
+ *		Allowed input: `HIGHEST`, `HIGH`, `USER`, `USER_LOW`, `LOWEST`.
+ * @param ... One or more event groups.
+ *		Allowed input: `COMMON`, `GAP`, `GATTC`, `GATTS`.
+ */
+#define NRF_SDH_BLE_EVT_OBSERVER(_observer, _handler, _ctx, _prio, ...)                            \
+	PRIO_LEVEL_IS_VALID(_prio);                                                                \
+	FOR_EACH_FIXED_ARG(Z_NRF_SDH_BLE_EVT_GROUP_OBSERVER_ARGS, (;),                             \
+			   (_observer, _handler, _ctx, _prio), __VA_ARGS__)
+
 /**
  * @brief Register a SoftDevice Bluetooth LE event observer.
  *
+ * The observer receives all Bluetooth LE events.
+ * Use @ref NRF_SDH_BLE_EVT_OBSERVER to receive only the events of selected groups.
+ *
  * @param _observer Name of the observer.
  * @param _handler State request handler.
  * @param _ctx A context passed to the state request handler.
@@ -58,12 +133,7 @@ struct nrf_sdh_ble_evt_observer {
  *		Allowed input: `HIGHEST`, `HIGH`, `USER`, `USER_LOW`, `LOWEST`.
  */
 #define NRF_SDH_BLE_OBSERVER(_observer, _handler, _ctx, _prio)                                     \
-	PRIO_LEVEL_IS_VALID(_prio);                                                                \
-	static const TYPE_SECTION_ITERABLE(struct nrf_sdh_ble_evt_observer, _observer,             \
-					   nrf_sdh_ble_evt_observers, PRIO_LEVEL_ORD(_prio)) = {   \
-		.handler = _handler,                                                               \
-		.context = _ctx,                                                                   \
-	}
+	NRF_SDH_BLE_EVT_OBSERVER(_observer, _handler, _ctx, _prio, COMMON, GAP, GATTC, GATTS)
 
 /**
  * @brief Enable the SoftDevice Bluetooth stack.
@@ -101,6 +101,13 @@ struct bm_storage_info {
 	 * @brief Whether the memory must be erased before it can be written to.
 	 */
 	bool is_erase_before_write;
+	/**
+	 * @brief Whether the memory can be read directly through the CPU address space.
+	 *
+	 * When set, the contents of a partition are available at the partition address
+	 * and can be accessed without @ref bm_storage_read.
+	 */
+	bool is_memory_mapped;
 };
 
 struct bm_storage;
@@ -204,7 +204,7 @@ static void on_ble_evt(const ble_evt_t *evt, void *ctx)
 		break;
 	}
 }
-NRF_SDH_BLE_OBSERVER(ble_observer, on_ble_evt, NULL, HIGH);
+NRF_SDH_BLE_EVT_OBSERVER(ble_observer, on_ble_evt, NULL, HIGH, GAP);
 
 static int on_state_evt(enum nrf_sdh_state_evt evt, void *ctx)
 {
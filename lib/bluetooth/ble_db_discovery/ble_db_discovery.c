@@ -6,23 +6,135 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <ble_gap.h>
 #include <ble_gattc.h>
 #include <ble_types.h>
 #include <bm/bluetooth/ble_db_discovery.h>
 #include <bm/bluetooth/ble_gq.h>
 #include <bm/bluetooth/services/uuid.h>
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+#include <bm/bluetooth/peer_manager/peer_manager.h>
+#endif
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/__assert.h>
+#include <zephyr/sys/util.h>
 
 LOG_MODULE_REGISTER(ble_db_disc, CONFIG_BLE_DB_DISCOVERY_LOG_LEVEL);
 
-static inline struct ble_gatt_db_srv *curr_discovered_srv_get(struct ble_db_discovery *db_discovery)
+BUILD_ASSERT(BLE_DB_DISCOVERY_SRV_POOL_SIZE >= BLE_DB_DISCOVERY_LINK_SRV_RECS,
+	     "The service record pool must fit the records of one link");
+BUILD_ASSERT(BLE_DB_DISCOVERY_SRV_POOL_SIZE <= UINT8_MAX,
+	     "The service record pool must be indexable by the links");
+
+static inline struct ble_gatt_db_srv *curr_discovered_srv_get(struct ble_db_discovery *db_discovery,
+							       struct ble_db_discovery_link *link)
+{
+	__ASSERT(link->curr_srv_idx < link->srv_rec_count, "Service index out of range");
+
+	return &(db_discovery->services[link->srv_rec_idx + link->curr_srv_idx]);
+}
+
+/* Get the link being discovered on a connection, or NULL if there is none. */
+static struct ble_db_discovery_link *link_get(struct ble_db_discovery *db_discovery,
+					      uint16_t conn_handle)
 {
-	__ASSERT(db_discovery->curr_srv_idx < CONFIG_BLE_DB_DISCOVERY_MAX_SRV,
-		 "Service index out of range");
+	if (conn_handle == BLE_CONN_HANDLE_INVALID) {
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->links); i++) {
+		if (db_discovery->links[i].conn_handle == conn_handle) {
+			return &db_discovery->links[i];
+		}
+	}
 
-	return &(db_discovery->services[db_discovery->curr_srv_idx]);
+	return NULL;
+}
+
+/* Get the link of a connection, or a free link if the connection has none. */
+static struct ble_db_discovery_link *link_alloc(struct ble_db_discovery *db_discovery,
+						uint16_t conn_handle)
+{
+	struct ble_db_discovery_link *link = link_get(db_discovery, conn_handle);
+
+	if (link) {
+		return link;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->links); i++) {
+		if (db_discovery->links[i].conn_handle == BLE_CONN_HANDLE_INVALID) {
+			return &db_discovery->links[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Return the service records of a link to the pool, and free the link. */
+static void link_release(struct ble_db_discovery_link *link)
+{
+	link->conn_handle = BLE_CONN_HANDLE_INVALID;
+	link->srv_rec_count = 0;
+	link->discovery_in_progress = false;
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	link->db_hash_pending = false;
+#endif
+}
+
+/* Move the start of a candidate run of service records past a run that it overlaps. */
+static bool srv_recs_skip(uint32_t *start, uint32_t count, uint32_t rec_idx, uint32_t rec_count)
+{
+	if ((rec_count == 0) || (*start >= (rec_idx + rec_count)) ||
+	    (rec_idx >= (*start + count))) {
+		return false;
+	}
+
+	*start = rec_idx + rec_count;
+
+	return true;
+}
+
+/* Take a run of consecutive service records from the pool. The records of a link are kept
+ * together, so that they can be stored in the remote database of the peer as one record.
+ */
+static bool srv_recs_alloc(struct ble_db_discovery *db_discovery,
+			   struct ble_db_discovery_link *link, uint32_t count)
+{
+	uint32_t start = 0;
+	bool overlap;
+
+	do {
+		overlap = false;
+
+		/* Skip past the records of any link that overlap the candidate run. */
+		for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->links); i++) {
+			const struct ble_db_discovery_link *other = &db_discovery->links[i];
+
+			overlap |= srv_recs_skip(&start, count, other->srv_rec_idx,
+						 other->srv_rec_count);
+		}
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+		/* And past the records that are still being stored. */
+		for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->cache_stores); i++) {
+			const struct ble_db_discovery_cache_store *store =
+				&db_discovery->cache_stores[i];
+
+			overlap |= srv_recs_skip(&start, count, store->srv_rec_idx,
+						 store->srv_rec_count);
+		}
+#endif
+	} while (overlap && ((start + count) <= ARRAY_SIZE(db_discovery->services)));
+
+	if ((start + count) > ARRAY_SIZE(db_discovery->services)) {
+		return false;
+	}
+
+	link->srv_rec_idx = start;
+	link->srv_rec_count = count;
+
+	return true;
 }
 
 static bool is_uuid_registered(struct ble_db_discovery *db_discovery, const ble_uuid_t *uuid)
@@ -52,13 +164,28 @@ static uint32_t uuid_register(struct ble_db_discovery *db_discovery, const ble_u
 	return NRF_SUCCESS;
 }
 
-static void pending_user_events_send(struct ble_db_discovery *db_discovery)
+/* Send the result of the discovery of each registered service to the user. */
+static void pending_user_events_send(struct ble_db_discovery *db_discovery,
+				     struct ble_db_discovery_link *link)
 {
-	for (uint32_t i = 0; i < db_discovery->pending_usr_evt_idx; i++) {
-		db_discovery->evt_handler(db_discovery, &(db_discovery->pending_usr_evts[i]));
-	}
+	for (uint32_t i = 0; i < db_discovery->num_registered_uuids; i++) {
+		const struct ble_gatt_db_srv *const srv =
+			&db_discovery->services[link->srv_rec_idx + i];
+		struct ble_db_discovery_evt evt = {
+			.conn_handle = link->conn_handle,
+		};
+
+		/* The handle range of a service stays invalid if the service is not found. */
+		if (srv->handle_range.start_handle != BLE_GATT_HANDLE_INVALID) {
+			evt.evt_type = BLE_DB_DISCOVERY_COMPLETE;
+			evt.discovered_db = srv;
+		} else {
+			evt.evt_type = BLE_DB_DISCOVERY_SRV_NOT_FOUND;
+			evt.srv_uuid = srv->srv_uuid;
+		}
 
-	db_discovery->pending_usr_evt_idx = 0;
+		db_discovery->evt_handler(db_discovery, &evt);
+	}
 }
 
 static void discovery_available_evt_trigger(struct ble_db_discovery *const db_discovery,
@@ -74,124 +201,357 @@ static void discovery_available_evt_trigger(struct ble_db_discovery *const db_di
 	}
 }
 
-static void discovery_error_evt_trigger(struct ble_db_discovery *db_discovery, uint32_t nrf_err,
-					uint16_t conn_handle)
+static void discovery_error_handler(struct ble_db_discovery *db_discovery,
+				    struct ble_db_discovery_link *link, uint32_t nrf_err)
 {
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
+	const uint16_t conn_handle = link->conn_handle;
+	struct ble_db_discovery_evt evt = {
+		.evt_type = BLE_DB_DISCOVERY_ERROR,
+		.conn_handle = conn_handle,
+		.error.reason = nrf_err,
+	};
 
-	if (is_uuid_registered(db_discovery, &(srv_being_discovered->srv_uuid))) {
-		struct ble_db_discovery_evt evt = {
-			.evt_type = BLE_DB_DISCOVERY_ERROR,
-			.conn_handle = conn_handle,
-			.error.reason = nrf_err,
-		};
+	/* Free the link first, so that the discovery can be restarted from the event handler. */
+	link_release(link);
 
-		db_discovery->evt_handler(db_discovery, &evt);
+	db_discovery->evt_handler(db_discovery, &evt);
+	discovery_available_evt_trigger(db_discovery, conn_handle);
+}
+
+static void discovery_gq_event_handler(const struct ble_gq_req *req, struct ble_gq_evt *evt)
+{
+	struct ble_db_discovery *const db_discovery = req->ctx;
+	struct ble_db_discovery_link *link;
+
+	if (evt->evt_type != BLE_GQ_EVT_ERROR) {
+		return;
 	}
+
+	link = link_get(db_discovery, evt->conn_handle);
+	if (!link || !link->discovery_in_progress) {
+		return;
+	}
+
+	discovery_error_handler(db_discovery, link, evt->error.reason);
 }
 
-static void discovery_error_handler(uint16_t conn_handle, uint32_t nrf_err, void *ctx)
+/* Get the link of a connection if a discovery is in progress on it. */
+static struct ble_db_discovery_link *discovering_link_get(struct ble_db_discovery *db_discovery,
+							  uint16_t conn_handle)
 {
-	struct ble_db_discovery *db_discovery = (struct ble_db_discovery *)ctx;
+	struct ble_db_discovery_link *link = link_get(db_discovery, conn_handle);
 
-	db_discovery->discovery_in_progress = false;
+	if (!link || !link->discovery_in_progress) {
+		return NULL;
+	}
 
-	discovery_error_evt_trigger(db_discovery, nrf_err, conn_handle);
-	discovery_available_evt_trigger(db_discovery, conn_handle);
+	return link;
 }
 
-static void discovery_gq_event_handler(const struct ble_gq_req *req, struct ble_gq_evt *evt)
+/* Start the discovery of the service at the current service index. */
+static uint32_t srv_discover(struct ble_db_discovery *db_discovery,
+			     struct ble_db_discovery_link *link)
 {
-	if (evt->evt_type != BLE_GQ_EVT_ERROR) {
-		return;
+	struct ble_gatt_db_srv *const srv_being_discovered =
+		curr_discovered_srv_get(db_discovery, link);
+
+	srv_being_discovered->srv_uuid = db_discovery->registered_uuids[link->curr_srv_idx];
+
+	/* Reset the characteristic count and the handle range of the current service since a new
+	 * service discovery is about to start. The handle range stays invalid if the service is
+	 * not found.
+	 */
+	srv_being_discovered->char_count = 0;
+	srv_being_discovered->handle_range.start_handle = BLE_GATT_HANDLE_INVALID;
+	srv_being_discovered->handle_range.end_handle = BLE_GATT_HANDLE_INVALID;
+
+	LOG_DBG("Starting discovery of service with UUID %#x on connection handle %#x",
+		srv_being_discovered->srv_uuid.uuid, link->conn_handle);
+
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_SRV_DISCOVERY,
+		.evt_handler = discovery_gq_event_handler,
+		.ctx = db_discovery,
+		.gattc_srv_disc = {
+			.srvc_uuid = srv_being_discovered->srv_uuid,
+			.start_handle = CONFIG_BLE_DB_DISCOVERY_SRV_DISC_START_HANDLE,
+		},
+	};
+
+	return ble_gq_item_add(db_discovery->gatt_queue, &req, link->conn_handle);
+}
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+/* The record after the services of a link holds the Database Hash of the peer. */
+BUILD_ASSERT(sizeof(struct ble_gatt_db_srv) >= BLE_DB_DISCOVERY_DB_HASH_LEN);
+
+/* The record is stored as a single BM_ZMS entry of the Peer Manager, which must leave room in
+ * the sector for at least five allocation table entries of 16 bytes each.
+ */
+#define CACHE_LEN_MAX ((CONFIG_BLE_DB_DISCOVERY_MAX_SRV * sizeof(struct ble_gatt_db_srv)) + \
+		       BLE_DB_DISCOVERY_DB_HASH_LEN)
+#define CACHE_ENTRY_LEN_MAX (CONFIG_PM_BM_ZMS_SECTOR_SIZE - (5 * 16))
+
+BUILD_ASSERT(CACHE_LEN_MAX <= CACHE_ENTRY_LEN_MAX,
+	     "The service cache record does not fit in a Peer Manager storage entry, "
+	     "increase CONFIG_PM_BM_ZMS_SECTOR_SIZE or decrease CONFIG_BLE_DB_DISCOVERY_MAX_SRV");
+
+/* Number of service records a link takes from the pool, with or without the Database Hash. */
+static uint32_t srv_recs_count(const struct ble_db_discovery *db_discovery, bool db_hash)
+{
+	return db_discovery->num_registered_uuids + (db_hash ? 1 : 0);
+}
+
+static uint8_t *db_hash_get(struct ble_db_discovery *db_discovery,
+			    const struct ble_db_discovery_link *link)
+{
+	return (uint8_t *)&db_discovery->services[link->srv_rec_idx +
+						  db_discovery->num_registered_uuids];
+}
+
+/* Length of the record stored in the remote database of the peer: the registered services,
+ * followed by the Database Hash.
+ */
+static uint32_t cache_len(const struct ble_db_discovery *db_discovery)
+{
+	return (db_discovery->num_registered_uuids * sizeof(db_discovery->services[0])) +
+	       BLE_DB_DISCOVERY_DB_HASH_LEN;
+}
+
+/* Get the peer ID of a bonded peer, or PM_PEER_ID_INVALID if the peer is not bonded. */
+static uint16_t bonded_peer_id_get(uint16_t conn_handle)
+{
+	uint16_t peer_id;
+
+	if (pm_peer_id_get(conn_handle, &peer_id)) {
+		return PM_PEER_ID_INVALID;
 	}
 
-	discovery_error_handler(evt->conn_handle, evt->error.reason, req->ctx);
+	return peer_id;
 }
 
-static void discovery_complete_evt_trigger(struct ble_db_discovery *db_discovery, bool is_srv_found,
-					   uint16_t conn_handle)
+/* Load the services discovered at the peer in an earlier connection. */
+static bool cache_load(struct ble_db_discovery *db_discovery,
+		       const struct ble_db_discovery_link *link, uint16_t peer_id)
 {
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
+	uint32_t nrf_err;
+	uint32_t len = cache_len(db_discovery);
+	const struct ble_gatt_db_srv *const services = &db_discovery->services[link->srv_rec_idx];
 
-	if (!is_uuid_registered(db_discovery, &(srv_being_discovered->srv_uuid))) {
-		return;
+	nrf_err = pm_peer_data_load(peer_id, PM_PEER_DATA_ID_GATT_REMOTE,
+				    &db_discovery->services[link->srv_rec_idx], &len);
+	if (nrf_err || (len != cache_len(db_discovery))) {
+		return false;
 	}
 
-	if (db_discovery->pending_usr_evt_idx >= CONFIG_BLE_DB_DISCOVERY_MAX_SRV) {
-		return;
+	/* The services must have been discovered for the UUIDs registered now. */
+	for (uint32_t i = 0; i < db_discovery->num_registered_uuids; i++) {
+		if (!BLE_UUID_EQ(&services[i].srv_uuid, &db_discovery->registered_uuids[i])) {
+			return false;
+		}
 	}
 
-	struct ble_db_discovery_evt *const usr_evt =
-		&db_discovery->pending_usr_evts[db_discovery->pending_usr_evt_idx];
+	return true;
+}
 
-	/* Insert an event into the pending event list. */
-	usr_evt->conn_handle = conn_handle;
-	if (is_srv_found) {
-		usr_evt->evt_type = BLE_DB_DISCOVERY_COMPLETE;
-		usr_evt->discovered_db = srv_being_discovered;
-	} else {
-		usr_evt->evt_type = BLE_DB_DISCOVERY_SRV_NOT_FOUND;
-		usr_evt->srv_uuid = srv_being_discovered->srv_uuid;
-	}
+/* Get a free store, or NULL if there is none or if the services of the peer are being stored
+ * already.
+ */
+static struct ble_db_discovery_cache_store *cache_store_alloc(struct ble_db_discovery *db_discovery,
+							      uint16_t peer_id)
+{
+	struct ble_db_discovery_cache_store *free_store = NULL;
 
-	db_discovery->pending_usr_evt_idx++;
+	for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->cache_stores); i++) {
+		struct ble_db_discovery_cache_store *store = &db_discovery->cache_stores[i];
 
-	if (db_discovery->pending_usr_evt_idx == db_discovery->num_registered_uuids) {
-		/* All registered services have pending events. Send all pending events to user. */
-		pending_user_events_send(db_discovery);
+		if (store->srv_rec_count == 0) {
+			if (!free_store) {
+				free_store = store;
+			}
+		} else if (store->peer_id == peer_id) {
+			/* One store per peer, so that its completion can be told apart. */
+			return NULL;
+		}
 	}
+
+	return free_store;
 }
 
-static void on_srv_disc_completion(struct ble_db_discovery *db_discovery, uint16_t conn_handle)
+/* Store the discovered services in the remote database of the peer. The store takes over the
+ * service records of the link, as the services are written from there.
+ */
+static void cache_store(struct ble_db_discovery *db_discovery,
+			const struct ble_db_discovery_link *link)
 {
 	uint32_t nrf_err;
-	struct ble_gatt_db_srv *srv_being_discovered;
-
-	db_discovery->discoveries_count++;
+	struct ble_db_discovery_cache_store *store;
+	const uint16_t peer_id = bonded_peer_id_get(link->conn_handle);
 
-	/* Check if this was the last service to be discovered. */
-	if (db_discovery->discoveries_count >= db_discovery->num_registered_uuids) {
-		/* No more services need to be discovered. */
-		db_discovery->discovery_in_progress = false;
+	if (!link->db_hash_valid || (peer_id == PM_PEER_ID_INVALID)) {
+		/* Without the Database Hash the services could not be validated when restoring
+		 * them, and peers that are not bonded have no remote database.
+		 */
+		return;
+	}
 
-		discovery_available_evt_trigger(db_discovery, conn_handle);
+	store = cache_store_alloc(db_discovery, peer_id);
+	if (!store) {
+		/* The services of the pending store are kept. As they are stored with the
+		 * Database Hash they were discovered with, they are only restored if it matches.
+		 */
+		LOG_WRN("Services of peer %d are not stored, store busy", peer_id);
 		return;
 	}
 
-	/* More services need to be discovered. */
+	/* Take the records before the store is started, as it can complete before
+	 * pm_peer_data_store() returns.
+	 */
+	store->peer_id = peer_id;
+	store->srv_rec_idx = link->srv_rec_idx;
+	store->srv_rec_count = link->srv_rec_count;
 
-	/* Reset the current characteristic index. A new service discovery is about to start. */
-	db_discovery->curr_char_idx = 0;
+	nrf_err = pm_peer_data_store(peer_id, PM_PEER_DATA_ID_GATT_REMOTE,
+				     &db_discovery->services[link->srv_rec_idx],
+				     cache_len(db_discovery), NULL);
+	if (nrf_err) {
+		LOG_WRN("Failed to store the services of peer %d, nrf_error %#x", peer_id, nrf_err);
+		store->srv_rec_count = 0;
+	}
+}
 
-	/* Initiate discovery of the next service. */
-	db_discovery->curr_srv_idx++;
+#endif /* CONFIG_BLE_DB_DISCOVERY_CACHE */
 
-	srv_being_discovered = curr_discovered_srv_get(db_discovery);
+/* Send the results of the discovery of a link to the user, and end the discovery. */
+static void discovery_complete(struct ble_db_discovery *db_discovery,
+			       struct ble_db_discovery_link *link)
+{
+	const uint16_t conn_handle = link->conn_handle;
 
-	srv_being_discovered->srv_uuid = db_discovery->registered_uuids[db_discovery->curr_srv_idx];
+	pending_user_events_send(db_discovery, link);
 
-	/* Reset the characteristic count in the current service to zero since a new
-	 * service discovery is about to start.
-	 */
-	srv_being_discovered->char_count = 0;
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	cache_store(db_discovery, link);
+#endif
 
-	LOG_DBG("Starting discovery of service with UUID %#x on connection handle %#x",
-		srv_being_discovered->srv_uuid.uuid, conn_handle);
+	link_release(link);
+
+	discovery_available_evt_trigger(db_discovery, conn_handle);
+}
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+/* Raise the events of a discovery from the services loaded from the remote database. */
+static void cache_restore(struct ble_db_discovery *db_discovery,
+			  struct ble_db_discovery_link *link)
+{
+	for (uint32_t i = 0; i < db_discovery->num_registered_uuids; i++) {
+		if (db_discovery->services[link->srv_rec_idx + i].handle_range.start_handle !=
+		    BLE_GATT_HANDLE_INVALID) {
+			link->srv_count++;
+		}
+	}
+
+	link->discoveries_count = db_discovery->num_registered_uuids;
+
+	discovery_complete(db_discovery, link);
+}
 
+static uint32_t db_hash_read(struct ble_db_discovery *db_discovery,
+			     struct ble_db_discovery_link *link)
+{
+	uint32_t nrf_err;
 	struct ble_gq_req req = {
-		.type = BLE_GQ_REQ_SRV_DISCOVERY,
+		.type = BLE_GQ_REQ_GATTC_READ_BY_UUID,
 		.evt_handler = discovery_gq_event_handler,
 		.ctx = db_discovery,
-		.gattc_srv_disc = {
-			.srvc_uuid = srv_being_discovered->srv_uuid,
-			.start_handle = CONFIG_BLE_DB_DISCOVERY_SRV_DISC_START_HANDLE,
+		.gattc_read_by_uuid = {
+			.uuid = {
+				.uuid = BLE_UUID_DATABASE_HASH_CHAR,
+				.type = BLE_UUID_TYPE_BLE,
+			},
+			.handle_range = {
+				.start_handle = 0x0001,
+				.end_handle = 0xFFFF,
+			},
 		},
 	};
 
-	nrf_err = ble_gq_item_add(db_discovery->gatt_queue, &req, conn_handle);
+	nrf_err = ble_gq_item_add(db_discovery->gatt_queue, &req, link->conn_handle);
+	if (nrf_err) {
+		return nrf_err;
+	}
+
+	link->db_hash_pending = true;
+
+	return NRF_SUCCESS;
+}
+
+static void on_db_hash_read_rsp(struct ble_db_discovery *db_discovery,
+				const ble_gattc_evt_t *gattc_evt)
+{
+	uint32_t nrf_err;
+	struct ble_db_discovery_link *const link =
+		discovering_link_get(db_discovery, gattc_evt->conn_handle);
+	const ble_gattc_evt_char_val_by_uuid_read_rsp_t *const rsp =
+		&(gattc_evt->params.char_val_by_uuid_read_rsp);
+	/* The Handle-Value list holds the handle of the characteristic value, then the value. */
+	const uint8_t *const db_hash = &rsp->handle_value[sizeof(uint16_t)];
+
+	if (!link || !link->db_hash_pending) {
+		return;
+	}
+
+	link->db_hash_pending = false;
+
+	if ((gattc_evt->gatt_status == BLE_GATT_STATUS_SUCCESS) && (rsp->count == 1) &&
+	    (rsp->value_len == BLE_DB_DISCOVERY_DB_HASH_LEN)) {
+		if (link->cache_loaded && (memcmp(db_hash, db_hash_get(db_discovery, link),
+						  BLE_DB_DISCOVERY_DB_HASH_LEN) == 0)) {
+			LOG_DBG("Database Hash unchanged, restoring services on connection "
+				"handle %#x", gattc_evt->conn_handle);
+
+			cache_restore(db_discovery, link);
+			return;
+		}
+
+		memcpy(db_hash_get(db_discovery, link), db_hash, BLE_DB_DISCOVERY_DB_HASH_LEN);
+		link->db_hash_valid = true;
+	} else {
+		LOG_DBG("No Database Hash on connection handle %#x", gattc_evt->conn_handle);
+	}
+
+	nrf_err = srv_discover(db_discovery, link);
 	if (nrf_err) {
-		discovery_error_handler(conn_handle, nrf_err, db_discovery);
+		discovery_error_handler(db_discovery, link, nrf_err);
+	}
+}
+#endif /* CONFIG_BLE_DB_DISCOVERY_CACHE */
+
+static void on_srv_disc_completion(struct ble_db_discovery *db_discovery,
+				   struct ble_db_discovery_link *link)
+{
+	uint32_t nrf_err;
+
+	link->discoveries_count++;
+
+	/* Check if this was the last service to be discovered. */
+	if (link->discoveries_count >= db_discovery->num_registered_uuids) {
+		/* No more services need to be discovered. */
+		discovery_complete(db_discovery, link);
+		return;
+	}
+
+	/* More services need to be discovered. */
+
+	/* Reset the current characteristic index. A new service discovery is about to start. */
+	link->curr_char_idx = 0;
+
+	/* Initiate discovery of the next service. */
+	link->curr_srv_idx++;
+
+	nrf_err = srv_discover(db_discovery, link);
+	if (nrf_err) {
+		discovery_error_handler(db_discovery, link, nrf_err);
 	}
 }
 
@@ -250,19 +610,20 @@ static bool is_desc_discovery_required(struct ble_gatt_db_srv *curr_srv,
 }
 
 static uint32_t characteristics_discover(struct ble_db_discovery *db_discovery,
-					 uint16_t conn_handle)
+					 struct ble_db_discovery_link *link)
 {
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
+	struct ble_gatt_db_srv *const srv_being_discovered =
+		curr_discovered_srv_get(db_discovery, link);
 	ble_gattc_handle_range_t handle_range = {
 		.end_handle = srv_being_discovered->handle_range.end_handle,
 	};
 
-	if (db_discovery->curr_char_idx != 0) {
+	if (link->curr_char_idx != 0) {
 		/* This is not the first characteristic being discovered. Hence the 'start handle'
 		 * to be used must be computed using the handle_value of the previous
 		 * characteristic.
 		 */
-		const uint8_t prev_char_idx = db_discovery->curr_char_idx - 1;
+		const uint8_t prev_char_idx = link->curr_char_idx - 1;
 		ble_gattc_char_t *const prev_char =
 			&(srv_being_discovered->characteristics[prev_char_idx].characteristic);
 
@@ -279,20 +640,22 @@ static uint32_t characteristics_discover(struct ble_db_discovery *db_discovery,
 		.gattc_char_disc = handle_range,
 	};
 
-	return ble_gq_item_add(db_discovery->gatt_queue, &req, conn_handle);
+	return ble_gq_item_add(db_discovery->gatt_queue, &req, link->conn_handle);
 }
 
 static uint32_t descriptors_discover(struct ble_db_discovery *db_discovery,
-				     bool *raise_discovery_complete, uint16_t conn_handle)
+				     struct ble_db_discovery_link *link,
+				     bool *raise_discovery_complete)
 {
 	ble_gattc_handle_range_t handle_range;
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
+	struct ble_gatt_db_srv *const srv_being_discovered =
+		curr_discovered_srv_get(db_discovery, link);
 	struct ble_gatt_db_char *curr_char_being_discovered =
-		&(srv_being_discovered->characteristics[db_discovery->curr_char_idx]);
+		&(srv_being_discovered->characteristics[link->curr_char_idx]);
 	struct ble_gatt_db_char *next_char;
 	bool is_descriptor_discovery_required = false;
 
-	for (uint8_t i = db_discovery->curr_char_idx; i < srv_being_discovered->char_count; i++) {
+	for (uint8_t i = link->curr_char_idx; i < srv_being_discovered->char_count; i++) {
 		if (i == (srv_being_discovered->char_count - 1)) {
 			/* The current characteristic is the last characteristic in the service. */
 			next_char = NULL;
@@ -309,7 +672,7 @@ static uint32_t descriptors_discover(struct ble_db_discovery *db_discovery,
 
 		/* No descriptors can exist. */
 		curr_char_being_discovered = next_char;
-		db_discovery->curr_char_idx++;
+		link->curr_char_idx++;
 	}
 
 	if (!is_descriptor_discovery_required) {
@@ -330,26 +693,29 @@ static uint32_t descriptors_discover(struct ble_db_discovery *db_discovery,
 		.gattc_desc_disc = handle_range,
 	};
 
-	return ble_gq_item_add(db_discovery->gatt_queue, &req, conn_handle);
+	return ble_gq_item_add(db_discovery->gatt_queue, &req, link->conn_handle);
 }
 
 static void on_primary_srv_discovery_rsp(struct ble_db_discovery *db_discovery,
 					 const ble_gattc_evt_t *gattc_evt)
 {
 	uint32_t nrf_err;
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
+	struct ble_db_discovery_link *const link =
+		discovering_link_get(db_discovery, gattc_evt->conn_handle);
+	struct ble_gatt_db_srv *srv_being_discovered;
 
-	if (gattc_evt->conn_handle != db_discovery->conn_handle) {
+	if (!link) {
 		return;
 	}
 
+	srv_being_discovered = curr_discovered_srv_get(db_discovery, link);
+
 	/* Check if service was found or not. */
 	if (gattc_evt->gatt_status != BLE_GATT_STATUS_SUCCESS) {
 		/* Service was not found. */
 		LOG_DBG("Service with UUID %#x not found", srv_being_discovered->srv_uuid.uuid);
 
-		discovery_complete_evt_trigger(db_discovery, false, gattc_evt->conn_handle);
-		on_srv_disc_completion(db_discovery, gattc_evt->conn_handle);
+		on_srv_disc_completion(db_discovery, link);
 		return;
 	}
 
@@ -362,24 +728,24 @@ static void on_primary_srv_discovery_rsp(struct ble_db_discovery *db_discovery,
 	srv_being_discovered->handle_range = prim_srvc_disc_rsp_evt->services[0].handle_range;
 
 	/* Number of services previously discovered. */
-	const uint8_t prev_srv_disc_num = db_discovery->srv_count;
+	const uint8_t prev_srv_disc_num = link->srv_count;
 
 	/* Number of new services discovered. */
 	const uint8_t new_srv_disc_num = prim_srvc_disc_rsp_evt->count;
 
 	if ((prev_srv_disc_num + new_srv_disc_num) <= CONFIG_BLE_DB_DISCOVERY_MAX_SRV) {
-		db_discovery->srv_count += new_srv_disc_num;
+		link->srv_count += new_srv_disc_num;
 	} else {
-		db_discovery->srv_count = CONFIG_BLE_DB_DISCOVERY_MAX_SRV;
+		link->srv_count = CONFIG_BLE_DB_DISCOVERY_MAX_SRV;
 
 		LOG_WRN("Not enough space for services");
 		LOG_WRN("Increase CONFIG_BLE_DB_DISCOVERY_MAX_SRV to be able to store more "
 			"services!");
 	}
 
-	nrf_err = characteristics_discover(db_discovery, gattc_evt->conn_handle);
+	nrf_err = characteristics_discover(db_discovery, link);
 	if (nrf_err) {
-		discovery_error_handler(gattc_evt->conn_handle, nrf_err, db_discovery);
+		discovery_error_handler(db_discovery, link, nrf_err);
 	}
 }
 
@@ -387,12 +753,16 @@ static void on_characteristic_discovery_rsp(struct ble_db_discovery *db_discover
 					    const ble_gattc_evt_t *gattc_evt)
 {
 	uint32_t nrf_err;
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
+	struct ble_db_discovery_link *const link =
+		discovering_link_get(db_discovery, gattc_evt->conn_handle);
+	struct ble_gatt_db_srv *srv_being_discovered;
 
-	if (gattc_evt->conn_handle != db_discovery->conn_handle) {
+	if (!link) {
 		return;
 	}
 
+	srv_being_discovered = curr_discovered_srv_get(db_discovery, link);
+
 	if (gattc_evt->gatt_status != BLE_GATT_STATUS_SUCCESS) {
 		/* The previous characteristic discovery resulted in no characteristics.
 		 * descriptor discovery should be performed.
@@ -448,12 +818,12 @@ static void on_characteristic_discovery_rsp(struct ble_db_discovery *db_discover
 	if (is_char_discovery_required(srv_being_discovered, last_known_char) &&
 	    (srv_being_discovered->char_count != CONFIG_BLE_GATT_DB_MAX_CHARS)) {
 		/* Update the current characteristic index. */
-		db_discovery->curr_char_idx = srv_being_discovered->char_count;
+		link->curr_char_idx = srv_being_discovered->char_count;
 
 		/* Perform another round of characteristic discovery. */
-		nrf_err = characteristics_discover(db_discovery, gattc_evt->conn_handle);
+		nrf_err = characteristics_discover(db_discovery, link);
 		if (nrf_err) {
-			discovery_error_handler(gattc_evt->conn_handle, nrf_err, db_discovery);
+			discovery_error_handler(db_discovery, link, nrf_err);
 		}
 
 		return;
@@ -462,12 +832,11 @@ static void on_characteristic_discovery_rsp(struct ble_db_discovery *db_discover
 perform_descriptor_discovery:
 	bool raise_discovery_complete;
 
-	db_discovery->curr_char_idx = 0;
+	link->curr_char_idx = 0;
 
-	nrf_err = descriptors_discover(db_discovery, &raise_discovery_complete,
-				       gattc_evt->conn_handle);
+	nrf_err = descriptors_discover(db_discovery, link, &raise_discovery_complete);
 	if (nrf_err) {
-		discovery_error_handler(gattc_evt->conn_handle, nrf_err, db_discovery);
+		discovery_error_handler(db_discovery, link, nrf_err);
 		return;
 	}
 
@@ -478,8 +847,7 @@ perform_descriptor_discovery:
 		LOG_DBG("Discovery of service with UUID %#x completed with success on connection "
 			"handle %#x", srv_being_discovered->srv_uuid.uuid, gattc_evt->conn_handle);
 
-		discovery_complete_evt_trigger(db_discovery, true, gattc_evt->conn_handle);
-		on_srv_disc_completion(db_discovery, gattc_evt->conn_handle);
+		on_srv_disc_completion(db_discovery, link);
 	}
 }
 
@@ -487,15 +855,19 @@ static void on_descriptor_discovery_rsp(struct ble_db_discovery *const db_discov
 					const ble_gattc_evt_t *const gattc_evt)
 {
 	const ble_gattc_evt_desc_disc_rsp_t *const evt = &(gattc_evt->params.desc_disc_rsp);
-	struct ble_gatt_db_srv *const srv_being_discovered = curr_discovered_srv_get(db_discovery);
-	struct ble_gatt_db_char *const char_being_discovered =
-		&(srv_being_discovered->characteristics[db_discovery->curr_char_idx]);
+	struct ble_db_discovery_link *const link =
+		discovering_link_get(db_discovery, gattc_evt->conn_handle);
+	struct ble_gatt_db_srv *srv_being_discovered;
+	struct ble_gatt_db_char *char_being_discovered;
 	bool raise_discovery_complete = false;
 
-	if (gattc_evt->conn_handle != db_discovery->conn_handle) {
+	if (!link) {
 		return;
 	}
 
+	srv_being_discovered = curr_discovered_srv_get(db_discovery, link);
+	char_being_discovered = &(srv_being_discovered->characteristics[link->curr_char_idx]);
+
 	if (gattc_evt->gatt_status == BLE_GATT_STATUS_SUCCESS) {
 		/* The descriptor was found at the peer. Iterate through and collect CCCD,
 		 * Extended Properties, User Description & Report Reference descriptor handles.
@@ -526,7 +898,7 @@ static void on_descriptor_discovery_rsp(struct ble_db_discovery *const db_discov
 		}
 	}
 
-	if ((db_discovery->curr_char_idx + 1) == srv_being_discovered->char_count) {
+	if ((link->curr_char_idx + 1) == srv_being_discovered->char_count) {
 		/* No more characteristics and descriptors need to be discovered. Discovery is
 		 * complete. Send a discovery complete event to the user application.
 		 */
@@ -535,12 +907,11 @@ static void on_descriptor_discovery_rsp(struct ble_db_discovery *const db_discov
 		/* Begin discovery of descriptors for the next characteristic. */
 		uint32_t nrf_err;
 
-		db_discovery->curr_char_idx++;
+		link->curr_char_idx++;
 
-		nrf_err = descriptors_discover(db_discovery, &raise_discovery_complete,
-					       gattc_evt->conn_handle);
+		nrf_err = descriptors_discover(db_discovery, link, &raise_discovery_complete);
 		if (nrf_err) {
-			discovery_error_handler(gattc_evt->conn_handle, nrf_err, db_discovery);
+			discovery_error_handler(db_discovery, link, nrf_err);
 			return;
 		}
 	}
@@ -549,51 +920,62 @@ static void on_descriptor_discovery_rsp(struct ble_db_discovery *const db_discov
 		LOG_DBG("Discovery of service with UUID %#x completed with success on connection "
 			"handle %#x", srv_being_discovered->srv_uuid.uuid, gattc_evt->conn_handle);
 
-		discovery_complete_evt_trigger(db_discovery, true, gattc_evt->conn_handle);
-		on_srv_disc_completion(db_discovery, gattc_evt->conn_handle);
+		on_srv_disc_completion(db_discovery, link);
 	}
 }
 
-static uint32_t discovery_start(struct ble_db_discovery *const db_discovery, uint16_t conn_handle)
+static uint32_t discovery_start(struct ble_db_discovery *const db_discovery,
+			       struct ble_db_discovery_link *link, uint16_t conn_handle)
 {
 	int nrf_err;
-	struct ble_gatt_db_srv *srv_being_discovered;
+	uint32_t srv_rec_count = db_discovery->num_registered_uuids;
 
 	nrf_err = ble_gq_conn_handle_register(db_discovery->gatt_queue, conn_handle);
 	if (nrf_err) {
 		return nrf_err;
 	}
 
-	db_discovery->srv_count = 0;
-	db_discovery->curr_char_idx = 0;
-	db_discovery->curr_srv_idx = 0;
-	db_discovery->discoveries_count = 0;
-	db_discovery->conn_handle = conn_handle;
-	db_discovery->pending_usr_evt_idx = 0;
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	const uint16_t peer_id = bonded_peer_id_get(conn_handle);
 
-	srv_being_discovered = curr_discovered_srv_get(db_discovery);
-	srv_being_discovered->srv_uuid = db_discovery->registered_uuids[db_discovery->curr_srv_idx];
-	srv_being_discovered->char_count = 0;
+	/* The Database Hash of a bonded peer is kept in the record after the services. */
+	srv_rec_count = srv_recs_count(db_discovery, (peer_id != PM_PEER_ID_INVALID));
+#endif
 
-	LOG_DBG("Starting discovery of service with UUID %#x on connection handle %#x",
-		srv_being_discovered->srv_uuid.uuid, conn_handle);
+	if (!srv_recs_alloc(db_discovery, link, srv_rec_count)) {
+		link_release(link);
+		return NRF_ERROR_NO_MEM;
+	}
 
-	struct ble_gq_req req = {
-		.type = BLE_GQ_REQ_SRV_DISCOVERY,
-		.evt_handler = discovery_gq_event_handler,
-		.ctx = db_discovery,
-		.gattc_srv_disc = {
-			.srvc_uuid = srv_being_discovered->srv_uuid,
-			.start_handle = CONFIG_BLE_DB_DISCOVERY_SRV_DISC_START_HANDLE,
-		},
-	};
+	link->conn_handle = conn_handle;
+	link->srv_count = 0;
+	link->curr_char_idx = 0;
+	link->curr_srv_idx = 0;
+	link->discoveries_count = 0;
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	link->cache_loaded = false;
+	link->db_hash_valid = false;
 
-	nrf_err = ble_gq_item_add(db_discovery->gatt_queue, &req, conn_handle);
+	if (peer_id != PM_PEER_ID_INVALID) {
+		/* The Database Hash validates the cached services, or is stored with the services
+		 * that are about to be discovered.
+		 */
+		link->cache_loaded = cache_load(db_discovery, link, peer_id);
+
+		nrf_err = db_hash_read(db_discovery, link);
+	} else {
+		nrf_err = srv_discover(db_discovery, link);
+	}
+#else
+	nrf_err = srv_discover(db_discovery, link);
+#endif
 	if (nrf_err) {
+		link_release(link);
 		return nrf_err;
 	}
 
-	db_discovery->discovery_in_progress = true;
+	link->discovery_in_progress = true;
 
 	return NRF_SUCCESS;
 }
@@ -609,11 +991,23 @@ uint32_t ble_db_discovery_init(struct ble_db_discovery *db_discovery,
 	db_discovery->evt_handler = db_config->evt_handler;
 	db_discovery->gatt_queue = db_config->gatt_queue;
 
+	for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->links); i++) {
+		link_release(&db_discovery->links[i]);
+	}
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->cache_stores); i++) {
+		db_discovery->cache_stores[i].srv_rec_count = 0;
+	}
+#endif
+
 	return NRF_SUCCESS;
 }
 
 uint32_t ble_db_discovery_start(struct ble_db_discovery *db_discovery, uint16_t conn_handle)
 {
+	struct ble_db_discovery_link *link;
+
 	if (!db_discovery) {
 		return NRF_ERROR_NULL;
 	}
@@ -626,11 +1020,12 @@ uint32_t ble_db_discovery_start(struct ble_db_discovery *db_discovery, uint16_t
 		return NRF_ERROR_INVALID_STATE;
 	}
 
-	if (db_discovery->discovery_in_progress) {
+	link = link_alloc(db_discovery, conn_handle);
+	if (!link || link->discovery_in_progress) {
 		return NRF_ERROR_BUSY;
 	}
 
-	return discovery_start(db_discovery, conn_handle);
+	return discovery_start(db_discovery, link, conn_handle);
 }
 
 uint32_t ble_db_discovery_service_register(struct ble_db_discovery *db_discovery,
@@ -648,9 +1043,10 @@ uint32_t ble_db_discovery_service_register(struct ble_db_discovery *db_discovery
 
 static void on_disconnected(struct ble_db_discovery *db_discovery, const ble_gap_evt_t *evt)
 {
-	if (evt->conn_handle == db_discovery->conn_handle) {
-		db_discovery->discovery_in_progress = false;
-		db_discovery->conn_handle = BLE_CONN_HANDLE_INVALID;
+	struct ble_db_discovery_link *const link = link_get(db_discovery, evt->conn_handle);
+
+	if (link) {
+		link_release(link);
 	}
 }
 
@@ -678,6 +1074,12 @@ void ble_db_discovery_on_ble_evt(const ble_evt_t *ble_evt, void *ble_db_discover
 		on_descriptor_discovery_rsp(db_discovery, &(ble_evt->evt.gattc_evt));
 		break;
 
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	case BLE_GATTC_EVT_CHAR_VAL_BY_UUID_READ_RSP:
+		on_db_hash_read_rsp(db_discovery, &(ble_evt->evt.gattc_evt));
+		break;
+#endif
+
 	case BLE_GAP_EVT_DISCONNECTED:
 		on_disconnected(db_discovery, &(ble_evt->evt.gap_evt));
 		break;
@@ -686,3 +1088,42 @@ void ble_db_discovery_on_ble_evt(const ble_evt_t *ble_evt, void *ble_db_discover
 		break;
 	}
 }
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+void ble_db_discovery_on_pm_evt(struct ble_db_discovery *db_discovery,
+				const struct pm_evt *pm_evt)
+{
+	__ASSERT(db_discovery, "db_discovery is NULL");
+	__ASSERT(pm_evt, "pm_evt is NULL");
+
+	enum pm_peer_data_id data_id;
+
+	switch (pm_evt->evt_id) {
+	case PM_EVT_PEER_DATA_UPDATE_SUCCEEDED:
+		data_id = pm_evt->peer_data_update_succeeded.data_id;
+		break;
+
+	case PM_EVT_PEER_DATA_UPDATE_FAILED:
+		data_id = pm_evt->peer_data_update_failed.data_id;
+		break;
+
+	default:
+		return;
+	}
+
+	if (data_id != PM_PEER_DATA_ID_GATT_REMOTE) {
+		return;
+	}
+
+	/* The store is matched on the peer rather than on its token, as the event can be sent
+	 * before pm_peer_data_store() returns the token.
+	 */
+	for (uint32_t i = 0; i < ARRAY_SIZE(db_discovery->cache_stores); i++) {
+		struct ble_db_discovery_cache_store *store = &db_discovery->cache_stores[i];
+
+		if ((store->srv_rec_count != 0) && (store->peer_id == pm_evt->peer_id)) {
+			store->srv_rec_count = 0;
+		}
+	}
+}
+#endif
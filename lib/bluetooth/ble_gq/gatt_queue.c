@@ -18,10 +18,41 @@
 
 LOG_MODULE_REGISTER(ble_gatt_queue, CONFIG_BLE_GQ_LOG_LEVEL);
 
+/* A request block, with room for the data of short requests. */
+struct req_block {
+	struct ble_gq_req req;
+	uint8_t data[sizeof(uint16_t) + CONFIG_BLE_GQ_INLINE_DATA_SIZE] __aligned(sizeof(uint16_t));
+};
+
+BUILD_ASSERT(sizeof(struct req_block) <= BLE_GQ_REQ_BLOCK_SIZE);
+
+/* Get memory for the data of a request, in its request block if the data fits. */
+static uint8_t *req_data_alloc(struct k_heap *data_pool, struct ble_gq_req *req_buf, size_t len)
+{
+	struct req_block *block = CONTAINER_OF(req_buf, struct req_block, req);
+
+	if (len <= sizeof(block->data)) {
+		return block->data;
+	}
+
+	return k_heap_aligned_alloc(data_pool, sizeof(void *), len, K_NO_WAIT);
+}
+
+/* Free the data of a request, unless it is stored in the request block. */
+static void req_data_free(struct k_heap *data_pool, struct ble_gq_req *req)
+{
+	struct req_block *block = CONTAINER_OF(req, struct req_block, req);
+
+	if (req->data != block->data) {
+		LOG_DBG("Freeing heap memory with addr %#lx", (uintptr_t)req->data);
+		k_heap_free(data_pool, req->data);
+	}
+}
+
 /* Function prototype for preparing a request for storage.
  *
  * Functions of this type should:
- * 1. Allocate memory for additional request data.
+ * 1. Get memory for additional request data, in the request block or the data pool.
  * 2. Copy request to the storage buffer.
  *
  * data_pool  Memory pool for storing additional request data.
@@ -42,15 +73,13 @@ static uint32_t gattc_write_store(struct k_heap *data_pool, const struct ble_gq_
 	const ble_gattc_write_params_t *const gattc_write = &req->gattc_write;
 	uint8_t *data;
 
-	/* Allocate additional memory for GATTC write request data. */
-	data = k_heap_aligned_alloc(data_pool, sizeof(void *), gattc_write->len, K_NO_WAIT);
+	/* Get additional memory for GATTC write request data. */
+	data = req_data_alloc(data_pool, req_buf, gattc_write->len);
 	if (data == NULL) {
 		return NRF_ERROR_NO_MEM;
 	}
 
-	LOG_DBG("Allocated heap memory with addr %#lx", (uintptr_t)data);
-
-	/* Copy relevant data to the allocated heap space. */
+	/* Copy relevant data to the allocated space. */
 	memcpy(data, (void *)gattc_write->p_value, gattc_write->len);
 
 	/* Copy request to storage. */
@@ -70,16 +99,13 @@ static uint32_t gatts_hvx_store(struct k_heap *data_pool, const struct ble_gq_re
 	const ble_gatts_hvx_params_t *const gatts_hvx = &req->gatts_hvx;
 	uint8_t *data;
 
-	/* Allocate additional memory for GATTS notification or indication request data. */
-	data = k_heap_aligned_alloc(data_pool, sizeof(void *), *gatts_hvx->p_len + sizeof(uint16_t),
-				    K_NO_WAIT);
+	/* Get additional memory for GATTS notification or indication request data. */
+	data = req_data_alloc(data_pool, req_buf, *gatts_hvx->p_len + sizeof(uint16_t));
 	if (data == NULL) {
 		return NRF_ERROR_NO_MEM;
 	}
 
-	LOG_DBG("Allocated heap memory with addr %#lx", (uintptr_t)data);
-
-	/* Copy relevant data to the allocated heap space. */
+	/* Copy relevant data to the allocated space. */
 	memcpy(&data[0], (void *)gatts_hvx->p_len, sizeof(uint16_t));
 	memcpy(&data[sizeof(uint16_t)], (void *)gatts_hvx->p_data, *gatts_hvx->p_len);
 
@@ -97,6 +123,7 @@ static uint32_t gatts_hvx_store(struct k_heap *data_pool, const struct ble_gq_re
 /* Array of memory store functions for different GATT request types. */
 static const req_data_store_t req_data_store[BLE_GQ_REQ_NUM] = {
 	[BLE_GQ_REQ_GATTC_READ] = NULL,
+	[BLE_GQ_REQ_GATTC_READ_BY_UUID] = NULL,
 	[BLE_GQ_REQ_GATTC_WRITE] = gattc_write_store,
 	[BLE_GQ_REQ_SRV_DISCOVERY] = NULL,
 	[BLE_GQ_REQ_CHAR_DISCOVERY] = NULL,
@@ -125,9 +152,63 @@ static void request_error_handle(const struct ble_gq_req *req, uint16_t conn_han
 	}
 }
 
+/* Get the TX credits used by a request, or NULL if the request is not put in a TX queue
+ * of the SoftDevice.
+ */
+static struct ble_gq_tx_credits *tx_credits_get(const struct ble_gq *gq,
+						const struct ble_gq_req *req, uint16_t conn_id)
+{
+	switch (req->type) {
+	case BLE_GQ_REQ_GATTC_WRITE:
+		if (req->gattc_write.write_op == BLE_GATT_OP_WRITE_CMD) {
+			return &gq->conn_tx[conn_id].write_cmd;
+		}
+		break;
+	case BLE_GQ_REQ_GATTS_HVX:
+		if (req->gatts_hvx.type == BLE_GATT_HVX_NOTIFICATION) {
+			return &gq->conn_tx[conn_id].hvn;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return NULL;
+}
+
+static bool tx_credit_available(const struct ble_gq_tx_credits *tx)
+{
+	/* Once the countdown has elapsed, a packet is submitted past the known size to probe it. */
+	return (tx == NULL) || (tx->size == 0) || (tx->queued < tx->size) ||
+	       (tx->probe_countdown == 0);
+}
+
+static void tx_credit_take(struct ble_gq_tx_credits *tx)
+{
+	if (tx != NULL && tx->queued < UINT8_MAX) {
+		tx->queued++;
+
+		/* A probe was accepted, the TX queue holds more packets than known. */
+		if (tx->size != 0 && tx->queued > tx->size) {
+			tx->size = tx->queued;
+		}
+	}
+}
+
+static void tx_credits_return(struct ble_gq_tx_credits *tx, uint8_t count)
+{
+	tx->queued -= MIN(count, tx->queued);
+
+	if (tx->probe_countdown > 0) {
+		tx->probe_countdown--;
+	}
+}
+
 /* Process a single GATT request. */
-static bool request_process(const struct ble_gq_req *req, uint16_t conn_handle)
+static bool request_process(const struct ble_gq *gq, const struct ble_gq_req *req,
+			    uint16_t conn_handle, uint16_t conn_id)
 {
+	struct ble_gq_tx_credits *const tx = tx_credits_get(gq, req, conn_id);
 	uint32_t nrf_err;
 	uint16_t len;
 
@@ -137,9 +218,18 @@ static bool request_process(const struct ble_gq_req *req, uint16_t conn_handle)
 		nrf_err = sd_ble_gattc_read(conn_handle, req->gattc_read.handle,
 					    req->gattc_read.offset);
 		break;
+	case BLE_GQ_REQ_GATTC_READ_BY_UUID:
+		LOG_DBG("GATTC read using characteristic UUID request");
+		nrf_err = sd_ble_gattc_char_value_by_uuid_read(conn_handle,
+							       &req->gattc_read_by_uuid.uuid,
+							       &req->gattc_read_by_uuid.handle_range);
+		break;
 	case BLE_GQ_REQ_GATTC_WRITE:
 		LOG_DBG("GATTC write request");
 		nrf_err = sd_ble_gattc_write(conn_handle, &req->gattc_write);
+		if (nrf_err == NRF_SUCCESS) {
+			tx_credit_take(tx);
+		}
 		break;
 	case BLE_GQ_REQ_SRV_DISCOVERY:
 		LOG_DBG("GATTC primary services discovery request");
@@ -165,8 +255,11 @@ static bool request_process(const struct ble_gq_req *req, uint16_t conn_handle)
 		}
 		len = *(req->gatts_hvx.p_len);
 		nrf_err = sd_ble_gatts_hvx(conn_handle, &req->gatts_hvx);
-		if (nrf_err == NRF_SUCCESS && len != *(req->gatts_hvx.p_len)) {
-			nrf_err = NRF_ERROR_DATA_SIZE;
+		if (nrf_err == NRF_SUCCESS) {
+			tx_credit_take(tx);
+			if (len != *(req->gatts_hvx.p_len)) {
+				nrf_err = NRF_ERROR_DATA_SIZE;
+			}
 		}
 		break;
 	default:
@@ -182,45 +275,56 @@ static bool request_process(const struct ble_gq_req *req, uint16_t conn_handle)
 		return false;
 	}
 
+	if (nrf_err == NRF_ERROR_RESOURCES && tx != NULL) {
+		/* The TX queue is full. It holds the packets queued so far, stop submitting
+		 * until some of them are transmitted.
+		 */
+		tx->size = MAX(tx->queued, 1);
+		tx->probe_countdown = CONFIG_BLE_GQ_TX_PROBE_INTERVAL;
+		LOG_DBG("SD TX queue is full with %d packets.", tx->size);
+
+		return false;
+	}
+
 	request_error_handle(req, conn_handle, nrf_err);
 
 	/* Request was accepted by SoftDevice. */
 	return true;
 }
 
-/* Process a request from the GATT queue instance. */
+/* Process requests from the GATT queue instance, until the SoftDevice cannot take more. */
 static void queue_process(const struct ble_gq *gq, uint16_t conn_handle, uint16_t conn_id)
 {
 	sys_snode_t *elem;
 	struct ble_gq_req *req;
 
-	elem = sys_slist_peek_head(&gq->req_queue[conn_id]);
-	if (elem == NULL) {
-		/* Queue is empty */
-		return;
-	}
+	while ((elem = sys_slist_peek_head(&gq->req_queue[conn_id])) != NULL) {
+		req = CONTAINER_OF(elem, struct ble_gq_req, node);
 
-	req = CONTAINER_OF(elem, struct ble_gq_req, node);
+		if (!tx_credit_available(tx_credits_get(gq, req, conn_id))) {
+			/* Wait for the TX queue to have room, the request is not submitted. */
+			return;
+		}
 
-	const bool req_processed = request_process(req, conn_handle);
+		const bool req_processed = request_process(gq, req, conn_handle, conn_id);
 
-	if (!req_processed) {
-		return;
-	}
+		if (!req_processed) {
+			return;
+		}
 
-	/* Peeking was successful above. Queue should have at least one element.
-	 * The first element is already known. Dequeue it.
-	 */
-	(void)sys_slist_get_not_empty(&gq->req_queue[conn_id]);
+		/* Peeking was successful above. Queue should have at least one element.
+		 * The first element is already known. Dequeue it.
+		 */
+		(void)sys_slist_get_not_empty(&gq->req_queue[conn_id]);
 
-	/* Clear any additional data associated with the request. */
-	if (req->type >= BLE_GQ_REQ_NUM || req_data_store[req->type] != NULL) {
-		LOG_DBG("Freeing heap memory with addr %#lx", (uintptr_t)req->data);
-		k_heap_free(gq->data_pool, req->data);
-	}
+		/* Clear any additional data associated with the request. */
+		if (req->type >= BLE_GQ_REQ_NUM || req_data_store[req->type] != NULL) {
+			req_data_free(gq->data_pool, req);
+		}
 
-	/* Release the memory block back to its associated memory slab. */
-	k_mem_slab_free(gq->req_blocks, req);
+		/* Release the memory block back to its associated memory slab. */
+		k_mem_slab_free(gq->req_blocks, req);
+	}
 }
 
 /* Clear all requests from the queue identified by the conn_id. */
@@ -241,8 +345,7 @@ static void req_queue_clear(const struct ble_gq *gq, uint16_t conn_id)
 
 		/* Clear any additional data associated with the request. */
 		if (req_data_store[req->type] != NULL) {
-			LOG_DBG("Freeing heap memory with addr %#lx", (uintptr_t)req->data);
-			k_heap_free(gq->data_pool, req->data);
+			req_data_free(gq->data_pool, req);
 		}
 
 		/* Release the memory block back to its associated memory slab. */
@@ -323,6 +426,7 @@ static uint32_t conn_handle_register(const struct ble_gq *gq, uint16_t conn_hand
 	}
 
 	gq->conn_handles[unused_id] = conn_handle;
+	gq->conn_tx[unused_id] = (struct ble_gq_conn_tx){0};
 	return NRF_SUCCESS;
 }
 
@@ -347,8 +451,9 @@ uint32_t ble_gq_item_add(const struct ble_gq *gq, struct ble_gq_req *req, uint16
 	}
 
 	/* Try processing a request without buffering. */
-	if (sys_slist_is_empty(&gq->req_queue[conn_id])) {
-		const bool req_processed = request_process(req, conn_handle);
+	if (sys_slist_is_empty(&gq->req_queue[conn_id]) &&
+	    tx_credit_available(tx_credits_get(gq, req, conn_id))) {
+		const bool req_processed = request_process(gq, req, conn_handle, conn_id);
 
 		if (req_processed) {
 			return NRF_SUCCESS;
@@ -442,6 +547,14 @@ void ble_gq_on_ble_evt(const ble_evt_t *ble_evt, void *ble_gq)
 		/* Signal a purge of the request queue on a disconnect event. */
 		req_queue_purge_schedule(gq, conn_id);
 	} else {
+		if (ble_evt->header.evt_id == BLE_GATTS_EVT_HVN_TX_COMPLETE) {
+			tx_credits_return(&gq->conn_tx[conn_id].hvn,
+					  ble_evt->evt.gatts_evt.params.hvn_tx_complete.count);
+		} else if (ble_evt->header.evt_id == BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE) {
+			tx_credits_return(&gq->conn_tx[conn_id].write_cmd,
+					  ble_evt->evt.gattc_evt.params.write_cmd_tx_complete.count);
+		}
+
 		/* Check if SoftDevice is still busy. */
 		queue_process(gq, conn_handle, conn_id);
 	}
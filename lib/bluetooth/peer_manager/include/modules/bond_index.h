@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @defgroup bond_index Bond Index
+ * @ingroup peer_manager
+ * @{
+ * @brief An internal module of @ref peer_manager. This module keeps a copy of the identification
+ *        keys of the bonded peers in RAM, so that peers can be identified without reading the
+ *        bonding data from persistent storage.
+ *
+ * @details The index is filled by @ref peer_data_storage when the stored bonds are loaded, and it
+ *          is kept up to date when bonding data is stored or deleted. The index holds at most
+ *          @c CONFIG_PM_BOND_INDEX_SIZE bonds. When more bonds are stored, the index is marked as
+ *          incomplete and users must fall back to searching persistent storage for the bonds
+ *          that are not found in the index.
+ */
+
+#ifndef BOND_INDEX_H__
+#define BOND_INDEX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_gap.h>
+#include <bm/bluetooth/peer_manager/peer_manager_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The identification keys of a bonded peer. */
+struct bond_index_entry {
+	/** @brief The peer ID of the bond. */
+	uint16_t peer_id;
+	/** @brief The peer's identity address and IRK. */
+	ble_gap_id_key_t peer_ble_id;
+	/** @brief The master ID of the LTK distributed by the local device. */
+	ble_gap_master_id_t own_master_id;
+	/** @brief The master ID of the LTK distributed by the peer. */
+	ble_gap_master_id_t peer_master_id;
+};
+
+/** @brief Function for initializing the module. The index is empty and complete afterwards. */
+void bond_index_init(void);
+
+/**
+ * @brief Function for filling an index entry from bonding data.
+ *
+ * @param[out] entry         The entry to fill.
+ * @param[in]  peer_id       The peer the bonding data belongs to.
+ * @param[in]  bonding_data  The bonding data.
+ */
+static inline void bond_index_entry_fill(struct bond_index_entry *entry, uint16_t peer_id,
+					 const struct pm_peer_data_bonding *bonding_data)
+{
+	entry->peer_id = peer_id;
+	entry->peer_ble_id = bonding_data->peer_ble_id;
+	entry->own_master_id = bonding_data->own_ltk.master_id;
+	entry->peer_master_id = bonding_data->peer_ltk.master_id;
+}
+
+/**
+ * @brief Function for adding or updating the bond of a peer.
+ *
+ * @note If the index is full, the bond is not added and the index is marked as incomplete.
+ *
+ * @param[in]  peer_id       The peer the bonding data belongs to.
+ * @param[in]  bonding_data  The bonding data of the peer.
+ */
+void bond_index_update(uint16_t peer_id, const struct pm_peer_data_bonding *bonding_data);
+
+/**
+ * @brief Function for removing the bond of a peer from the index.
+ *
+ * @param[in]  peer_id  The peer whose bond to remove.
+ */
+void bond_index_remove(uint16_t peer_id);
+
+/**
+ * @brief Function for finding out whether the index holds all stored bonds.
+ *
+ * @retval  true   All stored bonds are in the index.
+ * @retval  false  The index was full when a bond was added. Bonds that are not found in the index
+ *                 must be searched for in persistent storage.
+ */
+bool bond_index_is_complete(void);
+
+/**
+ * @brief Function for getting the next entry in the index. Can be used to loop through all
+ *        bonds in the index.
+ *
+ * @param[in]  prev  The previous entry, or @c NULL to get the first entry.
+ *
+ * @return  The next entry, or @c NULL if @p prev was the last entry.
+ */
+const struct bond_index_entry *bond_index_next(const struct bond_index_entry *prev);
+
+/**
+ * @brief Function for looking up a resolvable private address among the recently resolved ones.
+ *
+ * @note The cache holds @c CONFIG_PM_RPA_CACHE_SIZE addresses. The addresses of a peer are
+ *       forgotten when the bond of the peer is updated or removed.
+ *
+ * @param[in]  addr  The resolvable private address.
+ *
+ * @return  The peer ID the address was resolved to, or @ref PM_PEER_ID_INVALID if the address
+ *          is not in the cache.
+ */
+uint16_t bond_index_rpa_cache_get(const ble_gap_addr_t *addr);
+
+/**
+ * @brief Function for remembering that a resolvable private address belongs to a peer.
+ *
+ * @details If the cache is full, the least recently used address is replaced.
+ *
+ * @param[in]  addr     The resolvable private address.
+ * @param[in]  peer_id  The peer the address was resolved to.
+ */
+void bond_index_rpa_cache_put(const ble_gap_addr_t *addr, uint16_t peer_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOND_INDEX_H__ */
+
+/** @} */
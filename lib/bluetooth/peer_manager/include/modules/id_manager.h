@@ -50,6 +50,19 @@ uint16_t im_peer_id_get_by_conn_handle(uint16_t conn_handle);
  */
 uint16_t im_peer_id_get_by_master_id(const ble_gap_master_id_t *master_id);
 
+/**
+ * @brief Function for getting the peer ID of the bonded peer that uses an address.
+ *
+ * @details Public and static random addresses are matched against the identity addresses of the
+ *          bonded peers. Resolvable private addresses are resolved against the IRKs of the bonded
+ *          peers. Non-resolvable private addresses never match.
+ *
+ * @param[in]  addr  The address.
+ *
+ * @return The corresponding peer ID, or @ref PM_PEER_ID_INVALID if none could be resolved.
+ */
+uint16_t im_peer_id_get_by_addr(const ble_gap_addr_t *addr);
+
 /**
  * @brief Function for getting the corresponding connection handle from a peer ID.
  *
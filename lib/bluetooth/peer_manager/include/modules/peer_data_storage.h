@@ -18,7 +18,9 @@
 #define PEER_DATA_STORAGE_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <ble_gap.h>
+#include <bm/fs/bm_zms.h>
 #include <bm/bluetooth/peer_manager/peer_manager_types.h>
 #include <modules/peer_manager_internal.h>
 
@@ -60,6 +62,7 @@ uint32_t pds_init(void);
  * @param[in]  data_id   The data to retrieve.
  * @param[out] data      The peer data. May not be @c NULL. data.length and data.data_id
  *                       are ignored. data.all_data is ignored if @p buf_len is @c NULL.
+ *                       On success, data.length is set to the length of the read data.
  * @param[in]  buf_len   Length of the provided buffer, in bytes. Pass @c NULL to only copy
  *                       a pointer to the data in flash.
  *
@@ -72,29 +75,40 @@ uint32_t pds_init(void);
 uint32_t pds_peer_data_read(uint16_t peer_id, enum pm_peer_data_id data_id,
 			    struct pm_peer_data *const data, const uint32_t *const buf_len);
 
+/** @brief Iterator over peer data in flash, see @ref pds_peer_data_iterate. */
+struct pds_peer_data_iter {
+	/** Iterator over the storage entries. */
+	struct bm_zms_iter zms_iter;
+	/** Whether the iteration over the storage entries has started. */
+	bool started;
+};
+
 /**
  * @brief Function to prepare iterating over peer data in flash using @ref pds_peer_data_iterate.
  *        Call this function once each time before iterating using @ref pds_peer_data_iterate.
  *
- * @param[in]  peer_id_iter  The peer ID used for keeping track of the iteration.
+ * @param[in]  iter  The iterator used for keeping track of the iteration.
  */
-void pds_peer_data_iterate_prepare(uint16_t *peer_id_iter);
+void pds_peer_data_iterate_prepare(struct pds_peer_data_iter *iter);
 
 /**
  * @brief Function for iterating peers' data in flash.
  *        Always call @ref pds_peer_data_iterate_prepare before starting iterating.
  *
+ * @details The storage entries are walked through once, and the peers are returned from the
+ *          most recently stored data to the oldest.
+ *
  * @param[in]  data_id      The peer data to iterate over.
  * @param[out] peer_id      The peer the data belongs to.
  * @param[out] data         The peer data in flash. @ref data.all_data must point to a buffer
  *                          of size @ref PM_PEER_DATA_MAX_SIZE.
- * @param[in]  peer_id_iter The peer ID used for keeping track of the iteration.
+ * @param[in]  iter         The iterator used for keeping track of the iteration.
  *
  * @retval true   If the operation was successful.
  * @retval false  If the data was not found in flash, or another error occurred.
  */
 bool pds_peer_data_iterate(enum pm_peer_data_id data_id, uint16_t *const peer_id,
-			   struct pm_peer_data_const *const data, uint16_t *peer_id_iter);
+			   struct pm_peer_data_const *const data, struct pds_peer_data_iter *iter);
 
 /**
  * @brief Function for storing peer data in flash. If the same piece of data already exists for the
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+#include <bm/bluetooth/peer_manager/peer_manager_types.h>
+#include <modules/bond_index.h>
+
+/* The entries are kept packed at the start of the array, in no particular order. */
+static struct bond_index_entry entries[CONFIG_PM_BOND_INDEX_SIZE];
+static uint32_t entry_count;
+static bool overflowed;
+
+#if CONFIG_PM_RPA_CACHE_SIZE > 0
+struct rpa_cache_entry {
+	/** The resolvable private address. */
+	uint8_t addr[BLE_GAP_ADDR_LEN];
+	/** The peer the address was resolved to, or PM_PEER_ID_INVALID if the slot is free. */
+	uint16_t peer_id;
+	/** When the address was last used, for replacing the least recently used address. */
+	uint32_t last_used;
+};
+
+static struct rpa_cache_entry rpa_cache[CONFIG_PM_RPA_CACHE_SIZE];
+static uint32_t rpa_cache_use_count;
+#endif
+
+/* Forget the resolvable private addresses of a peer, or of all peers. */
+static void rpa_cache_forget(uint16_t peer_id)
+{
+#if CONFIG_PM_RPA_CACHE_SIZE > 0
+	for (uint32_t i = 0; i < ARRAY_SIZE(rpa_cache); i++) {
+		if ((peer_id == PM_PEER_ID_INVALID) || (rpa_cache[i].peer_id == peer_id)) {
+			rpa_cache[i].peer_id = PM_PEER_ID_INVALID;
+		}
+	}
+#endif
+}
+
+static struct bond_index_entry *entry_find(uint16_t peer_id)
+{
+	for (uint32_t i = 0; i < entry_count; i++) {
+		if (entries[i].peer_id == peer_id) {
+			return &entries[i];
+		}
+	}
+
+	return NULL;
+}
+
+void bond_index_init(void)
+{
+	memset(entries, 0, sizeof(entries));
+	entry_count = 0;
+	overflowed = false;
+
+	rpa_cache_forget(PM_PEER_ID_INVALID);
+}
+
+void bond_index_update(uint16_t peer_id, const struct pm_peer_data_bonding *bonding_data)
+{
+	struct bond_index_entry *entry = entry_find(peer_id);
+
+	/* The IRK of the peer may have changed. */
+	rpa_cache_forget(peer_id);
+
+	if (entry == NULL) {
+		if (entry_count >= ARRAY_SIZE(entries)) {
+			overflowed = true;
+			return;
+		}
+		entry = &entries[entry_count++];
+	}
+
+	bond_index_entry_fill(entry, peer_id, bonding_data);
+}
+
+void bond_index_remove(uint16_t peer_id)
+{
+	struct bond_index_entry *entry = entry_find(peer_id);
+
+	rpa_cache_forget(peer_id);
+
+	if (entry == NULL) {
+		return;
+	}
+
+	/* Keep the array packed by moving the last entry into the freed slot. */
+	*entry = entries[--entry_count];
+	memset(&entries[entry_count], 0, sizeof(entries[entry_count]));
+}
+
+bool bond_index_is_complete(void)
+{
+	return !overflowed;
+}
+
+const struct bond_index_entry *bond_index_next(const struct bond_index_entry *prev)
+{
+	const struct bond_index_entry *next = (prev == NULL) ? &entries[0] : (prev + 1);
+
+	if (next >= &entries[entry_count]) {
+		return NULL;
+	}
+
+	return next;
+}
+
+uint16_t bond_index_rpa_cache_get(const ble_gap_addr_t *addr)
+{
+#if CONFIG_PM_RPA_CACHE_SIZE > 0
+	for (uint32_t i = 0; i < ARRAY_SIZE(rpa_cache); i++) {
+		if ((rpa_cache[i].peer_id != PM_PEER_ID_INVALID) &&
+		    (memcmp(rpa_cache[i].addr, addr->addr, BLE_GAP_ADDR_LEN) == 0)) {
+			rpa_cache[i].last_used = ++rpa_cache_use_count;
+			return rpa_cache[i].peer_id;
+		}
+	}
+#else
+	ARG_UNUSED(addr);
+#endif
+
+	return PM_PEER_ID_INVALID;
+}
+
+void bond_index_rpa_cache_put(const ble_gap_addr_t *addr, uint16_t peer_id)
+{
+#if CONFIG_PM_RPA_CACHE_SIZE > 0
+	struct rpa_cache_entry *slot = &rpa_cache[0];
+
+	/* Take a free slot, or the least recently used one. */
+	for (uint32_t i = 0; i < ARRAY_SIZE(rpa_cache); i++) {
+		if (rpa_cache[i].peer_id == PM_PEER_ID_INVALID) {
+			slot = &rpa_cache[i];
+			break;
+		}
+		if (rpa_cache[i].last_used < slot->last_used) {
+			slot = &rpa_cache[i];
+		}
+	}
+
+	memcpy(slot->addr, addr->addr, BLE_GAP_ADDR_LEN);
+	slot->peer_id = peer_id;
+	slot->last_used = ++rpa_cache_use_count;
+#else
+	ARG_UNUSED(addr);
+	ARG_UNUSED(peer_id);
+#endif
+}
@@ -18,6 +18,7 @@
 #include <modules/id_manager.h>
 #include <modules/peer_database.h>
 #include <modules/peer_data_storage.h>
+#include <modules/bond_index.h>
 
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/util.h>
@@ -112,6 +113,186 @@ bool addr_compare(const ble_gap_addr_t *addr1, const ble_gap_addr_t *addr2)
 	return (memcmp(addr1->addr, addr2->addr, BLE_GAP_ADDR_LEN) == 0);
 }
 
+/**
+ * @brief Function for checking whether a bond matches the searched identity.
+ *
+ * @param[in] bond The identification keys of the bond.
+ * @param[in] ctx  The identity that is searched for.
+ *
+ * @retval true  The bond matches.
+ * @retval false The bond does not match.
+ */
+typedef bool (*bond_match_t)(const struct bond_index_entry *bond, const void *ctx);
+
+/**
+ * @brief Function for finding the bonded peer that matches an identity in persistent storage.
+ *
+ * @param[in] match        The function checking whether a bond matches.
+ * @param[in] ctx          The identity that is searched for, passed to @p match.
+ * @param[in] peer_id_skip A peer ID to skip, or @ref PM_PEER_ID_INVALID.
+ *
+ * @return The peer ID of the first matching bond, or @ref PM_PEER_ID_INVALID.
+ */
+static uint16_t bond_find_in_storage(bond_match_t match, const void *ctx, uint16_t peer_id_skip)
+{
+	uint16_t peer_id;
+	struct bond_index_entry bond;
+	struct pm_peer_data_const peer_data;
+	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
+	struct pds_peer_data_iter iter;
+
+	peer_data.all_data = peer_data_buffer;
+
+	pds_peer_data_iterate_prepare(&iter);
+
+	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data, &iter)) {
+		if ((peer_id == peer_id_skip) || pds_peer_id_is_deleted(peer_id)) {
+			continue;
+		}
+
+		bond_index_entry_fill(&bond, peer_id, peer_data.bonding_data);
+		if (match(&bond, ctx)) {
+			return peer_id;
+		}
+	}
+
+	return PM_PEER_ID_INVALID;
+}
+
+/**
+ * @brief Function for finding the bonded peer that matches an identity.
+ *
+ * @details The bond index is searched first. Persistent storage is only searched if not all bonds
+ *          fit in the index, or if the index is disabled.
+ *
+ * @param[in] match        The function checking whether a bond matches.
+ * @param[in] ctx          The identity that is searched for, passed to @p match.
+ * @param[in] peer_id_skip A peer ID to skip, or @ref PM_PEER_ID_INVALID.
+ *
+ * @return The peer ID of the first matching bond, or @ref PM_PEER_ID_INVALID.
+ */
+static uint16_t bond_find(bond_match_t match, const void *ctx, uint16_t peer_id_skip)
+{
+#if defined(CONFIG_PM_BOND_INDEX)
+	const struct bond_index_entry *entry = NULL;
+
+	while ((entry = bond_index_next(entry)) != NULL) {
+		if ((entry->peer_id != peer_id_skip) && match(entry, ctx)) {
+			return entry->peer_id;
+		}
+	}
+
+	if (bond_index_is_complete()) {
+		return PM_PEER_ID_INVALID;
+	}
+#endif
+
+	return bond_find_in_storage(match, ctx, peer_id_skip);
+}
+
+static bool bond_match_addr(const struct bond_index_entry *bond, const void *ctx)
+{
+	return addr_compare(ctx, &bond->peer_ble_id.id_addr_info);
+}
+
+static bool bond_match_resolvable_addr(const struct bond_index_entry *bond, const void *ctx)
+{
+	return im_address_resolve(ctx, &bond->peer_ble_id.id_info);
+}
+
+#if defined(CONFIG_PM_BOND_INDEX)
+/**
+ * @brief Function for resolving a private address against all IRKs in the bond index.
+ *
+ * @details The cleartext is prepared once, and only the key is changed between the encryptions.
+ *          Bonds without a valid IRK are skipped.
+ *
+ * @param[in] addr The resolvable private address.
+ *
+ * @return The peer ID of the bond whose IRK resolves the address, or @ref PM_PEER_ID_INVALID.
+ */
+static uint16_t rpa_resolve_in_index(const ble_gap_addr_t *addr)
+{
+	nrf_ecb_hal_data_t ecb_hal_data;
+	const uint8_t *hash = &addr->addr[0];
+	const uint8_t *prand = &addr->addr[IM_ADDR_CIPHERTEXT_LENGTH];
+	const struct bond_index_entry *entry = NULL;
+
+	memset(ecb_hal_data.cleartext, 0, SOC_ECB_KEY_LENGTH - IM_ADDR_CLEARTEXT_LENGTH);
+	for (uint32_t i = 0; i < IM_ADDR_CLEARTEXT_LENGTH; i++) {
+		ecb_hal_data.cleartext[SOC_ECB_KEY_LENGTH - 1 - i] = prand[i];
+	}
+
+	while ((entry = bond_index_next(entry)) != NULL) {
+		const uint8_t *irk = entry->peer_ble_id.id_info.irk;
+		bool match = true;
+
+		if (!is_valid_irk(&entry->peer_ble_id.id_info)) {
+			continue;
+		}
+
+		for (uint32_t i = 0; i < SOC_ECB_KEY_LENGTH; i++) {
+			ecb_hal_data.key[i] = irk[SOC_ECB_KEY_LENGTH - 1 - i];
+		}
+
+		/* Can only return NRF_SUCCESS. */
+		(void)sd_ecb_block_encrypt(&ecb_hal_data);
+
+		for (uint32_t i = 0; i < IM_ADDR_CIPHERTEXT_LENGTH; i++) {
+			if (hash[i] != ecb_hal_data.ciphertext[SOC_ECB_KEY_LENGTH - 1 - i]) {
+				match = false;
+				break;
+			}
+		}
+
+		if (match) {
+			return entry->peer_id;
+		}
+	}
+
+	return PM_PEER_ID_INVALID;
+}
+#endif
+
+uint16_t im_peer_id_get_by_addr(const ble_gap_addr_t *addr)
+{
+	__ASSERT_NO_MSG(addr != NULL);
+
+	switch (addr->addr_type) {
+	case BLE_GAP_ADDR_TYPE_PUBLIC:
+	case BLE_GAP_ADDR_TYPE_RANDOM_STATIC:
+		return bond_find(bond_match_addr, addr, PM_PEER_ID_INVALID);
+
+	case BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE: {
+#if defined(CONFIG_PM_BOND_INDEX)
+		uint16_t peer_id = bond_index_rpa_cache_get(addr);
+
+		if (peer_id != PM_PEER_ID_INVALID) {
+			return peer_id;
+		}
+
+		peer_id = rpa_resolve_in_index(addr);
+		if ((peer_id == PM_PEER_ID_INVALID) && !bond_index_is_complete()) {
+			peer_id = bond_find_in_storage(bond_match_resolvable_addr, addr,
+						       PM_PEER_ID_INVALID);
+		}
+
+		if (peer_id != PM_PEER_ID_INVALID) {
+			bond_index_rpa_cache_put(addr, peer_id);
+		}
+
+		return peer_id;
+#else
+		return bond_find(bond_match_resolvable_addr, addr, PM_PEER_ID_INVALID);
+#endif
+	}
+
+	default:
+		/* Non-resolvable random addresses are not a longterm form of identification. */
+		return PM_PEER_ID_INVALID;
+	}
+}
+
 void im_ble_evt_handler(const ble_evt_t *ble_evt)
 {
 	ble_gap_evt_t gap_evt;
@@ -123,7 +304,6 @@ void im_ble_evt_handler(const ble_evt_t *ble_evt)
 	}
 
 	gap_evt = ble_evt->evt.gap_evt;
-	bonded_matching_peer_id = PM_PEER_ID_INVALID;
 
 	const int idx = nrf_sdh_ble_idx_get(gap_evt.conn_handle);
 
@@ -131,55 +311,13 @@ void im_ble_evt_handler(const ble_evt_t *ble_evt)
 		 "Invalid idx %d for conn_handle %#x, evt_id %#x",
 		 idx, gap_evt.conn_handle, ble_evt->header.evt_id);
 
-	if (gap_evt.params.connected.peer_addr.addr_type !=
-	    BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_NON_RESOLVABLE) {
-		/* Search the database for bonding data matching the one that triggered the event.
-		 * Public and static addresses can be matched on address alone, while resolvable
-		 * random addresses can be resolved agains known IRKs. Non-resolvable random
-		 * addresses are never matching because they are not longterm form of
-		 * identification.
-		 */
-
-		uint16_t peer_id;
-		struct pm_peer_data_const peer_data;
-		uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
-		uint16_t peer_id_iter;
-
-		peer_data.all_data = peer_data_buffer;
-
-		pds_peer_data_iterate_prepare(&peer_id_iter);
-
-		switch (gap_evt.params.connected.peer_addr.addr_type) {
-		case BLE_GAP_ADDR_TYPE_PUBLIC:
-		case BLE_GAP_ADDR_TYPE_RANDOM_STATIC: {
-			while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id,
-						     &peer_data, &peer_id_iter)) {
-				if (addr_compare(
-					    &gap_evt.params.connected.peer_addr,
-					    &peer_data.bonding_data->peer_ble_id.id_addr_info)) {
-					bonded_matching_peer_id = peer_id;
-					break;
-				}
-			}
-		} break;
-
-		case BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE: {
-			while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id,
-						     &peer_data, &peer_id_iter)) {
-				if (im_address_resolve(
-					    &gap_evt.params.connected.peer_addr,
-					    &peer_data.bonding_data->peer_ble_id.id_info)) {
-					bonded_matching_peer_id = peer_id;
-					break;
-				}
-			}
-		} break;
-
-		default:
-			__ASSERT_NO_MSG(false);
-			break;
-		}
-	}
+	/* Search the bonds for one matching the peer that triggered the event.
+	 * Public and static addresses can be matched on address alone, while resolvable
+	 * random addresses can be resolved agains known IRKs. Non-resolvable random
+	 * addresses are never matching because they are not longterm form of
+	 * identification.
+	 */
+	bonded_matching_peer_id = im_peer_id_get_by_addr(&gap_evt.params.connected.peer_addr);
 
 	connections[idx].conn_handle = gap_evt.conn_handle;
 	connections[idx].peer_id = bonded_matching_peer_id;
@@ -197,28 +335,22 @@ void im_ble_evt_handler(const ble_evt_t *ble_evt)
 }
 
 /**
- * @brief Function to compare two sets of bonding data to check if they belong to the same device.
+ * @brief Function to compare two identity keys to check if they belong to the same device.
  * @note  Invalid irks will never match even though they are identical.
  *
- * @param[in]  bonding_data1  First bonding data for comparison
- * @param[in]  bonding_data2  Second bonding data for comparison
+ * @param[in]  id_key1  First identity key for comparison
+ * @param[in]  id_key2  Second identity key for comparison
  *
  * @return     True if the input matches, false if it does not.
  */
-bool im_is_duplicate_bonding_data(const struct pm_peer_data_bonding *bonding_data1,
-				  const struct pm_peer_data_bonding *bonding_data2)
+static bool is_duplicate_id_key(const ble_gap_id_key_t *id_key1, const ble_gap_id_key_t *id_key2)
 {
-	__ASSERT_NO_MSG(bonding_data1 != NULL);
-	__ASSERT_NO_MSG(bonding_data2 != NULL);
-
-	const ble_gap_addr_t *addr1 = &bonding_data1->peer_ble_id.id_addr_info;
-	const ble_gap_addr_t *addr2 = &bonding_data2->peer_ble_id.id_addr_info;
+	const ble_gap_addr_t *addr1 = &id_key1->id_addr_info;
+	const ble_gap_addr_t *addr2 = &id_key2->id_addr_info;
 
 	bool duplicate_irk =
-		((memcmp(bonding_data1->peer_ble_id.id_info.irk,
-			 bonding_data2->peer_ble_id.id_info.irk, BLE_GAP_SEC_KEY_LEN) == 0) &&
-		 is_valid_irk(&bonding_data1->peer_ble_id.id_info) &&
-		 is_valid_irk(&bonding_data2->peer_ble_id.id_info));
+		((memcmp(id_key1->id_info.irk, id_key2->id_info.irk, BLE_GAP_SEC_KEY_LEN) == 0) &&
+		 is_valid_irk(&id_key1->id_info) && is_valid_irk(&id_key2->id_info));
 
 	bool duplicate_addr = addr_compare(addr1, addr2);
 
@@ -230,29 +362,35 @@ bool im_is_duplicate_bonding_data(const struct pm_peer_data_bonding *bonding_dat
 	return (duplicate_addr && id_addrs) || (duplicate_irk && !id_addrs);
 }
 
-uint16_t im_find_duplicate_bonding_data(const struct pm_peer_data_bonding *bonding_data,
-					uint16_t peer_id_skip)
+/**
+ * @brief Function to compare two sets of bonding data to check if they belong to the same device.
+ * @note  Invalid irks will never match even though they are identical.
+ *
+ * @param[in]  bonding_data1  First bonding data for comparison
+ * @param[in]  bonding_data2  Second bonding data for comparison
+ *
+ * @return     True if the input matches, false if it does not.
+ */
+bool im_is_duplicate_bonding_data(const struct pm_peer_data_bonding *bonding_data1,
+				  const struct pm_peer_data_bonding *bonding_data2)
 {
-	uint16_t peer_id;
-	struct pm_peer_data_const peer_data_duplicate;
-	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
-	uint16_t peer_id_iter;
+	__ASSERT_NO_MSG(bonding_data1 != NULL);
+	__ASSERT_NO_MSG(bonding_data2 != NULL);
 
-	peer_data_duplicate.all_data = peer_data_buffer;
+	return is_duplicate_id_key(&bonding_data1->peer_ble_id, &bonding_data2->peer_ble_id);
+}
 
-	__ASSERT_NO_MSG(bonding_data != NULL);
+static bool bond_match_id_key(const struct bond_index_entry *bond, const void *ctx)
+{
+	return is_duplicate_id_key(ctx, &bond->peer_ble_id);
+}
 
-	pds_peer_data_iterate_prepare(&peer_id_iter);
+uint16_t im_find_duplicate_bonding_data(const struct pm_peer_data_bonding *bonding_data,
+					uint16_t peer_id_skip)
+{
+	__ASSERT_NO_MSG(bonding_data != NULL);
 
-	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data_duplicate,
-		&peer_id_iter)) {
-		if ((peer_id != peer_id_skip) &&
-		    im_is_duplicate_bonding_data(bonding_data,
-						 peer_data_duplicate.bonding_data)) {
-			return peer_id;
-		}
-	}
-	return PM_PEER_ID_INVALID;
+	return bond_find(bond_match_id_key, &bonding_data->peer_ble_id, peer_id_skip);
 }
 
 uint16_t im_peer_id_get_by_conn_handle(uint16_t conn_handle)
@@ -297,33 +435,18 @@ bool im_master_ids_compare(const ble_gap_master_id_t *master_id1,
 	return (memcmp(master_id1->rand, master_id2->rand, BLE_GAP_SEC_RAND_LEN) == 0);
 }
 
-uint16_t im_peer_id_get_by_master_id(const ble_gap_master_id_t *master_id)
+static bool bond_match_master_id(const struct bond_index_entry *bond, const void *ctx)
 {
-	uint16_t peer_id;
-	struct pm_peer_data_const peer_data;
-	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
-	uint16_t peer_id_iter;
+	return im_master_ids_compare(ctx, &bond->own_master_id) ||
+	       im_master_ids_compare(ctx, &bond->peer_master_id);
+}
 
+uint16_t im_peer_id_get_by_master_id(const ble_gap_master_id_t *master_id)
+{
 	__ASSERT_NO_MSG(master_id != NULL);
 
-	peer_data.all_data = peer_data_buffer;
-
-	pds_peer_data_iterate_prepare(&peer_id_iter);
-
-	/* For each stored peer, check if the master_id matches master_id */
-	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data,
-		&peer_id_iter)) {
-		if (im_master_ids_compare(master_id,
-					  &peer_data.bonding_data->own_ltk.master_id) ||
-		    im_master_ids_compare(master_id,
-					  &peer_data.bonding_data->peer_ltk.master_id)) {
-			/* If a matching master ID is found then return the peer ID. */
-			return peer_id;
-		}
-	}
-
-	/* If no matching master ID is found return PM_PEER_ID_INVALID. */
-	return PM_PEER_ID_INVALID;
+	/* For each bonded peer, check if the own or peer master ID matches master_id. */
+	return bond_find(bond_match_master_id, master_id, PM_PEER_ID_INVALID);
 }
 
 uint16_t im_conn_handle_get(uint16_t peer_id)
@@ -15,6 +15,10 @@
 #include <zephyr/sys/util.h>
 #include <zephyr/sys/printk.h>
 #include <zephyr/toolchain.h>
+#include <zephyr/kernel.h>
+#if defined(CONFIG_PM_LESC_KEY_POOL) || defined(CONFIG_PM_LESC_DHKEY_DEFERRED)
+#include <bm/bm_scheduler.h>
+#endif
 
 #include <bm/bluetooth/peer_manager/nrf_ble_lesc.h>
 
@@ -28,6 +32,8 @@ struct lesc_peer_pub_key {
 	uint16_t conn_handle;
 	/** @brief Flag indicating that the public key has been requested to compute DH key. */
 	bool is_requested;
+	/** @brief Cycle count when the DH key was requested. */
+	uint32_t requested_at;
 };
 
 /**
@@ -55,6 +61,25 @@ static bool lesc_oobd_own_generated;
 /** LESC OOB data used in LESC OOB pairing mode. */
 static ble_gap_lesc_oob_data_t ble_lesc_oobd_own;
 static nrf_ble_lesc_peer_oob_data_handler lesc_oobd_peer_handler;
+static nrf_ble_lesc_dhkey_handler lesc_dhkey_handler;
+
+#if defined(CONFIG_PM_LESC_KEY_POOL)
+/** @brief An ECC key pair generated in advance. */
+struct lesc_keypair {
+	/** @brief ID of the key pair. */
+	psa_key_id_t id;
+	/** @brief Public key of the key pair. Stored in little-endian. */
+	ble_gap_lesc_p256_pk_t public_key;
+};
+
+/** Key pairs generated in advance, used by @ref nrf_ble_lesc_keypair_generate. */
+static struct lesc_keypair key_pool[CONFIG_PM_LESC_KEY_POOL_SIZE];
+static uint32_t key_pool_count;
+
+static void key_pool_refill(void *evt, size_t len);
+
+BM_SCHEDULER_COALESCE_DEFINE(key_pool_refill_evt, key_pool_refill, BM_SCHEDULER_PRIO_LOWEST);
+#endif
 
 #define ECC_PUB_KEY_UNCOMPRESSED_FORMAT_MARKER 0x04
 #define ECC_PUB_KEY_EXPORT_SIZE \
@@ -95,31 +120,21 @@ uint32_t nrf_ble_lesc_init(void)
 	return nrf_ble_lesc_keypair_generate();
 }
 
-uint32_t nrf_ble_lesc_keypair_generate(void)
+/**
+ * @brief Function for generating an ECC key pair and exporting its public key.
+ *
+ * @param[out] key_id      ID of the generated key pair. Set also if exporting the public key fails.
+ * @param[out] public_key  Public key of the generated key pair, in little-endian.
+ *
+ * @retval NRF_SUCCESS        If the operation was successful.
+ * @retval NRF_ERROR_INTERNAL If @ref psa_generate_key, or @ref psa_export_public_key failed.
+ */
+static uint32_t keypair_create(psa_key_id_t *key_id, ble_gap_lesc_p256_pk_t *public_key)
 {
 	psa_status_t status;
 	uint8_t pub_key[ECC_PUB_KEY_EXPORT_SIZE];
 	size_t pub_key_len = 0;
 
-	/* Check if any DH computation is pending */
-	for (uint16_t i = 0; i < ARRAY_SIZE(peer_keys); i++) {
-		if (peer_keys[i].is_requested) {
-			return NRF_ERROR_BUSY;
-		}
-	}
-
-	/* Update flag to indicate that there is no valid private key. */
-	keypair_generated = false;
-	lesc_oobd_own_generated = false;
-
-	/* Destroy the previous key pair (if any), to free up memory. */
-	status = psa_destroy_key(keypair_id);
-	if (status != PSA_SUCCESS && status != PSA_ERROR_INVALID_HANDLE) {
-		LOG_ERR("psa_destroy_key returned status %d", status);
-	} else {
-		keypair_id = 0;
-	}
-
 	LOG_DBG("Generating ECC key pair");
 
 	psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
@@ -134,14 +149,14 @@ uint32_t nrf_ble_lesc_keypair_generate(void)
 	psa_set_key_type(&key_attributes, PSA_KEY_TYPE_ECC_KEY_PAIR(PSA_ECC_FAMILY_SECP_R1));
 	psa_set_key_bits(&key_attributes, 256);
 
-	status = psa_generate_key(&key_attributes, &keypair_id);
+	status = psa_generate_key(&key_attributes, key_id);
 	if (status != PSA_SUCCESS) {
 		LOG_ERR("psa_generate_key() returned status %d", status);
 		return NRF_ERROR_INTERNAL;
 	}
 
 	/* Export the raw representation of the public key. */
-	status = psa_export_public_key(keypair_id, pub_key, sizeof(pub_key), &pub_key_len);
+	status = psa_export_public_key(*key_id, pub_key, sizeof(pub_key), &pub_key_len);
 	if (status != PSA_SUCCESS) {
 		LOG_ERR("psa_export_public_key() returned status %d", status);
 		return NRF_ERROR_INTERNAL;
@@ -152,7 +167,7 @@ uint32_t nrf_ble_lesc_keypair_generate(void)
 	size_t priv_key_len = 0;
 
 	LOG_WRN("CONFIG_PM_LESC_PRIVATE_KEY_EXPORT is not to be used in production!");
-	status = psa_export_key(keypair_id, priv_key, sizeof(priv_key), &priv_key_len);
+	status = psa_export_key(*key_id, priv_key, sizeof(priv_key), &priv_key_len);
 	if (status != PSA_SUCCESS) {
 		LOG_ERR("psa_export_key() returned status %d", status);
 	} else {
@@ -169,7 +184,90 @@ uint32_t nrf_ble_lesc_keypair_generate(void)
 	/* Convert from big-endian to little-endian.
 	 * Drop the first byte indicating the serialization format.
 	 */
-	ecc_public_key_byte_order_invert(&pub_key[1], lesc_public_key.pk);
+	ecc_public_key_byte_order_invert(&pub_key[1], public_key->pk);
+
+	return NRF_SUCCESS;
+}
+
+#if defined(CONFIG_PM_LESC_KEY_POOL)
+/* Generate one key pair for the pool per scheduler event, to keep each event short. */
+static void key_pool_refill(void *evt, size_t len)
+{
+	uint32_t nrf_err;
+	struct lesc_keypair *keypair;
+
+	ARG_UNUSED(evt);
+	ARG_UNUSED(len);
+
+	if (key_pool_count >= ARRAY_SIZE(key_pool)) {
+		return;
+	}
+
+	keypair = &key_pool[key_pool_count];
+	keypair->id = 0;
+
+	nrf_err = keypair_create(&keypair->id, &keypair->public_key);
+	if (nrf_err) {
+		/* Try again when the next key pair is taken from the pool. */
+		if (keypair->id != 0) {
+			(void)psa_destroy_key(keypair->id);
+		}
+		return;
+	}
+
+	key_pool_count++;
+	LOG_DBG("%u key pair(s) in the pool", key_pool_count);
+
+	if (key_pool_count < ARRAY_SIZE(key_pool)) {
+		(void)bm_scheduler_defer_coalesce(&key_pool_refill_evt);
+	}
+}
+#endif
+
+uint32_t nrf_ble_lesc_keypair_generate(void)
+{
+	uint32_t nrf_err;
+	psa_status_t status;
+
+	/* Check if any DH computation is pending */
+	for (uint16_t i = 0; i < ARRAY_SIZE(peer_keys); i++) {
+		if (peer_keys[i].is_requested) {
+			return NRF_ERROR_BUSY;
+		}
+	}
+
+	/* Update flag to indicate that there is no valid private key. */
+	keypair_generated = false;
+	lesc_oobd_own_generated = false;
+
+	/* Destroy the previous key pair (if any), to free up memory. */
+	status = psa_destroy_key(keypair_id);
+	if (status != PSA_SUCCESS && status != PSA_ERROR_INVALID_HANDLE) {
+		LOG_ERR("psa_destroy_key returned status %d", status);
+	} else {
+		keypair_id = 0;
+	}
+
+#if defined(CONFIG_PM_LESC_KEY_POOL)
+	/* Generate the next key pair while idle. */
+	if (bm_scheduler_defer_coalesce(&key_pool_refill_evt)) {
+		LOG_WRN("Failed to schedule generation of the next key pair");
+	}
+
+	if (key_pool_count > 0) {
+		key_pool_count--;
+		keypair_id = key_pool[key_pool_count].id;
+		lesc_public_key = key_pool[key_pool_count].public_key;
+		keypair_generated = true;
+
+		return NRF_SUCCESS;
+	}
+#endif
+
+	nrf_err = keypair_create(&keypair_id, &lesc_public_key);
+	if (nrf_err) {
+		return nrf_err;
+	}
 
 	/* Set the flag to indicate that there is a valid ECDH key pair generated. */
 	keypair_generated = true;
@@ -225,6 +323,11 @@ void nrf_ble_lesc_peer_oob_data_handler_set(nrf_ble_lesc_peer_oob_data_handler h
 	lesc_oobd_peer_handler = handler;
 }
 
+void nrf_ble_lesc_dhkey_handler_set(nrf_ble_lesc_dhkey_handler handler)
+{
+	lesc_dhkey_handler = handler;
+}
+
 /**
  * @brief Function for calculating a DH key and responding to the DH key request.
  *
@@ -281,6 +384,62 @@ static uint32_t compute_and_give_dhkey(struct lesc_peer_pub_key *peer_public_key
 	return sd_ble_gap_lesc_dhkey_reply(peer_public_key->conn_handle, sec_status, p_dh_key);
 }
 
+/**
+ * @brief Function for responding to a pending DH key request, and reporting the result to the
+ *        DH key handler.
+ *
+ * @param[in]  peer_public_key  The pending request.
+ *
+ * @return The result of @ref compute_and_give_dhkey.
+ */
+static uint32_t dhkey_request_process(struct lesc_peer_pub_key *peer_public_key)
+{
+	uint32_t nrf_err;
+	const uint32_t start = k_cycle_get_32();
+	struct nrf_ble_lesc_dhkey_result result = {
+		.conn_handle = peer_public_key->conn_handle,
+	};
+
+	nrf_err = compute_and_give_dhkey(peer_public_key);
+	peer_public_key->is_requested = false;
+
+	result.nrf_err = nrf_err;
+	result.compute_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+	result.latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - peer_public_key->requested_at);
+
+	LOG_DBG("DH key reply on conn_handle %d after %u us, of which %u us computing",
+		result.conn_handle, result.latency_us, result.compute_us);
+
+	if (lesc_dhkey_handler != NULL) {
+		lesc_dhkey_handler(&result);
+	}
+
+	return nrf_err;
+}
+
+#if defined(CONFIG_PM_LESC_DHKEY_DEFERRED)
+/* Respond to the DH key request of one link. */
+static void dhkey_request_sched_handler(void *evt, size_t len)
+{
+	uint32_t nrf_err;
+	struct lesc_peer_pub_key *peer_public_key = *(struct lesc_peer_pub_key **)evt;
+
+	ARG_UNUSED(len);
+
+	/* The request is dropped if the link disconnected, and it is left to
+	 * nrf_ble_lesc_request_handler() if the module encountered an internal error.
+	 */
+	if (!peer_public_key->is_requested || ble_lesc_internal_error) {
+		return;
+	}
+
+	nrf_err = dhkey_request_process(peer_public_key);
+	if (nrf_err) {
+		LOG_ERR("Failed to reply to DH key request, nrf_error %#x", nrf_err);
+	}
+}
+#endif
+
 uint32_t nrf_ble_lesc_request_handler(void)
 {
 	uint32_t nrf_err;
@@ -292,9 +451,7 @@ uint32_t nrf_ble_lesc_request_handler(void)
 
 	for (uint16_t i = 0; i < NRF_BLE_LESC_LINK_COUNT; i++) {
 		if (peer_keys[i].is_requested) {
-			nrf_err = compute_and_give_dhkey(&peer_keys[i]);
-			peer_keys[i].is_requested = false;
-
+			nrf_err = dhkey_request_process(&peer_keys[i]);
 			if (nrf_err) {
 				return nrf_err;
 			}
@@ -319,6 +476,17 @@ static void on_dhkey_request(uint16_t conn_handle, int idx,
 	memcpy(peer_keys[idx].value, public_raw, BLE_GAP_LESC_P256_PK_LEN);
 	peer_keys[idx].conn_handle = conn_handle;
 	peer_keys[idx].is_requested = true;
+	peer_keys[idx].requested_at = k_cycle_get_32();
+
+#if defined(CONFIG_PM_LESC_DHKEY_DEFERRED)
+	struct lesc_peer_pub_key *peer_public_key = &peer_keys[idx];
+
+	/* If the request cannot be deferred, it is handled by nrf_ble_lesc_request_handler(). */
+	if (bm_scheduler_defer(dhkey_request_sched_handler, &peer_public_key,
+			       sizeof(peer_public_key))) {
+		LOG_WRN("Failed to schedule DH key computation for conn_handle %d", conn_handle);
+	}
+#endif
 }
 
 /**
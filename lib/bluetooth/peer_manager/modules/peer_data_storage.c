@@ -19,6 +19,9 @@
 #include <modules/peer_manager_internal.h>
 #include <modules/peer_id.h>
 #include <modules/peer_data_storage.h>
+#if defined(CONFIG_PM_BOND_INDEX)
+#include <modules/bond_index.h>
+#endif
 
 #define PEER_MANAGER_PARTITION_OFFSET PARTITION_ADDRESS(peer_manager_partition)
 #define PEER_MANAGER_PARTITION_SIZE PARTITION_SIZE(peer_manager_partition)
@@ -173,20 +176,59 @@ static void peer_data_delete_process(void)
 static void peer_ids_load(void)
 {
 	uint16_t peer_id;
-	uint16_t peer_id_iter;
+	struct pds_peer_data_iter iter;
 	struct pm_peer_data_const peer_data = { 0 };
 	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
 
 	peer_data.all_data = peer_data_buffer;
 
 	/* Allocate peer IDs for already stored bonds. */
-	pds_peer_data_iterate_prepare(&peer_id_iter);
+	pds_peer_data_iterate_prepare(&iter);
 
-	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data,
-		&peer_id_iter)) {
+	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data, &iter)) {
 		(void)peer_id_allocate(peer_id);
+#if defined(CONFIG_PM_BOND_INDEX)
+		bond_index_update(peer_id, peer_data.bonding_data);
+#endif
+	}
+}
+
+#if defined(CONFIG_PM_BOND_INDEX)
+/* Rebuild the bond index from flash. Used when bonds that did not fit in the index may now fit. */
+static void bond_index_reload(void)
+{
+	uint16_t peer_id;
+	struct pds_peer_data_iter iter;
+	struct pm_peer_data_const peer_data = { 0 };
+	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
+
+	peer_data.all_data = peer_data_buffer;
+
+	bond_index_init();
+	pds_peer_data_iterate_prepare(&iter);
+
+	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data, &iter)) {
+		if (!peer_id_is_deleted(peer_id)) {
+			bond_index_update(peer_id, peer_data.bonding_data);
+		}
+	}
+}
+
+/* Bring the bond of a peer in the index back in line with flash, after a failed operation. */
+static void bond_index_sync(uint16_t peer_id)
+{
+	ssize_t ret;
+	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
+	uint32_t entry_id = peer_id_peer_data_id_to_entry_id(peer_id, PM_PEER_DATA_ID_BONDING);
+
+	ret = bm_zms_read(&fs, entry_id, peer_data_buffer, sizeof(peer_data_buffer));
+	if ((ret > 0) && !peer_id_is_deleted(peer_id)) {
+		bond_index_update(peer_id, (const struct pm_peer_data_bonding *)peer_data_buffer);
+	} else {
+		bond_index_remove(peer_id);
 	}
 }
+#endif
 
 static void bm_zms_evt_handler(const struct bm_zms_evt *evt)
 {
@@ -215,6 +257,11 @@ static void bm_zms_evt_handler(const struct bm_zms_evt *evt)
 			LOG_ERR("BM_ZMS write failed with error %d", evt->result);
 			pds_evt.evt_id = PM_EVT_PEER_DATA_UPDATE_FAILED;
 			pds_evt.peer_data_update_failed.error = NRF_ERROR_INTERNAL;
+#if defined(CONFIG_PM_BOND_INDEX)
+			if (data_id == PM_PEER_DATA_ID_BONDING) {
+				bond_index_sync(peer_id);
+			}
+#endif
 		}
 
 		pds_evt_send(&pds_evt);
@@ -228,10 +275,20 @@ static void bm_zms_evt_handler(const struct bm_zms_evt *evt)
 			if (evt->result == 0) {
 				pds_evt.evt_id = PM_EVT_PEER_DATA_UPDATE_SUCCEEDED;
 				pds_evt.peer_data_update_succeeded.flash_changed = true;
+#if defined(CONFIG_PM_BOND_INDEX)
+				if ((data_id == PM_PEER_DATA_ID_BONDING) && !bond_index_is_complete()) {
+					bond_index_reload();
+				}
+#endif
 			} else {
 				LOG_ERR("BM_ZMS delete failed with error %d", evt->result);
 				pds_evt.evt_id = PM_EVT_PEER_DATA_UPDATE_FAILED;
 				pds_evt.peer_data_update_failed.error = NRF_ERROR_INTERNAL;
+#if defined(CONFIG_PM_BOND_INDEX)
+				if (data_id == PM_PEER_DATA_ID_BONDING) {
+					bond_index_sync(peer_id);
+				}
+#endif
 			}
 
 			pds_evt_send(&pds_evt);
@@ -263,6 +320,11 @@ static void bm_zms_evt_handler(const struct bm_zms_evt *evt)
 
 					pds_evt.evt_id = PM_EVT_PEER_DELETE_SUCCEEDED;
 					peer_id_free(pds_evt.peer_id);
+#if defined(CONFIG_PM_BOND_INDEX)
+					if (!bond_index_is_complete()) {
+						bond_index_reload();
+					}
+#endif
 					pds_evt_send(&pds_evt);
 				}
 			}
@@ -288,53 +350,62 @@ static void wait_for_init(void)
 	}
 }
 
-void pds_peer_data_iterate_prepare(uint16_t *peer_id_iter)
+void pds_peer_data_iterate_prepare(struct pds_peer_data_iter *iter)
 {
-	*peer_id_iter = 0;
+	iter->started = false;
 }
 
 bool pds_peer_data_iterate(enum pm_peer_data_id data_id, uint16_t *const peer_id,
-			   struct pm_peer_data_const *const data, uint16_t *peer_id_iter)
+			   struct pm_peer_data_const *const data, struct pds_peer_data_iter *iter)
 {
+	int err;
 	ssize_t ret;
-	uint8_t temp_buf[PM_PEER_DATA_MAX_SIZE] = { 0 };
+	uint32_t entry_id;
+	enum pm_peer_data_id entry_data_id;
+
+	for (;;) {
+		if (!iter->started) {
+			/* Only the entries of the given data ID are returned by the storage. */
+			err = bm_zms_iter_init(&fs, &iter->zms_iter, ENTRY_ID_DATA_ID_MASK, data_id);
+			if (err) {
+				LOG_ERR("Could not iterate over NVM. bm_zms_iter_init() returned %d.",
+					err);
+				return false;
+			}
+			iter->started = true;
+		}
 
-	if (*peer_id_iter >= PM_PEER_ID_N_AVAILABLE_IDS) {
-		return false;
-	}
+		err = bm_zms_iter_next(&fs, &iter->zms_iter, &entry_id);
+		if (err == -EAGAIN) {
+			/* The storage was garbage collected during the iteration, start over. */
+			iter->started = false;
+			continue;
+		} else if (err == -ENOENT) {
+			return false;
+		} else if (err) {
+			LOG_ERR("Could not iterate over NVM. bm_zms_iter_next() returned %d.", err);
+			return false;
+		}
 
-	/* Exits the loop when `ret > 0` (it found data), it reached the end of the available peers,
-	 * or the read had a catastrophical failure.
-	 */
-	do {
-		uint32_t entry_id = peer_id_peer_data_id_to_entry_id(*peer_id_iter, data_id);
+		entry_id_to_peer_id_peer_data_id(entry_id, peer_id, &entry_data_id);
+		if (*peer_id >= PM_PEER_ID_N_AVAILABLE_IDS) {
+			continue;
+		}
 
-		ret = bm_zms_read(&fs, entry_id, temp_buf, sizeof(temp_buf));
-		if (ret < 0 && ret != -ENOENT) {
+		ret = bm_zms_read(&fs, entry_id, (void *)data->all_data, PM_PEER_DATA_MAX_SIZE);
+		if (ret > 0) {
+			/* We found a suitable Peer ID. */
+			return true;
+		}
+
+		/* The entry might have been deleted after it was iterated over. */
+		if (ret != -ENOENT) {
 			LOG_ERR("Could not read data from NVM. bm_zms_read() returned %d. "
 				"peer_id: %d",
-				ret, *peer_id_iter);
+				ret, *peer_id);
 			return false;
 		}
-
-		(*peer_id_iter)++;
-	} while ((ret == -ENOENT) && (*peer_id_iter < PM_PEER_ID_N_AVAILABLE_IDS));
-
-	if ((ret == -ENOENT) && (*peer_id_iter == PM_PEER_ID_N_AVAILABLE_IDS)) {
-		return false;
 	}
-
-	/* We found a suitable Peer ID. */
-
-	/* `p_peer_id_iter` counts the iterations, so the Peer ID is iterations minus one. */
-	*peer_id = (*peer_id_iter) - 1;
-
-	/* `ret` is equal the exact amount of data contained in the entry, so copy that amount
-	 * safely.
-	 */
-	memcpy((void *)data->all_data, temp_buf, ret);
-
-	return true;
 }
 
 uint32_t pds_init(void)
@@ -360,6 +431,9 @@ uint32_t pds_init(void)
 	wait_for_init();
 
 	peer_id_init();
+#if defined(CONFIG_PM_BOND_INDEX)
+	bond_index_init();
+#endif
 	peer_ids_load();
 
 	module_initialized = true;
@@ -399,6 +473,8 @@ uint32_t pds_peer_data_read(uint16_t peer_id, enum pm_peer_data_id data_id,
 		return NRF_ERROR_DATA_SIZE;
 	}
 
+	data->length = ret;
+
 	return NRF_SUCCESS;
 }
 
@@ -429,6 +505,12 @@ uint32_t pds_peer_data_store(uint16_t peer_id, const struct pm_peer_data_const *
 		*store_token = entry_id;
 	}
 
+#if defined(CONFIG_PM_BOND_INDEX)
+	if (peer_data->data_id == PM_PEER_DATA_ID_BONDING) {
+		bond_index_update(peer_id, peer_data->bonding_data);
+	}
+#endif
+
 	return NRF_SUCCESS;
 }
 
@@ -452,6 +534,12 @@ uint32_t pds_peer_data_delete(uint16_t peer_id, enum pm_peer_data_id data_id)
 		return NRF_ERROR_INTERNAL;
 	}
 
+#if defined(CONFIG_PM_BOND_INDEX)
+	if (data_id == PM_PEER_DATA_ID_BONDING) {
+		bond_index_remove(peer_id);
+	}
+#endif
+
 	return NRF_SUCCESS;
 }
 
@@ -473,6 +561,11 @@ uint32_t pds_peer_id_free(uint16_t peer_id)
 		return NRF_ERROR_INVALID_PARAM;
 	}
 
+#if defined(CONFIG_PM_BOND_INDEX)
+	/* A peer that is being deleted is no longer identified. */
+	bond_index_remove(peer_id);
+#endif
+
 	/* Only start processing on the first delete request.
 	 * `peer_data_delete_process` will iteratively take care of processing all the peers marked
 	 * for deletion.
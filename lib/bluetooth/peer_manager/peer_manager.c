@@ -623,6 +623,20 @@ uint32_t pm_peer_id_get(uint16_t conn_handle, uint16_t *peer_id)
 	return NRF_SUCCESS;
 }
 
+uint32_t pm_peer_id_get_by_addr(const ble_gap_addr_t *addr, uint16_t *peer_id)
+{
+	if (!module_initialized) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+
+	if ((addr == NULL) || (peer_id == NULL)) {
+		return NRF_ERROR_NULL;
+	}
+
+	*peer_id = im_peer_id_get_by_addr(addr);
+	return NRF_SUCCESS;
+}
+
 uint32_t pm_peer_count(void)
 {
 	if (!module_initialized) {
@@ -782,6 +796,7 @@ uint32_t pm_peer_id_list(uint16_t *peer_list, uint32_t *const list_size,
 uint32_t pm_peer_data_load(uint16_t peer_id, enum pm_peer_data_id data_id, void *data,
 			   uint32_t *length)
 {
+	uint32_t nrf_err;
 	struct pm_peer_data peer_data;
 
 	if (!module_initialized) {
@@ -795,7 +810,12 @@ uint32_t pm_peer_data_load(uint16_t peer_id, enum pm_peer_data_id data_id, void
 	memset(&peer_data, 0, sizeof(peer_data));
 	peer_data.all_data = data;
 
-	return pds_peer_data_read(peer_id, data_id, &peer_data, length);
+	nrf_err = pds_peer_data_read(peer_id, data_id, &peer_data, length);
+	if (nrf_err == NRF_SUCCESS) {
+		*length = peer_data.length;
+	}
+
+	return nrf_err;
 }
 
 uint32_t pm_peer_data_bonding_load(uint16_t peer_id, struct pm_peer_data_bonding *data)
@@ -890,9 +910,7 @@ uint32_t pm_peer_new(uint16_t *new_peer_id, struct pm_peer_data_bonding *bonding
 {
 	uint32_t nrf_err;
 	uint16_t peer_id;
-	uint16_t peer_id_iter;
 	struct pm_peer_data_const peer_data;
-	uint8_t peer_data_buffer[PM_PEER_DATA_MAX_SIZE] = { 0 };
 
 	if (!module_initialized) {
 		return NRF_ERROR_INVALID_STATE;
@@ -902,19 +920,11 @@ uint32_t pm_peer_new(uint16_t *new_peer_id, struct pm_peer_data_bonding *bonding
 		return NRF_ERROR_NULL;
 	}
 
-	memset(&peer_data, 0, sizeof(struct pm_peer_data_const));
-
-	peer_data.all_data = peer_data_buffer;
-
 	/* Search through existing bonds to look for a duplicate. */
-	pds_peer_data_iterate_prepare(&peer_id_iter);
-
-	while (pds_peer_data_iterate(PM_PEER_DATA_ID_BONDING, &peer_id, &peer_data,
-		&peer_id_iter)) {
-		if (im_is_duplicate_bonding_data(bonding_data, peer_data.bonding_data)) {
-			*new_peer_id = peer_id;
-			return NRF_SUCCESS;
-		}
+	peer_id = im_find_duplicate_bonding_data(bonding_data, PM_PEER_ID_INVALID);
+	if (peer_id != PM_PEER_ID_INVALID) {
+		*new_peer_id = peer_id;
+		return NRF_SUCCESS;
 	}
 
 	/* If no duplicate data is found, prepare to write a new bond to flash. */
@@ -10,27 +10,287 @@
 #include <zephyr/init.h>
 #include <zephyr/irq.h>
 #include <zephyr/kernel.h>	/* k_heap */
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/slist.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/logging/log.h>
 
 LOG_MODULE_REGISTER(bm_scheduler, CONFIG_BM_SCHEDULER_LOG_LEVEL);
 
-static sys_slist_t event_list;
 static K_HEAP_DEFINE(heap, CONFIG_BM_SCHEDULER_BUF_SIZE);
 
-int bm_scheduler_defer(bm_scheduler_fn_t handler, void *data, size_t len)
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+
+static void coalesce_handler(void *data, size_t len);
+
+static struct {
+	/* Number of events currently pending, and its peak. */
+	atomic_t depth;
+	atomic_t depth_peak;
+	uint32_t dispatched;
+	uint32_t latency_max;
+	uint64_t latency_sum;
+	uint32_t untracked;
+	struct bm_scheduler_handler_stats handlers[CONFIG_BM_SCHEDULER_STATS_HANDLERS];
+} stats;
+
+static void stats_enqueued(void)
 {
-	struct bm_scheduler_event *evt;
-	unsigned int key;
+	atomic_val_t depth = atomic_inc(&stats.depth) + 1;
+	atomic_val_t peak = atomic_get(&stats.depth_peak);
 
-	if (!handler) {
-		return -EFAULT;
+	while (depth > peak) {
+		if (atomic_cas(&stats.depth_peak, peak, depth)) {
+			break;
+		}
+		peak = atomic_get(&stats.depth_peak);
 	}
-	if ((data && (len == 0)) || (!data && (len != 0))) {
-		return -EINVAL;
+}
+
+static struct bm_scheduler_handler_stats *handler_stats_get(bm_scheduler_fn_t handler)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(stats.handlers); i++) {
+		if (stats.handlers[i].handler == handler) {
+			return &stats.handlers[i];
+		}
+		if (!stats.handlers[i].handler) {
+			stats.handlers[i].handler = handler;
+			return &stats.handlers[i];
+		}
+	}
+
+	return NULL;
+}
+
+static size_t hist_bucket(uint32_t ticks)
+{
+	size_t bucket = 0;
+
+	/* Bucket i holds durations shorter than 4^(i + 1) ticks. */
+	while ((ticks >= 4) && (bucket < (BM_SCHEDULER_STATS_HIST_BUCKETS - 1))) {
+		ticks >>= 2;
+		bucket++;
 	}
 
+	return bucket;
+}
+
+static void stats_dispatched(bm_scheduler_fn_t handler, void *data, uint32_t enqueued,
+			     uint32_t start, uint32_t end)
+{
+	struct bm_scheduler_handler_stats *hs;
+	const uint32_t latency = start - enqueued;
+	const uint32_t exec = end - start;
+
+	atomic_dec(&stats.depth);
+
+	stats.dispatched++;
+	stats.latency_sum += latency;
+	stats.latency_max = MAX(stats.latency_max, latency);
+
+	/* Account coalescing events to the handler they wrap. */
+	if (handler == coalesce_handler) {
+		handler = (*(struct bm_scheduler_coalesce **)data)->handler;
+	}
+
+	hs = handler_stats_get(handler);
+	if (!hs) {
+		stats.untracked++;
+		return;
+	}
+
+	hs->count++;
+	hs->exec_max = MAX(hs->exec_max, exec);
+	hs->hist[hist_bucket(exec)]++;
+}
+
+#endif /* CONFIG_BM_SCHEDULER_STATS */
+
+/* Called by the event queue backends when an event has been queued. */
+static inline void evt_enqueued(void)
+{
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+	stats_enqueued();
+#endif
+}
+
+/* Called by the event queue backends to dispatch an event. */
+static inline void evt_dispatch(bm_scheduler_fn_t handler, void *data, size_t len,
+				uint32_t enqueued)
+{
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+	const uint32_t start = k_cycle_get_32();
+
+	handler(data, len);
+	stats_dispatched(handler, data, enqueued, start, k_cycle_get_32());
+#else
+	ARG_UNUSED(enqueued);
+
+	handler(data, len);
+#endif
+}
+
+/* Timestamp of an event being queued, for latency measurements. */
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+#define EVT_TIMESTAMP_SET(_evt) ((_evt)->timestamp = k_cycle_get_32())
+#define EVT_TIMESTAMP(_evt) ((_evt)->timestamp)
+#else
+#define EVT_TIMESTAMP_SET(_evt)
+#define EVT_TIMESTAMP(_evt) 0
+#endif
+
+#if defined(CONFIG_BM_SCHEDULER_BACKEND_RING)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_BM_SCHEDULER_RING_SLOTS),
+	     "CONFIG_BM_SCHEDULER_RING_SLOTS must be a power of two");
+
+#define RING_MASK (CONFIG_BM_SCHEDULER_RING_SLOTS - 1)
+
+/* A ring slot.
+ *
+ * The sequence number tells the state of the slot for a given ring position `pos`:
+ * - `seq == pos`: the slot is free and can be claimed by a producer,
+ * - `seq == pos + 1`: the slot holds an event ready to be dispatched,
+ * - `seq == pos + CONFIG_BM_SCHEDULER_RING_SLOTS`: the slot has been dispatched and is free
+ *   for the next lap of the ring.
+ */
+struct ring_slot {
+	atomic_t seq;
+	bm_scheduler_fn_t handler;
+	size_t len;
+	/* Heap buffer holding the event data when it does not fit in the slot, or NULL. */
+	uint8_t *ext;
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+	uint32_t timestamp;
+#endif
+	uint8_t data[CONFIG_BM_SCHEDULER_RING_SLOT_SIZE] __aligned(sizeof(void *));
+};
+
+struct evt_queue {
+	/* Next position to be claimed by a producer. */
+	atomic_t head;
+	/* Next position to be dispatched. Only accessed by the consumer. */
+	atomic_val_t tail;
+	struct ring_slot slots[CONFIG_BM_SCHEDULER_RING_SLOTS];
+};
+
+/* Ring positions wrap around, so do the arithmetic unsigned. */
+static inline atomic_val_t pos_add(atomic_val_t pos, unsigned long n)
+{
+	return (atomic_val_t)((unsigned long)pos + n);
+}
+
+static inline atomic_val_t pos_diff(atomic_val_t a, atomic_val_t b)
+{
+	return (atomic_val_t)((unsigned long)a - (unsigned long)b);
+}
+
+static int evt_queue_put(struct evt_queue *q, bm_scheduler_fn_t handler, void *data, size_t len)
+{
+	struct ring_slot *slot;
+	atomic_val_t pos;
+	atomic_val_t diff;
+	uint8_t *ext = NULL;
+
+	if (len > CONFIG_BM_SCHEDULER_RING_SLOT_SIZE) {
+		ext = k_heap_alloc(&heap, len, K_NO_WAIT);
+		if (!ext) {
+			return -ENOMEM;
+		}
+	}
+
+	pos = atomic_get(&q->head);
+	for (;;) {
+		slot = &q->slots[pos & RING_MASK];
+		diff = pos_diff(atomic_get(&slot->seq), pos);
+
+		if (diff == 0) {
+			/* Slot is free, try to claim it. */
+			if (atomic_cas(&q->head, pos, pos_add(pos, 1))) {
+				break;
+			}
+		} else if (diff < 0) {
+			/* Slot has not been dispatched yet, the ring is full. */
+			if (ext) {
+				k_heap_free(&heap, ext);
+			}
+			return -ENOMEM;
+		}
+
+		/* Another producer claimed this position, retry with the latest one. */
+		pos = atomic_get(&q->head);
+	}
+
+	slot->handler = handler;
+	slot->len = len;
+	slot->ext = ext;
+	EVT_TIMESTAMP_SET(slot);
+
+	if (data) {
+		memcpy(ext ? ext : slot->data, data, len);
+	}
+
+	/* Publish the event to the consumer. */
+	evt_enqueued();
+	atomic_set(&slot->seq, pos_add(pos, 1));
+
+	LOG_DBG("Event %p scheduled for %p", slot, handler);
+
+	return 0;
+}
+
+static bool evt_queue_is_empty(struct evt_queue *q)
+{
+	struct ring_slot *slot = &q->slots[q->tail & RING_MASK];
+
+	return atomic_get(&slot->seq) != pos_add(q->tail, 1);
+}
+
+static bool evt_queue_dispatch(struct evt_queue *q)
+{
+	struct ring_slot *slot = &q->slots[q->tail & RING_MASK];
+
+	if (atomic_get(&slot->seq) != pos_add(q->tail, 1)) {
+		/* Empty, or the producer of the next event has not published it yet. */
+		return false;
+	}
+
+	LOG_DBG("Dispatching event %p to handler %p", slot, slot->handler);
+	evt_dispatch(slot->handler, slot->ext ? slot->ext : slot->data, slot->len,
+		     EVT_TIMESTAMP(slot));
+
+	if (slot->ext) {
+		k_heap_free(&heap, slot->ext);
+	}
+
+	/* Release the slot for the next lap of the ring. */
+	atomic_set(&slot->seq, pos_add(q->tail, CONFIG_BM_SCHEDULER_RING_SLOTS));
+	q->tail = pos_add(q->tail, 1);
+
+	return true;
+}
+
+static void evt_queue_init(struct evt_queue *q)
+{
+	atomic_set(&q->head, 0);
+	q->tail = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(q->slots); i++) {
+		atomic_set(&q->slots[i].seq, i);
+	}
+}
+
+#else /* CONFIG_BM_SCHEDULER_BACKEND_HEAP */
+
+struct evt_queue {
+	sys_slist_t list;
+};
+
+static int evt_queue_put(struct evt_queue *q, bm_scheduler_fn_t handler, void *data, size_t len)
+{
+	struct bm_scheduler_event *evt;
+	unsigned int key;
+
 	evt = k_heap_alloc(&heap, sizeof(struct bm_scheduler_event) + len, K_NO_WAIT);
 	if (!evt) {
 		return -ENOMEM;
@@ -38,13 +298,15 @@ int bm_scheduler_defer(bm_scheduler_fn_t handler, void *data, size_t len)
 
 	evt->handler = handler;
 	evt->len = len;
+	EVT_TIMESTAMP_SET(evt);
 
 	if (data) {
 		memcpy(evt->data, data, len);
 	}
 
 	key = irq_lock();
-	sys_slist_append(&event_list, &evt->node);
+	sys_slist_append(&q->list, &evt->node);
+	evt_enqueued();
 	irq_unlock(key);
 
 	LOG_DBG("Event %p scheduled for %p", evt, handler);
@@ -52,31 +314,200 @@ int bm_scheduler_defer(bm_scheduler_fn_t handler, void *data, size_t len)
 	return 0;
 }
 
-int bm_scheduler_process(void)
+static bool evt_queue_is_empty(struct evt_queue *q)
+{
+	return sys_slist_is_empty(&q->list);
+}
+
+static bool evt_queue_dispatch(struct evt_queue *q)
 {
 	sys_snode_t *node;
 	struct bm_scheduler_event *evt;
 	unsigned int key;
 
-	while (!sys_slist_is_empty(&event_list)) {
+	if (sys_slist_is_empty(&q->list)) {
+		return false;
+	}
+
+	key = irq_lock();
+	node = sys_slist_get_not_empty(&q->list);
+	irq_unlock(key);
+
+	evt = CONTAINER_OF(node, struct bm_scheduler_event, node);
+	LOG_DBG("Dispatching event %p to handler %p", evt, evt->handler);
+	evt_dispatch(evt->handler, evt->data, evt->len, EVT_TIMESTAMP(evt));
+
+	k_heap_free(&heap, evt);
+
+	return true;
+}
+
+static void evt_queue_init(struct evt_queue *q)
+{
+	sys_slist_init(&q->list);
+}
+
+#endif /* CONFIG_BM_SCHEDULER_BACKEND_RING */
+
+/* One event queue per priority level, highest priority first. */
+static struct evt_queue event_queue[CONFIG_BM_SCHEDULER_PRIO_LEVELS];
+
+static bool dispatch_next(void)
+{
+	for (size_t prio = 0; prio < ARRAY_SIZE(event_queue); prio++) {
+		if (evt_queue_dispatch(&event_queue[prio])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool is_pending(void)
+{
+	for (size_t prio = 0; prio < ARRAY_SIZE(event_queue); prio++) {
+		if (!evt_queue_is_empty(&event_queue[prio])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int bm_scheduler_defer_prio(bm_scheduler_fn_t handler, void *data, size_t len, uint8_t prio)
+{
+	if (!handler) {
+		return -EFAULT;
+	}
+	if ((data && (len == 0)) || (!data && (len != 0))) {
+		return -EINVAL;
+	}
+	if (prio >= ARRAY_SIZE(event_queue)) {
+		return -EINVAL;
+	}
+
+	return evt_queue_put(&event_queue[prio], handler, data, len);
+}
+
+int bm_scheduler_defer(bm_scheduler_fn_t handler, void *data, size_t len)
+{
+	return bm_scheduler_defer_prio(handler, data, len, BM_SCHEDULER_PRIO_LOWEST);
+}
+
+static void coalesce_handler(void *data, size_t len)
+{
+	struct bm_scheduler_coalesce *evt = *(struct bm_scheduler_coalesce **)data;
+
+	ARG_UNUSED(len);
+
+	/* Clear the pending flag first, so that defers from now on are not lost. */
+	atomic_clear(&evt->pending);
+	atomic_inc(&evt->dispatched);
+
+	evt->handler(NULL, 0);
+}
+
+int bm_scheduler_defer_coalesce(struct bm_scheduler_coalesce *evt)
+{
+	int err;
+
+	if (!evt || !evt->handler) {
+		return -EFAULT;
+	}
+
+	if (!atomic_cas(&evt->pending, 0, 1)) {
+		atomic_inc(&evt->coalesced);
+		return 0;
+	}
+
+	err = bm_scheduler_defer_prio(coalesce_handler, &evt, sizeof(evt), evt->prio);
+	if (err) {
+		atomic_clear(&evt->pending);
+	}
+
+	return err;
+}
+
+int bm_scheduler_process_budget(uint32_t budget_us)
+{
+	const uint32_t budget = k_us_to_cyc_ceil32(budget_us);
+	const uint32_t start = k_cycle_get_32();
+
+	while (dispatch_next()) {
+		if (budget_us && ((k_cycle_get_32() - start) >= budget)) {
+			if (is_pending()) {
+				LOG_DBG("Time budget of %u us exceeded", budget_us);
+				return -EAGAIN;
+			}
+			break;
+		}
+	}
+
+	return 0;
+}
+
+int bm_scheduler_process(void)
+{
+	return bm_scheduler_process_budget(CONFIG_BM_SCHEDULER_PROCESS_TIME_BUDGET_US);
+}
+
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+int bm_scheduler_stats_get(struct bm_scheduler_stats *out)
+{
+	struct sys_memory_stats heap_stats;
+
+	if (!out) {
+		return -EFAULT;
+	}
 
-		key = irq_lock();
-		node = sys_slist_get_not_empty(&event_list);
-		irq_unlock(key);
+	(void)sys_heap_runtime_stats_get(&heap.heap, &heap_stats);
 
-		evt = CONTAINER_OF(node, struct bm_scheduler_event, node);
-		LOG_DBG("Dispatching event %p to handler %p", evt, evt->handler);
-		evt->handler(evt->data, evt->len);
+	*out = (struct bm_scheduler_stats) {
+		.queue_depth = atomic_get(&stats.depth),
+		.queue_depth_peak = atomic_get(&stats.depth_peak),
+		.heap_peak = heap_stats.max_allocated_bytes,
+		.dispatched = stats.dispatched,
+		.latency_max = stats.latency_max,
+		.latency_avg = stats.dispatched ? (stats.latency_sum / stats.dispatched) : 0,
+		.untracked = stats.untracked,
+	};
 
-		k_heap_free(&heap, evt);
+	return 0;
+}
+
+int bm_scheduler_handler_stats_get(size_t idx, struct bm_scheduler_handler_stats *out)
+{
+	if (!out) {
+		return -EFAULT;
 	}
+	if ((idx >= ARRAY_SIZE(stats.handlers)) || !stats.handlers[idx].handler) {
+		return -ENOENT;
+	}
+
+	*out = stats.handlers[idx];
 
 	return 0;
 }
 
+void bm_scheduler_stats_reset(void)
+{
+	atomic_set(&stats.depth_peak, atomic_get(&stats.depth));
+	(void)sys_heap_runtime_stats_reset_max(&heap.heap);
+
+	stats.dispatched = 0;
+	stats.latency_max = 0;
+	stats.latency_sum = 0;
+	stats.untracked = 0;
+	memset(stats.handlers, 0, sizeof(stats.handlers));
+}
+#endif /* CONFIG_BM_SCHEDULER_STATS */
+
 static int bm_scheduler_init(void)
 {
-	sys_slist_init(&event_list);
+	for (size_t prio = 0; prio < ARRAY_SIZE(event_queue); prio++) {
+		evt_queue_init(&event_queue[prio]);
+	}
+
 	LOG_DBG("Event scheduler initialized");
 
 	return 0;
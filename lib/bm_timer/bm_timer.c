@@ -9,6 +9,7 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/__assert.h>
+#include "bm_timer_internal.h"
 
 LOG_MODULE_REGISTER(bm_timer, CONFIG_BM_TIMER_LOG_LEVEL);
 
@@ -27,6 +28,8 @@ static void irq_prio_lvl_configure(void)
 	LOG_DBG("Timer IRQ priority level set to %d", CONFIG_BM_TIMER_IRQ_PRIO);
 }
 
+#if defined(CONFIG_BM_TIMER_BACKEND_KERNEL)
+
 static void bm_timer_handler(struct k_timer *timer)
 {
 	__ASSERT(timer, "timer is NULL");
@@ -34,6 +37,21 @@ static void bm_timer_handler(struct k_timer *timer)
 	struct bm_timer *bm_timer = CONTAINER_OF(timer, struct bm_timer, timer);
 	void *context = k_timer_user_data_get(timer);
 
+	if (bm_timer->slack && bm_timer->mode == BM_TIMER_MODE_REPEATED) {
+		/* Lazy timers are single-shot kernel timers, re-armed from the nominal expiry
+		 * so that the alignment does not make the period drift.
+		 */
+		const uint64_t now = k_uptime_ticks();
+		uint64_t expiry;
+
+		do {
+			bm_timer->expiry += bm_timer->period;
+			expiry = bm_timer_expiry_align(bm_timer->expiry, bm_timer->slack);
+		} while (expiry <= now);
+
+		k_timer_start(timer, K_TIMEOUT_ABS_TICKS(expiry), K_NO_WAIT);
+	}
+
 	bm_timer->handler(context);
 }
 
@@ -64,12 +82,43 @@ int bm_timer_start(struct bm_timer *timer, uint32_t timeout_ticks, void *context
 	k_timeout_t duration = { .ticks = timeout_ticks };
 	k_timeout_t period = (timer->mode == BM_TIMER_MODE_SINGLE_SHOT) ? K_NO_WAIT : duration;
 
+	timer->slack = 0;
+
 	k_timer_user_data_set(&timer->timer, context);
 	k_timer_start(&timer->timer, duration, period);
 
 	return 0;
 }
 
+int bm_timer_start_lazy(struct bm_timer *timer, uint32_t timeout_ticks, uint32_t slack_ticks,
+			void *context)
+{
+	if (slack_ticks == 0) {
+		return bm_timer_start(timer, timeout_ticks, context);
+	}
+
+	if (timer == NULL) {
+		return -EFAULT;
+	}
+
+	if (timeout_ticks < BM_TIMER_MIN_TIMEOUT_TICKS) {
+		return -EINVAL;
+	}
+
+	k_timer_stop(&timer->timer);
+
+	timer->period = timeout_ticks;
+	timer->slack = slack_ticks;
+	timer->expiry = k_uptime_ticks() + timeout_ticks;
+
+	k_timer_user_data_set(&timer->timer, context);
+	k_timer_start(&timer->timer,
+		      K_TIMEOUT_ABS_TICKS(bm_timer_expiry_align(timer->expiry, timer->slack)),
+		      K_NO_WAIT);
+
+	return 0;
+}
+
 int bm_timer_stop(struct bm_timer *timer)
 {
 	if (timer == NULL) {
@@ -81,6 +130,8 @@ int bm_timer_stop(struct bm_timer *timer)
 	return 0;
 }
 
+#endif /* CONFIG_BM_TIMER_BACKEND_KERNEL */
+
 static int bm_timer_sys_init(void)
 {
 	irq_prio_lvl_configure();
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef BM_TIMER_INTERNAL_H__
+#define BM_TIMER_INTERNAL_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Align the expiry of a timer within its tolerance window.
+ *
+ * The expiry is rounded up to a multiple of the largest power of two that does not
+ * exceed the slack. The grids of different slacks are nested, so timers whose
+ * tolerance windows overlap tend to be aligned to the same tick.
+ *
+ * @param expiry Nominal expiry time, in absolute ticks.
+ * @param slack Slack, in ticks.
+ *
+ * @return Aligned expiry time, in absolute ticks.
+ */
+static inline uint64_t bm_timer_expiry_align(uint64_t expiry, uint32_t slack)
+{
+	uint64_t grid;
+
+	if (slack == 0) {
+		return expiry;
+	}
+
+	grid = 1ULL << (31 - __builtin_clz(slack));
+
+	return (expiry + grid - 1) & ~(grid - 1);
+}
+
+#endif /* BM_TIMER_INTERNAL_H__ */
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <bm/bm_timer.h>
+#include <zephyr/drivers/timer/nrf_grtc_timer.h>
+#include <zephyr/init.h>
+#include <zephyr/irq.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/dlist.h>
+#include <zephyr/sys/util.h>
+#include "bm_timer_internal.h"
+
+LOG_MODULE_DECLARE(bm_timer, CONFIG_BM_TIMER_LOG_LEVEL);
+
+/* Each level has 32 slots, so that the occupied slots of a level fit in a 32-bit word. */
+#define WHEEL_BITS 5
+#define WHEEL_SLOTS BIT(WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS CONFIG_BM_TIMER_WHEEL_LEVELS
+#define WHEEL_RANGE BIT64(WHEEL_BITS * WHEEL_LEVELS)
+
+/* Level of timers that have expired and are waiting to be dispatched. */
+#define LEVEL_EXPIRED UINT8_MAX
+
+#define NO_EVENT UINT64_MAX
+
+static struct {
+	/* GRTC compare channel. */
+	int32_t chan;
+	/* Current time of the wheel, in ticks. Lags behind the GRTC between events. */
+	uint64_t now;
+	/* Time of the event programmed in the GRTC compare channel, in ticks. */
+	uint64_t next;
+	/* Bitmap of the non-empty slots of each level. */
+	uint32_t occupied[WHEEL_LEVELS];
+	sys_dlist_t slots[WHEEL_LEVELS][WHEEL_SLOTS];
+	/* Timers that have expired and are waiting to be dispatched. */
+	sys_dlist_t expired;
+} wheel;
+
+static inline uint64_t ticks_now(void)
+{
+	return k_cyc_to_ticks_floor64(z_nrf_grtc_timer_read());
+}
+
+static inline uint32_t rotr(uint32_t val, uint32_t n)
+{
+	n &= 31;
+
+	return n ? ((val >> n) | (val << (32 - n))) : val;
+}
+
+static void wheel_insert(struct bm_timer *timer)
+{
+	/* Lazy timers are placed at their aligned expiry, to share the wakeup with others. */
+	uint64_t pos = bm_timer_expiry_align(timer->expiry, timer->slack);
+	uint64_t delta = (pos > wheel.now) ? (pos - wheel.now) : 0;
+	uint8_t level = 0;
+
+	if (delta >= WHEEL_RANGE) {
+		/* Park the timer in the top level, it is re-inserted when that slot is reached. */
+		delta = WHEEL_RANGE - 1;
+		pos = wheel.now + delta;
+	}
+
+	while (delta >= BIT64(WHEEL_BITS * (level + 1))) {
+		level++;
+	}
+
+	timer->level = level;
+	timer->slot = (pos >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+	sys_dlist_append(&wheel.slots[level][timer->slot], &timer->node);
+	wheel.occupied[level] |= BIT(timer->slot);
+}
+
+static void wheel_remove(struct bm_timer *timer)
+{
+	sys_dlist_remove(&timer->node);
+
+	if (timer->level != LEVEL_EXPIRED &&
+	    sys_dlist_is_empty(&wheel.slots[timer->level][timer->slot])) {
+		wheel.occupied[timer->level] &= ~BIT(timer->slot);
+	}
+}
+
+/* Time at which the wheel has to be processed next, in ticks. */
+static uint64_t wheel_next_event(void)
+{
+	uint64_t next = NO_EVENT;
+
+	for (size_t level = 0; level < WHEEL_LEVELS; level++) {
+		const uint32_t shift = WHEEL_BITS * level;
+		const uint32_t cur = (wheel.now >> shift) & WHEEL_MASK;
+		uint32_t dist;
+
+		if (!wheel.occupied[level]) {
+			continue;
+		}
+
+		/* Distance to the next non-empty slot, from 1 to WHEEL_SLOTS. */
+		dist = __builtin_ctz(rotr(wheel.occupied[level], cur + 1)) + 1;
+
+		next = MIN(next, ((wheel.now >> shift) + dist) << shift);
+	}
+
+	return next;
+}
+
+/* Re-insert the timers of a slot into the lower levels. */
+static void wheel_cascade(size_t level, uint32_t slot)
+{
+	sys_dlist_t *list = &wheel.slots[level][slot];
+	sys_dnode_t *node;
+	sys_dlist_t tmp;
+
+	sys_dlist_init(&tmp);
+	while ((node = sys_dlist_get(list)) != NULL) {
+		sys_dlist_append(&tmp, node);
+	}
+	wheel.occupied[level] &= ~BIT(slot);
+
+	while ((node = sys_dlist_get(&tmp)) != NULL) {
+		wheel_insert(CONTAINER_OF(node, struct bm_timer, node));
+	}
+}
+
+/* Process the wheel at the current time. */
+static void wheel_tick(void)
+{
+	const uint32_t slot = wheel.now & WHEEL_MASK;
+	sys_dnode_t *node;
+
+	for (size_t level = 1; level < WHEEL_LEVELS; level++) {
+		if ((wheel.now >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK) {
+			break;
+		}
+		wheel_cascade(level, (wheel.now >> (WHEEL_BITS * level)) & WHEEL_MASK);
+	}
+
+	while ((node = sys_dlist_get(&wheel.slots[0][slot])) != NULL) {
+		CONTAINER_OF(node, struct bm_timer, node)->level = LEVEL_EXPIRED;
+		sys_dlist_append(&wheel.expired, node);
+	}
+	wheel.occupied[0] &= ~BIT(slot);
+}
+
+/* Advance the wheel to the given time, collecting expired timers. */
+static void wheel_advance(uint64_t target)
+{
+	uint64_t next;
+
+	/* Skip directly to the next non-empty slot, nothing happens in between. */
+	while ((next = wheel_next_event()) <= target) {
+		wheel.now = next;
+		wheel_tick();
+	}
+
+	wheel.now = MAX(wheel.now, target);
+}
+
+/* Bring the wheel time up to date, without processing any events. */
+static void wheel_sync(void)
+{
+	const uint64_t now = ticks_now();
+	const uint64_t next = wheel_next_event();
+
+	if (next > now) {
+		wheel.now = MAX(wheel.now, now);
+	} else {
+		/* Events are due and will be processed by the compare handler. */
+		wheel.now = MAX(wheel.now, next - 1);
+	}
+}
+
+static void grtc_handler(int32_t id, uint64_t expire_time, void *user_data);
+
+static void wheel_program(void)
+{
+	const uint64_t next = wheel_next_event();
+
+	if (next == wheel.next) {
+		return;
+	}
+
+	wheel.next = next;
+
+	if (next == NO_EVENT) {
+		z_nrf_grtc_timer_abort(wheel.chan);
+		return;
+	}
+
+	(void)z_nrf_grtc_timer_set(wheel.chan, k_ticks_to_cyc_ceil64(next), grtc_handler, NULL);
+}
+
+static void grtc_handler(int32_t id, uint64_t expire_time, void *user_data)
+{
+	struct bm_timer *timer;
+	sys_dnode_t *node;
+	bm_timer_timeout_handler_t handler;
+	void *context;
+	unsigned int key;
+
+	ARG_UNUSED(id);
+	ARG_UNUSED(expire_time);
+	ARG_UNUSED(user_data);
+
+	key = irq_lock();
+	wheel.next = NO_EVENT;
+	wheel_advance(ticks_now());
+	irq_unlock(key);
+
+	/* Dispatch one timer at a time, so that handlers can start and stop any timer. */
+	for (;;) {
+		key = irq_lock();
+
+		node = sys_dlist_get(&wheel.expired);
+		if (!node) {
+			irq_unlock(key);
+			break;
+		}
+
+		timer = CONTAINER_OF(node, struct bm_timer, node);
+		handler = timer->handler;
+		context = timer->context;
+
+		if (timer->mode == BM_TIMER_MODE_REPEATED) {
+			/* Skip the periods that were missed, if any. */
+			do {
+				timer->expiry += timer->period;
+			} while (bm_timer_expiry_align(timer->expiry, timer->slack) <= wheel.now);
+
+			wheel_insert(timer);
+		}
+
+		irq_unlock(key);
+
+		handler(context);
+	}
+
+	key = irq_lock();
+	wheel_program();
+	irq_unlock(key);
+}
+
+int bm_timer_init(struct bm_timer *timer, enum bm_timer_mode mode,
+		  bm_timer_timeout_handler_t timeout_handler)
+{
+	if (timer == NULL || timeout_handler == NULL) {
+		return -EFAULT;
+	}
+
+	timer->mode = mode;
+	timer->handler = timeout_handler;
+	sys_dnode_init(&timer->node);
+
+	return 0;
+}
+
+int bm_timer_start_lazy(struct bm_timer *timer, uint32_t timeout_ticks, uint32_t slack_ticks,
+			void *context)
+{
+	unsigned int key;
+
+	if (timer == NULL) {
+		return -EFAULT;
+	}
+
+	if (timeout_ticks < BM_TIMER_MIN_TIMEOUT_TICKS) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+
+	if (sys_dnode_is_linked(&timer->node)) {
+		wheel_remove(timer);
+	}
+
+	wheel_sync();
+
+	timer->context = context;
+	timer->period = timeout_ticks;
+	timer->slack = slack_ticks;
+	timer->expiry = ticks_now() + timeout_ticks;
+
+	wheel_insert(timer);
+	wheel_program();
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+int bm_timer_start(struct bm_timer *timer, uint32_t timeout_ticks, void *context)
+{
+	return bm_timer_start_lazy(timer, timeout_ticks, 0, context);
+}
+
+int bm_timer_stop(struct bm_timer *timer)
+{
+	unsigned int key;
+
+	if (timer == NULL) {
+		return -EFAULT;
+	}
+
+	key = irq_lock();
+
+	if (sys_dnode_is_linked(&timer->node)) {
+		wheel_remove(timer);
+		wheel_program();
+	}
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+static int bm_timer_wheel_init(void)
+{
+	wheel.chan = z_nrf_grtc_timer_chan_alloc();
+	if (wheel.chan < 0) {
+		LOG_ERR("Failed to allocate GRTC channel, err %d", wheel.chan);
+		return -ENOMEM;
+	}
+
+	for (size_t level = 0; level < WHEEL_LEVELS; level++) {
+		for (size_t slot = 0; slot < WHEEL_SLOTS; slot++) {
+			sys_dlist_init(&wheel.slots[level][slot]);
+		}
+	}
+	sys_dlist_init(&wheel.expired);
+
+	wheel.now = ticks_now();
+	wheel.next = NO_EVENT;
+
+	LOG_DBG("Timer wheel using GRTC channel %d", wheel.chan);
+
+	return 0;
+}
+
+SYS_INIT(bm_timer_wheel_init, APPLICATION, 0);
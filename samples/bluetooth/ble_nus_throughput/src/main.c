@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <nrf_error.h>
+#include <string.h>
+#include <ble_gap.h>
+#include <bm/bm_timer.h>
+#include <bm/softdevice_handler/nrf_sdh.h>
+#include <bm/softdevice_handler/nrf_sdh_ble.h>
+#include <bm/bluetooth/ble_adv.h>
+#include <bm/bluetooth/ble_conn_params.h>
+#include <bm/bluetooth/ble_qwr.h>
+#include <bm/bluetooth/services/ble_nus.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#include <bm/shell/backend_bm_uarte.h>
+#endif
+
+LOG_MODULE_REGISTER(sample, CONFIG_SAMPLE_BLE_NUS_THROUGHPUT_LOG_LEVEL);
+
+#define LINK_COUNT CONFIG_NRF_SDH_BLE_PERIPHERAL_LINK_COUNT
+
+BLE_ADV_DEF(ble_adv); /* BLE advertising instance */
+BLE_NUS_DEF(ble_nus); /* BLE NUS service instance */
+
+/* One Queued Writes instance per link. */
+static struct ble_qwr ble_qwr[LINK_COUNT];
+
+#define BLE_QWR_OBSERVER(i, _)                                                                     \
+	NRF_SDH_BLE_OBSERVER(ble_qwr_obs_##i, ble_qwr_on_ble_evt, &ble_qwr[i], HIGH)
+
+LISTIFY(LINK_COUNT, BLE_QWR_OBSERVER, (;));
+
+/* Throughput statistics of a link. The counters are never reset, the report uses their deltas. */
+struct link_stats {
+	/* Connection handle, or BLE_CONN_HANDLE_INVALID if the link is not connected. */
+	uint16_t conn_handle;
+	/* Connection interval, in 1.25 ms units. */
+	uint16_t conn_interval;
+	/* Bytes accepted by the NUS TX stream. This runs ahead of the bytes the peer has
+	 * received by up to the size of the TX buffer.
+	 */
+	uint32_t bytes;
+	/* Notifications sent, as reported by the SoftDevice. */
+	uint32_t notifications;
+	/* Writes refused because the TX stream of the link was full. */
+	uint32_t stalls;
+	/* Report intervals and connection events while the link was connected. */
+	uint32_t reports;
+	uint32_t conn_events;
+	/* The TX stream is full, wait for @ref BLE_NUS_EVT_TX_RDY before writing again. */
+	bool stalled;
+};
+
+static struct link_stats links[LINK_COUNT];
+static uint8_t link_count;
+
+static struct bm_timer report_timer;
+
+/* Test pattern written to the NUS TX stream. */
+static uint8_t pattern[CONFIG_SAMPLE_NUS_THROUGHPUT_WRITE_SIZE];
+
+static struct link_stats *link_get(uint16_t conn_handle)
+{
+	const int idx = nrf_sdh_ble_idx_get(conn_handle);
+
+	if (idx < 0 || idx >= LINK_COUNT) {
+		return NULL;
+	}
+
+	return &links[idx];
+}
+
+/* Fill the TX stream of a link until it is full. */
+static void link_fill(struct link_stats *link)
+{
+	uint32_t nrf_err;
+	uint16_t len;
+
+	link->stalled = false;
+
+	while (link->conn_handle != BLE_CONN_HANDLE_INVALID) {
+		len = sizeof(pattern);
+		nrf_err = ble_nus_write(&ble_nus, pattern, &len, link->conn_handle);
+		link->bytes += (nrf_err == NRF_SUCCESS) ? len : 0;
+
+		if (nrf_err == NRF_ERROR_RESOURCES) {
+			link->stalls++;
+			link->stalled = true;
+			break;
+		} else if (nrf_err) {
+			LOG_ERR("Failed to write NUS data, nrf_error %#x", nrf_err);
+			break;
+		}
+	}
+}
+
+static void report_timeout_handler(void *context)
+{
+	/* Counters at the previous report. */
+	static struct link_stats prev[LINK_COUNT];
+	uint32_t total_bytes = 0;
+	uint32_t bytes;
+	uint32_t notifications;
+	uint32_t stalls;
+	uint32_t evts;
+
+	ARG_UNUSED(context);
+
+	for (size_t i = 0; i < LINK_COUNT; i++) {
+		bytes = links[i].bytes - prev[i].bytes;
+		notifications = links[i].notifications - prev[i].notifications;
+		stalls = links[i].stalls - prev[i].stalls;
+
+		prev[i].bytes += bytes;
+		prev[i].notifications += notifications;
+		prev[i].stalls += stalls;
+
+		if (links[i].conn_handle == BLE_CONN_HANDLE_INVALID) {
+			continue;
+		}
+
+		/* Connection events in the report interval, the connection interval is in 1.25 ms. */
+		evts = MAX(1, (CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL * 4) /
+			      (links[i].conn_interval * 5));
+
+		links[i].reports++;
+		links[i].conn_events += evts;
+
+		LOG_INF("Link %d: %u kbps accepted, %u.%02u notifications per connection event, "
+			"%u stalls",
+			links[i].conn_handle, bytes * 8 / CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL,
+			notifications / evts, (notifications % evts) * 100 / evts, stalls);
+
+		total_bytes += bytes;
+	}
+
+	if (link_count > 1) {
+		LOG_INF("Total: %u kbps accepted over %d links",
+			total_bytes * 8 / CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL, link_count);
+	}
+}
+
+#if defined(CONFIG_SHELL)
+/* Counters at the last reset of the statistics from the shell. */
+static struct link_stats shell_base[LINK_COUNT];
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	struct link_stats stats[LINK_COUNT];
+	uint32_t total_kbps = 0;
+	uint32_t reports;
+	uint32_t notifications;
+	uint32_t evts;
+	uint32_t kbps;
+	unsigned int key;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	/* The counters are updated from the SoftDevice event handlers. */
+	key = irq_lock();
+	memcpy(stats, links, sizeof(stats));
+	irq_unlock(key);
+
+	shell_print(sh, "Link  Reports    Accepted   Notif/evt  Stalls");
+	for (size_t i = 0; i < LINK_COUNT; i++) {
+		reports = stats[i].reports - shell_base[i].reports;
+		if (reports == 0) {
+			continue;
+		}
+
+		notifications = stats[i].notifications - shell_base[i].notifications;
+		evts = MAX(1, stats[i].conn_events - shell_base[i].conn_events);
+		kbps = ((uint64_t)(stats[i].bytes - shell_base[i].bytes) * 8) /
+		       ((uint64_t)reports * CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL);
+
+		shell_print(sh, "%-4zu  %-9u  %-9u  %6u.%02u  %u", i, reports, kbps,
+			    notifications / evts, (notifications % evts) * 100 / evts,
+			    stats[i].stalls - shell_base[i].stalls);
+
+		total_kbps += kbps;
+	}
+
+	shell_print(sh, "Total: %u kbps accepted", total_kbps);
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	unsigned int key;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	key = irq_lock();
+	memcpy(shell_base, links, sizeof(shell_base));
+	irq_unlock(key);
+
+	shell_print(sh, "Statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_throughput,
+	SHELL_CMD(stats, NULL, "Print the throughput statistics since the last reset", cmd_stats),
+	SHELL_CMD(reset, NULL, "Reset the throughput statistics", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(throughput, &sub_throughput, "NUS throughput commands", NULL);
+#endif /* CONFIG_SHELL */
+
+/* Wait for the next event, or for data received by the shell. */
+static void wait_for_event(void)
+{
+#if defined(CONFIG_SHELL)
+	const unsigned int key = irq_lock();
+
+	if (shell_backend_bm_uarte_rx_ready()) {
+		/* Process pending RX data */
+		irq_unlock(key);
+		return;
+	}
+
+	k_cpu_atomic_idle(key);
+#else
+	k_cpu_idle();
+#endif
+}
+
+static void adv_start(void)
+{
+	uint32_t nrf_err;
+
+	if (link_count >= LINK_COUNT) {
+		return;
+	}
+
+	nrf_err = ble_adv_start(&ble_adv, BLE_ADV_MODE_FAST);
+	if (nrf_err) {
+		LOG_ERR("Failed to start advertising, nrf_error %#x", nrf_err);
+	}
+}
+
+static void on_ble_evt(const ble_evt_t *evt, void *ctx)
+{
+	uint32_t nrf_err;
+	struct link_stats *link;
+
+	switch (evt->header.evt_id) {
+	case BLE_GAP_EVT_CONNECTED:
+		LOG_INF("Peer connected, conn_handle %d", evt->evt.gap_evt.conn_handle);
+
+		link = link_get(evt->evt.gap_evt.conn_handle);
+		if (!link) {
+			break;
+		}
+
+		link->conn_handle = evt->evt.gap_evt.conn_handle;
+		link->conn_interval = evt->evt.gap_evt.params.connected.conn_params.max_conn_interval;
+		link->stalled = false;
+		link_count++;
+
+		nrf_err = ble_qwr_conn_handle_assign(&ble_qwr[link - links],
+						     evt->evt.gap_evt.conn_handle);
+		if (nrf_err) {
+			LOG_ERR("Failed to assign qwr handle, nrf_error %#x", nrf_err);
+		}
+
+		/* Advertise again until all links are connected. */
+		adv_start();
+		break;
+
+	case BLE_GAP_EVT_DISCONNECTED:
+		LOG_INF("Peer disconnected, conn_handle %d, reason %#x",
+			evt->evt.gap_evt.conn_handle, evt->evt.gap_evt.params.disconnected.reason);
+
+		link = link_get(evt->evt.gap_evt.conn_handle);
+		if (!link) {
+			break;
+		}
+
+		link->conn_handle = BLE_CONN_HANDLE_INVALID;
+		link_count--;
+
+		adv_start();
+		break;
+
+	case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+		link = link_get(evt->evt.gatts_evt.conn_handle);
+		if (link) {
+			link->notifications += evt->evt.gatts_evt.params.hvn_tx_complete.count;
+		}
+		break;
+
+	case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
+		/* Pairing not supported */
+		nrf_err = sd_ble_gap_sec_params_reply(evt->evt.gap_evt.conn_handle,
+						      BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP,
+						      NULL, NULL);
+		if (nrf_err) {
+			LOG_ERR("Failed to reply with Security params, nrf_error %#x", nrf_err);
+		}
+		break;
+
+	case BLE_GATTS_EVT_SYS_ATTR_MISSING:
+		LOG_INF("BLE_GATTS_EVT_SYS_ATTR_MISSING");
+		/* No system attributes have been stored */
+		nrf_err = sd_ble_gatts_sys_attr_set(evt->evt.gatts_evt.conn_handle, NULL, 0, 0);
+		if (nrf_err) {
+			LOG_ERR("Failed to set system attributes, nrf_error %#x", nrf_err);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+NRF_SDH_BLE_OBSERVER(sdh_ble, on_ble_evt, NULL, USER_LOW);
+
+static void on_conn_params_evt(const struct ble_conn_params_evt *evt)
+{
+	struct link_stats *link = link_get(evt->conn_handle);
+
+	switch (evt->evt_type) {
+	case BLE_CONN_PARAMS_EVT_UPDATED:
+		if (link) {
+			link->conn_interval = evt->conn_params.max_conn_interval;
+		}
+		LOG_INF("Link %d: connection interval %d units",
+			evt->conn_handle, evt->conn_params.max_conn_interval);
+		break;
+
+	case BLE_CONN_PARAMS_EVT_ATT_MTU_UPDATED:
+		LOG_INF("Link %d: ATT MTU %d", evt->conn_handle, evt->att_mtu);
+		break;
+
+	case BLE_CONN_PARAMS_EVT_DATA_LENGTH_UPDATED:
+		LOG_INF("Link %d: data length TX %d, RX %d",
+			evt->conn_handle, evt->data_length.tx, evt->data_length.rx);
+		break;
+
+	case BLE_CONN_PARAMS_EVT_RADIO_PHY_MODE_UPDATED:
+		LOG_INF("Link %d: PHY TX %#x, RX %#x", evt->conn_handle,
+			evt->phy_update_evt.tx_phy, evt->phy_update_evt.rx_phy);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void ble_adv_evt_handler(struct ble_adv *adv, const struct ble_adv_evt *adv_evt)
+{
+	switch (adv_evt->evt_type) {
+	case BLE_ADV_EVT_ERROR:
+		LOG_ERR("Advertising error %#x", adv_evt->error.reason);
+		break;
+	default:
+		break;
+	}
+}
+
+uint16_t ble_qwr_evt_handler(struct ble_qwr *qwr, const struct ble_qwr_evt *qwr_evt)
+{
+	switch (qwr_evt->evt_type) {
+	case BLE_QWR_EVT_ERROR:
+		LOG_ERR("QWR error event, nrf_error %#x", qwr_evt->error.reason);
+		break;
+	default:
+		break;
+	}
+
+	return BLE_GATT_STATUS_SUCCESS;
+}
+
+static void ble_nus_evt_handler(struct ble_nus *nus, const struct ble_nus_evt *evt)
+{
+	struct link_stats *link = link_get(evt->conn_handle);
+
+	if (!link) {
+		return;
+	}
+
+	switch (evt->evt_type) {
+	case BLE_NUS_EVT_COMM_STARTED:
+		LOG_INF("Link %d: notifications enabled, streaming", evt->conn_handle);
+		link_fill(link);
+		break;
+
+	case BLE_NUS_EVT_TX_RDY:
+		if (link->stalled) {
+			link_fill(link);
+		}
+		break;
+
+	case BLE_NUS_EVT_ERROR:
+		LOG_ERR("NUS error event, nrf_error %#x", evt->error.reason);
+		break;
+
+	default:
+		break;
+	}
+}
+
+int main(void)
+{
+	int err;
+	uint32_t nrf_err;
+	ble_gap_conn_sec_mode_t device_name_write_sec;
+	struct ble_adv_config ble_adv_cfg = {
+		.conn_cfg_tag = CONFIG_NRF_SDH_BLE_CONN_TAG,
+		.evt_handler = ble_adv_evt_handler,
+		.adv_data = {
+			.name_type = BLE_ADV_DATA_FULL_NAME,
+			.flags = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE,
+		},
+	};
+	struct ble_nus_config nus_cfg = {
+		.evt_handler = ble_nus_evt_handler,
+		.sec_mode = BLE_NUS_CONFIG_SEC_MODE_DEFAULT,
+	};
+	struct ble_qwr_config qwr_config = {
+		.evt_handler = ble_qwr_evt_handler,
+	};
+
+#if defined(CONFIG_SHELL)
+	const struct shell_backend_config_flags cfg_flags = SHELL_DEFAULT_BACKEND_CONFIG_FLAGS;
+
+	shell_init(shell_backend_bm_uarte_get_ptr(), NULL, cfg_flags, false, 0);
+	shell_start(shell_backend_bm_uarte_get_ptr());
+#endif
+
+	LOG_INF("BLE NUS throughput sample started");
+
+	for (size_t i = 0; i < ARRAY_SIZE(links); i++) {
+		links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+	}
+
+	for (size_t i = 0; i < sizeof(pattern); i++) {
+		pattern[i] = i;
+	}
+
+	err = nrf_sdh_enable_request();
+	if (err) {
+		LOG_ERR("Failed to enable SoftDevice, err %d", err);
+		goto idle;
+	}
+
+	LOG_INF("SoftDevice enabled");
+
+	err = nrf_sdh_ble_enable(CONFIG_NRF_SDH_BLE_CONN_TAG);
+	if (err) {
+		LOG_ERR("Failed to enable BLE, err %d", err);
+		goto idle;
+	}
+
+	LOG_INF("Bluetooth enabled");
+
+	BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&device_name_write_sec);
+	nrf_err = sd_ble_gap_device_name_set(&device_name_write_sec, CONFIG_SAMPLE_BLE_DEVICE_NAME,
+					     strlen(CONFIG_SAMPLE_BLE_DEVICE_NAME));
+	if (nrf_err) {
+		LOG_ERR("Failed to set device name, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(ble_qwr); i++) {
+		nrf_err = ble_qwr_init(&ble_qwr[i], &qwr_config);
+		if (nrf_err) {
+			LOG_ERR("ble_qwr_init failed, nrf_error %#x", nrf_err);
+			goto idle;
+		}
+	}
+
+	nrf_err = ble_nus_init(&ble_nus, &nus_cfg);
+	if (nrf_err) {
+		LOG_ERR("Failed to initialize Nordic uart service, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	/* Adding the Nordic UART Service UUID to the scan response data. */
+	ble_uuid_t adv_uuid_list[] = {
+		/* Using a vendor specific UUID type that was added during NUS initialization. */
+		{ .uuid = BLE_UUID_NUS_SERVICE, .type = ble_nus.uuid_type },
+	};
+	ble_adv_cfg.sr_data.uuid_lists.complete.uuid = &adv_uuid_list[0];
+	ble_adv_cfg.sr_data.uuid_lists.complete.len = ARRAY_SIZE(adv_uuid_list);
+
+	nrf_err = ble_conn_params_evt_handler_set(on_conn_params_evt);
+	if (nrf_err) {
+		LOG_ERR("Failed to setup conn param event handler, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	nrf_err = ble_adv_init(&ble_adv, &ble_adv_cfg);
+	if (nrf_err) {
+		LOG_ERR("Failed to initialize advertising, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	err = bm_timer_init(&report_timer, BM_TIMER_MODE_REPEATED, report_timeout_handler);
+	if (err) {
+		LOG_ERR("Failed to initialize report timer, err %d", err);
+		goto idle;
+	}
+
+	err = bm_timer_start(&report_timer,
+			     BM_TIMER_MS_TO_TICKS(CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL), NULL);
+	if (err) {
+		LOG_ERR("Failed to start report timer, err %d", err);
+		goto idle;
+	}
+
+	LOG_INF("BLE NUS throughput sample initialized");
+
+	adv_start();
+
+	LOG_INF("Advertising as %s, up to %d links", CONFIG_SAMPLE_BLE_DEVICE_NAME, LINK_COUNT);
+
+idle:
+	while (true) {
+#if defined(CONFIG_SHELL)
+		shell_process(shell_backend_bm_uarte_get_ptr());
+#endif
+		log_flush();
+
+		wait_for_event();
+	}
+
+	return 0;
+}
@@ -0,0 +1,571 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <ble.h>
+#include <bm/bm_timer.h>
+
+#include <bm/bluetooth/ble_conn_params.h>
+#include <bm/bluetooth/ble_db_discovery.h>
+#include <bm/bluetooth/ble_gq.h>
+#include <bm/bluetooth/ble_scan.h>
+#include <bm/softdevice_handler/nrf_sdh.h>
+#include <bm/softdevice_handler/nrf_sdh_ble.h>
+
+#include <bm/bluetooth/services/ble_nus_client.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#include <bm/shell/backend_bm_uarte.h>
+#endif
+
+LOG_MODULE_REGISTER(sample, CONFIG_SAMPLE_BLE_NUS_THROUGHPUT_CENTRAL_LOG_LEVEL);
+
+#define LINK_COUNT CONFIG_NRF_SDH_BLE_CENTRAL_LINK_COUNT
+
+/* Scanning Module instance. */
+BLE_SCAN_DEF(ble_scan);
+/* BLE GATT Queue instance. */
+BLE_GQ_DEF(ble_gq);
+
+/* One database discovery instance discovers all links in parallel. */
+BLE_DB_DISCOVERY_DEF(ble_db_disc);
+
+/* One BLE NUS client per link. */
+static struct ble_nus_client ble_nus_client[LINK_COUNT];
+
+#define BLE_NUS_CLIENT_OBSERVER(i, _)                                                              \
+	NRF_SDH_BLE_OBSERVER(ble_nus_client_obs_##i, ble_nus_client_on_ble_evt,                    \
+			     &ble_nus_client[i], HIGH)
+
+LISTIFY(LINK_COUNT, BLE_NUS_CLIENT_OBSERVER, (;));
+
+/* Throughput statistics of a link. The counters are never reset, the report uses their deltas. */
+struct link_stats {
+	/* Connection handle, or BLE_CONN_HANDLE_INVALID if the link is not connected. */
+	uint16_t conn_handle;
+	/* Connection interval, in 1.25 ms units. */
+	uint16_t conn_interval;
+	/* Bytes received in notifications. */
+	uint32_t bytes;
+	/* Notifications received. */
+	uint32_t notifications;
+	/* Report intervals and connection events while the link was connected. */
+	uint32_t reports;
+	uint32_t conn_events;
+};
+
+static struct link_stats links[LINK_COUNT];
+static uint8_t link_count;
+
+static struct bm_timer report_timer;
+
+static struct link_stats *link_get(uint16_t conn_handle)
+{
+	const int idx = nrf_sdh_ble_idx_get(conn_handle);
+
+	if (idx < 0 || idx >= LINK_COUNT) {
+		return NULL;
+	}
+
+	return &links[idx];
+}
+
+static void scan_start(void)
+{
+	uint32_t nrf_err;
+
+	if (link_count >= LINK_COUNT) {
+		return;
+	}
+
+	nrf_err = ble_scan_start(&ble_scan);
+	if (nrf_err) {
+		LOG_ERR("Failed to start scanning, nrf_error %#x", nrf_err);
+	}
+}
+
+static void report_timeout_handler(void *context)
+{
+	/* Counters at the previous report. */
+	static struct link_stats prev[LINK_COUNT];
+	uint32_t total_bytes = 0;
+	uint32_t bytes;
+	uint32_t notifications;
+	uint32_t evts;
+
+	ARG_UNUSED(context);
+
+	for (size_t i = 0; i < LINK_COUNT; i++) {
+		bytes = links[i].bytes - prev[i].bytes;
+		notifications = links[i].notifications - prev[i].notifications;
+
+		prev[i].bytes += bytes;
+		prev[i].notifications += notifications;
+
+		if (links[i].conn_handle == BLE_CONN_HANDLE_INVALID) {
+			continue;
+		}
+
+		/* Connection events in the report interval, the connection interval is in 1.25 ms. */
+		evts = MAX(1, (CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL * 4) /
+			      (links[i].conn_interval * 5));
+
+		links[i].reports++;
+		links[i].conn_events += evts;
+
+		LOG_INF("Link %d: %u kbps, %u.%02u notifications per connection event",
+			links[i].conn_handle, bytes * 8 / CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL,
+			notifications / evts, (notifications % evts) * 100 / evts);
+
+		total_bytes += bytes;
+	}
+
+	if (link_count > 1) {
+		LOG_INF("Total: %u kbps over %d links",
+			total_bytes * 8 / CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL, link_count);
+	}
+}
+
+#if defined(CONFIG_SHELL)
+/* Counters at the last reset of the statistics from the shell. */
+static struct link_stats shell_base[LINK_COUNT];
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	struct link_stats stats[LINK_COUNT];
+	uint32_t total_kbps = 0;
+	uint32_t reports;
+	uint32_t notifications;
+	uint32_t evts;
+	uint32_t kbps;
+	unsigned int key;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	/* The counters are updated from the SoftDevice event handlers. */
+	key = irq_lock();
+	memcpy(stats, links, sizeof(stats));
+	irq_unlock(key);
+
+	shell_print(sh, "Link  Reports    kbps       Notif/evt");
+	for (size_t i = 0; i < LINK_COUNT; i++) {
+		reports = stats[i].reports - shell_base[i].reports;
+		if (reports == 0) {
+			continue;
+		}
+
+		notifications = stats[i].notifications - shell_base[i].notifications;
+		evts = MAX(1, stats[i].conn_events - shell_base[i].conn_events);
+		kbps = ((uint64_t)(stats[i].bytes - shell_base[i].bytes) * 8) /
+		       ((uint64_t)reports * CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL);
+
+		shell_print(sh, "%-4zu  %-9u  %-9u  %6u.%02u", i, reports, kbps,
+			    notifications / evts, (notifications % evts) * 100 / evts);
+
+		total_kbps += kbps;
+	}
+
+	shell_print(sh, "Total: %u kbps", total_kbps);
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	unsigned int key;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	key = irq_lock();
+	memcpy(shell_base, links, sizeof(shell_base));
+	irq_unlock(key);
+
+	shell_print(sh, "Statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_throughput,
+	SHELL_CMD(stats, NULL, "Print the throughput statistics since the last reset", cmd_stats),
+	SHELL_CMD(reset, NULL, "Reset the throughput statistics", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(throughput, &sub_throughput, "NUS throughput commands", NULL);
+#endif /* CONFIG_SHELL */
+
+/* Wait for the next event, or for data received by the shell. */
+static void wait_for_event(void)
+{
+#if defined(CONFIG_SHELL)
+	const unsigned int key = irq_lock();
+
+	if (shell_backend_bm_uarte_rx_ready()) {
+		/* Process pending RX data */
+		irq_unlock(key);
+		return;
+	}
+
+	k_cpu_atomic_idle(key);
+#else
+	k_cpu_idle();
+#endif
+}
+
+static void on_ble_evt(const ble_evt_t *ble_evt, void *context)
+{
+	uint32_t nrf_err;
+	const ble_gap_evt_t *const gap_evt = &ble_evt->evt.gap_evt;
+	struct link_stats *link;
+
+	switch (ble_evt->header.evt_id) {
+	case BLE_GAP_EVT_CONNECTED:
+		link = link_get(gap_evt->conn_handle);
+		if (!link) {
+			break;
+		}
+
+		link->conn_handle = gap_evt->conn_handle;
+		link->conn_interval = gap_evt->params.connected.conn_params.max_conn_interval;
+		link_count++;
+
+		/* Start discovery of services. The NUS Client waits for a discovery result. */
+		nrf_err = ble_db_discovery_start(&ble_db_disc, gap_evt->conn_handle);
+		if (nrf_err) {
+			LOG_ERR("Failed to start db discovery, nrf_error %#x", nrf_err);
+		}
+
+		/* Scan again until all links are connected. */
+		scan_start();
+		break;
+	case BLE_GAP_EVT_DISCONNECTED:
+		LOG_INF("Disconnected conn_handle %#x, reason %#x",
+			gap_evt->conn_handle, gap_evt->params.disconnected.reason);
+
+		link = link_get(gap_evt->conn_handle);
+		if (!link) {
+			break;
+		}
+
+		link->conn_handle = BLE_CONN_HANDLE_INVALID;
+		link_count--;
+
+		scan_start();
+		break;
+	case BLE_GAP_EVT_TIMEOUT:
+		if (gap_evt->params.timeout.src == BLE_GAP_TIMEOUT_SRC_CONN) {
+			LOG_INF("Connection request timed out");
+		}
+		break;
+	case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
+		/* Pairing not supported. */
+		nrf_err = sd_ble_gap_sec_params_reply(ble_evt->evt.gap_evt.conn_handle,
+						      BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL,
+						      NULL);
+		if (nrf_err) {
+			LOG_ERR("gap_sec_params_reply failed, nrf_error %#x", nrf_err);
+		}
+		break;
+	case BLE_GATTC_EVT_TIMEOUT:
+		/* Disconnect on GATT Client timeout event. */
+		LOG_DBG("GATT Client Timeout");
+		nrf_err = sd_ble_gap_disconnect(ble_evt->evt.gattc_evt.conn_handle,
+						 BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+		if (nrf_err) {
+			LOG_ERR("gap_disconnect failed, nrf_error %#x", nrf_err);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+NRF_SDH_BLE_OBSERVER(sdh_ble, on_ble_evt, NULL, USER_LOW);
+
+static void conn_params_evt_handler(const struct ble_conn_params_evt *evt)
+{
+	struct link_stats *link = link_get(evt->conn_handle);
+
+	switch (evt->evt_type) {
+	case BLE_CONN_PARAMS_EVT_UPDATED:
+		if (link) {
+			link->conn_interval = evt->conn_params.max_conn_interval;
+		}
+		LOG_INF("Link %d: connection interval %d units",
+			evt->conn_handle, evt->conn_params.max_conn_interval);
+		break;
+
+	case BLE_CONN_PARAMS_EVT_ATT_MTU_UPDATED:
+		LOG_INF("Link %d: ATT MTU %d", evt->conn_handle, evt->att_mtu);
+		break;
+
+	case BLE_CONN_PARAMS_EVT_DATA_LENGTH_UPDATED:
+		LOG_INF("Link %d: data length TX %d, RX %d",
+			evt->conn_handle, evt->data_length.tx, evt->data_length.rx);
+		break;
+
+	case BLE_CONN_PARAMS_EVT_RADIO_PHY_MODE_UPDATED:
+		LOG_INF("Link %d: PHY TX %#x, RX %#x", evt->conn_handle,
+			evt->phy_update_evt.tx_phy, evt->phy_update_evt.rx_phy);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void db_disc_evt_handler(struct ble_db_discovery *ble_db_discovery,
+				struct ble_db_discovery_evt *evt)
+{
+	const struct link_stats *link = link_get(evt->conn_handle);
+
+	if (!link) {
+		return;
+	}
+
+	ble_nus_client_on_db_disc_evt(&ble_nus_client[link - links], evt);
+}
+
+static void scan_evt_handler(const struct ble_scan_evt *scan_evt)
+{
+	switch (scan_evt->evt_type) {
+	case BLE_SCAN_EVT_CONNECTING_ERROR:
+		LOG_ERR("Failed to connect, nrf_error %#x", scan_evt->connecting_err.reason);
+		break;
+
+	case BLE_SCAN_EVT_CONNECTED:
+		const ble_gap_addr_t *const peer_addr = &scan_evt->connected.connected->peer_addr;
+
+		/* Scan is automatically stopped by the connection. */
+		LOG_INF("Connecting to target %02X:%02X:%02X:%02X:%02X:%02X",
+			peer_addr->addr[5], peer_addr->addr[4], peer_addr->addr[3],
+			peer_addr->addr[2], peer_addr->addr[1], peer_addr->addr[0]);
+		break;
+
+	case BLE_SCAN_EVT_SCAN_TIMEOUT:
+		LOG_INF("Scan timed out");
+		scan_start();
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void nus_client_evt_handler(struct ble_nus_client *nus_c,
+				   const struct ble_nus_client_evt *nus_evt)
+{
+	uint32_t nrf_err;
+	struct link_stats *link;
+
+	switch (nus_evt->evt_type) {
+	case BLE_NUS_CLIENT_EVT_DISCOVERY_COMPLETE:
+		nrf_err = ble_nus_client_handles_assign(nus_c, nus_evt->conn_handle,
+							&nus_evt->discovery_complete.handles);
+		if (nrf_err) {
+			LOG_ERR("Failed to assign handles, nrf_error %#x", nrf_err);
+			break;
+		}
+		nrf_err = ble_nus_client_tx_notif_enable(nus_c);
+		if (nrf_err) {
+			LOG_ERR("Failed to enable peer tx notifications, nrf_error %#x", nrf_err);
+			break;
+		}
+		LOG_INF("Link %d: NUS discovered, receiving", nus_evt->conn_handle);
+		break;
+	case BLE_NUS_CLIENT_EVT_TX_DATA:
+		link = link_get(nus_c->conn_handle);
+		if (link) {
+			link->bytes += nus_evt->tx_data.length;
+			link->notifications++;
+		}
+		break;
+	case BLE_NUS_CLIENT_EVT_DISCONNECTED:
+		break;
+	case BLE_NUS_CLIENT_EVT_ERROR:
+		LOG_ERR("NUS error, nrf_error %#x", nus_evt->error.reason);
+		break;
+	default:
+		break;
+	}
+}
+
+static uint32_t nus_client_init(void)
+{
+	uint32_t nrf_err;
+	struct ble_nus_client_config ble_nus_client_config = {
+		.evt_handler = nus_client_evt_handler,
+		.gatt_queue = &ble_gq,
+		.db_discovery = &ble_db_disc,
+	};
+
+	for (size_t i = 0; i < LINK_COUNT; i++) {
+		nrf_err = ble_nus_client_init(&ble_nus_client[i], &ble_nus_client_config);
+		if (nrf_err) {
+			return nrf_err;
+		}
+	}
+
+	return NRF_SUCCESS;
+}
+
+static uint32_t scan_init(void)
+{
+	uint32_t nrf_err;
+	struct ble_scan_config scan_cfg = {
+		.scan_params = {
+			.active = 0x01,
+			.interval = BLE_GAP_SCAN_INTERVAL_US_MIN * 6,
+			.window = BLE_GAP_SCAN_WINDOW_US_MIN * 6,
+			.filter_policy = BLE_GAP_SCAN_FP_ACCEPT_ALL,
+			.timeout = BLE_GAP_SCAN_TIMEOUT_UNLIMITED,
+			.scan_phys = BLE_GAP_PHY_AUTO,
+		},
+		.conn_params = BLE_SCAN_CONN_PARAMS_DEFAULT,
+		.connect_if_match = true,
+		.conn_cfg_tag = CONFIG_NRF_SDH_BLE_CONN_TAG,
+		.evt_handler = scan_evt_handler,
+	};
+	struct ble_scan_filter_data filter_data = {
+		.name_filter.name = CONFIG_SAMPLE_TARGET_PERIPHERAL_NAME,
+	};
+
+	nrf_err = ble_scan_init(&ble_scan, &scan_cfg);
+	if (nrf_err) {
+		LOG_ERR("ble_scan_init failed, nrf_error %#x", nrf_err);
+		return nrf_err;
+	}
+
+	nrf_err = ble_scan_filter_add(&ble_scan, BLE_SCAN_NAME_FILTER, &filter_data);
+	if (nrf_err) {
+		LOG_ERR("ble_scan_filter_add name failed, nrf_error %#x", nrf_err);
+		return nrf_err;
+	}
+
+	nrf_err = ble_scan_filters_enable(&ble_scan, BLE_SCAN_NAME_FILTER, false);
+	if (nrf_err) {
+		LOG_ERR("Failed to enable scan filters, nrf_error %#x", nrf_err);
+		return nrf_err;
+	}
+
+	return NRF_SUCCESS;
+}
+
+static uint32_t db_discovery_init(void)
+{
+	struct ble_db_discovery_config db_cfg = {
+		.evt_handler = db_disc_evt_handler,
+		.gatt_queue = &ble_gq,
+	};
+
+	return ble_db_discovery_init(&ble_db_disc, &db_cfg);
+}
+
+int main(void)
+{
+	int err;
+	uint32_t nrf_err;
+	ble_gap_conn_sec_mode_t device_name_write_sec;
+
+#if defined(CONFIG_SHELL)
+	const struct shell_backend_config_flags cfg_flags = SHELL_DEFAULT_BACKEND_CONFIG_FLAGS;
+
+	shell_init(shell_backend_bm_uarte_get_ptr(), NULL, cfg_flags, false, 0);
+	shell_start(shell_backend_bm_uarte_get_ptr());
+#endif
+
+	LOG_INF("BLE NUS throughput central sample started");
+
+	for (size_t i = 0; i < ARRAY_SIZE(links); i++) {
+		links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+	}
+
+	err = nrf_sdh_enable_request();
+	if (err) {
+		LOG_ERR("Failed to enable SoftDevice, err %d", err);
+		goto idle;
+	}
+
+	LOG_INF("SoftDevice enabled");
+
+	err = nrf_sdh_ble_enable(CONFIG_NRF_SDH_BLE_CONN_TAG);
+	if (err) {
+		LOG_ERR("Failed to enable BLE, err %d", err);
+		goto idle;
+	}
+
+	LOG_INF("Bluetooth enabled");
+
+	BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&device_name_write_sec);
+	nrf_err = sd_ble_gap_device_name_set(&device_name_write_sec, CONFIG_SAMPLE_BLE_DEVICE_NAME,
+					     strlen(CONFIG_SAMPLE_BLE_DEVICE_NAME));
+	if (nrf_err) {
+		LOG_ERR("Failed to set device name, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	nrf_err = ble_conn_params_evt_handler_set(conn_params_evt_handler);
+	if (nrf_err) {
+		LOG_ERR("Failed to setup conn params event handler, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	nrf_err = db_discovery_init();
+	if (nrf_err) {
+		LOG_ERR("Failed to initialize db discovery, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	nrf_err = nus_client_init();
+	if (nrf_err) {
+		LOG_ERR("Failed to initialize NUS client, nrf_error %#x", nrf_err);
+		goto idle;
+	}
+
+	nrf_err = scan_init();
+	if (nrf_err) {
+		goto idle;
+	}
+
+	err = bm_timer_init(&report_timer, BM_TIMER_MODE_REPEATED, report_timeout_handler);
+	if (err) {
+		LOG_ERR("Failed to initialize report timer, err %d", err);
+		goto idle;
+	}
+
+	err = bm_timer_start(&report_timer,
+			     BM_TIMER_MS_TO_TICKS(CONFIG_SAMPLE_NUS_THROUGHPUT_REPORT_INTERVAL), NULL);
+	if (err) {
+		LOG_ERR("Failed to start report timer, err %d", err);
+		goto idle;
+	}
+
+	LOG_INF("BLE NUS throughput central sample initialized");
+
+	scan_start();
+
+	LOG_INF("Scanning for %s, up to %d links", CONFIG_SAMPLE_TARGET_PERIPHERAL_NAME,
+		LINK_COUNT);
+
+idle:
+	while (true) {
+#if defined(CONFIG_SHELL)
+		shell_process(shell_backend_bm_uarte_get_ptr());
+#endif
+		log_flush();
+
+		wait_for_event();
+	}
+}
@@ -48,6 +48,9 @@ LOG_MODULE_REGISTER(sample, CONFIG_SAMPLE_BLE_PWR_PROFILING_LOG_LEVEL);
 /* Notification connection timeout. */
 #define NOTIF_CONN_TIMEOUT CONFIG_SAMPLE_BLE_PWR_PROFILING_NOTIF_CONNECTION_TIMEOUT
 
+/* Slack of the timers that tolerate a late expiry. */
+#define TIMER_SLACK_TICKS BM_TIMER_MS_TO_TICKS(CONFIG_SAMPLE_BLE_PWR_PROFILING_TIMER_SLACK_MS)
+
 /** Characteristic notification timer. */
 static struct bm_timer char_notif_timer;
 /** Connection timer. */
@@ -55,6 +58,15 @@ static struct bm_timer connection_timer;
 /** Poweroff timer. */
 static struct bm_timer poweroff_timer;
 
+#if CONFIG_SAMPLE_BLE_PWR_PROFILING_BACKGROUND_TIMERS
+/** Background timer periods, in milliseconds. */
+static const uint32_t background_timer_period_ms[] = { 1000, 1100, 1300, 1700 };
+/** Background timers. */
+static struct bm_timer background_timer[CONFIG_SAMPLE_BLE_PWR_PROFILING_BACKGROUND_TIMERS];
+/** Number of expiries of each background timer. */
+static uint32_t background_timer_count[CONFIG_SAMPLE_BLE_PWR_PROFILING_BACKGROUND_TIMERS];
+#endif
+
 /** BLE QWR instance. */
 BLE_QWR_DEF(ble_qwr);
 /** Characteristic value. */
@@ -248,6 +260,44 @@ static void connection_timeout_handler(void *ctx)
 	}
 }
 
+#if CONFIG_SAMPLE_BLE_PWR_PROFILING_BACKGROUND_TIMERS
+/* Background timeout.
+ * This function will be called when a background timer expires. It stands for periodic
+ * application work that is not time critical.
+ */
+static void background_timeout_handler(void *ctx)
+{
+	uint32_t *count = ctx;
+
+	(*count)++;
+}
+
+static int background_timers_start(void)
+{
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(background_timer); i++) {
+		err = bm_timer_init(&background_timer[i], BM_TIMER_MODE_REPEATED,
+				    background_timeout_handler);
+		if (err) {
+			return err;
+		}
+
+		err = bm_timer_start_lazy(&background_timer[i],
+					  BM_TIMER_MS_TO_TICKS(background_timer_period_ms[i]),
+					  TIMER_SLACK_TICKS, &background_timer_count[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	LOG_INF("Started %zu background timers, slack %u ms", ARRAY_SIZE(background_timer),
+		CONFIG_SAMPLE_BLE_PWR_PROFILING_TIMER_SLACK_MS);
+
+	return 0;
+}
+#endif
+
 /* Poweroff timeout.
  * This function will be called when the poweroff timer triggers.
  */
@@ -273,8 +323,14 @@ static void on_write(const ble_evt_t *ble_evt)
 		notif_enabled = is_notification_enabled(evt_write->data);
 
 		if (notif_enabled) {
-			err = bm_timer_start(&char_notif_timer,
-					     BM_TIMER_MS_TO_TICKS(conn_interval_ms), NULL);
+			/* Notifications are sent on the next connection event anyway, so the
+			 * timer can be late by up to half of the connection interval.
+			 */
+			err = bm_timer_start_lazy(&char_notif_timer,
+						  BM_TIMER_MS_TO_TICKS(conn_interval_ms),
+						  MIN(TIMER_SLACK_TICKS,
+						      BM_TIMER_MS_TO_TICKS(conn_interval_ms) / 2),
+						  NULL);
 			if (err) {
 				LOG_ERR("Failed to start conn interval timer, err %d", err);
 			}
@@ -704,6 +760,14 @@ int main(void)
 
 	LOG_INF("BLE PWR Profiling sample initialized");
 
+#if CONFIG_SAMPLE_BLE_PWR_PROFILING_BACKGROUND_TIMERS
+	err = background_timers_start();
+	if (err) {
+		LOG_ERR("Failed to start background timers, err %d", err);
+		goto idle;
+	}
+#endif
+
 	err = bm_buttons_enable();
 	if (err) {
 		LOG_ERR("Failed to enable buttons, err %d", err);
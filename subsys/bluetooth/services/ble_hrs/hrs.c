@@ -24,6 +24,13 @@ LOG_MODULE_REGISTER(ble_hrs, CONFIG_BLE_HRS_LOG_LEVEL);
 /* Initial Heart Rate Measurement value. */
 #define INITIAL_VALUE_HRM 0
 
+/* Cached state of the Heart Rate Measurement CCCD. */
+enum {
+	HRM_CCCD_UNKNOWN,
+	HRM_CCCD_DISABLED,
+	HRM_CCCD_ENABLED,
+};
+
 /* Heart Rate Measurement flag bits. */
 
 /* Heart Rate Value Format bit. */
@@ -151,12 +158,14 @@ static void on_connect(struct ble_hrs *hrs, const ble_gap_evt_t *gap_evt)
 {
 	hrs->max_hrm_len = MAX_HRM_LEN_CALC(BLE_GATT_ATT_MTU_DEFAULT);
 	hrs->conn_handle = gap_evt->conn_handle;
+	hrs->hrm_cccd = HRM_CCCD_UNKNOWN;
 }
 
 static void on_disconnect(struct ble_hrs *hrs, const ble_gap_evt_t *gap_evt)
 {
 	ARG_UNUSED(gap_evt);
 	hrs->conn_handle = BLE_CONN_HANDLE_INVALID;
+	hrs->hrm_cccd = HRM_CCCD_UNKNOWN;
 }
 
 static void on_write(struct ble_hrs *hrs, const ble_gatts_evt_t *gatts_evt)
@@ -165,10 +174,6 @@ static void on_write(struct ble_hrs *hrs, const ble_gatts_evt_t *gatts_evt)
 		.conn_handle = gatts_evt->conn_handle,
 	};
 
-	if (!hrs->evt_handler) {
-		return;
-	}
-
 	if ((gatts_evt->params.write.handle != hrs->hrm_handles.cccd_handle) ||
 	    (gatts_evt->params.write.len != 2)) {
 		/* Nothing to do */
@@ -177,14 +182,20 @@ static void on_write(struct ble_hrs *hrs, const ble_gatts_evt_t *gatts_evt)
 
 	if (is_notification_enabled(gatts_evt->params.write.data)) {
 		hrs_evt.evt_type = BLE_HRS_EVT_NOTIFICATION_ENABLED;
+		hrs->hrm_cccd = HRM_CCCD_ENABLED;
 	} else {
 		hrs_evt.evt_type = BLE_HRS_EVT_NOTIFICATION_DISABLED;
+		hrs->hrm_cccd = HRM_CCCD_DISABLED;
 	}
 
 	LOG_DBG("Heart rate measurement notifications %sabled for peer %#x",
 		(hrs_evt.evt_type == BLE_HRS_EVT_NOTIFICATION_ENABLED ? "en" : "dis"),
 		gatts_evt->conn_handle);
 
+	if (!hrs->evt_handler) {
+		return;
+	}
+
 	hrs->evt_handler(hrs, &hrs_evt);
 }
 
@@ -229,6 +240,7 @@ uint32_t ble_hrs_init(struct ble_hrs *hrs, const struct ble_hrs_config *cfg)
 	hrs->max_hrm_len = MAX_HRM_LEN_CALC(BLE_GATT_ATT_MTU_DEFAULT);
 	hrs->is_sensor_contact_supported = cfg->is_sensor_contact_supported;
 	hrs->is_sensor_contact_detected = false;
+	hrs->hrm_cccd = HRM_CCCD_UNKNOWN;
 
 	BLE_UUID_BLE_ASSIGN(ble_uuid, BLE_UUID_HEART_RATE_SERVICE);
 
@@ -274,14 +286,22 @@ uint32_t ble_hrs_heart_rate_measurement_send(struct ble_hrs *hrs, uint16_t heart
 		return NRF_ERROR_NULL;
 	}
 
-	/* Get heart rate measurement CCCD value. */
-	nrf_err = sd_ble_gatts_value_get(hrs->conn_handle, hrs->hrm_handles.cccd_handle, &cccd_val);
-	if (nrf_err) {
-		return nrf_err;
+	/* Read the heart rate measurement CCCD value once per connection,
+	 * it is then tracked from the writes of the peer.
+	 */
+	if (hrs->hrm_cccd == HRM_CCCD_UNKNOWN) {
+		nrf_err = sd_ble_gatts_value_get(hrs->conn_handle, hrs->hrm_handles.cccd_handle,
+						 &cccd_val);
+		if (nrf_err) {
+			return nrf_err;
+		}
+
+		hrs->hrm_cccd = is_notification_enabled(cccd_val.p_value) ?
+				HRM_CCCD_ENABLED : HRM_CCCD_DISABLED;
 	}
 
-	/* CCCD read success. Check if peer has enabled notifications. */
-	if (!is_notification_enabled(cccd_val.p_value)) {
+	/* Check if peer has enabled notifications. */
+	if (hrs->hrm_cccd != HRM_CCCD_ENABLED) {
 		return NRF_ERROR_INVALID_STATE;
 	}
 
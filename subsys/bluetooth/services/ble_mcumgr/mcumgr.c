@@ -327,7 +327,7 @@ static void on_ble_evt(const ble_evt_t *evt, void *ctx)
 	};
 }
 
-NRF_SDH_BLE_OBSERVER(sdh_ble, on_ble_evt, &ble_mcumgr, HIGH);
+NRF_SDH_BLE_EVT_OBSERVER(sdh_ble, on_ble_evt, &ble_mcumgr, HIGH, GAP, GATTS);
 
 uint32_t ble_mcumgr_init(const struct ble_mcumgr_config *cfg)
 {
@@ -7,9 +7,15 @@
 #include <nrf_error.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <bm/bluetooth/ble_common.h>
 #include <bm/bluetooth/services/ble_nus.h>
 #include <bm/bluetooth/services/uuid.h>
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+#include <bm/bluetooth/ble_conn_params.h>
+#include <zephyr/irq.h>
+#include <zephyr/sys/util.h>
+#endif
 
 #include <zephyr/logging/log.h>
 
@@ -81,6 +87,201 @@ static uint32_t nus_tx_char_add(struct ble_nus *nus, const struct ble_nus_config
 					       &nus->tx_handles);
 }
 
+/* Cached state of the TX characteristic CCCD of a link. */
+enum {
+	TX_CCCD_UNKNOWN,
+	TX_CCCD_DISABLED,
+	TX_CCCD_ENABLED,
+};
+
+static void tx_cccd_set(struct ble_nus *nus, uint16_t conn_handle, uint8_t state)
+{
+	const int idx = nrf_sdh_ble_idx_get(conn_handle);
+
+	if (idx >= 0) {
+		nus->tx_cccd[idx] = state;
+	}
+}
+
+/* Check whether the peer has enabled notifications of the TX characteristic.
+ * The CCCD is read from the SoftDevice once per connection, when the system attributes are set,
+ * and is then tracked from the writes of the peer.
+ */
+static bool tx_notif_enabled(struct ble_nus *nus, uint16_t conn_handle)
+{
+	uint32_t nrf_err;
+	const int idx = nrf_sdh_ble_idx_get(conn_handle);
+	ble_gatts_value_t gatts_val = {
+		.p_value = (uint8_t *)&(uint16_t){0},
+		.len = sizeof(uint16_t),
+	};
+
+	if (idx < 0) {
+		return false;
+	}
+
+	if (nus->tx_cccd[idx] == TX_CCCD_UNKNOWN) {
+		nrf_err = sd_ble_gatts_value_get(conn_handle, nus->tx_handles.cccd_handle,
+						 &gatts_val);
+		if (nrf_err) {
+			/* The system attributes may not be set yet, read again next time. */
+			return false;
+		}
+
+		nus->tx_cccd[idx] = is_notification_enabled(gatts_val.p_value) ?
+				    TX_CCCD_ENABLED : TX_CCCD_DISABLED;
+	}
+
+	return (nus->tx_cccd[idx] == TX_CCCD_ENABLED);
+}
+
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+/* TX stream flags. */
+enum {
+	/* The stream is being sent. */
+	TX_STREAM_BUSY,
+	/* The stream has to be sent again when the current sender is done. */
+	TX_STREAM_KICK,
+	/* Send all buffered data, regardless of the threshold. */
+	TX_STREAM_FLUSH,
+};
+
+/* Get the TX stream of a connected link, or NULL if the link is not connected. */
+static struct ble_nus_tx_stream *tx_stream_get(struct ble_nus *nus, uint16_t conn_handle)
+{
+	const int idx = nrf_sdh_ble_idx_get(conn_handle);
+
+	if (idx < 0) {
+		return NULL;
+	}
+
+	/* The index alone does not tell whether the handle is connected, with a single link
+	 * every handle has index 0.
+	 */
+	if (nus->tx_stream[idx].conn_handle != conn_handle) {
+		return NULL;
+	}
+
+	return &nus->tx_stream[idx];
+}
+
+static void tx_stream_reset(struct ble_nus_tx_stream *stream, uint16_t conn_handle)
+{
+	const unsigned int key = irq_lock();
+
+	stream->conn_handle = conn_handle;
+	ring_buf_init(&stream->rb, sizeof(stream->buf), stream->buf);
+	stream->hvn_queued = 0;
+	atomic_clear_bit(&stream->flags, TX_STREAM_FLUSH);
+
+	irq_unlock(key);
+}
+
+/* Send notifications until the SoftDevice queue is full or there is not enough data to send. */
+static void tx_stream_drain(struct ble_nus *nus, struct ble_nus_tx_stream *stream,
+			    uint16_t conn_handle)
+{
+	uint32_t nrf_err;
+	unsigned int key;
+	uint16_t att_mtu;
+	uint16_t max_len;
+	uint16_t threshold;
+	uint32_t buffered;
+	uint16_t len;
+	/* The data of a notification may wrap around the end of the ring buffer. */
+	uint8_t data[BLE_NUS_MAX_DATA_LEN];
+	ble_gatts_hvx_params_t hvx = {
+		.type = BLE_GATT_HVX_NOTIFICATION,
+		.handle = nus->tx_handles.value_handle,
+		.p_data = data,
+		.p_len = &len,
+	};
+	struct ble_nus_evt evt = {
+		.evt_type = BLE_NUS_EVT_ERROR,
+		.conn_handle = conn_handle,
+	};
+
+	nrf_err = ble_conn_params_att_mtu_get(conn_handle, &att_mtu);
+	if (nrf_err) {
+		return;
+	}
+
+	max_len = MIN(BLE_NUS_MAX_DATA_LEN_CALC(att_mtu), sizeof(data));
+	threshold = (CONFIG_BLE_NUS_TX_STREAM_THRESHOLD == 0) ?
+		    max_len : MIN(CONFIG_BLE_NUS_TX_STREAM_THRESHOLD, max_len);
+
+	for (;;) {
+		key = irq_lock();
+
+		buffered = ring_buf_size_get(&stream->rb);
+		if (buffered == 0) {
+			atomic_clear_bit(&stream->flags, TX_STREAM_FLUSH);
+		}
+
+		/* Hold back short notifications while the SoftDevice still has data to send,
+		 * more data is likely to be written by the time it is done.
+		 */
+		if ((buffered < threshold) && (stream->hvn_queued > 0) &&
+		    !atomic_test_bit(&stream->flags, TX_STREAM_FLUSH)) {
+			buffered = 0;
+		}
+
+		len = ring_buf_peek(&stream->rb, data, MIN(buffered, max_len));
+
+		irq_unlock(key);
+
+		if (len == 0) {
+			return;
+		}
+
+		nrf_err = sd_ble_gatts_hvx(conn_handle, &hvx);
+		if (nrf_err == NRF_ERROR_RESOURCES) {
+			/* Resume on BLE_GATTS_EVT_HVN_TX_COMPLETE. */
+			return;
+		} else if ((nrf_err == NRF_ERROR_INVALID_STATE) ||
+			   (nrf_err == BLE_ERROR_GATTS_SYS_ATTR_MISSING)) {
+			/* Resume when the peer enables notifications. The system attributes may
+			 * not be set yet right after connecting.
+			 */
+			return;
+		} else if (nrf_err) {
+			LOG_ERR("Failed to notify NUS TX data, nrf_error %#x", nrf_err);
+			if (nus->evt_handler != NULL) {
+				evt.error.reason = nrf_err;
+				nus->evt_handler(nus, &evt);
+			}
+			return;
+		}
+
+		key = irq_lock();
+		(void)ring_buf_get(&stream->rb, NULL, len);
+		stream->hvn_queued++;
+		irq_unlock(key);
+	}
+}
+
+static void tx_stream_send(struct ble_nus *nus, uint16_t conn_handle)
+{
+	struct ble_nus_tx_stream *stream = tx_stream_get(nus, conn_handle);
+
+	if (stream == NULL) {
+		return;
+	}
+
+	/* The stream is sent both from ble_nus_write() and from the SoftDevice event handler,
+	 * which can preempt it. Only one of them sends at a time, the other asks it to go again.
+	 */
+	atomic_set_bit(&stream->flags, TX_STREAM_KICK);
+
+	while (atomic_test_bit(&stream->flags, TX_STREAM_KICK) &&
+	       !atomic_test_and_set_bit(&stream->flags, TX_STREAM_BUSY)) {
+		atomic_clear_bit(&stream->flags, TX_STREAM_KICK);
+		tx_stream_drain(nus, stream, conn_handle);
+		atomic_clear_bit(&stream->flags, TX_STREAM_BUSY);
+	}
+}
+#endif /* CONFIG_BLE_NUS_TX_STREAM */
+
 /**
  * @brief Function for handling the @ref BLE_GAP_EVT_CONNECTED event from the SoftDevice.
  *
@@ -89,25 +290,49 @@ static uint32_t nus_tx_char_add(struct ble_nus *nus, const struct ble_nus_config
  */
 static void on_connect(struct ble_nus *nus, const ble_evt_t *ble_evt)
 {
-	uint32_t nrf_err;
 	const uint16_t conn_handle = ble_evt->evt.gap_evt.conn_handle;
 	struct ble_nus_evt evt = {
 		.evt_type = BLE_NUS_EVT_COMM_STARTED,
 		.conn_handle = conn_handle,
 	};
-	ble_gatts_value_t gatts_val = {
-		.p_value = (uint8_t *)&(uint16_t){0},
-		.len = sizeof(uint16_t),
-	};
+
+	tx_cccd_set(nus, conn_handle, TX_CCCD_UNKNOWN);
+
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+	const int idx = nrf_sdh_ble_idx_get(conn_handle);
+
+	if (idx >= 0) {
+		tx_stream_reset(&nus->tx_stream[idx], conn_handle);
+	}
+#endif
 
 	/* Check the host's CCCD value to inform of readiness to send data. */
-	nrf_err = sd_ble_gatts_value_get(conn_handle, nus->tx_handles.cccd_handle, &gatts_val);
-	if ((nrf_err == NRF_SUCCESS) && (nus->evt_handler != NULL) &&
-	    is_notification_enabled(gatts_val.p_value)) {
+	if (tx_notif_enabled(nus, conn_handle) && (nus->evt_handler != NULL)) {
 		nus->evt_handler(nus, &evt);
 	}
 }
 
+/**
+ * @brief Function for handling the @ref BLE_GAP_EVT_DISCONNECTED event from the SoftDevice.
+ *
+ * @param[in] nus Nordic UART Service structure.
+ * @param[in] ble_evt Pointer to the event received from BLE stack.
+ */
+static void on_disconnect(struct ble_nus *nus, const ble_evt_t *ble_evt)
+{
+	const uint16_t conn_handle = ble_evt->evt.gap_evt.conn_handle;
+
+	tx_cccd_set(nus, conn_handle, TX_CCCD_UNKNOWN);
+
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+	struct ble_nus_tx_stream *stream = tx_stream_get(nus, conn_handle);
+
+	if (stream != NULL) {
+		tx_stream_reset(stream, BLE_CONN_HANDLE_INVALID);
+	}
+#endif
+}
+
 /**
  * @brief Function for handling the @ref BLE_GATTS_EVT_WRITE event from the SoftDevice.
  *
@@ -125,13 +350,22 @@ static void on_write(struct ble_nus *nus, const ble_evt_t *ble_evt)
 	if ((evt_write->handle == nus->tx_handles.cccd_handle) && (evt_write->len == 2)) {
 		if (is_notification_enabled(evt_write->data)) {
 			evt.evt_type = BLE_NUS_EVT_COMM_STARTED;
+			tx_cccd_set(nus, conn_handle, TX_CCCD_ENABLED);
 		} else {
 			evt.evt_type = BLE_NUS_EVT_COMM_STOPPED;
+			tx_cccd_set(nus, conn_handle, TX_CCCD_DISABLED);
 		}
 
 		if (nus->evt_handler != NULL) {
 			nus->evt_handler(nus, &evt);
 		}
+
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+		if (evt.evt_type == BLE_NUS_EVT_COMM_STARTED) {
+			/* Send the data buffered while notifications were disabled. */
+			tx_stream_send(nus, conn_handle);
+		}
+#endif
 	} else if ((evt_write->handle == nus->rx_handles.value_handle) &&
 		   (nus->evt_handler != NULL)) {
 		evt.evt_type = BLE_NUS_EVT_RX_DATA;
@@ -152,23 +386,29 @@ static void on_write(struct ble_nus *nus, const ble_evt_t *ble_evt)
  */
 static void on_hvx_tx_complete(struct ble_nus *nus, const ble_evt_t *ble_evt)
 {
-	uint32_t nrf_err;
 	const uint16_t conn_handle = ble_evt->evt.gatts_evt.conn_handle;
 	struct ble_nus_evt evt = {
 		.evt_type = BLE_NUS_EVT_TX_RDY,
 		.conn_handle = conn_handle,
 	};
-	ble_gatts_value_t val = {
-		.p_value = (uint8_t *)&(uint16_t){0},
-		.len = sizeof(uint16_t),
-	};
 
-	/* Check if peer still has notifications enabled. */
-	nrf_err = sd_ble_gatts_value_get(conn_handle, nus->tx_handles.cccd_handle, &val);
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+	struct ble_nus_tx_stream *stream = tx_stream_get(nus, conn_handle);
+	const uint8_t count = ble_evt->evt.gatts_evt.params.hvn_tx_complete.count;
+
+	if (stream != NULL) {
+		const unsigned int key = irq_lock();
+
+		/* The count includes the notifications of other services too. */
+		stream->hvn_queued -= MIN(count, stream->hvn_queued);
+		irq_unlock(key);
 
-	if ((nrf_err == NRF_SUCCESS) &&
-	    is_notification_enabled(val.p_value) &&
-	    (nus->evt_handler != NULL)) {
+		tx_stream_send(nus, conn_handle);
+	}
+#endif
+
+	/* Check if peer still has notifications enabled. */
+	if (tx_notif_enabled(nus, conn_handle) && (nus->evt_handler != NULL)) {
 		nus->evt_handler(nus, &evt);
 	}
 }
@@ -185,6 +425,10 @@ void ble_nus_on_ble_evt(const ble_evt_t *ble_evt, void *ble_nus)
 		on_connect(nus, ble_evt);
 		break;
 
+	case BLE_GAP_EVT_DISCONNECTED:
+		on_disconnect(nus, ble_evt);
+		break;
+
 	case BLE_GATTS_EVT_WRITE:
 		on_write(nus, ble_evt);
 		break;
@@ -211,6 +455,13 @@ uint32_t ble_nus_init(struct ble_nus *nus, const struct ble_nus_config *cfg)
 
 	/* Initialize the service structure. */
 	nus->evt_handler = cfg->evt_handler;
+	memset(nus->tx_cccd, TX_CCCD_UNKNOWN, sizeof(nus->tx_cccd));
+
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+	for (size_t i = 0; i < ARRAY_SIZE(nus->tx_stream); i++) {
+		tx_stream_reset(&nus->tx_stream[i], BLE_CONN_HANDLE_INVALID);
+	}
+#endif
 
 	/* Add a custom base UUID. */
 	nrf_err = sd_ble_uuid_vs_add(&uuid_base, &nus->uuid_type);
@@ -273,3 +524,55 @@ uint32_t ble_nus_data_send(struct ble_nus *nus, uint8_t *data,
 
 	return NRF_SUCCESS;
 }
+
+#if defined(CONFIG_BLE_NUS_TX_STREAM)
+uint32_t ble_nus_write(struct ble_nus *nus, const uint8_t *data, uint16_t *len,
+		       uint16_t conn_handle)
+{
+	unsigned int key;
+	uint16_t requested;
+	struct ble_nus_tx_stream *stream;
+
+	if (!nus || !data || !len) {
+		return NRF_ERROR_NULL;
+	}
+
+	stream = tx_stream_get(nus, conn_handle);
+	if (stream == NULL) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	requested = *len;
+
+	key = irq_lock();
+	*len = ring_buf_put(&stream->rb, data, requested);
+	irq_unlock(key);
+
+	if ((*len == 0) && (requested > 0)) {
+		return NRF_ERROR_RESOURCES;
+	}
+
+	tx_stream_send(nus, conn_handle);
+
+	return NRF_SUCCESS;
+}
+
+uint32_t ble_nus_flush(struct ble_nus *nus, uint16_t conn_handle)
+{
+	struct ble_nus_tx_stream *stream;
+
+	if (!nus) {
+		return NRF_ERROR_NULL;
+	}
+
+	stream = tx_stream_get(nus, conn_handle);
+	if (stream == NULL) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	atomic_set_bit(&stream->flags, TX_STREAM_FLUSH);
+	tx_stream_send(nus, conn_handle);
+
+	return NRF_SUCCESS;
+}
+#endif /* CONFIG_BLE_NUS_TX_STREAM */
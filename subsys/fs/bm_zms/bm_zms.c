@@ -10,6 +10,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <zephyr/sys/crc.h>
 #include <zephyr/sys/atomic.h>
@@ -17,38 +18,36 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/irq.h>
 #include <zephyr/toolchain.h>
+#include <zephyr/linker/section_tags.h>
 
 #include <bm/storage/bm_storage.h>
 #include <bm/fs/bm_zms.h>
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND_SCHEDULER)
+#include <bm/bm_scheduler.h>
+#endif
 #include "bm_zms_priv.h"
 
 LOG_MODULE_REGISTER(bm_zms, CONFIG_BM_ZMS_LOG_LEVEL);
 
-static zms_op_t cur_op; /* Current bm_zms operation. */
-static zms_op_t *p_cur_op;
-static atomic_t cur_op_result = ATOMIC_INIT(0);
-static atomic_t queue_process_start = ATOMIC_INIT(false);
+/* Operation queues, one per mounted file system. */
+static struct bm_zms_op_queue op_queues[CONFIG_BM_ZMS_MAX_FS];
+
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+/* Lookup cache snapshots, one per operation queue. Not initialized at boot. */
+static struct zms_cache_snapshot cache_snapshots[CONFIG_BM_ZMS_MAX_FS] __noinit;
+#endif
 
 #ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
 static inline size_t zms_lookup_cache_pos(uint32_t id);
 #endif
 static void zms_event_handler(struct bm_storage_evt *evt);
-static int zms_init(void);
+static int zms_init(struct bm_zms_fs *fs);
 static int zms_flash_al_wrt(struct bm_zms_fs *fs);
-static int zms_write_execute(void);
+static int zms_write_execute(struct bm_zms_fs *fs);
 static inline size_t zms_al_size(struct bm_zms_fs *fs, size_t len);
 static int zms_flash_block_move(struct bm_zms_fs *fs);
 static void zms_verify_space(zms_op_t *op);
-static int bm_zms_clear_execute(void);
-
-/* The number of queued operations.
- * Incremented by queue_start() and decremented by queue_has_next().
- */
-static atomic_t queued_op_cnt;
-
-/* Queue of bm_zms operations. */
-RING_BUF_DECLARE(zms_fifo, CONFIG_BM_ZMS_OP_QUEUE_SIZE * sizeof(zms_op_t));
-
+static int bm_zms_clear_execute(struct bm_zms_fs *fs);
 
 static int zms_prev_ate(struct bm_zms_fs *fs, uint64_t *addr, struct zms_ate *ate);
 static int zms_ate_valid(struct bm_zms_fs *fs, const struct zms_ate *entry);
@@ -57,25 +56,42 @@ static int zms_get_sector_header(struct bm_zms_fs *fs, uint64_t addr, struct zms
 				 struct zms_ate *close_ate);
 static int zms_ate_valid_different_sector(struct bm_zms_fs *fs, const struct zms_ate *entry,
 					  uint8_t cycle_cnt);
+static int zms_flash_ate_rd(struct bm_zms_fs *fs, uint64_t addr, struct zms_ate *entry);
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+static void zms_cache_snapshot_update(struct bm_zms_fs *fs);
+static void zms_cache_snapshot_invalidate(struct bm_zms_fs *fs);
+#endif
+#if defined(CONFIG_BM_ZMS_NO_DOUBLE_WRITE)
+static bool zms_write_is_unchanged(zms_op_t *op);
+#endif
 
-static void event_prepare(struct bm_zms_evt *evt)
+static void event_prepare(zms_op_t *op, struct bm_zms_evt *evt)
 {
-	switch (cur_op.op_code) {
+	switch (op->op_code) {
 	case ZMS_OP_INIT:
 		evt->evt_type = BM_ZMS_EVT_MOUNT;
 		break;
 
 	case ZMS_OP_WRITE:
-		atomic_sub(&cur_op.fs->ongoing_writes, 1);
-		evt->evt_type = (!cur_op.data_len && !cur_op.data) ? BM_ZMS_EVT_DELETE :
+		atomic_sub(&op->fs->ongoing_writes, 1);
+		if (op->batch.entries) {
+			evt->evt_type = BM_ZMS_EVT_WRITE_BATCH;
+			evt->id = op->batch.entries[0].id;
+			break;
+		}
+		evt->evt_type = (!op->data_len && !op->data) ? BM_ZMS_EVT_DELETE :
 			BM_ZMS_EVT_WRITE;
-		evt->id = cur_op.id;
+		evt->id = op->id;
 		break;
 
 	case ZMS_OP_CLEAR:
 		evt->evt_type = BM_ZMS_EVT_CLEAR;
 		break;
 
+	case ZMS_OP_GC:
+		evt->evt_type = BM_ZMS_EVT_GC;
+		break;
+
 	case ZMS_OP_NONE:
 		evt->evt_type = BM_ZMS_EVT_NONE;
 		break;
@@ -92,49 +108,121 @@ static void event_send(const struct bm_zms_evt *const evt, struct bm_zms_fs *fs)
 	}
 }
 
-static bool queue_has_next(void)
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+static bool zms_write_copy_owns(struct bm_zms_op_queue *queue, const void *data)
+{
+	return ((const uint8_t *)data >= queue->write_copy_buf) &&
+	       ((const uint8_t *)data < queue->write_copy_buf + sizeof(queue->write_copy_buf));
+}
+
+/* Release the block holding the data of a write, if the data was copied. */
+static void zms_write_copy_free(struct bm_zms_op_queue *queue, zms_op_t *op)
+{
+	if ((op->op_code == ZMS_OP_WRITE) && zms_write_copy_owns(queue, op->app_data)) {
+		k_mem_slab_free(&queue->write_copy_slab, (void *)op->app_data);
+		op->app_data = NULL;
+	}
+}
+#endif
+
+static bool queue_has_next(struct bm_zms_op_queue *queue)
 {
 	/** Decrement the number of queued operations. */
-	if (queued_op_cnt != 0) {
-		return atomic_sub(&queued_op_cnt, 1) == 1 ? false : true;
+	if (queue->queued_op_cnt != 0) {
+		return atomic_sub(&queue->queued_op_cnt, 1) == 1 ? false : true;
 	}
 
 	return false;
 }
 
-static void queue_process(void)
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+/* Whether the free space in the open sector is below the background GC threshold. */
+static bool zms_gc_needed(struct bm_zms_fs *fs)
+{
+	const uint32_t threshold =
+		(fs->sector_size * CONFIG_BM_ZMS_GC_BACKGROUND_THRESHOLD) / 100;
+
+	/* Nothing was written since the last background GC, another one cannot free more space. */
+	if (fs->ate_wra == fs->op_queue->gc_ate_wra) {
+		return false;
+	}
+
+	return (fs->ate_wra - fs->data_wra - fs->ate_size) < threshold;
+}
+
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND_SCHEDULER)
+static void zms_gc_sched_handler(void *evt, size_t len)
+{
+	struct bm_zms_fs *fs = *(struct bm_zms_fs **)evt;
+
+	ARG_UNUSED(len);
+
+	atomic_set(&fs->op_queue->gc_scheduled, false);
+	(void)bm_zms_gc_step(fs);
+}
+
+static void zms_gc_schedule(struct bm_zms_fs *fs)
 {
+	if (!atomic_get(&fs->op_queue->gc_paused) && !zms_gc_needed(fs)) {
+		return;
+	}
+
+	if (!atomic_cas(&fs->op_queue->gc_scheduled, false, true)) {
+		/* A step is already pending. */
+		return;
+	}
+
+	if (bm_scheduler_defer(zms_gc_sched_handler, &fs, sizeof(fs))) {
+		atomic_set(&fs->op_queue->gc_scheduled, false);
+		LOG_WRN("Failed to schedule a GC step");
+	}
+}
+#endif /* CONFIG_BM_ZMS_GC_BACKGROUND_SCHEDULER */
+#endif /* CONFIG_BM_ZMS_GC_BACKGROUND */
+
+static void queue_process(struct bm_zms_op_queue *queue)
+{
+	zms_op_t *op = &queue->cur_op;
 	int result = 0, prev_result = 0;
 	int evt_result = 0;
 	uint32_t rc;
 	unsigned int key;
 
 	while (true) {
-		if (queue_process_start) {
+		if (queue->queue_process_start) {
 			/* If the storage operation has ended, reset the flag. */
-			atomic_set(&queue_process_start, false);
+			atomic_set(&queue->queue_process_start, false);
 		} else {
 			/* We get here when the backend is asynchronous. */
 			return;
 		}
-		prev_result = atomic_get(&cur_op_result);
+		prev_result = atomic_get(&queue->cur_op_result);
 		if (prev_result) {
 			/* If the previous operation failed, we need to break the loop. */
 			result = prev_result;
 			goto completed;
 		}
 
-		if (p_cur_op == NULL) {
+		if (queue->p_cur_op == NULL) {
 			/* Load the next from the queue if no operation is being executed.*/
 			key = irq_lock();
-			rc = ring_buf_get(&zms_fifo, (uint8_t *)&cur_op, sizeof(zms_op_t));
+			rc = ring_buf_get(&queue->fifo, (uint8_t *)op, sizeof(zms_op_t));
 			irq_unlock(key);
 
 			if (rc != sizeof(zms_op_t)) {
 				result = -EIO;
 				goto completed;
 			}
-			p_cur_op = &cur_op;
+			queue->p_cur_op = op;
+
+			if (((op->op_code == ZMS_OP_WRITE) || (op->op_code == ZMS_OP_GC)) &&
+			    !op->fs->init_flags.initialized) {
+				/* The file system was cleared, or a batch failed, after the write
+				 * was queued.
+				 */
+				result = -EACCES;
+				goto completed;
+			}
 		}
 
 		/* We can reach here in three ways:
@@ -144,46 +232,61 @@ static void queue_process(void)
 		 *
 		 * In all these three cases, cur_op != NULL.
 		 */
-		__ASSERT(p_cur_op != NULL, "p_cur_op is NULL, but it should not be.");
+		__ASSERT(queue->p_cur_op != NULL, "p_cur_op is NULL, but it should not be.");
 
-		switch (cur_op.op_code) {
+		switch (op->op_code) {
 		case ZMS_OP_INIT:
-			result = zms_init();
+			result = zms_init(op->fs);
 			break;
 
 		case ZMS_OP_WRITE:
-			if ((cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_ATE2) ||
-			    (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_DATA2)) {
+		case ZMS_OP_GC:
+			if ((op->sub_step == ZMS_OP_WRITE_SUB_STEP_ATE2) ||
+			    (op->sub_step == ZMS_OP_WRITE_SUB_STEP_DATA2)) {
 				/* If we are in the second sub-step, we need to write the second
 				 * part.
 				 */
-				result = zms_flash_al_wrt(cur_op.fs);
-			} else if ((cur_op.gc.step == ZMS_OP_WRITE_GC_BLK_MOVE) &&
-				   (cur_op.gc.blk_mv_len)) {
+				result = zms_flash_al_wrt(op->fs);
+			} else if ((op->gc.step == ZMS_OP_WRITE_GC_BLK_MOVE) &&
+				   (op->gc.blk_mv_len)) {
 				/* If we are still moving data, a previous block write succeeded .
 				 * Increase the data write address by the size of the block.
 				 */
-				cur_op.fs->data_wra += zms_al_size(cur_op.fs, ZMS_BLOCK_SIZE);
+				op->fs->data_wra += zms_al_size(op->fs, ZMS_BLOCK_SIZE);
 				/* If we are in the garbage collection step, we need to move the
 				 * block.
 				 */
-				result = zms_flash_block_move(cur_op.fs);
-			} else if (cur_op.step == ZMS_OP_WRITE_STARTUP) {
-				zms_verify_space(&cur_op);
-				result = zms_write_execute();
+				result = zms_flash_block_move(op->fs);
+			} else if (op->step == ZMS_OP_WRITE_STARTUP) {
+#if defined(CONFIG_BM_ZMS_NO_DOUBLE_WRITE)
+				if (zms_write_is_unchanged(op)) {
+					/* Complete the write without leaving the startup step. */
+#if defined(CONFIG_BM_ZMS_STATS)
+					op->fs->stats.writes_skipped++;
+#endif
+					op->op_completed = true;
+					result = 0;
+					break;
+				}
+#endif
+				zms_verify_space(op);
+				result = zms_write_execute(op->fs);
 			} else {
-				result = zms_write_execute();
+				result = zms_write_execute(op->fs);
 			}
 			break;
 		case ZMS_OP_CLEAR:
-			if (cur_op.step == ZMS_OP_CLEAR_DONE) {
+			if (op->step == ZMS_OP_CLEAR_DONE) {
 				/* bm_zms needs to be reinitialized after clearing */
-				cur_op.fs->init_flags.initialized = false;
-				cur_op.fs->init_flags.initializing = false;
-				cur_op.op_completed = true;
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+				zms_cache_snapshot_invalidate(op->fs);
+#endif
+				op->fs->init_flags.initialized = false;
+				op->fs->init_flags.initializing = false;
+				op->op_completed = true;
 				result = 0;
 			} else {
-				result = bm_zms_clear_execute();
+				result = bm_zms_clear_execute(op->fs);
 			}
 			break;
 
@@ -192,7 +295,7 @@ static void queue_process(void)
 			break;
 		}
 
-		if (!result && !cur_op.op_completed) {
+		if (!result && !op->op_completed) {
 			continue;
 		}
 
@@ -202,7 +305,7 @@ completed:
 		 * - free the operation buffer
 		 * - execute any other queued operations
 		 */
-		cur_op.op_completed = true;
+		op->op_completed = true;
 
 		if (result > 0) {
 			/* If result is not 0, an internal error occurred. */
@@ -214,6 +317,14 @@ completed:
 			/* no errors. */
 			evt_result = 0;
 		}
+
+		if (evt_result && op->batch.ate_wra) {
+			/* Part of the batch might have been written. Require a new mount, which
+			 * rolls it back, before writing anything else after it.
+			 */
+			LOG_ERR("Batch write failed, the file system must be mounted again");
+			op->fs->init_flags.initialized = false;
+		}
 		struct bm_zms_evt evt = {
 			/* The operation might have failed for one of the following reasons:
 			 * -ENOSPC:  no free space in flash.
@@ -226,46 +337,82 @@ completed:
 			.result = evt_result,
 		};
 
-		if ((cur_op.op_code == ZMS_OP_INIT) && cur_op.op_completed) {
+		if ((op->op_code == ZMS_OP_INIT) && op->op_completed) {
 			/* print information about sectors layout after init. */
-			LOG_INF("%u Sectors of %u bytes", cur_op.fs->sector_count,
-				cur_op.fs->sector_size);
-			LOG_INF("alloc wra %llu, %llx", SECTOR_NUM(cur_op.fs->ate_wra),
-				SECTOR_OFFSET(cur_op.fs->ate_wra));
-			LOG_INF("data wra %llu, %llx", SECTOR_NUM(cur_op.fs->data_wra),
-				SECTOR_OFFSET(cur_op.fs->data_wra));
+			LOG_INF("%u Sectors of %u bytes", op->fs->sector_count,
+				op->fs->sector_size);
+			LOG_INF("alloc wra %llu, %llx", SECTOR_NUM(op->fs->ate_wra),
+				SECTOR_OFFSET(op->fs->ate_wra));
+			LOG_INF("data wra %llu, %llx", SECTOR_NUM(op->fs->data_wra),
+				SECTOR_OFFSET(op->fs->data_wra));
+		}
+
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+		if (!evt_result && ((op->op_code == ZMS_OP_WRITE) || (op->op_code == ZMS_OP_GC))) {
+			zms_cache_snapshot_update(op->fs);
 		}
+#endif
+
+#if defined(CONFIG_BM_ZMS_STATS)
+		/* Skipped writes complete in the startup step. A delete writes a single ATE. */
+		if (!evt_result && (op->op_code == ZMS_OP_WRITE) &&
+		    (op->step != ZMS_OP_WRITE_STARTUP)) {
+			op->fs->stats.bytes_written += MAX(op->required_space, op->fs->ate_size);
+		}
+#endif
 
-		event_prepare(&evt);
-		event_send(&evt, cur_op.fs);
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+		/* Release the block first, so that the event handler can queue another write. */
+		zms_write_copy_free(queue, op);
+#endif
+
+		event_prepare(op, &evt);
+		event_send(&evt, op->fs);
+
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND_SCHEDULER)
+		if ((op->op_code == ZMS_OP_WRITE) && !evt_result) {
+			/* Collect garbage while idle, before a write has to. */
+			zms_gc_schedule(op->fs);
+		}
+#endif
 
 		/* Zero the pointer to the current operation so that this function
 		 * will fetch a new one from the queue next time it is run.
 		 */
-		p_cur_op = NULL;
+		queue->p_cur_op = NULL;
 
 		/* The result of the operation must be reset upon re-entering the loop to ensure
 		 * the next operation won't be affected by eventual errors in previous operations.
 		 */
 		result = 0;
 
-		if (!queue_has_next()) {
+		if (!queue_has_next(queue)) {
 			LOG_DBG("No more elements in the queue, exiting.");
 			/* No more elements left. Nothing to do. */
 			break;
 		}
 		LOG_DBG("There are more elements in the queue, processing next one. %u",
-			(uint32_t)queued_op_cnt);
-		atomic_set(&queue_process_start, true);
+			(uint32_t)queue->queued_op_cnt);
+		atomic_set(&queue->queue_process_start, true);
 	}
 }
 
-static void queue_start(void)
+static void queue_start(struct bm_zms_op_queue *queue)
 {
-	if (!atomic_add(&queued_op_cnt, 1)) {
-		atomic_set(&queue_process_start, true);
-		queue_process();
+	if (!atomic_add(&queue->queued_op_cnt, 1)) {
+		atomic_set(&queue->queue_process_start, true);
+		queue_process(queue);
+		return;
+	}
+
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+	if (atomic_cas(&queue->gc_paused, true, false)) {
+		/* Do not make the operation wait for the next GC steps, complete the GC now. */
+		queue->gc_budget = UINT32_MAX;
+		atomic_set(&queue->queue_process_start, true);
+		queue_process(queue);
 	}
+#endif
 }
 
 static inline bool is_end_of_ate_write_step(zms_op_t *p_op)
@@ -277,21 +424,35 @@ static inline bool is_end_of_ate_write_step(zms_op_t *p_op)
 	    (p_op->gc.step == ZMS_OP_WRITE_GC_EXECUTE) ||
 	    (p_op->gc.step == ZMS_OP_WRITE_GC_ATE_COPY_DONE) ||
 	    (((p_op->step == ZMS_OP_WRITE_GC) || (p_op->step == ZMS_OP_INIT_GC)) &&
-	    (p_op->gc.step == ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR))) {
+	    (p_op->gc.step == ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR)) ||
+	    (p_op->step == ZMS_OP_WRITE_BATCH_BEGIN_DONE) ||
+	    (p_op->step == ZMS_OP_WRITE_BATCH_COMMIT_DONE)) {
 		return true;
 	}
 
 	return false;
 }
 
+static inline bool is_batch_ate_write_step(zms_op_t *p_op)
+{
+	return (p_op->batch.entries &&
+		((p_op->step == ZMS_OP_WRITE_BATCH_BEGIN_DONE) ||
+		 (p_op->step == ZMS_OP_WRITE_DONE) ||
+		 (p_op->step == ZMS_OP_WRITE_BATCH_COMMIT_DONE)));
+}
+
 static void zms_event_handler(struct bm_storage_evt *p_evt)
 {
 	zms_op_t *p_op;
+	struct bm_zms_op_queue *queue;
 
 	if (p_evt->ctx != NULL) {
 		p_op = (zms_op_t *)(p_evt->ctx);
 
-		if (is_end_of_ate_write_step(p_op)) {
+		if (is_batch_ate_write_step(p_op)) {
+			/* The entries of a batch become visible when it is committed. */
+			p_op->batch.ate_wra -= zms_al_size(p_op->fs, sizeof(struct zms_ate));
+		} else if (is_end_of_ate_write_step(p_op)) {
 #ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
 			/* 0xFFFFFFFF is a special-purpose identifier. Exclude it from the cache */
 			if (p_op->ate_entry.id != ZMS_HEAD_ID) {
@@ -306,11 +467,12 @@ static void zms_event_handler(struct bm_storage_evt *p_evt)
 		LOG_ERR("%s: p_evt->ctx is NULL", __func__);
 		return;
 	}
-	atomic_set(&queue_process_start, true);
-	atomic_set(&cur_op_result, p_evt->result);
+	queue = CONTAINER_OF(p_op, struct bm_zms_op_queue, cur_op);
+	atomic_set(&queue->queue_process_start, true);
+	atomic_set(&queue->cur_op_result, p_evt->result);
 
 	if (p_evt->is_async) {
-		queue_process();
+		queue_process(queue);
 	}
 }
 
@@ -395,6 +557,107 @@ static void zms_lookup_cache_invalidate(struct bm_zms_fs *fs, uint32_t sector)
 	}
 }
 
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+
+static inline struct zms_cache_snapshot *zms_cache_snapshot_get(struct bm_zms_fs *fs)
+{
+	return &cache_snapshots[fs->op_queue - op_queues];
+}
+
+static uint32_t zms_cache_snapshot_crc(const struct zms_cache_snapshot *snapshot)
+{
+	return crc32_ieee((const uint8_t *)&snapshot->ate_wra,
+			  sizeof(*snapshot) - offsetof(struct zms_cache_snapshot, ate_wra));
+}
+
+static void zms_cache_snapshot_invalidate(struct bm_zms_fs *fs)
+{
+	zms_cache_snapshot_get(fs)->magic = 0;
+}
+
+static void zms_cache_snapshot_save(struct bm_zms_fs *fs)
+{
+	struct zms_cache_snapshot *snapshot = zms_cache_snapshot_get(fs);
+	uint8_t cycle;
+
+	snapshot->magic = 0;
+
+	if (zms_get_sector_cycle(fs, fs->ate_wra, &cycle)) {
+		return;
+	}
+
+	snapshot->ate_wra = fs->ate_wra;
+	snapshot->offset = fs->offset;
+	snapshot->sector_size = fs->sector_size;
+	snapshot->sector_count = fs->sector_count;
+	snapshot->sector_cycle = cycle;
+	memcpy(snapshot->lookup_cache, fs->lookup_cache, sizeof(snapshot->lookup_cache));
+	snapshot->crc = zms_cache_snapshot_crc(snapshot);
+	snapshot->magic = ZMS_CACHE_SNAPSHOT_MAGIC;
+}
+
+/* Take a new snapshot when the open sector has changed since the last one. Entries written in
+ * the same sector are replayed at mount.
+ */
+static void zms_cache_snapshot_update(struct bm_zms_fs *fs)
+{
+	const struct zms_cache_snapshot *snapshot = zms_cache_snapshot_get(fs);
+
+	if ((snapshot->magic != ZMS_CACHE_SNAPSHOT_MAGIC) ||
+	    (SECTOR_NUM(snapshot->ate_wra) != SECTOR_NUM(fs->ate_wra))) {
+		zms_cache_snapshot_save(fs);
+	}
+}
+
+/* Restore the lookup cache from the snapshot, if it was taken in the open sector and no sector
+ * was erased since. Otherwise, rebuild it from all ATEs.
+ */
+static int zms_lookup_cache_restore(struct bm_zms_fs *fs)
+{
+	const struct zms_cache_snapshot *snapshot = zms_cache_snapshot_get(fs);
+	struct zms_ate ate;
+	uint64_t addr;
+	uint8_t cycle;
+	int rc;
+
+	if ((snapshot->magic != ZMS_CACHE_SNAPSHOT_MAGIC) ||
+	    (snapshot->offset != (uint64_t)fs->offset) ||
+	    (snapshot->sector_size != fs->sector_size) ||
+	    (snapshot->sector_count != fs->sector_count) ||
+	    (SECTOR_NUM(snapshot->ate_wra) != SECTOR_NUM(fs->ate_wra)) ||
+	    (snapshot->ate_wra < fs->ate_wra) ||
+	    (snapshot->crc != zms_cache_snapshot_crc(snapshot))) {
+		return zms_lookup_cache_rebuild(fs);
+	}
+
+	/* The cycle counter of the open sector changes when it is erased. */
+	rc = zms_get_sector_cycle(fs, fs->ate_wra, &cycle);
+	if (rc || (cycle != snapshot->sector_cycle)) {
+		return zms_lookup_cache_rebuild(fs);
+	}
+
+	memcpy(fs->lookup_cache, snapshot->lookup_cache, sizeof(fs->lookup_cache));
+
+	/* Replay the ATEs written after the snapshot, from the oldest to the most recent. */
+	for (addr = snapshot->ate_wra; addr > fs->ate_wra; addr -= fs->ate_size) {
+		rc = zms_flash_ate_rd(fs, addr, &ate);
+		if (rc) {
+			return rc;
+		}
+
+		if ((ate.id != ZMS_HEAD_ID) && zms_ate_valid_different_sector(fs, &ate, cycle)) {
+			fs->lookup_cache[zms_lookup_cache_pos(ate.id)] = addr;
+		}
+	}
+
+	LOG_DBG("Lookup cache restored, %llu ATEs replayed",
+		(snapshot->ate_wra - fs->ate_wra) / fs->ate_size);
+
+	return 0;
+}
+
+#endif /* CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT */
+
 #endif /* CONFIG_BM_ZMS_LOOKUP_CACHE */
 
 /* Helper to compute a partition-relative offset from a ZMS virtual address */
@@ -440,239 +703,268 @@ static inline uint64_t zms_close_ate_addr(struct bm_zms_fs *fs, uint64_t addr)
 	return (addr & ADDR_SECT_MASK) + fs->sector_size - 2 * fs->ate_size;
 }
 
-static void zms_next_state_common(zms_write_step_t next_step, zms_write_step_t default_state)
+static void zms_next_state_common(struct bm_zms_fs *fs, zms_write_step_t next_step,
+				  zms_write_step_t default_state)
 {
-	switch (cur_op.sub_step) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	switch (op->sub_step) {
 	case ZMS_OP_WRITE_SUB_STEP_ATE1:
-		if (cur_op.len) {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE2;
-			cur_op.addr = cur_op.fs->ate_wra;
+		if (op->len) {
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE2;
+			op->addr = op->fs->ate_wra;
 		} else {
-			cur_op.step = next_step;
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+			op->step = next_step;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		}
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_ATE2:
-		cur_op.step = next_step;
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		op->step = next_step;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		break;
 	default:
 		/* Should not happen */
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
-		cur_op.step = default_state;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		op->step = default_state;
 		break;
 	}
 }
 
-static void zms_next_state_write_execute(void)
+static void zms_next_state_write_execute(struct bm_zms_fs *fs)
 {
-	switch (cur_op.sub_step) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	switch (op->sub_step) {
 	case ZMS_OP_WRITE_SUB_STEP_DATA1:
-		if (cur_op.len) {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_DATA2;
-			cur_op.addr = cur_op.fs->data_wra;
+		if (op->len) {
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_DATA2;
+			op->addr = op->fs->data_wra;
 		} else {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
 		}
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_DATA2:
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_ATE1:
-		if (cur_op.len) {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE2;
-			cur_op.addr = cur_op.fs->ate_wra;
+		if (op->len) {
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE2;
+			op->addr = op->fs->ate_wra;
 		} else {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
-			cur_op.step = ZMS_OP_WRITE_DONE;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+			op->step = ZMS_OP_WRITE_DONE;
 		}
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_ATE2:
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
-		cur_op.step = ZMS_OP_WRITE_DONE;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		op->step = ZMS_OP_WRITE_DONE;
 		break;
 	default:
 		/* Should not happen */
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		break;
 	}
 }
 
-static void zms_next_state_write_close_sector_garbage(void)
+static void zms_next_state_write_close_sector_garbage(struct bm_zms_fs *fs)
 {
-	zms_next_state_common(ZMS_OP_WRITE_CLOSE_SECTOR_ATE, ZMS_OP_WRITE_DONE);
+	zms_next_state_common(fs, ZMS_OP_WRITE_CLOSE_SECTOR_ATE, ZMS_OP_WRITE_DONE);
 }
 
-static void zms_next_state_write_close_sector_ate(void)
+static void zms_next_state_write_close_sector_ate(struct bm_zms_fs *fs)
 {
-	zms_next_state_common(ZMS_OP_WRITE_CLOSE_SECTOR_DONE, ZMS_OP_WRITE_DONE);
+	zms_next_state_common(fs, ZMS_OP_WRITE_CLOSE_SECTOR_DONE, ZMS_OP_WRITE_DONE);
 }
 
-static void zms_next_state_gc(void)
+static void zms_next_state_gc(struct bm_zms_fs *fs)
 {
-	switch (cur_op.gc.step) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	switch (op->gc.step) {
 	case ZMS_OP_WRITE_GC_INIT:
-		cur_op.gc.step = ZMS_OP_WRITE_GC_EXECUTE;
+		op->gc.step = ZMS_OP_WRITE_GC_EXECUTE;
 		break;
 	case ZMS_OP_WRITE_GC_INIT_EMPTY_SECTOR:
-		cur_op.gc.step = ZMS_OP_WRITE_GC_INIT;
+		op->gc.step = ZMS_OP_WRITE_GC_INIT;
 		break;
 	case ZMS_OP_WRITE_GC_EXECUTE:
-		if ((cur_op.gc.blk_mv_len) && (cur_op.ate_entry.len > ZMS_DATA_IN_ATE_SIZE)) {
-			cur_op.gc.step = ZMS_OP_WRITE_GC_BLK_MOVE;
+		if ((op->gc.blk_mv_len) && (op->ate_entry.len > ZMS_DATA_IN_ATE_SIZE)) {
+			op->gc.step = ZMS_OP_WRITE_GC_BLK_MOVE;
 		} else {
-			cur_op.gc.step = ZMS_OP_WRITE_GC_ATE_COPY;
+			op->gc.step = ZMS_OP_WRITE_GC_ATE_COPY;
 		}
 		break;
 	case ZMS_OP_WRITE_GC_BLK_MOVE:
-		if (!cur_op.gc.blk_mv_len) {
+		if (!op->gc.blk_mv_len) {
 			/* If there is no more data to move, we can proceed to the next step */
-			cur_op.gc.step = ZMS_OP_WRITE_GC_ATE_COPY;
+			op->gc.step = ZMS_OP_WRITE_GC_ATE_COPY;
 		} else {
 			/* If there is still data to move, we need to continue moving it */
-			cur_op.gc.step = ZMS_OP_WRITE_GC_BLK_MOVE;
+			op->gc.step = ZMS_OP_WRITE_GC_BLK_MOVE;
 		}
 		break;
 	case ZMS_OP_WRITE_GC_ATE_COPY:
-		if (cur_op.gc.gc_prev_addr == cur_op.gc.stop_addr) {
-			cur_op.gc.step = ZMS_OP_WRITE_GC_ATE_COPY_DONE;
+		if (op->gc.gc_prev_addr == op->gc.stop_addr) {
+			op->gc.step = ZMS_OP_WRITE_GC_ATE_COPY_DONE;
 		} else {
-			cur_op.gc.step = ZMS_OP_WRITE_GC_EXECUTE;
+			op->gc.step = ZMS_OP_WRITE_GC_EXECUTE;
 		}
 		break;
 	case ZMS_OP_WRITE_GC_DONE:
 	case ZMS_OP_WRITE_GC_ATE_COPY_DONE:
-		cur_op.gc.step = ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR;
+		op->gc.step = ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR;
 		break;
 	case ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR:
-		if (cur_op.op_code == ZMS_OP_WRITE) {
-			cur_op.data = cur_op.app_data;
-			zms_verify_space(&cur_op);
-			if (cur_op.step == ZMS_OP_WRITE_EXECUTE) {
-				cur_op.gc.step = ZMS_OP_WRITE_GC_NONE;
-				cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		if (op->op_code == ZMS_OP_WRITE) {
+			op->data = op->app_data;
+			zms_verify_space(op);
+			if ((op->step == ZMS_OP_WRITE_EXECUTE) ||
+			    (op->step == ZMS_OP_WRITE_BATCH_BEGIN)) {
+				op->gc.step = ZMS_OP_WRITE_GC_NONE;
+				op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 			}
-		} else if (cur_op.op_code == ZMS_OP_INIT) {
-			cur_op.step = ZMS_OP_INIT_ADD_GC_DONE;
-			cur_op.gc.step = ZMS_OP_WRITE_GC_NONE;
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		} else if (op->op_code == ZMS_OP_GC) {
+			op->step = ZMS_OP_GC_DONE;
+			op->gc.step = ZMS_OP_WRITE_GC_NONE;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		} else if (op->op_code == ZMS_OP_INIT) {
+			op->step = ZMS_OP_INIT_ADD_GC_DONE;
+			op->gc.step = ZMS_OP_WRITE_GC_NONE;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		}
 		break;
 
 	default:
 		/* Should not happen */
-		cur_op.gc.step = ZMS_OP_WRITE_GC_NONE;
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
-		cur_op.step = ZMS_OP_WRITE_DONE;
+		op->gc.step = ZMS_OP_WRITE_GC_NONE;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		op->step = ZMS_OP_WRITE_DONE;
 		break;
 	}
 }
 
-static void zms_next_state_common_gc(void)
+static void zms_next_state_common_gc(struct bm_zms_fs *fs)
 {
-	switch (cur_op.sub_step) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	switch (op->sub_step) {
 	case ZMS_OP_WRITE_SUB_STEP_ATE1:
-		if (cur_op.len) {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE2;
-			cur_op.addr = cur_op.fs->ate_wra;
+		if (op->len) {
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE2;
+			op->addr = op->fs->ate_wra;
 		} else {
-			zms_next_state_gc();
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+			zms_next_state_gc(fs);
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		}
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_ATE2:
-		zms_next_state_gc();
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		zms_next_state_gc(fs);
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_DATA1:
-		if (cur_op.len) {
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_DATA2;
-			cur_op.addr = cur_op.fs->data_wra;
+		if (op->len) {
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_DATA2;
+			op->addr = op->fs->data_wra;
 		} else {
-			zms_next_state_gc();
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+			zms_next_state_gc(fs);
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		}
 		break;
 	case ZMS_OP_WRITE_SUB_STEP_DATA2:
-		zms_next_state_gc();
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		zms_next_state_gc(fs);
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
 		break;
 	default: /* Should not happen */
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
-		cur_op.step = ZMS_OP_WRITE_DONE;
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+		op->step = ZMS_OP_WRITE_DONE;
 		break;
 	}
 }
 
-static void zms_next_state_init_all_open_add_empty_ate(void)
+static void zms_next_state_init_all_open_add_empty_ate(struct bm_zms_fs *fs)
 {
-	zms_next_state_common(ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE, ZMS_OP_INIT_DONE);
+	zms_next_state_common(fs, ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE, ZMS_OP_INIT_DONE);
 }
 
-static void zms_next_state_init_add_empty_ate_gc_done(void)
+static void zms_next_state_init_add_empty_ate_gc_done(struct bm_zms_fs *fs)
 {
-	zms_next_state_common(ZMS_OP_INIT_ADD_GC_DONE, ZMS_OP_INIT_DONE);
+	zms_next_state_common(fs, ZMS_OP_INIT_ADD_GC_DONE, ZMS_OP_INIT_DONE);
 }
 
-static void zms_next_state_init_add_empty_ate_gc_todo(void)
+static void zms_next_state_init_add_empty_ate_gc_todo(struct bm_zms_fs *fs)
 {
-	zms_next_state_common(ZMS_OP_INIT_GC_START, ZMS_OP_INIT_DONE);
+	zms_next_state_common(fs, ZMS_OP_INIT_GC_START, ZMS_OP_INIT_DONE);
 }
 
-static void zms_next_state_init_add_gc_done(void)
+static void zms_next_state_init_add_gc_done(struct bm_zms_fs *fs)
 {
-	zms_next_state_common(ZMS_OP_INIT_DONE, ZMS_OP_INIT_DONE);
+	zms_next_state_common(fs, ZMS_OP_INIT_DONE, ZMS_OP_INIT_DONE);
 }
 
-static void zms_next_state_clear(void)
+static void zms_next_state_clear(struct bm_zms_fs *fs)
 {
-	if (cur_op.clear_sector >= cur_op.fs->sector_count) {
-		zms_next_state_common(ZMS_OP_CLEAR_DONE, ZMS_OP_CLEAR_DONE);
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	if (op->clear_sector >= op->fs->sector_count) {
+		zms_next_state_common(fs, ZMS_OP_CLEAR_DONE, ZMS_OP_CLEAR_DONE);
 	} else {
-		zms_next_state_common(ZMS_OP_CLEAR_EXECUTE, ZMS_OP_CLEAR_DONE);
+		zms_next_state_common(fs, ZMS_OP_CLEAR_EXECUTE, ZMS_OP_CLEAR_DONE);
 	}
 }
 
 static void zms_al_wrt_next_op(struct bm_zms_fs *fs)
 {
-	if (cur_op.op_code == ZMS_OP_WRITE) {
-		switch (cur_op.step) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	if ((op->op_code == ZMS_OP_WRITE) || (op->op_code == ZMS_OP_GC)) {
+		switch (op->step) {
 		case ZMS_OP_WRITE_EXECUTE:
-			zms_next_state_write_execute();
+			zms_next_state_write_execute(fs);
 			break;
 		case ZMS_OP_WRITE_CLOSE_SECTOR_GARBAGE:
-			zms_next_state_write_close_sector_garbage();
+			zms_next_state_write_close_sector_garbage(fs);
 			break;
 		case ZMS_OP_WRITE_CLOSE_SECTOR_ATE:
-			zms_next_state_write_close_sector_ate();
+			zms_next_state_write_close_sector_ate(fs);
 			break;
 		case ZMS_OP_WRITE_GC:
-			zms_next_state_common_gc();
+			zms_next_state_common_gc(fs);
+			break;
+		case ZMS_OP_WRITE_BATCH_BEGIN:
+			zms_next_state_common(fs, ZMS_OP_WRITE_BATCH_BEGIN_DONE,
+					      ZMS_OP_WRITE_DONE);
+			break;
+		case ZMS_OP_WRITE_BATCH_COMMIT:
+			zms_next_state_common(fs, ZMS_OP_WRITE_BATCH_COMMIT_DONE,
+					      ZMS_OP_WRITE_DONE);
 			break;
 		case ZMS_OP_WRITE_DONE:
 			break;
 		default:
 			/* Should not happen */
-			cur_op.step = ZMS_OP_WRITE_DONE;
+			op->step = ZMS_OP_WRITE_DONE;
 			break;
 		}
-	} else if (cur_op.op_code == ZMS_OP_INIT) {
-		switch (cur_op.step) {
+	} else if (op->op_code == ZMS_OP_INIT) {
+		switch (op->step) {
 		case ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE:
-			zms_next_state_init_all_open_add_empty_ate();
+			zms_next_state_init_all_open_add_empty_ate(fs);
 			break;
 		case ZMS_OP_INIT_ADD_EMPTY_ATE_GC_DONE:
-			zms_next_state_init_add_empty_ate_gc_done();
+			zms_next_state_init_add_empty_ate_gc_done(fs);
 			break;
 		case ZMS_OP_INIT_ADD_EMPTY_ATE_GC_TODO:
-			zms_next_state_init_add_empty_ate_gc_todo();
+			zms_next_state_init_add_empty_ate_gc_todo(fs);
 			break;
 		case ZMS_OP_INIT_ADD_GC_DONE:
-			zms_next_state_init_add_gc_done();
+			zms_next_state_init_add_gc_done(fs);
 			break;
 		case ZMS_OP_INIT_GC_START:
 		case ZMS_OP_INIT_GC:
-			zms_next_state_common_gc();
+			zms_next_state_common_gc(fs);
+			break;
+		case ZMS_OP_INIT_BATCH_ROLLBACK:
+			zms_next_state_common(fs, ZMS_OP_INIT_BATCH_ROLLBACK, ZMS_OP_INIT_DONE);
 			break;
 		case ZMS_OP_INIT_DONE:
 			fs->init_flags.initializing = false;
@@ -680,47 +972,48 @@ static void zms_al_wrt_next_op(struct bm_zms_fs *fs)
 			break;
 		default:
 			/* Should not happen */
-			cur_op.step = ZMS_OP_INIT_DONE;
+			op->step = ZMS_OP_INIT_DONE;
 			fs->init_flags.initializing = false;
 			fs->init_flags.initialized = true;
 			break;
 		}
-	} else if (cur_op.op_code == ZMS_OP_CLEAR) {
-		zms_next_state_clear();
+	} else if (op->op_code == ZMS_OP_CLEAR) {
+		zms_next_state_clear(fs);
 	}
 }
 
 /* Aligned memory write */
 static int zms_flash_al_wrt(struct bm_zms_fs *fs)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
 	const uint8_t *data8;
 	off_t offset;
 	size_t len;
 
-	if (!cur_op.len) {
+	if (!op->len) {
 		zms_al_wrt_next_op(fs);
 		/* Nothing to write, avoid changing the flash protection */
 		return 0;
 	}
 
-	if ((cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_ATE1) ||
-	    (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_ATE2)) {
+	if ((op->sub_step == ZMS_OP_WRITE_SUB_STEP_ATE1) ||
+	    (op->sub_step == ZMS_OP_WRITE_SUB_STEP_ATE2)) {
 		/* If this is an ATE write set the data8 pointer to the ATE. */
-		data8 = (const uint8_t *)&cur_op.ate_entry;
+		data8 = (const uint8_t *)&op->ate_entry;
 	} else {
 		/* If this is a data write set the data8 pointer to the actual data to write.
 		 * This could be either a data from the App or from an internal buffer.
 		 */
-		data8 = (const uint8_t *)cur_op.data;
+		data8 = (const uint8_t *)op->data;
 	}
 
-	offset = zms_addr_to_offset(fs, cur_op.addr);
-	len = cur_op.len;
+	offset = zms_addr_to_offset(fs, op->addr);
+	len = op->len;
 
-	cur_op.len = 0;
+	op->len = 0;
 
 	zms_al_wrt_next_op(fs);
-	return bm_storage_write(&fs->zms_bm_storage, offset, data8, len, (void *)&cur_op);
+	return bm_storage_write(&fs->zms_bm_storage, offset, data8, len, (void *)op);
 }
 
 /* basic flash read from bm_zms address */
@@ -736,9 +1029,11 @@ static int zms_flash_rd(struct bm_zms_fs *fs, uint64_t addr, void *data, size_t
 /* allocation entry write */
 static int zms_flash_ate_wrt(struct bm_zms_fs *fs)
 {
-	if (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_NONE) {
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
-		cur_op.len = sizeof(struct zms_ate);
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	if (op->sub_step == ZMS_OP_WRITE_SUB_STEP_NONE) {
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
+		op->len = sizeof(struct zms_ate);
 	}
 	return zms_flash_al_wrt(fs);
 }
@@ -746,13 +1041,15 @@ static int zms_flash_ate_wrt(struct bm_zms_fs *fs)
 /* data write */
 static int zms_flash_data_wrt(struct bm_zms_fs *fs)
 {
-	if (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_NONE) {
-		cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_DATA1;
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	if (op->sub_step == ZMS_OP_WRITE_SUB_STEP_NONE) {
+		op->sub_step = ZMS_OP_WRITE_SUB_STEP_DATA1;
 	}
-	if (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_DATA1) {
-		cur_op.len = cur_op.data_len;
+	if (op->sub_step == ZMS_OP_WRITE_SUB_STEP_DATA1) {
+		op->len = op->data_len;
 	}
-	cur_op.addr = fs->data_wra;
+	op->addr = fs->data_wra;
 
 	return zms_flash_al_wrt(fs);
 }
@@ -825,26 +1122,26 @@ static int zms_flash_cmp_const(struct bm_zms_fs *fs, uint64_t addr, uint8_t valu
  */
 static int zms_flash_block_move(struct bm_zms_fs *fs)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
 	int rc;
 	size_t bytes_to_copy;
 	size_t block_size;
-
-	static __aligned(4) uint8_t buf_gc[ZMS_BLOCK_SIZE];
+	uint8_t *buf_gc = fs->op_queue->buf_gc;
 
 	block_size = zms_round_down_write_block_size(fs, ZMS_BLOCK_SIZE);
 
-	if (cur_op.gc.blk_mv_len) {
-		bytes_to_copy = MIN(block_size, cur_op.gc.blk_mv_len);
-		rc = zms_flash_rd(fs, cur_op.gc.blk_mv_addr, buf_gc, bytes_to_copy);
+	if (op->gc.blk_mv_len) {
+		bytes_to_copy = MIN(block_size, op->gc.blk_mv_len);
+		rc = zms_flash_rd(fs, op->gc.blk_mv_addr, buf_gc, bytes_to_copy);
 		if (rc) {
 			return rc;
 		}
 
-		cur_op.gc.blk_mv_len -= bytes_to_copy;
-		cur_op.gc.blk_mv_addr += bytes_to_copy;
-		cur_op.data = buf_gc;
-		cur_op.data_len = bytes_to_copy;
-		cur_op.len = bytes_to_copy;
+		op->gc.blk_mv_len -= bytes_to_copy;
+		op->gc.blk_mv_addr += bytes_to_copy;
+		op->data = buf_gc;
+		op->data_len = bytes_to_copy;
+		op->len = bytes_to_copy;
 		return zms_flash_data_wrt(fs);
 	}
 	return 0;
@@ -855,6 +1152,7 @@ static int zms_flash_block_move(struct bm_zms_fs *fs)
  */
 static int zms_flash_erase_sector(struct bm_zms_fs *fs, uint64_t addr)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
 	int rc;
 	off_t offset;
 	bool ebw_required = fs->nvm_info->is_erase_before_write;
@@ -879,7 +1177,7 @@ static int zms_flash_erase_sector(struct bm_zms_fs *fs, uint64_t addr)
 #ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
 	zms_lookup_cache_invalidate(fs, SECTOR_NUM(addr));
 #endif
-	rc = bm_storage_erase(&fs->zms_bm_storage, offset, fs->sector_size, &cur_op);
+	rc = bm_storage_erase(&fs->zms_bm_storage, offset, fs->sector_size, op);
 	if (rc) {
 		return rc;
 	}
@@ -1039,48 +1337,50 @@ static int zms_validate_closed_sector(struct bm_zms_fs *fs, uint64_t addr,
 /* store an entry in flash */
 static int zms_flash_write_entry(struct bm_zms_fs *fs)
 {
-	if (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_NONE) {
-		if (cur_op.data_len > ZMS_DATA_IN_ATE_SIZE) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	if (op->sub_step == ZMS_OP_WRITE_SUB_STEP_NONE) {
+		if (op->data_len > ZMS_DATA_IN_ATE_SIZE) {
 			/* data_len is greater than 8 bytes, write data separately */
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_DATA1;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_DATA1;
 		} else {
 			/* data_len is less than or equal to 8 bytes, write data in ATE */
-			cur_op.sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
 		}
 	}
 
-	if ((cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_ATE1) ||
-	    (cur_op.sub_step == ZMS_OP_WRITE_SUB_STEP_ATE2)) {
+	if ((op->sub_step == ZMS_OP_WRITE_SUB_STEP_ATE1) ||
+	    (op->sub_step == ZMS_OP_WRITE_SUB_STEP_ATE2)) {
 		/* Initialize all members to 0 */
-		memset(&cur_op.ate_entry, 0, sizeof(struct zms_ate));
+		memset(&op->ate_entry, 0, sizeof(struct zms_ate));
 
-		cur_op.ate_entry.id = cur_op.id;
-		cur_op.ate_entry.len = (uint16_t)cur_op.data_len;
-		cur_op.ate_entry.cycle_cnt = fs->sector_cycle;
+		op->ate_entry.id = op->id;
+		op->ate_entry.len = (uint16_t)op->data_len;
+		op->ate_entry.cycle_cnt = fs->sector_cycle;
 
-		if (cur_op.data_len > ZMS_DATA_IN_ATE_SIZE) {
+		if (op->data_len > ZMS_DATA_IN_ATE_SIZE) {
 			/* only compute CRC if len is greater than 8 bytes */
 			if (IS_ENABLED(CONFIG_BM_ZMS_DATA_CRC)) {
-				cur_op.ate_entry.data_crc =
-					crc32_ieee(cur_op.data, cur_op.data_len);
+				op->ate_entry.data_crc =
+					crc32_ieee(op->data, op->data_len);
 			}
-			cur_op.ate_entry.offset = (uint32_t)SECTOR_OFFSET(fs->data_wra);
-		} else if ((cur_op.data_len > 0) && (cur_op.data_len <= ZMS_DATA_IN_ATE_SIZE)) {
+			op->ate_entry.offset = (uint32_t)SECTOR_OFFSET(fs->data_wra);
+		} else if ((op->data_len > 0) && (op->data_len <= ZMS_DATA_IN_ATE_SIZE)) {
 			/* Copy data into entry for small data ( < 8B) */
-			memcpy(&cur_op.ate_entry.data, cur_op.data, cur_op.data_len);
+			memcpy(&op->ate_entry.data, op->data, op->data_len);
 		}
-		zms_ate_crc8_update(&cur_op.ate_entry);
+		zms_ate_crc8_update(&op->ate_entry);
 	}
 
-	switch (cur_op.sub_step) {
+	switch (op->sub_step) {
 	case ZMS_OP_WRITE_SUB_STEP_DATA1:
 	case ZMS_OP_WRITE_SUB_STEP_DATA2:
-		cur_op.addr = fs->data_wra;
+		op->addr = fs->data_wra;
 		return zms_flash_data_wrt(fs);
 	case ZMS_OP_WRITE_SUB_STEP_ATE1:
 	case ZMS_OP_WRITE_SUB_STEP_ATE2:
-		cur_op.addr = fs->ate_wra;
-		cur_op.len = sizeof(struct zms_ate);
+		op->addr = op->batch.entries ? op->batch.ate_wra : fs->ate_wra;
+		op->len = sizeof(struct zms_ate);
 		return zms_flash_ate_wrt(fs);
 	default:
 		break;
@@ -1203,7 +1503,9 @@ static void zms_sector_advance(struct bm_zms_fs *fs, uint64_t *addr)
  */
 static int zms_sector_close(struct bm_zms_fs *fs)
 {
-	if (cur_op.step == ZMS_OP_WRITE_CLOSE_SECTOR_GARBAGE) {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	if (op->step == ZMS_OP_WRITE_CLOSE_SECTOR_GARBAGE) {
 		/* When we close the sector, we must write all non used ATE with
 		 * a non valid (Junk) ATE.
 		 * This is needed to avoid some corner cases where some ATEs are
@@ -1216,27 +1518,27 @@ static int zms_sector_close(struct bm_zms_fs *fs)
 		 *   - Next 256th cycle the leading cycle_cnt is 0, this ATE becomes
 		 *     valid even if it is not the case.
 		 */
-		memset(&cur_op.ate_entry, fs->nvm_info->erase_value,
+		memset(&op->ate_entry, fs->nvm_info->erase_value,
 		       sizeof(struct zms_ate));
 		if (SECTOR_OFFSET(fs->ate_wra) && (fs->ate_wra > fs->data_wra)) {
-			cur_op.len = sizeof(struct zms_ate);
-			cur_op.addr = fs->ate_wra;
+			op->len = sizeof(struct zms_ate);
+			op->addr = fs->ate_wra;
 			return zms_flash_ate_wrt(fs);
 		}
-		cur_op.step = ZMS_OP_WRITE_CLOSE_SECTOR_ATE;
+		op->step = ZMS_OP_WRITE_CLOSE_SECTOR_ATE;
 	}
 
-	if (cur_op.step == ZMS_OP_WRITE_CLOSE_SECTOR_ATE) {
-		cur_op.ate_entry.id = ZMS_HEAD_ID;
-		cur_op.ate_entry.len = 0U;
-		cur_op.ate_entry.offset = (uint32_t)SECTOR_OFFSET(fs->ate_wra + fs->ate_size);
-		cur_op.ate_entry.metadata = 0xffffffff;
-		cur_op.ate_entry.cycle_cnt = fs->sector_cycle;
-		zms_ate_crc8_update(&cur_op.ate_entry);
+	if (op->step == ZMS_OP_WRITE_CLOSE_SECTOR_ATE) {
+		op->ate_entry.id = ZMS_HEAD_ID;
+		op->ate_entry.len = 0U;
+		op->ate_entry.offset = (uint32_t)SECTOR_OFFSET(fs->ate_wra + fs->ate_size);
+		op->ate_entry.metadata = 0xffffffff;
+		op->ate_entry.cycle_cnt = fs->sector_cycle;
+		zms_ate_crc8_update(&op->ate_entry);
 		fs->ate_ra = fs->ate_wra;
 		fs->ate_wra = zms_close_ate_addr(fs, fs->ate_wra);
-		cur_op.addr = fs->ate_wra;
-		cur_op.len = sizeof(struct zms_ate);
+		op->addr = fs->ate_wra;
+		op->len = sizeof(struct zms_ate);
 		return zms_flash_ate_wrt(fs);
 	}
 
@@ -1245,6 +1547,7 @@ static int zms_sector_close(struct bm_zms_fs *fs)
 
 static int zms_gc_prepare(struct bm_zms_fs *fs)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
 	int rc;
 
 	zms_sector_advance(fs, &fs->ate_wra);
@@ -1257,29 +1560,149 @@ static int zms_gc_prepare(struct bm_zms_fs *fs)
 		return rc;
 	}
 	fs->data_wra = fs->ate_wra & ADDR_SECT_MASK;
-	cur_op.gc.step = ZMS_OP_WRITE_GC_INIT;
+	op->gc.step = ZMS_OP_WRITE_GC_INIT;
 
 	return 0;
 }
 
 static int zms_add_gc_done_ate(struct bm_zms_fs *fs)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
+
 	LOG_DBG("Adding gc done ate at %llx", fs->ate_wra);
 	/* Initialize all members to 0 */
-	memset(&cur_op.ate_entry, 0, sizeof(struct zms_ate));
-	cur_op.ate_entry.id = ZMS_HEAD_ID;
-	cur_op.ate_entry.len = 0U;
-	cur_op.ate_entry.offset = (uint32_t)SECTOR_OFFSET(fs->data_wra);
-	cur_op.ate_entry.metadata = 0xffffffff;
-	cur_op.ate_entry.cycle_cnt = fs->sector_cycle;
+	memset(&op->ate_entry, 0, sizeof(struct zms_ate));
+	op->ate_entry.id = ZMS_HEAD_ID;
+	op->ate_entry.len = 0U;
+	op->ate_entry.offset = (uint32_t)SECTOR_OFFSET(fs->data_wra);
+	op->ate_entry.metadata = 0xffffffff;
+	op->ate_entry.cycle_cnt = fs->sector_cycle;
+
+	zms_ate_crc8_update(&op->ate_entry);
+
+	op->len = sizeof(struct zms_ate);
+	op->addr = fs->ate_wra;
+	return zms_flash_ate_wrt(fs);
+}
+
+/* Write the ATE that begins or commits a batch, below the ATEs already written by the batch */
+static int zms_batch_marker_write(struct bm_zms_fs *fs, uint16_t marker_len)
+{
+	zms_op_t *op = &fs->op_queue->cur_op;
+
+	memset(&op->ate_entry, 0, sizeof(struct zms_ate));
+	op->ate_entry.id = ZMS_HEAD_ID;
+	op->ate_entry.len = marker_len;
+	op->ate_entry.offset = op->batch.count;
+	op->ate_entry.metadata = 0xffffffff;
+	op->ate_entry.cycle_cnt = fs->sector_cycle;
 
-	zms_ate_crc8_update(&cur_op.ate_entry);
+	zms_ate_crc8_update(&op->ate_entry);
 
-	cur_op.len = sizeof(struct zms_ate);
-	cur_op.addr = fs->ate_wra;
+	op->len = sizeof(struct zms_ate);
+	op->addr = op->batch.ate_wra;
 	return zms_flash_ate_wrt(fs);
 }
 
+/* Load the next entry of a batch into the operation and start writing it */
+static int zms_batch_entry_write(struct bm_zms_fs *fs)
+{
+	zms_op_t *op = &fs->op_queue->cur_op;
+	const struct bm_zms_batch_entry *entry = &op->batch.entries[op->batch.idx];
+
+	op->id = entry->id;
+	op->data = entry->data;
+	op->app_data = entry->data;
+	op->data_len = entry->len;
+	op->step = ZMS_OP_WRITE_EXECUTE;
+	op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+
+	return zms_flash_write_entry(fs);
+}
+
+/* The commit ATE is written, make the entries of the batch visible */
+static void zms_batch_commit(struct bm_zms_fs *fs)
+{
+	zms_op_t *op = &fs->op_queue->cur_op;
+#ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
+	/* The entry ATEs follow the begin ATE, which is at fs->ate_wra */
+	uint64_t addr = fs->ate_wra;
+
+	for (uint32_t i = 0; i < op->batch.count; i++) {
+		addr -= fs->ate_size;
+		fs->lookup_cache[zms_lookup_cache_pos(op->batch.entries[i].id)] = addr;
+	}
+#endif
+	fs->ate_wra = op->batch.ate_wra;
+}
+
+/* Search the open sector for a batch that was interrupted before it was committed.
+ * The newest batch ATE tells whether the last batch completed, as batches never span
+ * sectors and nothing is written between the ATEs of a batch.
+ */
+static int zms_batch_find_interrupted(struct bm_zms_fs *fs, uint64_t *batch_addr)
+{
+	int rc;
+	uint64_t addr;
+	struct zms_ate ate;
+
+	*batch_addr = 0;
+
+	for (addr = fs->ate_wra + fs->ate_size; addr < zms_close_ate_addr(fs, fs->ate_wra);
+	     addr += fs->ate_size) {
+		rc = zms_flash_ate_rd(fs, addr, &ate);
+		if (rc) {
+			return rc;
+		}
+
+		if (!zms_ate_valid(fs, &ate) || (ate.id != ZMS_HEAD_ID)) {
+			continue;
+		}
+
+		/* A commit or gc_done ATE is found first if no batch is pending */
+		if (ate.len == ZMS_BATCH_BEGIN_LEN) {
+			LOG_WRN("Rolling back interrupted batch of %u entries", ate.offset);
+			*batch_addr = addr;
+		}
+		break;
+	}
+
+	return 0;
+}
+
+/* Invalidate the next valid ATE of an interrupted batch, from the newest ATE up to the begin
+ * ATE, which is invalidated last so that an interrupted rollback is resumed at the next mount.
+ * op->init.batch_addr is cleared once all ATEs are invalid.
+ */
+static int zms_batch_rollback(struct bm_zms_fs *fs)
+{
+	zms_op_t *op = &fs->op_queue->cur_op;
+	struct zms_ate ate;
+	uint64_t addr;
+	int rc;
+
+	while (op->init.rollback_addr <= op->init.batch_addr) {
+		addr = op->init.rollback_addr;
+		op->init.rollback_addr += fs->ate_size;
+
+		rc = zms_flash_ate_rd(fs, addr, &ate);
+		if (rc) {
+			return rc;
+		}
+
+		if (zms_ate_valid(fs, &ate)) {
+			memset(&op->ate_entry, fs->nvm_info->erase_value, sizeof(struct zms_ate));
+			op->len = sizeof(struct zms_ate);
+			op->addr = addr;
+			return zms_flash_ate_wrt(fs);
+		}
+	}
+
+	op->init.batch_addr = 0;
+
+	return 0;
+}
+
 /* This function verifies that the cycle_cnt of the close ATE will not be equal
  * to the cycle_cnt of the empty ATE after incrementing it.
  * This is possible only in these extreme conditions:
@@ -1316,15 +1739,25 @@ static inline int zms_verify_and_increment_cycle_cnt(struct bm_zms_fs *fs, uint6
 
 static int zms_add_empty_ate(struct bm_zms_fs *fs, uint64_t addr)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
 	uint8_t cycle_cnt;
 	int rc = 0;
 
 	addr &= ADDR_SECT_MASK;
 
-	cur_op.ate_entry.id = ZMS_HEAD_ID;
-	cur_op.ate_entry.len = 0xffff;
-	cur_op.ate_entry.offset = 0U;
-	cur_op.ate_entry.metadata =
+	/* The sector is reused, references to its data are no longer valid. */
+	atomic_inc(&fs->generation);
+
+#if defined(CONFIG_BM_ZMS_STATS)
+	if (SECTOR_NUM(addr) < CONFIG_BM_ZMS_STATS_MAX_SECTORS) {
+		fs->stats.sector_erase_count[SECTOR_NUM(addr)]++;
+	}
+#endif
+
+	op->ate_entry.id = ZMS_HEAD_ID;
+	op->ate_entry.len = 0xffff;
+	op->ate_entry.offset = 0U;
+	op->ate_entry.metadata =
 		FIELD_PREP(ZMS_MAGIC_NUMBER_MASK, ZMS_MAGIC_NUMBER) | ZMS_DEFAULT_VERSION;
 
 	rc = zms_get_sector_cycle(fs, addr, &cycle_cnt);
@@ -1341,11 +1774,11 @@ static int zms_add_empty_ate(struct bm_zms_fs *fs, uint64_t addr)
 	if (rc < 0) {
 		return rc;
 	}
-	cur_op.ate_entry.cycle_cnt = cycle_cnt;
-	zms_ate_crc8_update(&cur_op.ate_entry);
+	op->ate_entry.cycle_cnt = cycle_cnt;
+	zms_ate_crc8_update(&op->ate_entry);
 
-	cur_op.addr = zms_empty_ate_addr(fs, addr);
-	cur_op.len = sizeof(struct zms_ate);
+	op->addr = zms_empty_ate_addr(fs, addr);
+	op->len = sizeof(struct zms_ate);
 	return zms_flash_ate_wrt(fs);
 }
 
@@ -1452,12 +1885,45 @@ static int zms_find_ate_with_id(struct bm_zms_fs *fs, uint32_t id, uint64_t star
 	return prev_found;
 }
 
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+/* A background GC pauses once it has examined the ATEs allowed in the current step. */
+static bool zms_gc_pause(struct bm_zms_fs *fs)
+{
+	struct bm_zms_op_queue *queue = fs->op_queue;
+
+	if (queue->cur_op.op_code != ZMS_OP_GC) {
+		return false;
+	}
+
+	if (queue->gc_budget) {
+		queue->gc_budget--;
+		return false;
+	}
+
+	atomic_set(&queue->gc_paused, true);
+	if ((atomic_get(&queue->queued_op_cnt) > 1) &&
+	    atomic_cas(&queue->gc_paused, true, false)) {
+		/* An operation was queued meanwhile, do not make it wait for the next steps. */
+		queue->gc_budget = UINT32_MAX;
+		return false;
+	}
+
+	LOG_DBG("GC paused, gc_addr 0x%llx", queue->cur_op.gc.gc_addr);
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND_SCHEDULER)
+	zms_gc_schedule(fs);
+#endif
+
+	return true;
+}
+#endif
+
 /* garbage collection: the address ate_wra has been updated to the new sector
  * that has just been started. The data to gc is in the sector after this new
  * sector.
  */
 static int zms_gc(struct bm_zms_fs *fs)
 {
+	zms_op_t *op = &fs->op_queue->cur_op;
 	int rc;
 	int sec_closed;
 	struct zms_ate close_ate;
@@ -1467,35 +1933,35 @@ static int zms_gc(struct bm_zms_fs *fs)
 	uint64_t wlk_prev_addr;
 	uint64_t data_addr;
 
-	if (cur_op.gc.step == ZMS_OP_WRITE_GC_INIT) {
+	if (op->gc.step == ZMS_OP_WRITE_GC_INIT) {
 		rc = zms_get_sector_cycle(fs, fs->ate_wra, &fs->sector_cycle);
 		if (rc == -ENOENT) {
 			/* Erase this new unused sector if needed */
 			rc = zms_flash_erase_sector(fs, fs->ate_wra);
 
 			/* sector never used */
-			cur_op.gc.step = ZMS_OP_WRITE_GC_INIT_EMPTY_SECTOR;
+			op->gc.step = ZMS_OP_WRITE_GC_INIT_EMPTY_SECTOR;
 			return zms_add_empty_ate(fs, fs->ate_wra);
 		} else if (rc) {
 			/* bad flash read */
 			return rc;
 		}
-		cur_op.gc.previous_cycle = fs->sector_cycle;
+		op->gc.previous_cycle = fs->sector_cycle;
 
-		cur_op.gc.sec_addr = (fs->ate_wra & ADDR_SECT_MASK);
-		zms_sector_advance(fs, &cur_op.gc.sec_addr);
-		cur_op.gc.gc_addr = cur_op.gc.sec_addr + fs->sector_size - fs->ate_size;
+		op->gc.sec_addr = (fs->ate_wra & ADDR_SECT_MASK);
+		zms_sector_advance(fs, &op->gc.sec_addr);
+		op->gc.gc_addr = op->gc.sec_addr + fs->sector_size - fs->ate_size;
 
 		/* verify if the sector is closed */
 		sec_closed =
-			zms_validate_closed_sector(fs, cur_op.gc.gc_addr, &empty_ate, &close_ate);
+			zms_validate_closed_sector(fs, op->gc.gc_addr, &empty_ate, &close_ate);
 		if (sec_closed < 0) {
 			return sec_closed;
 		}
 
 		/* if the sector is not closed don't do gc */
 		if (!sec_closed) {
-			cur_op.gc.step = ZMS_OP_WRITE_GC_DONE;
+			op->gc.step = ZMS_OP_WRITE_GC_DONE;
 			goto gc_done;
 		}
 
@@ -1503,29 +1969,37 @@ static int zms_gc(struct bm_zms_fs *fs)
 		fs->sector_cycle = empty_ate.cycle_cnt;
 
 		/* stop_addr points to the first ATE before the header ATEs */
-		cur_op.gc.stop_addr = cur_op.gc.gc_addr - 2 * fs->ate_size;
+		op->gc.stop_addr = op->gc.gc_addr - 2 * fs->ate_size;
 		/* At this step empty & close ATEs are valid.
 		 * let's start the GC
 		 */
-		cur_op.gc.gc_addr &= ADDR_SECT_MASK;
-		cur_op.gc.gc_addr += close_ate.offset;
-		cur_op.gc.step = ZMS_OP_WRITE_GC_EXECUTE;
+		op->gc.gc_addr &= ADDR_SECT_MASK;
+		op->gc.gc_addr += close_ate.offset;
+		op->gc.step = ZMS_OP_WRITE_GC_EXECUTE;
 	}
 
-	if (cur_op.gc.step == ZMS_OP_WRITE_GC_EXECUTE) {
+	if (op->gc.step == ZMS_OP_WRITE_GC_EXECUTE) {
 		do {
-			cur_op.gc.gc_prev_addr = cur_op.gc.gc_addr;
-			rc = zms_prev_ate(fs, &cur_op.gc.gc_addr, &cur_op.ate_entry);
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+			if (zms_gc_pause(fs)) {
+				/* Resumed by bm_zms_gc_step(), or by the next queued operation. */
+				return 0;
+			}
+#endif
+			op->gc.gc_prev_addr = op->gc.gc_addr;
+			rc = zms_prev_ate(fs, &op->gc.gc_addr, &op->ate_entry);
 			if (rc) {
 				return rc;
 			}
 
-			if (!zms_ate_valid(fs, &cur_op.ate_entry) || !cur_op.ate_entry.len) {
+			/* Skip batch ATEs, the entries they enclose are moved one by one. */
+			if (!zms_ate_valid(fs, &op->ate_entry) || !op->ate_entry.len ||
+			    (op->ate_entry.id == ZMS_HEAD_ID)) {
 				continue;
 			}
 
 #ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
-			wlk_addr = fs->lookup_cache[zms_lookup_cache_pos(cur_op.ate_entry.id)];
+			wlk_addr = fs->lookup_cache[zms_lookup_cache_pos(op->ate_entry.id)];
 
 			if (wlk_addr == ZMS_LOOKUP_CACHE_NO_ADDR) {
 				wlk_addr = fs->ate_wra;
@@ -1535,11 +2009,11 @@ static int zms_gc(struct bm_zms_fs *fs)
 #endif
 
 			/* Initialize the wlk_prev_addr as if no previous ID will be found */
-			wlk_prev_addr = cur_op.gc.gc_prev_addr;
+			wlk_prev_addr = op->gc.gc_prev_addr;
 			/* Search for a previous valid ATE with the same ID. If it doesn't exist
 			 * then wlk_prev_addr will be equal to gc_prev_addr.
 			 */
-			rc = zms_find_ate_with_id(fs, cur_op.ate_entry.id, wlk_addr, fs->ate_wra,
+			rc = zms_find_ate_with_id(fs, op->ate_entry.id, wlk_addr, fs->ate_wra,
 						  &wlk_ate, &wlk_prev_addr);
 			if (rc < 0) {
 				return rc;
@@ -1548,53 +2022,60 @@ static int zms_gc(struct bm_zms_fs *fs)
 			/* if walk_addr has reached the same address as gc_addr, a copy is
 			 * needed unless it is a deleted item.
 			 */
-			if (wlk_prev_addr == cur_op.gc.gc_prev_addr) {
+			if (wlk_prev_addr == op->gc.gc_prev_addr) {
 				/* copy needed */
 				LOG_DBG("Moving %d, len %d gc_prev_addr %llx from %x to data_wra "
 					"%llx ate_wra %llx",
-					cur_op.ate_entry.id, cur_op.ate_entry.len,
-					cur_op.gc.gc_prev_addr, cur_op.ate_entry.offset,
+					op->ate_entry.id, op->ate_entry.len,
+					op->gc.gc_prev_addr, op->ate_entry.offset,
 					fs->data_wra, fs->ate_wra);
+#if defined(CONFIG_BM_ZMS_STATS)
+				fs->stats.gc_bytes_moved += fs->ate_size;
+				if (op->ate_entry.len > ZMS_DATA_IN_ATE_SIZE) {
+					fs->stats.gc_bytes_moved +=
+						zms_al_size(fs, op->ate_entry.len);
+				}
+#endif
 
-				if (cur_op.ate_entry.len > ZMS_DATA_IN_ATE_SIZE) {
+				if (op->ate_entry.len > ZMS_DATA_IN_ATE_SIZE) {
 					/* Copy Data only when len > 8
 					 * Otherwise, Data is already inside ATE
 					 */
-					data_addr = (cur_op.gc.gc_prev_addr & ADDR_SECT_MASK);
-					data_addr += cur_op.ate_entry.offset;
-					cur_op.ate_entry.offset =
+					data_addr = (op->gc.gc_prev_addr & ADDR_SECT_MASK);
+					data_addr += op->ate_entry.offset;
+					op->ate_entry.offset =
 						(uint32_t)SECTOR_OFFSET(fs->data_wra);
-					cur_op.gc.blk_mv_addr = data_addr;
-					cur_op.gc.blk_mv_len = cur_op.ate_entry.len;
+					op->gc.blk_mv_addr = data_addr;
+					op->gc.blk_mv_len = op->ate_entry.len;
 
 					return zms_flash_block_move(fs);
 				}
-				cur_op.gc.step = ZMS_OP_WRITE_GC_ATE_COPY;
+				op->gc.step = ZMS_OP_WRITE_GC_ATE_COPY;
 				goto ate_copy;
 			}
-		} while (cur_op.gc.gc_prev_addr != cur_op.gc.stop_addr);
-		cur_op.gc.step = ZMS_OP_WRITE_GC_DONE;
+		} while (op->gc.gc_prev_addr != op->gc.stop_addr);
+		op->gc.step = ZMS_OP_WRITE_GC_DONE;
 	}
 
 ate_copy:
-	if (cur_op.gc.step == ZMS_OP_WRITE_GC_ATE_COPY) {
+	if (op->gc.step == ZMS_OP_WRITE_GC_ATE_COPY) {
 		/* data write (if needed) succeeded, increment data_wra */
-		if (cur_op.ate_entry.len > ZMS_DATA_IN_ATE_SIZE) {
-			fs->data_wra += zms_al_size(fs, cur_op.ate_entry.len);
+		if (op->ate_entry.len > ZMS_DATA_IN_ATE_SIZE) {
+			fs->data_wra += zms_al_size(fs, op->ate_entry.len);
 		}
-		cur_op.ate_entry.cycle_cnt = cur_op.gc.previous_cycle;
-		zms_ate_crc8_update(&cur_op.ate_entry);
-		cur_op.len = sizeof(struct zms_ate);
-		cur_op.addr = fs->ate_wra;
+		op->ate_entry.cycle_cnt = op->gc.previous_cycle;
+		zms_ate_crc8_update(&op->ate_entry);
+		op->len = sizeof(struct zms_ate);
+		op->addr = fs->ate_wra;
 		return zms_flash_ate_wrt(fs);
 	}
 
 gc_done:
 
-	if ((cur_op.gc.step == ZMS_OP_WRITE_GC_DONE) ||
-	    (cur_op.gc.step == ZMS_OP_WRITE_GC_ATE_COPY_DONE)) {
+	if ((op->gc.step == ZMS_OP_WRITE_GC_DONE) ||
+	    (op->gc.step == ZMS_OP_WRITE_GC_ATE_COPY_DONE)) {
 		/* restore the previous sector_cycle */
-		fs->sector_cycle = cur_op.gc.previous_cycle;
+		fs->sector_cycle = op->gc.previous_cycle;
 
 		/* Write a GC_done ATE to mark the end of this operation
 		 */
@@ -1602,33 +2083,36 @@ gc_done:
 		return zms_add_gc_done_ate(fs);
 	}
 
-	if (cur_op.gc.step == ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR) {
-		cur_op.gc.gc_count++;
-		LOG_DBG("GC done, gc_count %u", cur_op.gc.gc_count);
+	if (op->gc.step == ZMS_OP_WRITE_GC_DONE_EMPTY_SECTOR) {
+		op->gc.gc_count++;
+		LOG_DBG("GC done, gc_count %u", op->gc.gc_count);
+#if defined(CONFIG_BM_ZMS_STATS)
+		fs->stats.gc_count++;
+#endif
 		/* Erase the GC'ed sector when needed */
-		rc = zms_flash_erase_sector(fs, cur_op.gc.sec_addr);
+		rc = zms_flash_erase_sector(fs, op->gc.sec_addr);
 
 #ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
-		zms_lookup_cache_invalidate(fs, cur_op.gc.sec_addr >> ADDR_SECT_SHIFT);
+		zms_lookup_cache_invalidate(fs, op->gc.sec_addr >> ADDR_SECT_SHIFT);
 #endif
-		return zms_add_empty_ate(fs, cur_op.gc.sec_addr);
+		return zms_add_empty_ate(fs, op->gc.sec_addr);
 	}
 	return 0;
 }
 
-int bm_zms_clear_execute(void)
+static int bm_zms_clear_execute(struct bm_zms_fs *fs)
 {
 	int rc = 0;
-	struct bm_zms_fs *fs = cur_op.fs;
+	zms_op_t *op = &fs->op_queue->cur_op;
 	uint64_t addr;
 
-	if (cur_op.step == ZMS_OP_CLEAR_START) {
-		cur_op.step = ZMS_OP_CLEAR_EXECUTE;
+	if (op->step == ZMS_OP_CLEAR_START) {
+		op->step = ZMS_OP_CLEAR_EXECUTE;
 	}
 
-	if (cur_op.step == ZMS_OP_CLEAR_EXECUTE) {
-		addr = (uint64_t)cur_op.clear_sector << ADDR_SECT_SHIFT;
-		cur_op.clear_sector++;
+	if (op->step == ZMS_OP_CLEAR_EXECUTE) {
+		addr = (uint64_t)op->clear_sector << ADDR_SECT_SHIFT;
+		op->clear_sector++;
 		rc = zms_flash_erase_sector(fs, addr);
 		if (rc) {
 			return 0;
@@ -1662,18 +2146,18 @@ int bm_zms_clear(struct bm_zms_fs *fs)
 	cur_clear_op.clear_sector = 0U;
 	cur_clear_op.addr = 0U;
 
-	rc = ring_buf_put(&zms_fifo, (uint8_t *)&cur_clear_op, sizeof(zms_op_t));
+	rc = ring_buf_put(&fs->op_queue->fifo, (uint8_t *)&cur_clear_op, sizeof(zms_op_t));
 	irq_unlock(key);
 	if (rc != sizeof(zms_op_t)) {
 		return -ENOMEM;
 	}
 
-	queue_start();
+	queue_start(fs->op_queue);
 
 	return 0;
 }
 
-static int zms_init(void)
+static int zms_init(struct bm_zms_fs *fs)
 {
 	int rc = 0;
 	int ret;
@@ -1686,9 +2170,9 @@ static int zms_init(void)
 	uint32_t i;
 	uint32_t closed_sectors = 0;
 	bool zms_magic_exist = false;
-	struct bm_zms_fs *fs = cur_op.fs;
+	zms_op_t *op = &fs->op_queue->cur_op;
 
-	if (cur_op.step == ZMS_OP_INIT_START) {
+	if (op->step == ZMS_OP_INIT_START) {
 		/* step through the sectors to find a open sector following
 		 * a closed sector, this is where bm_zms can write.
 		 */
@@ -1782,21 +2266,21 @@ static int zms_init(void)
 				}
 				fs->sector_cycle = empty_ate.cycle_cnt;
 			} else {
-				cur_op.step = ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE;
+				op->step = ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE;
 				rc = zms_flash_erase_sector(fs, addr);
 				if (rc) {
 					goto end;
 				}
-				cur_op.init.addr = addr;
+				op->init.addr = addr;
 				return zms_add_empty_ate(fs, addr);
 			}
 		}
-		cur_op.step = ZMS_OP_INIT_RECOVER_LAST_ATE;
-		cur_op.init.addr = addr;
+		op->step = ZMS_OP_INIT_RECOVER_LAST_ATE;
+		op->init.addr = addr;
 	}
 
-	if (cur_op.step == ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE) {
-		rc = zms_get_sector_cycle(fs, cur_op.init.addr, &fs->sector_cycle);
+	if (op->step == ZMS_OP_INIT_ALL_OPEN_ADD_EMPTY_ATE) {
+		rc = zms_get_sector_cycle(fs, op->init.addr, &fs->sector_cycle);
 		if (rc == -ENOENT) {
 			/* sector never used */
 			fs->sector_cycle = 0;
@@ -1804,19 +2288,19 @@ static int zms_init(void)
 			/* bad flash read */
 			goto end;
 		}
-		cur_op.step = ZMS_OP_INIT_RECOVER_LAST_ATE;
+		op->step = ZMS_OP_INIT_RECOVER_LAST_ATE;
 	}
 
-	if (cur_op.step == ZMS_OP_INIT_RECOVER_LAST_ATE) {
+	if (op->step == ZMS_OP_INIT_RECOVER_LAST_ATE) {
 		/* addr contains address of closing ate in the most recent sector,
 		 * search for the last valid ate using the recover_last_ate routine
 		 * and also update the data_wra
 		 */
-		uint64_t ate_wra = cur_op.init.addr, data_wra = cur_op.init.data_wra;
+		uint64_t ate_wra = op->init.addr, data_wra = op->init.data_wra;
 
 		rc = zms_recover_last_ate(fs, &ate_wra, &data_wra);
-		cur_op.init.addr = ate_wra;
-		cur_op.init.data_wra = data_wra;
+		op->init.addr = ate_wra;
+		op->init.data_wra = data_wra;
 		if (rc) {
 			goto end;
 		}
@@ -1824,8 +2308,8 @@ static int zms_init(void)
 		/* addr contains address of the last valid ate in the most recent sector
 		 * data_wra contains the data write address of the current sector
 		 */
-		fs->ate_wra = cur_op.init.addr;
-		fs->data_wra = cur_op.init.data_wra;
+		fs->ate_wra = op->init.addr;
+		fs->data_wra = op->init.data_wra;
 
 		/* fs->ate_wra should point to the next available entry. This is normally
 		 * the next position after the one found by the recovery function.
@@ -1904,7 +2388,7 @@ static int zms_init(void)
 					rc = -EIO;
 					goto end;
 				}
-				cur_op.step = ZMS_OP_INIT_ADD_EMPTY_ATE_GC_DONE;
+				op->step = ZMS_OP_INIT_ADD_EMPTY_ATE_GC_DONE;
 				return zms_add_empty_ate(fs, addr);
 			}
 			LOG_DBG("No GC Done marker found: restarting gc");
@@ -1928,27 +2412,49 @@ static int zms_init(void)
 			if (rc) {
 				goto end;
 			}
-			cur_op.step = ZMS_OP_INIT_ADD_EMPTY_ATE_GC_TODO;
+			op->step = ZMS_OP_INIT_ADD_EMPTY_ATE_GC_TODO;
 			return zms_add_empty_ate(fs, fs->ate_wra);
 		}
-		cur_op.step = ZMS_OP_INIT_ADD_GC_DONE;
+
+		rc = zms_batch_find_interrupted(fs, &op->init.batch_addr);
+		if (rc) {
+			goto end;
+		}
+		op->init.rollback_addr = fs->ate_wra + fs->ate_size;
+		op->step = ZMS_OP_INIT_BATCH_ROLLBACK;
 	}
-	if (cur_op.step == ZMS_OP_INIT_GC_START) {
+	if (op->step == ZMS_OP_INIT_GC_START) {
 		rc = zms_gc_prepare(fs);
 		if (rc) {
 			goto end;
 		}
 		return zms_gc(fs);
 	}
-	if (cur_op.step == ZMS_OP_INIT_GC) {
+	if (op->step == ZMS_OP_INIT_GC) {
 		return zms_gc(fs);
 	}
 
-	if (cur_op.step == ZMS_OP_INIT_ADD_GC_DONE) {
+	if (op->step == ZMS_OP_INIT_BATCH_ROLLBACK) {
+		rc = zms_batch_rollback(fs);
+		if (rc) {
+			goto end;
+		}
+		if (op->init.batch_addr) {
+			/* Wait for the invalidated ATE to be written */
+			return 0;
+		}
+		op->step = ZMS_OP_INIT_ADD_GC_DONE;
+	}
+
+	if (op->step == ZMS_OP_INIT_ADD_GC_DONE) {
 end:
 #ifdef CONFIG_BM_ZMS_LOOKUP_CACHE
 		if (!rc) {
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+			rc = zms_lookup_cache_restore(fs);
+#else
 			rc = zms_lookup_cache_rebuild(fs);
+#endif
 		}
 #endif
 		/* If the sector is empty add a gc done ate to avoid having insufficient
@@ -1957,18 +2463,56 @@ end:
 		if ((!rc) && (SECTOR_OFFSET(fs->ate_wra) == (fs->sector_size - 3 * fs->ate_size))) {
 			return zms_add_gc_done_ate(fs);
 		}
-		cur_op.step = ZMS_OP_INIT_DONE;
+		op->step = ZMS_OP_INIT_DONE;
 	}
 
-	if (cur_op.step == ZMS_OP_INIT_DONE) {
+	if (op->step == ZMS_OP_INIT_DONE) {
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+		zms_cache_snapshot_save(fs);
+#endif
 		fs->init_flags.initialized = true;
 		fs->init_flags.initializing = false;
-		cur_op.op_completed = true;
+		op->op_completed = true;
 		rc = 0;
 	}
 	return rc;
 }
 
+/* Get the operation queue of a file system, assigning a free one on its first mount. */
+static int op_queue_get(struct bm_zms_fs *fs)
+{
+	struct bm_zms_op_queue *free_queue = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(op_queues); i++) {
+		if (op_queues[i].fs == fs) {
+			fs->op_queue = &op_queues[i];
+			return 0;
+		}
+		if (!free_queue && !op_queues[i].fs) {
+			free_queue = &op_queues[i];
+		}
+	}
+
+	if (!free_queue) {
+		return -ENOMEM;
+	}
+
+	ring_buf_init(&free_queue->fifo, sizeof(free_queue->fifo_buf), free_queue->fifo_buf);
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+	int rc = k_mem_slab_init(&free_queue->write_copy_slab, free_queue->write_copy_buf,
+				 ZMS_WRITE_COPY_BLOCK_SIZE, CONFIG_BM_ZMS_WRITE_COPY_BLOCK_COUNT);
+
+	if (rc) {
+		return rc;
+	}
+#endif
+
+	free_queue->fs = fs;
+	fs->op_queue = free_queue;
+
+	return 0;
+}
+
 int bm_zms_mount(struct bm_zms_fs *fs, const struct bm_zms_fs_config *config)
 {
 	int ret;
@@ -1981,10 +2525,25 @@ int bm_zms_mount(struct bm_zms_fs *fs, const struct bm_zms_fs_config *config)
 		return -EFAULT;
 	}
 
-	fs->offset = config->offset;
-	fs->sector_size = config->sector_size;
+	key = irq_lock();
+	ret = op_queue_get(fs);
+	irq_unlock(key);
+	if (ret == -ENOMEM) {
+		LOG_ERR("No free operation queue, increase CONFIG_BM_ZMS_MAX_FS");
+		return -ENOMEM;
+	}
+	if (ret) {
+		LOG_ERR("Failed to initialize the write copy blocks, ret %d", ret);
+		return ret;
+	}
+
+	fs->offset = config->offset;
+	fs->sector_size = config->sector_size;
 	fs->sector_count = config->sector_count;
 	fs->evt_handler = config->evt_handler;
+#if defined(CONFIG_BM_ZMS_STATS)
+	memset(&fs->stats, 0, sizeof(fs->stats));
+#endif
 
 	/* Initialize BM Storage */
 
@@ -2056,13 +2615,13 @@ int bm_zms_mount(struct bm_zms_fs *fs, const struct bm_zms_fs_config *config)
 	cur_init_op.op_code = ZMS_OP_INIT;
 	cur_init_op.step = ZMS_OP_INIT_START;
 
-	rc = ring_buf_put(&zms_fifo, (uint8_t *)&cur_init_op, sizeof(zms_op_t));
+	rc = ring_buf_put(&fs->op_queue->fifo, (uint8_t *)&cur_init_op, sizeof(zms_op_t));
 	irq_unlock(key);
 	if (rc != sizeof(zms_op_t)) {
 		return -ENOMEM;
 	}
 
-	queue_start();
+	queue_start(fs->op_queue);
 
 	return 0;
 }
@@ -2077,7 +2636,9 @@ static void zms_verify_space(zms_op_t *op)
 	 * So the first position of a sector (fs->ate_wra = 0x0) is forbidden for ATEs
 	 * and the second position could be written only be a delete ATE.
 	 */
-	if ((SECTOR_OFFSET(fs->ate_wra)) && (fs->ate_wra >= (fs->data_wra + op->required_space)) &&
+	/* A background GC always closes the open sector. */
+	if ((op->op_code == ZMS_OP_WRITE) && (SECTOR_OFFSET(fs->ate_wra)) &&
+	    (fs->ate_wra >= (fs->data_wra + op->required_space)) &&
 	    (SECTOR_OFFSET(fs->ate_wra - fs->ate_size) || !op->data_len)) {
 		op->step = ZMS_OP_WRITE_EXECUTE;
 		if (op->data_len > ZMS_DATA_IN_ATE_SIZE) {
@@ -2085,6 +2646,12 @@ static void zms_verify_space(zms_op_t *op)
 		} else {
 			op->sub_step = ZMS_OP_WRITE_SUB_STEP_ATE1;
 		}
+		if (op->batch.entries) {
+			/* The whole batch fits in the sector, start it with the begin ATE */
+			op->step = ZMS_OP_WRITE_BATCH_BEGIN;
+			op->sub_step = ZMS_OP_WRITE_SUB_STEP_NONE;
+			op->batch.ate_wra = fs->ate_wra;
+		}
 		op->gc.gc_count = 0;
 	} else {
 		if (SECTOR_OFFSET(fs->ate_wra) && (fs->ate_wra > fs->data_wra)) {
@@ -2136,6 +2703,18 @@ ssize_t bm_zms_write(struct bm_zms_fs *fs, uint32_t id, const void *data, size_t
 		}
 	}
 
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+	if ((len > 0) && (len <= CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE)) {
+		void *block;
+
+		if (k_mem_slab_alloc(&fs->op_queue->write_copy_slab, &block, K_NO_WAIT)) {
+			return -ENOMEM;
+		}
+		memcpy(block, data, len);
+		data = block;
+	}
+#endif
+
 	key = irq_lock();
 	memset(&cur_write_op, 0, sizeof(cur_write_op));
 	cur_write_op.fs = fs;
@@ -2148,34 +2727,102 @@ ssize_t bm_zms_write(struct bm_zms_fs *fs, uint32_t id, const void *data, size_t
 	cur_write_op.id = id;
 	cur_write_op.required_space = required_space;
 
-	rc = ring_buf_put(&zms_fifo, (uint8_t *)&cur_write_op, sizeof(zms_op_t));
+	rc = ring_buf_put(&fs->op_queue->fifo, (uint8_t *)&cur_write_op, sizeof(zms_op_t));
 	irq_unlock(key);
 	if (rc != sizeof(zms_op_t)) {
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+		zms_write_copy_free(fs->op_queue, &cur_write_op);
+#endif
 		return -ENOMEM;
 	}
 
 	atomic_add(&fs->ongoing_writes, 1);
-	queue_start();
+	queue_start(fs->op_queue);
 
 	return len;
 }
 
-static int zms_write_execute(void)
+int bm_zms_write_batch(struct bm_zms_fs *fs, const struct bm_zms_batch_entry *entries,
+		       size_t count)
+{
+	/* Space for the begin and commit ATEs, and for the ATE of each entry */
+	uint32_t required_space;
+	zms_op_t cur_write_op;
+	uint32_t rc;
+	unsigned int key;
+
+	if (!fs || !entries) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("zms not initialized");
+		return -EACCES;
+	}
+
+	if (!count) {
+		return -EINVAL;
+	}
+
+	required_space = (count + 2) * fs->ate_size;
+
+	for (size_t i = 0; i < count; i++) {
+		if ((entries[i].len > UINT16_MAX) ||
+		    ((entries[i].len > 0) && (entries[i].data == NULL))) {
+			return -EINVAL;
+		}
+		if (entries[i].len > ZMS_DATA_IN_ATE_SIZE) {
+			required_space += zms_al_size(fs, entries[i].len);
+		}
+	}
+
+	/* The batch is written in a single sector, next to the close, empty and gc_done ATEs,
+	 * and it must leave the ATE reserved for deletion free.
+	 */
+	if (required_space > (fs->sector_size - 4 * fs->ate_size)) {
+		return -EINVAL;
+	}
+
+	LOG_DBG("%s %zu entries, %u bytes, ate_wra 0x%llx, data_wra 0x%llx", __func__, count,
+		required_space, fs->ate_wra, fs->data_wra);
+
+	key = irq_lock();
+	memset(&cur_write_op, 0, sizeof(cur_write_op));
+	cur_write_op.fs = fs;
+	cur_write_op.op_code = ZMS_OP_WRITE;
+	cur_write_op.step = ZMS_OP_WRITE_STARTUP;
+	cur_write_op.required_space = required_space;
+	cur_write_op.batch.entries = entries;
+	cur_write_op.batch.count = count;
+
+	rc = ring_buf_put(&fs->op_queue->fifo, (uint8_t *)&cur_write_op, sizeof(zms_op_t));
+	irq_unlock(key);
+	if (rc != sizeof(zms_op_t)) {
+		return -ENOMEM;
+	}
+
+	atomic_add(&fs->ongoing_writes, 1);
+	queue_start(fs->op_queue);
+
+	return 0;
+}
+
+static int zms_write_execute(struct bm_zms_fs *fs)
 {
 	int rc = 0;
-	struct bm_zms_fs *fs = cur_op.fs;
+	zms_op_t *op = &fs->op_queue->cur_op;
 
-	if (cur_op.gc.gc_count == (fs->sector_count - 1)) {
+	if ((op->op_code == ZMS_OP_WRITE) && (op->gc.gc_count == (fs->sector_count - 1))) {
 		/* gc'ed all sectors, no extra space will be created
 		 * by extra gc.
 		 */
 		rc = -ENOSPC;
-		LOG_ERR("No space in flash, gc_count %u, sector_count %u", cur_op.gc.gc_count,
+		LOG_ERR("No space in flash, gc_count %u, sector_count %u", op->gc.gc_count,
 			fs->sector_count);
 		goto end;
 	}
 
-	switch (cur_op.step) {
+	switch (op->step) {
 	case ZMS_OP_WRITE_EXECUTE:
 		return zms_flash_write_entry(fs);
 	case ZMS_OP_WRITE_CLOSE_SECTOR_GARBAGE:
@@ -2186,18 +2833,40 @@ static int zms_write_execute(void)
 		if (rc) {
 			goto end;
 		}
-		cur_op.step = ZMS_OP_WRITE_GC;
+		op->step = ZMS_OP_WRITE_GC;
 		return zms_gc(fs);
 	case ZMS_OP_WRITE_GC:
 		return zms_gc(fs);
+	case ZMS_OP_WRITE_BATCH_BEGIN:
+		return zms_batch_marker_write(fs, ZMS_BATCH_BEGIN_LEN);
+	case ZMS_OP_WRITE_BATCH_BEGIN_DONE:
+		return zms_batch_entry_write(fs);
 	case ZMS_OP_WRITE_DONE:
-		if (cur_op.data_len > ZMS_DATA_IN_ATE_SIZE) {
-			fs->data_wra += zms_al_size(fs, cur_op.data_len);
+		if (op->data_len > ZMS_DATA_IN_ATE_SIZE) {
+			fs->data_wra += zms_al_size(fs, op->data_len);
 		}
-		cur_op.op_completed = true;
+		if (op->batch.entries) {
+			op->batch.idx++;
+			if (op->batch.idx < op->batch.count) {
+				return zms_batch_entry_write(fs);
+			}
+			op->step = ZMS_OP_WRITE_BATCH_COMMIT;
+			return zms_batch_marker_write(fs, ZMS_BATCH_COMMIT_LEN);
+		}
+		op->op_completed = true;
+		return 0;
+	case ZMS_OP_WRITE_BATCH_COMMIT_DONE:
+		zms_batch_commit(fs);
+		op->op_completed = true;
+		return 0;
+	case ZMS_OP_GC_DONE:
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+		fs->op_queue->gc_ate_wra = fs->ate_wra;
+#endif
+		op->op_completed = true;
 		return 0;
 	default:
-		LOG_ERR("Unknown step %d", cur_op.step);
+		LOG_ERR("Unknown step %d", op->step);
 		rc = -EIO;
 		goto end;
 	}
@@ -2211,7 +2880,9 @@ int bm_zms_delete(struct bm_zms_fs *fs, uint32_t id)
 	return bm_zms_write(fs, id, NULL, 0);
 }
 
-ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t len, uint32_t cnt)
+/* Find the ATE of a history entry of an ID and its address. */
+static int zms_find_hist_ate(struct bm_zms_fs *fs, uint32_t id, uint32_t cnt,
+			     struct zms_ate *ate, uint64_t *ate_addr)
 {
 	int rc;
 	int prev_found = 0;
@@ -2221,18 +2892,6 @@ ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t l
 	uint64_t end_search_addr = 0;
 	uint32_t cnt_his;
 	struct zms_ate wlk_ate;
-#ifdef CONFIG_BM_ZMS_DATA_CRC
-	uint32_t computed_data_crc;
-#endif
-
-	if (!fs) {
-		return -EFAULT;
-	}
-
-	if (!fs->init_flags.initialized) {
-		LOG_ERR("zms not initialized");
-		return -EACCES;
-	}
 
 	cnt_his = 0U;
 
@@ -2240,8 +2899,7 @@ ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t l
 	wlk_addr = fs->lookup_cache[zms_lookup_cache_pos(id)];
 
 	if (wlk_addr == ZMS_LOOKUP_CACHE_NO_ADDR) {
-		rc = -ENOENT;
-		goto err;
+		return -ENOENT;
 	}
 #else
 	wlk_addr = fs->ate_wra;
@@ -2260,8 +2918,7 @@ ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t l
 		prev_found = zms_find_ate_with_id(fs, id, wlk_addr, end_search_addr, &wlk_ate,
 						  &wlk_prev_addr);
 		if (prev_found < 0) {
-			rc = prev_found;
-			goto err;
+			return prev_found;
 		}
 		if (prev_found) {
 			cnt_his++;
@@ -2273,7 +2930,7 @@ ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t l
 			 */
 			rc = zms_compute_prev_addr(fs, &wlk_prev_addr);
 			if (rc) {
-				goto err;
+				return rc;
 			}
 			/* wlk_addr will be the start research address in the next loop */
 			wlk_addr = wlk_prev_addr;
@@ -2283,7 +2940,35 @@ ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t l
 	}
 
 	if (((!prev_found) || (wlk_ate.id != id)) || (wlk_ate.len == 0U) || (cnt_his < cnt)) {
-		rc = -ENOENT;
+		return -ENOENT;
+	}
+
+	*ate = wlk_ate;
+	*ate_addr = rd_addr;
+
+	return 0;
+}
+
+ssize_t bm_zms_read_hist(struct bm_zms_fs *fs, uint32_t id, void *data, size_t len, uint32_t cnt)
+{
+	int rc;
+	uint64_t rd_addr;
+	struct zms_ate wlk_ate;
+#ifdef CONFIG_BM_ZMS_DATA_CRC
+	uint32_t computed_data_crc;
+#endif
+
+	if (!fs) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("zms not initialized");
+		return -EACCES;
+	}
+
+	rc = zms_find_hist_ate(fs, id, cnt, &wlk_ate, &rd_addr);
+	if (rc) {
 		goto err;
 	}
 
@@ -2323,6 +3008,239 @@ err:
 	return rc;
 }
 
+#if defined(CONFIG_BM_ZMS_NO_DOUBLE_WRITE)
+/* Whether a write would store the value that its ID already has. */
+static bool zms_write_is_unchanged(zms_op_t *op)
+{
+	struct bm_zms_fs *fs = op->fs;
+	struct zms_ate ate;
+	uint64_t ate_addr;
+	int rc;
+
+	if ((op->op_code != ZMS_OP_WRITE) || op->batch.entries) {
+		return false;
+	}
+
+	rc = zms_find_hist_ate(fs, op->id, 0, &ate, &ate_addr);
+	if (rc == -ENOENT) {
+		/* Deleting an ID that is not stored does not change anything. */
+		return (op->data_len == 0);
+	} else if (rc) {
+		return false;
+	}
+
+	if (ate.len != op->data_len) {
+		return false;
+	}
+
+	if (ate.len <= ZMS_DATA_IN_ATE_SIZE) {
+		return (memcmp(ate.data, op->data, ate.len) == 0);
+	}
+
+#ifdef CONFIG_BM_ZMS_DATA_CRC
+	/* A changed value is detected without reading the stored data. */
+	if (crc32_ieee(op->data, ate.len) != ate.data_crc) {
+		return false;
+	}
+#endif
+
+	return (zms_flash_block_cmp(fs, (ate_addr & ADDR_SECT_MASK) + ate.offset, op->data,
+				    ate.len) == 0);
+}
+#endif
+
+int bm_zms_read_ref(struct bm_zms_fs *fs, uint32_t id, struct bm_zms_ref *ref)
+{
+	int rc;
+	uint64_t ate_addr;
+	uint64_t rd_addr;
+	uint32_t generation;
+	struct zms_ate wlk_ate;
+#ifdef CONFIG_BM_ZMS_DATA_CRC
+	uint32_t computed_data_crc;
+#endif
+
+	if (!fs || !ref) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("zms not initialized");
+		return -EACCES;
+	}
+
+	if (!fs->nvm_info->is_memory_mapped) {
+		return -ENOTSUP;
+	}
+
+	/* Sample the generation before the lookup, so that a concurrent erase is detected. */
+	generation = atomic_get(&fs->generation);
+
+	rc = zms_find_hist_ate(fs, id, 0, &wlk_ate, &ate_addr);
+	if (rc) {
+		return rc;
+	}
+
+	if (wlk_ate.len <= ZMS_DATA_IN_ATE_SIZE) {
+		/* data is stored in the ATE */
+		rd_addr = ate_addr + offsetof(struct zms_ate, data);
+	} else {
+		rd_addr = (ate_addr & ADDR_SECT_MASK) + wlk_ate.offset;
+	}
+
+	ref->data = (const void *)(uintptr_t)(fs->zms_bm_storage.addr +
+					      zms_addr_to_offset(fs, rd_addr));
+	ref->len = wlk_ate.len;
+	ref->generation = generation;
+
+#ifdef CONFIG_BM_ZMS_DATA_CRC
+	if (wlk_ate.len > ZMS_DATA_IN_ATE_SIZE) {
+		computed_data_crc = crc32_ieee(ref->data, wlk_ate.len);
+		if (computed_data_crc != wlk_ate.data_crc) {
+			LOG_ERR("Invalid data CRC, ATE_CRC: 0x%08X, "
+				"computed_data_crc: 0x%08X",
+				wlk_ate.data_crc, computed_data_crc);
+			return -EIO;
+		}
+	}
+#endif
+
+	return 0;
+}
+
+bool bm_zms_ref_valid(struct bm_zms_fs *fs, const struct bm_zms_ref *ref)
+{
+	if (!fs || !ref) {
+		return false;
+	}
+
+	return atomic_get(&fs->generation) == (atomic_val_t)ref->generation;
+}
+
+int bm_zms_iter_init(struct bm_zms_fs *fs, struct bm_zms_iter *iter, uint32_t id_mask,
+		     uint32_t id_prefix)
+{
+	if (!fs || !iter) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("zms not initialized");
+		return -EACCES;
+	}
+
+	iter->id_mask = id_mask;
+	iter->id_prefix = id_prefix & id_mask;
+	iter->addr = fs->ate_wra;
+	if (SECTOR_OFFSET(iter->addr) >= (fs->sector_size - 2 * fs->ate_size)) {
+		/* we are maybe in the middle of a GC */
+		iter->addr = fs->ate_ra;
+	}
+	iter->end_addr = iter->addr;
+	iter->generation = atomic_get(&fs->generation);
+	iter->sector_num = ZMS_INVALID_SECTOR_NUM;
+	iter->done = false;
+#if CONFIG_BM_ZMS_ITER_SEEN_IDS > 0
+	iter->seen_ids_full = false;
+	iter->seen_id_count = 0;
+#endif
+
+	return 0;
+}
+
+/* Find out whether the entry of an ID at ate_addr is the latest one and is not deleted.
+ * The entries are walked from the most recent, so the first entry found for an ID is its latest
+ * one. The iterator remembers the IDs it has found, and looks up the ID in the file system only
+ * when it could not remember all of them.
+ */
+static int zms_iter_latest_check(struct bm_zms_fs *fs, struct bm_zms_iter *iter,
+				 const struct zms_ate *ate, uint64_t ate_addr)
+{
+	int rc;
+	uint64_t latest_addr;
+	struct zms_ate latest_ate;
+
+#if CONFIG_BM_ZMS_ITER_SEEN_IDS > 0
+	for (uint32_t i = 0; i < iter->seen_id_count; i++) {
+		if (iter->seen_ids[i] == ate->id) {
+			return -ENOENT;
+		}
+	}
+
+	if (!iter->seen_ids_full) {
+		if (iter->seen_id_count < ARRAY_SIZE(iter->seen_ids)) {
+			iter->seen_ids[iter->seen_id_count++] = ate->id;
+		} else {
+			/* The IDs found from now on might have been found before. */
+			iter->seen_ids_full = true;
+		}
+
+		return (ate->len == 0U) ? -ENOENT : 0;
+	}
+#endif
+
+	rc = zms_find_hist_ate(fs, ate->id, 0, &latest_ate, &latest_addr);
+	if (rc) {
+		return rc;
+	}
+
+	return (latest_addr == ate_addr) ? 0 : -ENOENT;
+}
+
+int bm_zms_iter_next(struct bm_zms_fs *fs, struct bm_zms_iter *iter, uint32_t *id)
+{
+	int rc;
+	uint64_t ate_addr;
+	struct zms_ate ate;
+
+	if (!fs || !iter || !id) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("zms not initialized");
+		return -EACCES;
+	}
+
+	while (!iter->done) {
+		if (atomic_get(&fs->generation) != (atomic_val_t)iter->generation) {
+			return -EAGAIN;
+		}
+
+		ate_addr = iter->addr;
+		rc = zms_prev_ate(fs, &iter->addr, &ate);
+		if (rc) {
+			return rc;
+		}
+		iter->done = (iter->addr == iter->end_addr);
+
+		rc = zms_get_cycle_on_sector_change(fs, ate_addr, iter->sector_num,
+						    &iter->sector_cycle);
+		if (rc) {
+			return rc;
+		}
+		iter->sector_num = SECTOR_NUM(ate_addr);
+
+		if (!zms_ate_valid_different_sector(fs, &ate, iter->sector_cycle) ||
+		    (ate.id == ZMS_HEAD_ID) || ((ate.id & iter->id_mask) != iter->id_prefix)) {
+			continue;
+		}
+
+		/* Only the latest entry of an ID is returned, and only if it is not deleted. */
+		rc = zms_iter_latest_check(fs, iter, &ate, ate_addr);
+		if (rc == -ENOENT) {
+			continue;
+		} else if (rc) {
+			return rc;
+		}
+
+		*id = ate.id;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
 ssize_t bm_zms_read(struct bm_zms_fs *fs, uint32_t id, void *data, size_t len)
 {
 	int rc;
@@ -2477,3 +3395,81 @@ ssize_t bm_zms_active_sector_free_space(struct bm_zms_fs *fs)
 
 	return fs->ate_wra - fs->data_wra - fs->ate_size;
 }
+
+#if defined(CONFIG_BM_ZMS_STATS)
+int bm_zms_stats_get(struct bm_zms_fs *fs, struct bm_zms_stats *stats)
+{
+	unsigned int key;
+
+	if (!fs || !stats) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("zms not initialized");
+		return -EACCES;
+	}
+
+	key = irq_lock();
+	*stats = fs->stats;
+	irq_unlock(key);
+
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+int bm_zms_gc_step(struct bm_zms_fs *fs)
+{
+	struct bm_zms_op_queue *queue;
+	zms_op_t gc_op;
+	uint32_t rc;
+	unsigned int key;
+
+	if (!fs) {
+		return -EFAULT;
+	}
+
+	if (!fs->init_flags.initialized) {
+		LOG_ERR("ZMS not initialized");
+		return -EACCES;
+	}
+
+	queue = fs->op_queue;
+
+	if (atomic_cas(&queue->gc_paused, true, false)) {
+		queue->gc_budget = CONFIG_BM_ZMS_GC_STEP_ATES;
+		atomic_set(&queue->queue_process_start, true);
+		queue_process(queue);
+		return 0;
+	}
+
+	if (atomic_get(&queue->queued_op_cnt)) {
+		/* Do not delay the queued operations. */
+		return -EBUSY;
+	}
+
+	if (!zms_gc_needed(fs)) {
+		return -EALREADY;
+	}
+
+	LOG_DBG("%s ate_wra 0x%llx, data_wra 0x%llx", __func__, fs->ate_wra, fs->data_wra);
+
+	key = irq_lock();
+	memset(&gc_op, 0, sizeof(gc_op));
+	gc_op.fs = fs;
+	gc_op.op_code = ZMS_OP_GC;
+	gc_op.step = ZMS_OP_WRITE_STARTUP;
+
+	rc = ring_buf_put(&queue->fifo, (uint8_t *)&gc_op, sizeof(zms_op_t));
+	irq_unlock(key);
+	if (rc != sizeof(zms_op_t)) {
+		return -ENOMEM;
+	}
+
+	queue->gc_budget = CONFIG_BM_ZMS_GC_STEP_ATES;
+	queue_start(queue);
+
+	return 0;
+}
+#endif
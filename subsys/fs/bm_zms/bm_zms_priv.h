@@ -10,6 +10,12 @@
 #ifndef __BM_ZMS_PRIV_H_
 #define __BM_ZMS_PRIV_H_
 
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/ring_buffer.h>
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+#include <zephyr/kernel.h>
+#endif
+
 /*
  * MASKS AND SHIFT FOR ADDRESSES.
  * An address in bm_zms is an uint64_t where:
@@ -42,6 +48,13 @@
 #define ZMS_INVALID_SECTOR_NUM	 -1
 #define ZMS_DATA_IN_ATE_SIZE	 8
 
+/* Lengths of the ZMS_HEAD_ID ATEs that enclose the entries of a batch write.
+ * They differ from the lengths of the empty ATE (0xffff) and of the close and gc_done
+ * ATEs (0).
+ */
+#define ZMS_BATCH_BEGIN_LEN	 1
+#define ZMS_BATCH_COMMIT_LEN	 2
+
 /**
  * @ingroup zms_data_structures
  * BM_ZMS Allocation Table Entry (ATE) structure
@@ -84,6 +97,7 @@ typedef enum {
 	ZMS_OP_INIT,  /* Initialize the module. */
 	ZMS_OP_WRITE, /* Write a record to flash. */
 	ZMS_OP_CLEAR, /* Clear all sectors. */
+	ZMS_OP_GC,    /* Close the open sector and collect garbage ahead of time. */
 } zms_op_code_t;
 
 typedef enum {
@@ -95,6 +109,7 @@ typedef enum {
 	ZMS_OP_INIT_ADD_GC_DONE,
 	ZMS_OP_INIT_GC_START,
 	ZMS_OP_INIT_GC,
+	ZMS_OP_INIT_BATCH_ROLLBACK,
 	ZMS_OP_INIT_DONE,
 	ZMS_OP_WRITE_STARTUP,
 	ZMS_OP_WRITE_EXECUTE,
@@ -104,6 +119,11 @@ typedef enum {
 	ZMS_OP_WRITE_ERASE_SECTOR,
 	ZMS_OP_WRITE_GC,
 	ZMS_OP_WRITE_DONE,
+	ZMS_OP_WRITE_BATCH_BEGIN,
+	ZMS_OP_WRITE_BATCH_BEGIN_DONE,
+	ZMS_OP_WRITE_BATCH_COMMIT,
+	ZMS_OP_WRITE_BATCH_COMMIT_DONE,
+	ZMS_OP_GC_DONE,
 	ZMS_OP_CLEAR_START,
 	ZMS_OP_CLEAR_EXECUTE,
 	ZMS_OP_CLEAR_DONE,
@@ -142,11 +162,20 @@ typedef struct {
 } gc_context_t;
 
 typedef struct {
-	uint64_t addr;	       /* Allocation Table Entry (ATE) write address. */
-	uint64_t data_wra;     /* Data write address. */
-	uint32_t sector_cycle; /* Sector cycle count. */
+	uint64_t addr;		 /* Allocation Table Entry (ATE) write address. */
+	uint64_t data_wra;	 /* Data write address. */
+	uint32_t sector_cycle;	 /* Sector cycle count. */
+	uint64_t batch_addr;	 /* Begin ATE of an interrupted batch, 0 if none. */
+	uint64_t rollback_addr; /* Next ATE to invalidate when rolling back a batch. */
 } init_context_t;
 
+typedef struct {
+	const struct bm_zms_batch_entry *entries; /* Entries to write, NULL if not a batch. */
+	uint64_t ate_wra;			  /* ATE write address within the batch. */
+	uint32_t count;				  /* Number of entries. */
+	uint32_t idx;				  /* Index of the entry being written. */
+} batch_context_t;
+
 typedef struct __aligned(4) {
 	__aligned(4) struct zms_ate ate_entry; /* ATE entry to write */
 	__aligned(4) const void *data;	       /* Pointer to the data to write. */
@@ -162,8 +191,57 @@ typedef struct __aligned(4) {
 	struct bm_zms_fs *fs;		       /* Pointer to the file system. */
 	gc_context_t gc;		       /* Garbage collection context */
 	init_context_t init;		       /* Initialization context */
+	batch_context_t batch;		       /* Batch write context */
 	uint32_t clear_sector;		       /* Sector to clear */
 	bool op_completed;	       /* The current operation completed. */
 } zms_op_t;
 
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT)
+#define ZMS_CACHE_SNAPSHOT_MAGIC 0x434d5a42 /* "BZMC" */
+
+/* Copy of the lookup cache of a file system, kept across warm resets. */
+struct zms_cache_snapshot {
+	uint32_t magic;		/* ZMS_CACHE_SNAPSHOT_MAGIC if the snapshot is valid. */
+	uint32_t crc;		/* CRC32 of the fields below. */
+	uint64_t ate_wra;	/* ATE write address when the snapshot was taken. */
+	uint64_t offset;	/* Layout of the file system. */
+	uint32_t sector_size;
+	uint32_t sector_count;
+	uint32_t sector_cycle;	/* Cycle counter of the open sector. */
+	uint64_t lookup_cache[CONFIG_BM_ZMS_LOOKUP_CACHE_SIZE];
+};
+#endif
+
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+/* k_mem_slab requires the block size to be a multiple of the pointer size. */
+#define ZMS_WRITE_COPY_BLOCK_SIZE ROUND_UP(CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE, sizeof(void *))
+#endif
+
+/* Operation queue and state machine of a mounted file system. */
+struct bm_zms_op_queue {
+	struct bm_zms_fs *fs;	       /* File system owning the queue, NULL if free. */
+	zms_op_t cur_op;	       /* Current bm_zms operation. */
+	zms_op_t *p_cur_op;	       /* Set while an operation is being executed. */
+	atomic_t cur_op_result;	       /* Result of the last storage operation. */
+	atomic_t queue_process_start;  /* Set when the queue must be processed. */
+	/* The number of queued operations.
+	 * Incremented by queue_start() and decremented by queue_has_next().
+	 */
+	atomic_t queued_op_cnt;
+	struct ring_buf fifo;	       /* Queue of bm_zms operations. */
+	uint8_t fifo_buf[CONFIG_BM_ZMS_OP_QUEUE_SIZE * sizeof(zms_op_t)];
+	__aligned(4) uint8_t buf_gc[ZMS_BLOCK_SIZE]; /* Buffer for garbage collection moves. */
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+	struct k_mem_slab write_copy_slab; /* Blocks holding the data of queued writes. */
+	__aligned(sizeof(void *)) uint8_t write_copy_buf[CONFIG_BM_ZMS_WRITE_COPY_BLOCK_COUNT *
+							 ZMS_WRITE_COPY_BLOCK_SIZE];
+#endif
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+	uint32_t gc_budget;	       /* ATEs a background GC can still examine in this step. */
+	atomic_t gc_paused;	       /* Set while a background GC waits for its next step. */
+	atomic_t gc_scheduled;	       /* Set while a GC step is pending in bm_scheduler. */
+	uint64_t gc_ate_wra;	       /* ATE write address after the last background GC. */
+#endif
+};
+
 #endif /* __BM_ZMS_PRIV_H_ */
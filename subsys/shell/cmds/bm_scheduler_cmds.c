@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2026 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <bm/bm_scheduler.h>
+#include <zephyr/shell/shell.h>
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	struct bm_scheduler_stats stats;
+	struct bm_scheduler_handler_stats hs;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	(void)bm_scheduler_stats_get(&stats);
+
+	shell_print(sh, "Queue depth: %u, peak %u", stats.queue_depth, stats.queue_depth_peak);
+	shell_print(sh, "Heap peak: %zu of %u bytes", stats.heap_peak,
+		    CONFIG_BM_SCHEDULER_BUF_SIZE);
+	shell_print(sh, "Dispatched: %u, latency avg %u max %u cycles", stats.dispatched,
+		    stats.latency_avg, stats.latency_max);
+	if (stats.untracked) {
+		shell_print(sh, "Untracked: %u", stats.untracked);
+	}
+
+	shell_print(sh, "Handler     Count      Max        Histogram (<4^(i+1) cycles)");
+	for (size_t i = 0; bm_scheduler_handler_stats_get(i, &hs) == 0; i++) {
+		shell_print(sh, "%-10p  %-9u  %-9u  %u %u %u %u %u %u %u %u", (void *)hs.handler,
+			    hs.count, hs.exec_max, hs.hist[0], hs.hist[1], hs.hist[2], hs.hist[3],
+			    hs.hist[4], hs.hist[5], hs.hist[6], hs.hist[7]);
+	}
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	bm_scheduler_stats_reset();
+	shell_print(sh, "Statistics reset");
+
+	return 0;
+}
+
+BUILD_ASSERT(BM_SCHEDULER_STATS_HIST_BUCKETS == 8, "Update the histogram print format");
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_bm_scheduler,
+	SHELL_CMD(stats, NULL, "Print event scheduler statistics", cmd_stats),
+	SHELL_CMD(reset, NULL, "Reset event scheduler statistics", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(bm_scheduler, &sub_bm_scheduler, "Event scheduler commands", NULL);
@@ -373,11 +373,16 @@ static void sdh_events_poll(void *data, size_t len)
 	nrf_sdh_evts_poll();
 }
 
+/* A single poll drains all pending SoftDevice events, so there is no need to schedule
+ * more than one poll at a time. Dispatch ahead of other deferred application work.
+ */
+static BM_SCHEDULER_COALESCE_DEFINE(sdh_poll_evt, sdh_events_poll, BM_SCHEDULER_PRIO_HIGHEST);
+
 void SD_EVT_IRQHandler(void)
 {
 	int err;
 
-	err = bm_scheduler_defer(sdh_events_poll, NULL, 0);
+	err = bm_scheduler_defer_coalesce(&sdh_poll_evt);
 	if (err) {
 		LOG_WRN("Unable to schedule SoftDevice event, err %d", err);
 	}
@@ -356,6 +356,30 @@ static void idx_unassign(uint16_t conn_handle)
 	__ASSERT(false, "Could not find any idx assigned to conn_handle %#x", conn_handle);
 }
 
+/* Forward an event to the BLE observers registered for its event group. */
+#define EVT_GROUP_DISPATCH(_group, _ble_evt)                                                       \
+	TYPE_SECTION_FOREACH(struct nrf_sdh_ble_evt_observer,                                      \
+			     nrf_sdh_ble_evt_observers_##_group, obs) {                            \
+		obs->handler(_ble_evt, obs->context);                                              \
+	}
+
+static void evt_dispatch(const ble_evt_t *ble_evt)
+{
+	const uint16_t evt_id = ble_evt->header.evt_id;
+
+	if (IN_RANGE(evt_id, BLE_GAP_EVT_BASE, BLE_GAP_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(GAP, ble_evt);
+	} else if (IN_RANGE(evt_id, BLE_GATTS_EVT_BASE, BLE_GATTS_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(GATTS, ble_evt);
+	} else if (IN_RANGE(evt_id, BLE_GATTC_EVT_BASE, BLE_GATTC_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(GATTC, ble_evt);
+	} else if (IN_RANGE(evt_id, BLE_EVT_BASE, BLE_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(COMMON, ble_evt);
+	} else {
+		LOG_WRN("Unknown BLE event %#x", evt_id);
+	}
+}
+
 static void ble_evt_poll(void *context)
 {
 	int err;
@@ -377,11 +401,7 @@ static void ble_evt_poll(void *context)
 			idx_assign(ble_evt->evt.gap_evt.conn_handle);
 		}
 
-		/* Forward the event to BLE observers. */
-		TYPE_SECTION_FOREACH(
-			struct nrf_sdh_ble_evt_observer, nrf_sdh_ble_evt_observers, obs) {
-			obs->handler(ble_evt, obs->context);
-		}
+		evt_dispatch(ble_evt);
 
 		if (ble_evt->header.evt_id == BLE_GAP_EVT_DISCONNECTED) {
 			idx_unassign(ble_evt->evt.gap_evt.conn_handle);
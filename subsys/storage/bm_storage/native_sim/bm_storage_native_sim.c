@@ -19,6 +19,7 @@ static const struct bm_storage_info bm_storage_info = {
 	.wear_unit = 16,
 	.erase_value = 0xFF,
 	.is_erase_before_write = false,
+	.is_memory_mapped = true,
 };
 
 static void event_send(const struct bm_storage *storage, struct bm_storage_evt *evt)
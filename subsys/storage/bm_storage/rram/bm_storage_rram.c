@@ -24,6 +24,7 @@ static const struct bm_storage_info bm_storage_info = {
 	.wear_unit = RRAMC_WRITE_BLOCK_SIZE,
 	.erase_value = 0xFF,
 	.is_erase_before_write = false,
+	.is_memory_mapped = true,
 };
 
 struct bm_storage_rram_state {
@@ -95,6 +95,7 @@ static const struct bm_storage_info bm_storage_info = {
 	.wear_unit = SD_WRITE_BLOCK_SIZE,
 	.erase_value = 0xFF,
 	.is_erase_before_write = false,
+	.is_memory_mapped = true,
 };
 
 static void bm_storage_sd_on_soc_evt(uint32_t evt, void *ctx);
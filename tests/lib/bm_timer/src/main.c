@@ -16,14 +16,30 @@
 /* Timer duration that is comfortably above BM_TIMER_MIN_TIMEOUT_TICKS but short enough
  * to keep the tests fast. ~50 ms is plenty for both single shot and repeated tests.
  */
-#define TEST_TIMER_MS         50U
-#define TEST_TIMER_TICKS      BM_TIMER_MS_TO_TICKS(TEST_TIMER_MS)
+#define TEST_TIMER_MS            50U
+#define TEST_TIMER_TICKS         BM_TIMER_MS_TO_TICKS(TEST_TIMER_MS)
 
 /* Slack to allow the timer to fire before the test thread checks the result. */
-#define TEST_TIMER_WAIT_MS    (TEST_TIMER_MS + 50U)
+#define TEST_TIMER_WAIT_MS       (TEST_TIMER_MS + 50U)
+
+/* Slack of the lazy timers, it must fit in the wait above. */
+#define TEST_TIMER_SLACK_MS      30U
+#define TEST_TIMER_SLACK_TICKS   BM_TIMER_MS_TO_TICKS(TEST_TIMER_SLACK_MS)
+
+/* Interrupt latency tolerated on top of the slack. */
+#define TEST_TIMER_LATENCY_TICKS 2U
+
+/* Number of lazy timers started with nearly the same timeout. */
+#define TEST_LAZY_TIMER_COUNT    3U
+
+/* Number of timers used for the multi-timer tests. */
+#define TEST_TIMER_COUNT         32U
+
+/* Number of rounds to start and stop all the timers in the benchmark. */
+#define TEST_BENCHMARK_ROUNDS    100U
 
 /* Magic value used to verify the context pointer is forwarded to the handler. */
-#define TEST_CONTEXT_MAGIC    ((void *)0xDEADBEEFUL)
+#define TEST_CONTEXT_MAGIC       ((void *)0xDEADBEEFUL)
 
 /* Shared test state updated from the timer expiry handler (interrupt context). */
 static atomic_t handler_call_count;
@@ -35,10 +51,20 @@ static void timeout_handler(void *context)
 	atomic_inc(&handler_call_count);
 }
 
+/* Expiry times recorded by the lazy timer handler. */
+static int64_t expiry_ticks[TEST_LAZY_TIMER_COUNT];
+
+static void lazy_timeout_handler(void *context)
+{
+	expiry_ticks[(uintptr_t)context] = k_uptime_ticks();
+	atomic_inc(&handler_call_count);
+}
+
 static void reset_handler_state(void)
 {
 	atomic_set(&handler_call_count, 0);
 	last_context = NULL;
+	memset(expiry_ticks, 0, sizeof(expiry_ticks));
 }
 
 static void before(void *fixture)
@@ -210,4 +236,129 @@ ZTEST(bm_timer, test_bm_timer_restart)
 			  "context not propagated to handler");
 }
 
+ZTEST(bm_timer, test_bm_timer_same_expiry)
+{
+	int err;
+	struct bm_timer timers[TEST_TIMER_COUNT];
+
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		err = bm_timer_init(&timers[i], BM_TIMER_MODE_SINGLE_SHOT, timeout_handler);
+		zassert_ok(err, "bm_timer_init failed, err %d", err);
+	}
+
+	/* Timers expiring at the same time must all be dispatched. */
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		err = bm_timer_start(&timers[i], TEST_TIMER_TICKS, NULL);
+		zassert_ok(err, "bm_timer_start failed, err %d", err);
+	}
+
+	k_sleep(K_MSEC(TEST_TIMER_WAIT_MS));
+
+	zassert_equal(atomic_get(&handler_call_count), ARRAY_SIZE(timers),
+		      "expected %zu expiries, got %ld", ARRAY_SIZE(timers),
+		      (long)atomic_get(&handler_call_count));
+}
+
+ZTEST(bm_timer, test_bm_timer_lazy)
+{
+	int err;
+	int64_t start;
+	size_t wakeups;
+	struct bm_timer timers[TEST_LAZY_TIMER_COUNT];
+
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		err = bm_timer_init(&timers[i], BM_TIMER_MODE_SINGLE_SHOT, lazy_timeout_handler);
+		zassert_ok(err, "bm_timer_init failed, err %d", err);
+	}
+
+	/* Timeouts one tick apart, with overlapping tolerance windows. */
+	start = k_uptime_ticks();
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		err = bm_timer_start_lazy(&timers[i], TEST_TIMER_TICKS + i, TEST_TIMER_SLACK_TICKS,
+					  (void *)i);
+		zassert_ok(err, "bm_timer_start_lazy failed, err %d", err);
+	}
+
+	k_sleep(K_MSEC(TEST_TIMER_WAIT_MS));
+
+	zassert_equal(atomic_get(&handler_call_count), ARRAY_SIZE(timers),
+		      "expected %zu expiries, got %ld", ARRAY_SIZE(timers),
+		      (long)atomic_get(&handler_call_count));
+
+	wakeups = 1;
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		zassert_true(expiry_ticks[i] >= start + TEST_TIMER_TICKS + i,
+			     "timer %zu expired early", i);
+		zassert_true(expiry_ticks[i] <= start + TEST_TIMER_TICKS + i +
+					       TEST_TIMER_SLACK_TICKS + TEST_TIMER_LATENCY_TICKS,
+			     "timer %zu expired after its tolerance window", i);
+		if (i > 0 && expiry_ticks[i] - expiry_ticks[i - 1] > 1) {
+			wakeups++;
+		}
+	}
+
+	/* The alignment grid can split the timers at most once. */
+	zassert_true(wakeups < ARRAY_SIZE(timers),
+		     "lazy timers expired in %zu separate wakeups", wakeups);
+}
+
+ZTEST(bm_timer, test_bm_timer_lazy_repeated)
+{
+	int err;
+	struct bm_timer timer;
+	atomic_val_t count;
+
+	err = bm_timer_init(&timer, BM_TIMER_MODE_REPEATED, timeout_handler);
+	zassert_ok(err, "bm_timer_init failed, err %d", err);
+
+	err = bm_timer_start_lazy(&timer, TEST_TIMER_TICKS, TEST_TIMER_SLACK_TICKS, NULL);
+	zassert_ok(err, "bm_timer_start_lazy failed, err %d", err);
+
+	/* The period does not drift by the slack, so ten periods give ten expiries. */
+	k_sleep(K_MSEC(TEST_TIMER_MS * 10 + TEST_TIMER_SLACK_MS + 10U));
+
+	err = bm_timer_stop(&timer);
+	zassert_ok(err, "bm_timer_stop failed, err %d", err);
+
+	count = atomic_get(&handler_call_count);
+	zassert_equal(count, 10, "lazy repeated timer expired %ld times, expected 10",
+		      (long)count);
+}
+
+ZTEST(bm_timer, test_bm_timer_start_stop_benchmark)
+{
+	int err;
+	uint32_t start;
+	uint32_t cycles;
+	struct bm_timer timers[TEST_TIMER_COUNT];
+
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		err = bm_timer_init(&timers[i], BM_TIMER_MODE_REPEATED, timeout_handler);
+		zassert_ok(err, "bm_timer_init failed, err %d", err);
+	}
+
+	/* Start and stop timers with spread timeouts, as an application
+	 * with many timers running would.
+	 */
+	start = k_cycle_get_32();
+	for (size_t round = 0; round < TEST_BENCHMARK_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+			err = bm_timer_start(&timers[i], TEST_TIMER_TICKS * (i + 1), NULL);
+			zassert_ok(err, "bm_timer_start failed, err %d", err);
+		}
+		for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+			err = bm_timer_stop(&timers[i]);
+			zassert_ok(err, "bm_timer_stop failed, err %d", err);
+		}
+	}
+	cycles = k_cycle_get_32() - start;
+
+	zassert_equal(atomic_get(&handler_call_count), 0, "timers expired during benchmark");
+
+	TC_PRINT("%s backend: %u start/stop pairs in %u cycles (%u Hz)\n",
+		 IS_ENABLED(CONFIG_BM_TIMER_BACKEND_WHEEL) ? "wheel" : "kernel",
+		 TEST_BENCHMARK_ROUNDS * TEST_TIMER_COUNT, cycles,
+		 sys_clock_hw_cycles_per_sec());
+}
+
 ZTEST_SUITE(bm_timer, NULL, NULL, before, NULL, NULL);
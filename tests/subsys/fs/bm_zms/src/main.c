@@ -49,6 +49,7 @@ struct bm_zms_fixture {
 
 static bool nvm_is_full;
 static bool fs_is_init;
+static volatile bool gc_notif;
 
 static void wait_for_write(void)
 {
@@ -105,6 +106,7 @@ void bm_zms_test_evt_handler(const struct bm_zms_evt *evt)
 		break;
 	case BM_ZMS_EVT_WRITE:
 	case BM_ZMS_EVT_DELETE:
+	case BM_ZMS_EVT_WRITE_BATCH:
 #if defined(CONFIG_BOARD_NATIVE_SIM)
 		k_sem_give(&write_sem);
 #elif defined(CONFIG_SOFTDEVICE)
@@ -117,6 +119,10 @@ void bm_zms_test_evt_handler(const struct bm_zms_evt *evt)
 			printf("BM_ZMS Error received %d\n", evt->result);
 		}
 
+		break;
+	case BM_ZMS_EVT_GC:
+		gc_notif = true;
+		zassert_true(evt->result == 0, "Garbage collection failed, res %d", evt->result);
 		break;
 	default:
 		printf("BM_ZMS unexpected event received %d\n", evt->evt_type);
@@ -162,6 +168,10 @@ static void after(void *data)
 	}
 
 	fixture->config.sector_count = TEST_SECTOR_COUNT;
+	fixture->config.offset = TEST_PARTITION_START;
+#if defined(CONFIG_BM_STORAGE_BACKEND_NATIVE_SIM)
+	fixture->config.storage_api = &bm_storage_native_sim_api;
+#endif
 }
 
 ZTEST_SUITE(bm_zms, NULL, setup, before, after, NULL);
@@ -268,6 +278,346 @@ ZTEST_F(bm_zms, test_zms_gc)
 	}
 }
 
+ZTEST_F(bm_zms, test_bm_zms_read_ref)
+{
+	int err;
+	int len;
+	uint8_t buf[32];
+	uint8_t expected[32];
+	const uint8_t small_buf[4] = {0x11, 0x22, 0x33, 0x44};
+	struct bm_zms_ref ref;
+	struct bm_zms_ref small_ref;
+	int writes = 0;
+
+	fixture->config.sector_count = 2;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	wait_for_mount();
+	zassert_true(err == 0, "zms_mount call failed, err %d", err);
+
+	memset(expected, 0xa5, sizeof(expected));
+	memcpy(buf, expected, sizeof(buf));
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID, buf, sizeof(buf));
+	wait_for_write();
+	zassert_true(len == sizeof(buf), "bm_zms_write failed");
+
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID + 1, small_buf, sizeof(small_buf));
+	wait_for_write();
+	zassert_true(len == sizeof(small_buf), "bm_zms_write failed");
+
+	err = bm_zms_read_ref(&fixture->fs, TEST_DATA_ID, &ref);
+	zassert_true(err == 0, "bm_zms_read_ref call failure, err %d", err);
+	zassert_equal(ref.len, sizeof(buf), "Unexpected reference length");
+	zassert_mem_equal(ref.data, expected, sizeof(expected),
+			  "Referenced data differs from written data");
+
+	/* Small data is referenced in place in its ATE. */
+	err = bm_zms_read_ref(&fixture->fs, TEST_DATA_ID + 1, &small_ref);
+	zassert_true(err == 0, "bm_zms_read_ref call failure, err %d", err);
+	zassert_equal(small_ref.len, sizeof(small_buf), "Unexpected reference length");
+	zassert_mem_equal(small_ref.data, small_buf, sizeof(small_buf),
+			  "Referenced data differs from written data");
+
+	err = bm_zms_read_ref(&fixture->fs, TEST_DATA_ID + 2, &ref);
+	zassert_true(err == -ENOENT, "bm_zms_read_ref unexpected result, err %d", err);
+
+	err = bm_zms_read_ref(&fixture->fs, TEST_DATA_ID, &ref);
+	zassert_true(err == 0, "bm_zms_read_ref call failure, err %d", err);
+	zassert_true(bm_zms_ref_valid(&fixture->fs, &ref), "Reference should be valid");
+
+	/* Writing other entries does not move the data until a sector is reused. */
+	memset(buf, 0x5a, sizeof(buf));
+	while (bm_zms_ref_valid(&fixture->fs, &ref)) {
+		zassert_true(writes++ < 64, "Garbage collection did not invalidate the reference");
+		zassert_mem_equal(ref.data, expected, sizeof(expected),
+				  "Referenced data changed while the reference is valid");
+
+		buf[0] = writes;
+		len = bm_zms_write(&fixture->fs, TEST_DATA_ID + 2 + (writes % 10), buf,
+				   sizeof(buf));
+		wait_for_write();
+		zassert_true(len == sizeof(buf), "bm_zms_write failed");
+	}
+
+	/* A new reference is taken after garbage collection moved the data. */
+	err = bm_zms_read_ref(&fixture->fs, TEST_DATA_ID, &ref);
+	zassert_true(err == 0, "bm_zms_read_ref call failure, err %d", err);
+	zassert_true(bm_zms_ref_valid(&fixture->fs, &ref), "Reference should be valid");
+	zassert_mem_equal(ref.data, expected, sizeof(expected),
+			  "Referenced data differs from written data");
+
+	err = bm_zms_read_ref(&fixture->fs, TEST_DATA_ID + 1, &small_ref);
+	zassert_true(err == 0, "bm_zms_read_ref call failure, err %d", err);
+	zassert_mem_equal(small_ref.data, small_buf, sizeof(small_buf),
+			  "Referenced data differs from written data");
+}
+
+#define ITER_PREFIX_SHIFT 16
+
+/* Collect the IDs of an iteration, checking that each is returned once. */
+static uint32_t iter_collect(struct bm_zms_fs *fs, uint32_t id_mask, uint32_t id_prefix,
+			     uint32_t *ids, uint32_t max_ids)
+{
+	int err;
+	uint32_t id;
+	uint32_t count = 0;
+	struct bm_zms_iter iter;
+
+	err = bm_zms_iter_init(fs, &iter, id_mask, id_prefix);
+	zassert_true(err == 0, "bm_zms_iter_init call failure, err %d", err);
+
+	while ((err = bm_zms_iter_next(fs, &iter, &id)) == 0) {
+		for (uint32_t i = 0; i < count; i++) {
+			zassert_not_equal(ids[i], id, "ID 0x%x returned twice", id);
+		}
+		zassert_true(count < max_ids, "Too many IDs returned");
+		ids[count++] = id;
+	}
+	zassert_true(err == -ENOENT, "bm_zms_iter_next unexpected result, err %d", err);
+
+	return count;
+}
+
+ZTEST_F(bm_zms, test_bm_zms_iter)
+{
+	int err;
+	int len;
+	uint8_t buf[32];
+	uint32_t ids[32];
+	uint32_t count;
+	const uint32_t max_id = 8;
+
+	fixture->config.sector_count = 3;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	wait_for_mount();
+	zassert_true(err == 0, "zms_mount call failed, err %d", err);
+
+	count = iter_collect(&fixture->fs, 0, 0, ids, ARRAY_SIZE(ids));
+	zassert_equal(count, 0, "Empty file system returned %u IDs", count);
+
+	/* Entries of prefix 1 and 2, written several times so that garbage is collected. */
+	for (uint32_t round = 0; round < 8; round++) {
+		for (uint32_t i = 0; i < max_id; i++) {
+			uint32_t id = ((1 + (i % 2)) << ITER_PREFIX_SHIFT) | i;
+
+			memset(buf, round, sizeof(buf));
+			len = bm_zms_write(&fixture->fs, id, buf, (i < 4) ? 4 : sizeof(buf));
+			wait_for_write();
+			zassert_true(len >= 0, "bm_zms_write failed");
+		}
+	}
+
+	zassert_not_equal(SECTOR_NUM(fixture->fs.ate_wra), 0, "No garbage collection");
+	err = bm_zms_delete(&fixture->fs, (1 << ITER_PREFIX_SHIFT) | 2);
+	zassert_true(err == 0, "bm_zms_delete call failure");
+	wait_for_write();
+
+	count = iter_collect(&fixture->fs, 0, 0, ids, ARRAY_SIZE(ids));
+	zassert_equal(count, max_id - 1, "Unexpected number of IDs %u", count);
+	/* The most recently written ID comes first. */
+	zassert_equal(ids[0], (2 << ITER_PREFIX_SHIFT) | (max_id - 1), "Unexpected first ID");
+
+	count = iter_collect(&fixture->fs, GENMASK(31, ITER_PREFIX_SHIFT),
+			     1 << ITER_PREFIX_SHIFT, ids, ARRAY_SIZE(ids));
+	zassert_equal(count, max_id / 2 - 1, "Unexpected number of IDs %u", count);
+	for (uint32_t i = 0; i < count; i++) {
+		zassert_equal(ids[i] >> ITER_PREFIX_SHIFT, 1, "ID 0x%x does not match", ids[i]);
+		zassert_not_equal(ids[i], (1 << ITER_PREFIX_SHIFT) | 2, "Deleted ID returned");
+	}
+
+	/* The IDs are found again after a mount. */
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	wait_for_mount();
+	zassert_true(err == 0, "bm_zms_mount call failure");
+
+	count = iter_collect(&fixture->fs, GENMASK(31, ITER_PREFIX_SHIFT),
+			     2 << ITER_PREFIX_SHIFT, ids, ARRAY_SIZE(ids));
+	zassert_equal(count, max_id / 2, "Unexpected number of IDs %u", count);
+}
+
+ZTEST_F(bm_zms, test_bm_zms_no_double_write)
+{
+#if defined(CONFIG_BM_ZMS_NO_DOUBLE_WRITE)
+	int err;
+	int len;
+	uint64_t ate_wra;
+	uint8_t buf[32];
+	uint8_t rd_buf[32];
+	const uint8_t small_buf[4] = {1, 2, 3, 4};
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	wait_for_mount();
+	zassert_true(err == 0, "zms_mount call failed, err %d", err);
+
+	/* Deleting an ID that is not stored writes nothing. */
+	ate_wra = fixture->fs.ate_wra;
+	err = bm_zms_delete(&fixture->fs, TEST_DATA_ID);
+	zassert_true(err == 0, "bm_zms_delete call failure");
+	wait_for_write();
+	zassert_equal(fixture->fs.ate_wra, ate_wra, "Delete of a missing ID was written");
+
+	memset(buf, 0x42, sizeof(buf));
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID, buf, sizeof(buf));
+	wait_for_write();
+	zassert_true(len == sizeof(buf), "bm_zms_write failed");
+
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID + 1, small_buf, sizeof(small_buf));
+	wait_for_write();
+	zassert_true(len == sizeof(small_buf), "bm_zms_write failed");
+
+	/* The same values are not written again. */
+	ate_wra = fixture->fs.ate_wra;
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID, buf, sizeof(buf));
+	wait_for_write();
+	zassert_true(len == sizeof(buf), "bm_zms_write failed");
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID + 1, small_buf, sizeof(small_buf));
+	wait_for_write();
+	zassert_true(len == sizeof(small_buf), "bm_zms_write failed");
+	zassert_equal(fixture->fs.ate_wra, ate_wra, "Unchanged value was written");
+
+	/* A changed value, or a value of another length, is written. */
+	buf[sizeof(buf) - 1]++;
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID, buf, sizeof(buf));
+	wait_for_write();
+	zassert_true(len == sizeof(buf), "bm_zms_write failed");
+	zassert_not_equal(fixture->fs.ate_wra, ate_wra, "Changed value was not written");
+
+	ate_wra = fixture->fs.ate_wra;
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID, buf, sizeof(buf) - 1);
+	wait_for_write();
+	zassert_true(len == sizeof(buf) - 1, "bm_zms_write failed");
+	zassert_not_equal(fixture->fs.ate_wra, ate_wra, "Shorter value was not written");
+
+	len = bm_zms_read(&fixture->fs, TEST_DATA_ID, rd_buf, sizeof(rd_buf));
+	zassert_true(len == sizeof(buf) - 1, "bm_zms_read unexpected failure");
+	zassert_mem_equal(rd_buf, buf, len, "RD buff should be equal to the WR buff");
+
+#if defined(CONFIG_BM_ZMS_STATS)
+	struct bm_zms_stats stats;
+
+	err = bm_zms_stats_get(&fixture->fs, &stats);
+	zassert_true(err == 0, "bm_zms_stats_get call failure");
+	zassert_equal(stats.writes_skipped, 3, "Unexpected number of skipped writes");
+#endif
+#else
+	ztest_test_skip();
+#endif
+}
+
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+/* Write from a stack buffer, which is overwritten before the write completes. */
+static ssize_t write_from_stack(struct bm_zms_fs *fs, uint32_t id, uint8_t value)
+{
+	uint8_t buf[CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE];
+	ssize_t len;
+
+	memset(buf, value, sizeof(buf));
+	len = bm_zms_write(fs, id, buf, sizeof(buf));
+	memset(buf, 0, sizeof(buf));
+
+	return len;
+}
+#endif
+
+ZTEST_F(bm_zms, test_bm_zms_write_copy)
+{
+#if defined(CONFIG_BM_ZMS_WRITE_COPY)
+	int err;
+	ssize_t len;
+	uint8_t rd_buf[CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE];
+	uint8_t expected[CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE];
+	/* Not copied, kept until the write completes. */
+	static uint8_t long_buf[CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE + 1];
+	const uint32_t count = CONFIG_BM_ZMS_WRITE_COPY_BLOCK_COUNT + 2;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	wait_for_mount();
+	zassert_true(err == 0, "zms_mount call failed, err %d", err);
+
+	/* More writes than blocks, the blocks are released when the writes complete. */
+	for (uint32_t i = 0; i < count; i++) {
+		len = write_from_stack(&fixture->fs, TEST_DATA_ID + i, i + 1);
+		zassert_equal(len, CONFIG_BM_ZMS_WRITE_COPY_BLOCK_SIZE,
+			      "bm_zms_write failed, len %d", (int)len);
+		wait_for_write();
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		memset(expected, i + 1, sizeof(expected));
+		len = bm_zms_read(&fixture->fs, TEST_DATA_ID + i, rd_buf, sizeof(rd_buf));
+		zassert_equal(len, sizeof(rd_buf), "bm_zms_read unexpected failure");
+		zassert_mem_equal(rd_buf, expected, sizeof(rd_buf), "Copied data is corrupted");
+	}
+
+	memset(long_buf, 0x5a, sizeof(long_buf));
+	len = bm_zms_write(&fixture->fs, TEST_DATA_ID, long_buf, sizeof(long_buf));
+	zassert_equal(len, sizeof(long_buf), "bm_zms_write failed");
+	wait_for_write();
+	zassert_true(bm_zms_get_data_length(&fixture->fs, TEST_DATA_ID) == sizeof(long_buf),
+		     "Unexpected length of the long write");
+#else
+	ztest_test_skip();
+#endif
+}
+
+ZTEST_F(bm_zms, test_bm_zms_stats)
+{
+#if defined(CONFIG_BM_ZMS_STATS)
+	int err;
+	int len;
+	uint8_t buf[32];
+	struct bm_zms_stats stats;
+	uint32_t erase_count = 0;
+	uint32_t mount_erase_count = 0;
+	const uint32_t writes = 60;
+
+	fixture->config.sector_count = 2;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	wait_for_mount();
+	zassert_true(err == 0, "zms_mount call failed, err %d", err);
+
+	err = bm_zms_stats_get(&fixture->fs, &stats);
+	zassert_true(err == 0, "bm_zms_stats_get call failure");
+	zassert_equal(stats.bytes_written, 0, "Unexpected bytes written at mount");
+	zassert_equal(stats.gc_count, 0, "Unexpected garbage collection at mount");
+
+	/* Mounting might have erased sectors already. */
+	for (uint32_t i = 0; i < fixture->config.sector_count; i++) {
+		mount_erase_count += stats.sector_erase_count[i];
+	}
+
+	/* A single ID is rewritten, garbage collection keeps its latest value only. */
+	for (uint32_t i = 0; i < writes; i++) {
+		memset(buf, i, sizeof(buf));
+		len = bm_zms_write(&fixture->fs, TEST_DATA_ID, buf, sizeof(buf));
+		wait_for_write();
+		zassert_true(len == sizeof(buf), "bm_zms_write failed");
+	}
+
+	err = bm_zms_stats_get(&fixture->fs, &stats);
+	zassert_true(err == 0, "bm_zms_stats_get call failure");
+
+	zassert_equal(stats.bytes_written, writes * (sizeof(buf) + fixture->fs.ate_size),
+		      "Unexpected bytes written %u", stats.bytes_written);
+	zassert_true(stats.gc_count > 0, "No garbage collection");
+	zassert_true(stats.gc_bytes_moved <= stats.gc_count * (sizeof(buf) + fixture->fs.ate_size),
+		     "More than one entry moved by each garbage collection");
+
+	for (uint32_t i = 0; i < fixture->config.sector_count; i++) {
+		erase_count += stats.sector_erase_count[i];
+	}
+	zassert_equal(erase_count - mount_erase_count, stats.gc_count,
+		      "Erases do not match garbage collections");
+
+	TC_PRINT("%u bytes written, %u bytes moved by %u garbage collections\n",
+		 stats.bytes_written, stats.gc_bytes_moved, stats.gc_count);
+#else
+	ztest_test_skip();
+#endif
+}
+
 static void write_content(uint32_t max_id, uint32_t begin, uint32_t end, struct bm_zms_fs *fs)
 {
 	uint8_t buf[32];
@@ -738,3 +1088,525 @@ ZTEST_F(bm_zms, test_bm_zms_write_prime)
 	zassert_mem_equal(wr_buf, rd_buf, sizeof(rd_buf),
 			  "RD buff should be equal to the WR buff");
 }
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+K_SEM_DEFINE(second_fs_sem, 0, 1);
+#else
+static volatile bool second_fs_notif;
+#endif
+
+static void second_fs_evt_handler(const struct bm_zms_evt *evt)
+{
+	zassert_true(evt->result == 0, "Second file system event %d failed, res %d",
+		     evt->evt_type, evt->result);
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	k_sem_give(&second_fs_sem);
+#else
+	second_fs_notif = true;
+#endif
+}
+
+static void wait_for_second_fs(void)
+{
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	k_sem_take(&second_fs_sem, K_FOREVER);
+#else
+	while (!second_fs_notif) {
+		k_cpu_idle();
+	}
+	second_fs_notif = false;
+#endif
+}
+
+/*
+ * Two file systems sharing a partition, with interleaved writes and garbage collection.
+ */
+ZTEST_F(bm_zms, test_bm_zms_multi_fs)
+{
+	static struct bm_zms_fs second_fs;
+	static struct bm_zms_fs third_fs;
+	struct bm_zms_fs_config second_config = fixture->config;
+	const uint32_t max_id = 10;
+	/* 21st write will trigger GC in both file systems. */
+	const uint32_t max_writes = 21;
+	uint8_t buf[32];
+	uint8_t rd_buf[32];
+	ssize_t len;
+	int err;
+
+	/* Each file system gets half of the partition. */
+	fixture->config.sector_count = TEST_SECTOR_COUNT / 2;
+	second_config.sector_count = TEST_SECTOR_COUNT / 2;
+	second_config.offset = fixture->config.offset + TEST_PARTITION_SIZE / 2;
+	second_config.evt_handler = second_fs_evt_handler;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	err = bm_zms_mount(&second_fs, &second_config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+	wait_for_second_fs();
+
+	zassert_not_equal(fixture->fs.op_queue, second_fs.op_queue,
+			  "File systems should not share an operation queue");
+
+	if (CONFIG_BM_ZMS_MAX_FS == 2) {
+		err = bm_zms_mount(&third_fs, &second_config);
+		zassert_equal(err, -ENOMEM, "bm_zms_mount should run out of queues, err %d", err);
+	}
+
+	for (uint32_t i = 0; i < max_writes; i++) {
+		uint32_t id = (i % max_id);
+		uint8_t id_data = id + max_id * (i / max_id);
+
+		/* Queue both writes before waiting, so that the two queues run together. */
+		memset(buf, id_data, sizeof(buf));
+		len = bm_zms_write(&fixture->fs, id, buf, sizeof(buf));
+		zassert_true(len == sizeof(buf), "bm_zms_write failed");
+
+		memset(buf, ~id_data, sizeof(buf));
+		len = bm_zms_write(&second_fs, id + max_id, buf, sizeof(buf));
+		zassert_true(len == sizeof(buf), "bm_zms_write failed");
+
+		wait_for_write();
+		wait_for_second_fs();
+	}
+
+	check_content(max_id, &fixture->fs);
+
+	for (uint32_t id = 0; id < max_id; id++) {
+		len = bm_zms_read(&second_fs, id + max_id, rd_buf, sizeof(rd_buf));
+		zassert_true(len == sizeof(rd_buf), "bm_zms_read unexpected failure");
+
+		for (int i = 0; i < ARRAY_SIZE(rd_buf); i++) {
+			rd_buf[i] = (uint8_t)~rd_buf[i] % max_id;
+			buf[i] = id;
+		}
+		zassert_mem_equal(buf, rd_buf, sizeof(rd_buf),
+				  "RD buff should be equal to the WR buff");
+
+		/* Entries must not leak between the file systems. */
+		len = bm_zms_read(&fixture->fs, id + max_id, rd_buf, sizeof(rd_buf));
+		zassert_true(len == -ENOENT, "bm_zms_read unexpected entry");
+		len = bm_zms_read(&second_fs, id, rd_buf, sizeof(rd_buf));
+		zassert_true(len == -ENOENT, "bm_zms_read unexpected entry");
+	}
+
+	err = bm_zms_clear(&second_fs);
+	zassert_true(err == 0, "bm_zms_clear call failure");
+	wait_for_second_fs();
+
+	/* Clearing one file system leaves the other one intact. */
+	check_content(max_id, &fixture->fs);
+}
+
+ZTEST_F(bm_zms, test_bm_zms_write_batch)
+{
+	int err;
+	ssize_t len;
+	uint8_t big[64];
+	uint8_t rd_buf[64];
+	uint32_t small = 0x12345678;
+	const struct bm_zms_batch_entry entries[] = {
+		{ .id = 1, .data = big, .len = sizeof(big) },
+		{ .id = 2, .data = &small, .len = sizeof(small) },
+		{ .id = 3 },
+	};
+
+	memset(big, 0xA5, sizeof(big));
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	len = bm_zms_write(&fixture->fs, 3, &small, sizeof(small));
+	zassert_true(len == sizeof(small), "bm_zms_write failed");
+	wait_for_write();
+
+	err = bm_zms_write_batch(&fixture->fs, entries, ARRAY_SIZE(entries));
+	zassert_true(err == 0, "bm_zms_write_batch call failure, err %d", err);
+	wait_for_write();
+
+	for (int i = 0; i < 2; i++) {
+		len = bm_zms_read(&fixture->fs, 1, rd_buf, sizeof(rd_buf));
+		zassert_true(len == sizeof(big), "bm_zms_read unexpected failure");
+		zassert_mem_equal(big, rd_buf, sizeof(big),
+				  "RD buff should be equal to the WR buff");
+
+		len = bm_zms_read(&fixture->fs, 2, rd_buf, sizeof(rd_buf));
+		zassert_true(len == sizeof(small), "bm_zms_read unexpected failure");
+		zassert_mem_equal(&small, rd_buf, sizeof(small),
+				  "RD buff should be equal to the WR buff");
+
+		/* The batch deleted the entry written before it. */
+		len = bm_zms_read(&fixture->fs, 3, rd_buf, sizeof(rd_buf));
+		zassert_true(len == -ENOENT, "bm_zms_read unexpected entry");
+
+		/* The entries must still be there after a new mount. */
+		err = bm_zms_mount(&fixture->fs, &fixture->config);
+		zassert_true(err == 0, "bm_zms_mount call failure");
+		wait_for_mount();
+	}
+}
+
+ZTEST_F(bm_zms, test_bm_zms_write_batch_invalid)
+{
+	int err;
+	uint8_t buf[TEST_SECTOR_SIZE / 2];
+	const struct bm_zms_batch_entry too_large[] = {
+		{ .id = 1, .data = buf, .len = sizeof(buf) },
+		{ .id = 2, .data = buf, .len = sizeof(buf) },
+	};
+	const struct bm_zms_batch_entry no_data[] = {
+		{ .id = 1, .data = NULL, .len = sizeof(buf) },
+	};
+
+	err = bm_zms_write_batch(&fixture->fs, too_large, ARRAY_SIZE(too_large));
+	zassert_equal(err, -EACCES, "bm_zms_write_batch should fail before mount");
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	err = bm_zms_write_batch(&fixture->fs, too_large, 0);
+	zassert_equal(err, -EINVAL, "bm_zms_write_batch should fail with no entries");
+
+	/* The batch must fit in a single sector. */
+	err = bm_zms_write_batch(&fixture->fs, too_large, ARRAY_SIZE(too_large));
+	zassert_equal(err, -EINVAL, "bm_zms_write_batch should fail, entries too large");
+
+	err = bm_zms_write_batch(&fixture->fs, no_data, ARRAY_SIZE(no_data));
+	zassert_equal(err, -EINVAL, "bm_zms_write_batch should fail without data");
+}
+
+/*
+ * Batches that do not fit in the open sector close it and trigger a garbage collection.
+ */
+ZTEST_F(bm_zms, test_bm_zms_write_batch_gc)
+{
+	int err;
+	const uint32_t max_id = 10;
+	uint8_t data[4][32];
+	struct bm_zms_batch_entry entries[4];
+
+	fixture->config.sector_count = 2;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	/* Each sector holds about 4 batches of 4 entries, so 20 batches trigger several GCs. */
+	for (uint32_t i = 0; i < 20 * ARRAY_SIZE(entries); i += ARRAY_SIZE(entries)) {
+		for (uint32_t j = 0; j < ARRAY_SIZE(entries); j++) {
+			uint32_t id = (i + j) % max_id;
+
+			memset(data[j], id + max_id * ((i + j) / max_id), sizeof(data[j]));
+			entries[j].id = id;
+			entries[j].data = data[j];
+			entries[j].len = sizeof(data[j]);
+		}
+
+		err = bm_zms_write_batch(&fixture->fs, entries, ARRAY_SIZE(entries));
+		zassert_true(err == 0, "bm_zms_write_batch call failure, err %d", err);
+		wait_for_write();
+		zassert_false(nvm_is_full, "bm_zms_write_batch ran out of space");
+	}
+
+	check_content(max_id, &fixture->fs);
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	check_content(max_id, &fixture->fs);
+}
+
+/*
+ * A batch interrupted before its commit ATE is written is rolled back at mount.
+ */
+ZTEST_F(bm_zms, test_bm_zms_write_batch_rollback)
+{
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	int err;
+	ssize_t len;
+	uint64_t commit_addr;
+	uint32_t value;
+	uint8_t big_old[32];
+	uint8_t big_new[32];
+	uint8_t rd_buf[32];
+	const uint32_t old_value = 1;
+	const uint32_t new_value = 2;
+	const struct bm_zms_batch_entry entries[] = {
+		{ .id = 1, .data = &new_value, .len = sizeof(new_value) },
+		{ .id = 2, .data = big_new, .len = sizeof(big_new) },
+		{ .id = 3, .data = &new_value, .len = sizeof(new_value) },
+	};
+
+	memset(big_old, 0x11, sizeof(big_old));
+	memset(big_new, 0x22, sizeof(big_new));
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	len = bm_zms_write(&fixture->fs, 1, &old_value, sizeof(old_value));
+	zassert_true(len == sizeof(old_value), "bm_zms_write failed");
+	wait_for_write();
+	len = bm_zms_write(&fixture->fs, 2, big_old, sizeof(big_old));
+	zassert_true(len == sizeof(big_old), "bm_zms_write failed");
+	wait_for_write();
+
+	err = bm_zms_write_batch(&fixture->fs, entries, ARRAY_SIZE(entries));
+	zassert_true(err == 0, "bm_zms_write_batch call failure, err %d", err);
+	wait_for_write();
+
+	/* Simulate a power loss before the commit ATE, the last ATE written, is written. */
+	commit_addr = fixture->fs.ate_wra + fixture->fs.ate_size;
+	memset(&mem[SECTOR_NUM(commit_addr) * TEST_SECTOR_SIZE + SECTOR_OFFSET(commit_addr)], 0xff,
+	       fixture->fs.ate_size);
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	/* None of the entries of the batch are visible. */
+	len = bm_zms_read(&fixture->fs, 1, &value, sizeof(value));
+	zassert_true(len == sizeof(value), "bm_zms_read unexpected failure");
+	zassert_equal(value, old_value, "Batch entry should have been rolled back");
+	len = bm_zms_read(&fixture->fs, 2, rd_buf, sizeof(rd_buf));
+	zassert_true(len == sizeof(rd_buf), "bm_zms_read unexpected failure");
+	zassert_mem_equal(big_old, rd_buf, sizeof(rd_buf),
+			  "Batch entry should have been rolled back");
+	len = bm_zms_read(&fixture->fs, 3, &value, sizeof(value));
+	zassert_true(len == -ENOENT, "Batch entry should have been rolled back");
+
+	/* Writes after the rollback are kept by the next mount. */
+	len = bm_zms_write(&fixture->fs, 3, &new_value, sizeof(new_value));
+	zassert_true(len == sizeof(new_value), "bm_zms_write failed");
+	wait_for_write();
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	len = bm_zms_read(&fixture->fs, 3, &value, sizeof(value));
+	zassert_true(len == sizeof(value), "bm_zms_read unexpected failure");
+	zassert_equal(value, new_value, "Entry written after the rollback is missing");
+	len = bm_zms_read(&fixture->fs, 1, &value, sizeof(value));
+	zassert_true(len == sizeof(value), "bm_zms_read unexpected failure");
+	zassert_equal(value, old_value, "Batch entry should have been rolled back");
+#else
+	ztest_test_skip();
+#endif
+}
+
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+#define TEST_GC_THRESHOLD ((TEST_SECTOR_SIZE * CONFIG_BM_ZMS_GC_BACKGROUND_THRESHOLD) / 100)
+
+/* Fill the open sector until it is below the background GC threshold, without a GC. */
+static uint32_t fill_to_gc_threshold(uint32_t max_id, struct bm_zms_fs *fs)
+{
+	uint64_t sector = SECTOR_NUM(fs->ate_wra);
+	uint32_t writes = 0;
+
+	while (bm_zms_active_sector_free_space(fs) >= TEST_GC_THRESHOLD) {
+		write_content(max_id, writes, writes + 1, fs);
+		writes++;
+	}
+	zassert_equal(SECTOR_NUM(fs->ate_wra), sector, "Unexpected garbage collection");
+
+	return writes;
+}
+
+/* Run background GC steps until the garbage collection is completed. */
+static uint32_t run_gc_steps(struct bm_zms_fs *fs)
+{
+	uint32_t steps = 0;
+	int err;
+
+	gc_notif = false;
+	while (!gc_notif) {
+		err = bm_zms_gc_step(fs);
+		if (err == -EBUSY) {
+			/* The previous step is still being executed. */
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+			k_sleep(K_MSEC(1));
+#else
+			k_cpu_idle();
+#endif
+			continue;
+		}
+		zassert_equal(err, 0, "bm_zms_gc_step call failure, err %d", err);
+		steps++;
+	}
+
+	return steps;
+}
+#endif
+
+/*
+ * Background garbage collection prepares a fresh sector in bounded steps.
+ */
+ZTEST_F(bm_zms, test_bm_zms_gc_step)
+{
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+	int err;
+	uint32_t steps;
+	uint64_t sector;
+	const uint32_t max_id = 10;
+
+	fixture->config.sector_count = 2;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	err = bm_zms_gc_step(&fixture->fs);
+	zassert_equal(err, -EALREADY, "bm_zms_gc_step should have nothing to do, err %d", err);
+
+	fill_to_gc_threshold(max_id, &fixture->fs);
+	sector = SECTOR_NUM(fixture->fs.ate_wra);
+
+	steps = run_gc_steps(&fixture->fs);
+	zassert_true(steps > 1, "Garbage collection was not split in steps");
+	zassert_not_equal(SECTOR_NUM(fixture->fs.ate_wra), sector, "Sector was not closed");
+	zassert_true(bm_zms_active_sector_free_space(&fixture->fs) >= TEST_GC_THRESHOLD,
+		     "Garbage collection did not free space");
+
+	/* Nothing was written since, another garbage collection would not free more space. */
+	err = bm_zms_gc_step(&fixture->fs);
+	zassert_equal(err, -EALREADY, "bm_zms_gc_step should have nothing to do, err %d", err);
+
+	check_content(max_id, &fixture->fs);
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	check_content(max_id, &fixture->fs);
+#else
+	ztest_test_skip();
+#endif
+}
+
+/*
+ * A write queued while background garbage collection is paused completes it first.
+ */
+ZTEST_F(bm_zms, test_bm_zms_gc_step_write)
+{
+#if defined(CONFIG_BM_ZMS_GC_BACKGROUND)
+	int err;
+	uint32_t writes;
+	uint64_t sector;
+	const uint32_t max_id = 10;
+
+	fixture->config.sector_count = 2;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	writes = fill_to_gc_threshold(max_id, &fixture->fs);
+	sector = SECTOR_NUM(fixture->fs.ate_wra);
+
+	gc_notif = false;
+	err = bm_zms_gc_step(&fixture->fs);
+	zassert_equal(err, 0, "bm_zms_gc_step call failure, err %d", err);
+#if defined(CONFIG_BM_STORAGE_BACKEND_NATIVE_SIM) && \
+	!defined(CONFIG_BM_STORAGE_BACKEND_NATIVE_SIM_ASYNC)
+	zassert_false(gc_notif, "Garbage collection should be paused");
+#endif
+
+	write_content(max_id, writes, writes + 1, &fixture->fs);
+	zassert_true(gc_notif, "Garbage collection should be completed before the write");
+	zassert_not_equal(SECTOR_NUM(fixture->fs.ate_wra), sector, "Sector was not closed");
+
+	check_content(max_id, &fixture->fs);
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	check_content(max_id, &fixture->fs);
+#else
+	ztest_test_skip();
+#endif
+}
+
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT) && defined(CONFIG_BOARD_NATIVE_SIM)
+static uint8_t benchmark_mem[TEST_PARTITION_SIZE];
+static struct bm_storage_api counting_api;
+static uint32_t storage_reads;
+
+static int counting_read(const struct bm_storage *storage, uint32_t src, void *dest, uint32_t len)
+{
+	storage_reads++;
+
+	return bm_storage_native_sim_api.read(storage, src, dest, len);
+}
+
+static void benchmark_mount(struct bm_zms_fixture *fixture, uint32_t *reads, uint32_t *cycles)
+{
+	uint32_t start;
+	int err;
+
+	storage_reads = 0;
+	start = k_cycle_get_32();
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	*cycles = k_cycle_get_32() - start;
+	*reads = storage_reads;
+}
+#endif
+
+/*
+ * Mount with and without the lookup cache snapshot, on a partition with a long write history.
+ */
+ZTEST_F(bm_zms, test_bm_zms_mount_benchmark)
+{
+#if defined(CONFIG_BM_ZMS_LOOKUP_CACHE_SNAPSHOT) && defined(CONFIG_BOARD_NATIVE_SIM)
+	int err;
+	uint32_t cold_reads, cold_cycles;
+	uint32_t warm_reads, warm_cycles;
+	uint64_t expected_cache[CONFIG_BM_ZMS_LOOKUP_CACHE_SIZE];
+	const uint32_t max_id = 20;
+
+	err = bm_zms_mount(&fixture->fs, &fixture->config);
+	zassert_true(err == 0, "bm_zms_mount call failure");
+	wait_for_mount();
+
+	/* Three sectors worth of history, half of the last sector is in the open sector. */
+	write_content(max_id, 0, 50, &fixture->fs);
+
+	/* A copy of the partition at another offset has no snapshot. */
+	memcpy(benchmark_mem, mem, sizeof(benchmark_mem));
+	counting_api = bm_storage_native_sim_api;
+	counting_api.read = counting_read;
+	fixture->config.offset = (off_t)benchmark_mem;
+	fixture->config.storage_api = &counting_api;
+
+	benchmark_mount(fixture, &cold_reads, &cold_cycles);
+
+	/* Writes in the open sector after the snapshot are replayed. */
+	write_content(max_id, 50, 53, &fixture->fs);
+	memcpy(expected_cache, fixture->fs.lookup_cache, sizeof(expected_cache));
+
+	benchmark_mount(fixture, &warm_reads, &warm_cycles);
+
+	zassert_mem_equal(expected_cache, fixture->fs.lookup_cache, sizeof(expected_cache),
+			  "Restored lookup cache differs from the rebuilt one");
+	zassert_true(warm_reads < cold_reads, "Snapshot did not reduce the storage reads");
+
+	TC_PRINT("Mount without snapshot: %u storage reads, %u cycles\n", cold_reads,
+		 cold_cycles);
+	TC_PRINT("Mount with snapshot:    %u storage reads, %u cycles\n", warm_reads,
+		 warm_cycles);
+
+	check_content(max_id, &fixture->fs);
+#else
+	ztest_test_skip();
+#endif
+}
@@ -5,18 +5,22 @@
  */
 
 #include <nrf_error.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <unity.h>
 #include <bm/bluetooth/ble_db_discovery.h>
 #include <bm/bluetooth/services/uuid.h>
 
 #include "cmock_ble_gq.h"
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+#include "cmock_peer_manager.h"
+#endif
 
 BLE_DB_DISCOVERY_DEF(db_discovery);
 static struct ble_gq ble_gatt_queue;
 
-static struct ble_gatt_db_srv db_disc_srv[8];
-static struct ble_db_discovery_evt db_disc_evt[8];
+static struct ble_gatt_db_srv db_disc_srv[16];
+static struct ble_db_discovery_evt db_disc_evt[16];
 static uint32_t db_disc_evt_count;
 
 static uint16_t test_conn_handle;
@@ -79,6 +83,212 @@ static const struct ble_db_discovery_config db_disc_config = {
 
 static int stub_ble_gq_item_add_success_num_calls;
 
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+/* Layout of the record stored in the remote database of the peer, for two services. */
+struct cache_record {
+	struct ble_gatt_db_srv services[2];
+	uint8_t db_hash[BLE_DB_DISCOVERY_DB_HASH_LEN];
+};
+
+/* Length of the record, without any padding at the end of the structure. */
+#define CACHE_RECORD_LEN (offsetof(struct cache_record, db_hash) + BLE_DB_DISCOVERY_DB_HASH_LEN)
+
+static const uint8_t test_db_hash[BLE_DB_DISCOVERY_DB_HASH_LEN] = {
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+	0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+};
+
+static uint16_t test_peer_id;
+static struct cache_record test_record;
+static uint32_t test_record_len;
+static uint32_t pm_peer_data_store_num_calls;
+
+static uint32_t stub_pm_peer_id_get(uint16_t conn_handle, uint16_t *peer_id, int cmock_num_calls)
+{
+	/* Only the peer on the test connection can be bonded. */
+	*peer_id = (conn_handle == test_conn_handle) ? test_peer_id : PM_PEER_ID_INVALID;
+
+	return NRF_SUCCESS;
+}
+
+static uint32_t stub_pm_peer_data_load(uint16_t peer_id, enum pm_peer_data_id data_id, void *data,
+				       uint32_t *len, int cmock_num_calls)
+{
+	TEST_ASSERT_EQUAL(test_peer_id, peer_id);
+	TEST_ASSERT_EQUAL(PM_PEER_DATA_ID_GATT_REMOTE, data_id);
+
+	if (test_record_len == 0) {
+		return NRF_ERROR_NOT_FOUND;
+	}
+
+	TEST_ASSERT_GREATER_OR_EQUAL(test_record_len, *len);
+	memcpy(data, &test_record, test_record_len);
+	*len = test_record_len;
+
+	return NRF_SUCCESS;
+}
+
+static uint32_t stub_pm_peer_data_store(uint16_t peer_id, enum pm_peer_data_id data_id,
+					const void *data, uint32_t len, uint32_t *token,
+					int cmock_num_calls)
+{
+	TEST_ASSERT_EQUAL(test_peer_id, peer_id);
+	TEST_ASSERT_EQUAL(PM_PEER_DATA_ID_GATT_REMOTE, data_id);
+	TEST_ASSERT_LESS_OR_EQUAL(sizeof(test_record), len);
+
+	memcpy(&test_record, data, len);
+	test_record_len = len;
+	pm_peer_data_store_num_calls++;
+
+	return NRF_SUCCESS;
+}
+
+static void db_hash_read_rsp_evt_send(uint16_t gatt_status, const uint8_t *db_hash)
+{
+	/* The Handle-Value list of the response holds the handle followed by the value. */
+	uint8_t buf[sizeof(ble_evt_t) + sizeof(uint16_t) + BLE_DB_DISCOVERY_DB_HASH_LEN]
+		__aligned(4) = {0};
+	ble_evt_t *evt = (ble_evt_t *)buf;
+	ble_gattc_evt_char_val_by_uuid_read_rsp_t *rsp =
+		&evt->evt.gattc_evt.params.char_val_by_uuid_read_rsp;
+
+	evt->header.evt_id = BLE_GATTC_EVT_CHAR_VAL_BY_UUID_READ_RSP;
+	evt->evt.gattc_evt.conn_handle = test_conn_handle;
+	evt->evt.gattc_evt.gatt_status = gatt_status;
+
+	if (gatt_status == BLE_GATT_STATUS_SUCCESS) {
+		rsp->count = 1;
+		rsp->value_len = BLE_DB_DISCOVERY_DB_HASH_LEN;
+		rsp->handle_value[0] = 0x0D;
+		rsp->handle_value[1] = 0x00;
+		memcpy(&rsp->handle_value[sizeof(uint16_t)], db_hash, BLE_DB_DISCOVERY_DB_HASH_LEN);
+	}
+
+	ble_db_discovery_on_ble_evt(evt, &db_discovery);
+}
+
+static uint32_t stub_ble_gq_item_add_scenario_cache(const struct ble_gq *gatt_queue,
+						    struct ble_gq_req *req, uint16_t conn_handle,
+						    int cmock_num_calls)
+{
+	stub_ble_gq_item_add_success_num_calls = cmock_num_calls + 1;
+
+	TEST_ASSERT_EQUAL_PTR(&ble_gatt_queue, gatt_queue);
+	TEST_ASSERT_EQUAL(test_conn_handle, conn_handle);
+	TEST_ASSERT_EQUAL_PTR(&db_discovery, req->ctx);
+
+	switch (stub_ble_gq_item_add_success_num_calls) {
+	case 1:
+		/* Check Database Hash read request. */
+		TEST_ASSERT_EQUAL(BLE_GQ_REQ_GATTC_READ_BY_UUID, req->type);
+		TEST_ASSERT_EQUAL(BLE_UUID_DATABASE_HASH_CHAR, req->gattc_read_by_uuid.uuid.uuid);
+		TEST_ASSERT_EQUAL(BLE_UUID_TYPE_BLE, req->gattc_read_by_uuid.uuid.type);
+		TEST_ASSERT_EQUAL(0x0001, req->gattc_read_by_uuid.handle_range.start_handle);
+		TEST_ASSERT_EQUAL(0xFFFF, req->gattc_read_by_uuid.handle_range.end_handle);
+		break;
+	case 2:
+		/* Check service 1 discovery request. */
+		TEST_ASSERT_EQUAL(BLE_GQ_REQ_SRV_DISCOVERY, req->type);
+		TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv1_uuid, &req->gattc_srv_disc.srvc_uuid));
+		break;
+	case 3:
+		/* Check characteristic discovery request (service 1). */
+		TEST_ASSERT_EQUAL(BLE_GQ_REQ_CHAR_DISCOVERY, req->type);
+		TEST_ASSERT_EQUAL(0x0001, req->gattc_char_disc.start_handle);
+		TEST_ASSERT_EQUAL(0x0003, req->gattc_char_disc.end_handle);
+		break;
+	case 4:
+		/* Check service 2 discovery request. */
+		TEST_ASSERT_EQUAL(BLE_GQ_REQ_SRV_DISCOVERY, req->type);
+		TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv2_uuid, &req->gattc_srv_disc.srvc_uuid));
+		break;
+	default:
+		TEST_FAIL();
+	}
+
+	return NRF_SUCCESS;
+}
+
+/* Discover service 1 with one characteristic, service 2 is not found. */
+static void scenario_cache_discover(void)
+{
+	ble_evt_t evt;
+
+	/* Service 1 is found. */
+	evt = (ble_evt_t) {
+		.header.evt_id = BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP,
+		.evt.gattc_evt = {
+			.gatt_status = BLE_GATT_STATUS_SUCCESS,
+			.conn_handle = test_conn_handle,
+			.params.prim_srvc_disc_rsp = {
+				.count = 1,
+				.services[0] = {
+					.uuid = srv1_uuid,
+					.handle_range = {.start_handle = 0x0001, .end_handle = 0x0003},
+				},
+			},
+		},
+	};
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+	TEST_ASSERT_EQUAL(3, stub_ble_gq_item_add_success_num_calls);
+
+	/* Its only characteristic ends the service, so service 2 is discovered next. */
+	evt = (ble_evt_t) {
+		.header.evt_id = BLE_GATTC_EVT_CHAR_DISC_RSP,
+		.evt.gattc_evt = {
+			.gatt_status = BLE_GATT_STATUS_SUCCESS,
+			.conn_handle = test_conn_handle,
+			.params.char_disc_rsp = {
+				.count = 1,
+				.chars[0] = {
+					.uuid = srv1_char1_uuid,
+					.handle_decl = 0x0002,
+					.handle_value = 0x0003,
+				},
+			},
+		},
+	};
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+	TEST_ASSERT_EQUAL(4, stub_ble_gq_item_add_success_num_calls);
+
+	/* Service 2 is not found. */
+	evt = (ble_evt_t) {
+		.header.evt_id = BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP,
+		.evt.gattc_evt = {
+			.gatt_status = BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND,
+			.conn_handle = test_conn_handle,
+		},
+	};
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+	TEST_ASSERT_EQUAL(4, stub_ble_gq_item_add_success_num_calls);
+}
+
+static void scenario_cache_start(void)
+{
+	uint32_t nrf_err;
+
+	__cmock_ble_gq_item_add_Stub(stub_ble_gq_item_add_scenario_cache);
+	__cmock_ble_gq_conn_handle_register_ExpectAndReturn(&ble_gatt_queue, test_conn_handle,
+							    NRF_SUCCESS);
+	__cmock_pm_peer_data_load_Stub(stub_pm_peer_data_load);
+	__cmock_pm_peer_data_store_Stub(stub_pm_peer_data_store);
+
+	nrf_err = ble_db_discovery_init(&db_discovery, &db_disc_config);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv1_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv2_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	/* The peer is bonded. Start Discovery, sends a Database Hash read request. */
+	test_peer_id = 3;
+
+	nrf_err = ble_db_discovery_start(&db_discovery, test_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(1, stub_ble_gq_item_add_success_num_calls);
+}
+#endif
+
 void test_ble_db_discovery_init_error_null(void)
 {
 	uint32_t nrf_err;
@@ -1886,6 +2096,7 @@ static uint32_t stub_ble_gq_item_add_success_then_no_mem(
 {
 	struct ble_gq_evt evt = {
 		.evt_type = BLE_GQ_EVT_ERROR,
+		.conn_handle = conn_handle,
 		.error.reason = NRF_ERROR_NO_MEM,
 	};
 
@@ -1992,6 +2203,493 @@ void test_scenario_ble_gq_item_add_no_mem(void)
 	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_AVAILABLE, db_disc_evt[3].evt_type);
 }
 
+/* Connection handles of the peers discovered in parallel. There is one more peer than links. */
+static const uint16_t multi_link_conn_handles[] = {0x0100, 0x0101, 0x0102, 0x0103, 0x0104};
+/* The last request sent for each peer, and the number of requests. */
+static struct ble_gq_req multi_link_last_req[ARRAY_SIZE(multi_link_conn_handles)];
+static uint32_t multi_link_req_count[ARRAY_SIZE(multi_link_conn_handles)];
+
+static int multi_link_idx_get(uint16_t conn_handle)
+{
+	for (int i = 0; i < ARRAY_SIZE(multi_link_conn_handles); i++) {
+		if (multi_link_conn_handles[i] == conn_handle) {
+			return i;
+		}
+	}
+
+	TEST_FAIL_MESSAGE("Request for an unknown connection handle");
+	return -1;
+}
+
+static uint32_t stub_ble_gq_item_add_scenario_multi_link(const struct ble_gq *gatt_queue,
+							 struct ble_gq_req *req,
+							 uint16_t conn_handle, int cmock_num_calls)
+{
+	const int idx = multi_link_idx_get(conn_handle);
+
+	TEST_ASSERT_EQUAL_PTR(&ble_gatt_queue, gatt_queue);
+	TEST_ASSERT_NOT_NULL(req->evt_handler);
+	TEST_ASSERT_EQUAL_PTR(&db_discovery, req->ctx);
+
+	multi_link_last_req[idx] = *req;
+	multi_link_req_count[idx]++;
+
+	return NRF_SUCCESS;
+}
+
+static void multi_link_prim_srvc_disc_rsp_send(int idx, const ble_uuid_t *uuid,
+					       uint16_t start_handle)
+{
+	ble_evt_t evt = {
+		.header.evt_id = BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP,
+		.evt.gattc_evt = {
+			.conn_handle = multi_link_conn_handles[idx],
+		},
+	};
+
+	if (uuid) {
+		/* The service holds one characteristic. */
+		evt.evt.gattc_evt.gatt_status = BLE_GATT_STATUS_SUCCESS;
+		evt.evt.gattc_evt.params.prim_srvc_disc_rsp.count = 1;
+		evt.evt.gattc_evt.params.prim_srvc_disc_rsp.services[0] = (ble_gattc_service_t) {
+			.uuid = *uuid,
+			.handle_range = {.start_handle = start_handle,
+					 .end_handle = start_handle + 2},
+		};
+	} else {
+		evt.evt.gattc_evt.gatt_status = BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND;
+	}
+
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+}
+
+static void multi_link_char_disc_rsp_send(int idx, uint16_t srv_start_handle)
+{
+	ble_evt_t evt = {
+		.header.evt_id = BLE_GATTC_EVT_CHAR_DISC_RSP,
+		.evt.gattc_evt = {
+			.gatt_status = BLE_GATT_STATUS_SUCCESS,
+			.conn_handle = multi_link_conn_handles[idx],
+			.params.char_disc_rsp = {
+				.count = 1,
+				.chars[0] = {
+					.uuid = srv1_char1_uuid,
+					.handle_decl = srv_start_handle + 1,
+					.handle_value = srv_start_handle + 2,
+				},
+			},
+		},
+	};
+
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+}
+
+static void multi_link_srv_disc_req_check(int idx, const ble_uuid_t *uuid, uint32_t req_count)
+{
+	TEST_ASSERT_EQUAL(req_count, multi_link_req_count[idx]);
+	TEST_ASSERT_EQUAL(BLE_GQ_REQ_SRV_DISCOVERY, multi_link_last_req[idx].type);
+	TEST_ASSERT_TRUE(BLE_UUID_EQ(uuid, &multi_link_last_req[idx].gattc_srv_disc.srvc_uuid));
+}
+
+/* Find the index of the first discovery event sent for a peer. */
+static uint32_t multi_link_evt_idx_get(int idx)
+{
+	for (uint32_t i = 0; i < db_disc_evt_count; i++) {
+		if (db_disc_evt[i].conn_handle == multi_link_conn_handles[idx]) {
+			return i;
+		}
+	}
+
+	TEST_FAIL_MESSAGE("No event for the peer");
+	return 0;
+}
+
+void test_scenario_discover_four_links(void)
+{
+	uint32_t nrf_err;
+	uint32_t evt_idx;
+	uint32_t srv_rec_count = 0;
+	const int new_peer = CONFIG_BLE_DB_DISCOVERY_LINK_COUNT;
+	/* The services of each peer are at different handles. */
+	const uint16_t srv1_start[] = {0x0010, 0x0020, 0x0030, 0x0040};
+	const uint16_t srv2_start[] = {0x0050, 0x0060, 0x0070, 0x0080};
+
+	memset(multi_link_req_count, 0, sizeof(multi_link_req_count));
+	__cmock_ble_gq_item_add_Stub(stub_ble_gq_item_add_scenario_multi_link);
+
+	nrf_err = ble_db_discovery_init(&db_discovery, &db_disc_config);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv1_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv2_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	/* Start the discovery of each peer. Each sends its first request right away. */
+	for (int i = 0; i < CONFIG_BLE_DB_DISCOVERY_LINK_COUNT; i++) {
+		__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+			&ble_gatt_queue, multi_link_conn_handles[i], NRF_SUCCESS);
+
+		nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[i]);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+		multi_link_srv_disc_req_check(i, &srv1_uuid, 1);
+	}
+
+	/* All links are in use. */
+	nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[new_peer]);
+	TEST_ASSERT_EQUAL(NRF_ERROR_BUSY, nrf_err);
+	nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[2]);
+	TEST_ASSERT_EQUAL(NRF_ERROR_BUSY, nrf_err);
+
+	/* Service 1 is found at each peer, answered in reverse order. */
+	for (int i = CONFIG_BLE_DB_DISCOVERY_LINK_COUNT - 1; i >= 0; i--) {
+		multi_link_prim_srvc_disc_rsp_send(i, &srv1_uuid, srv1_start[i]);
+
+		TEST_ASSERT_EQUAL(2, multi_link_req_count[i]);
+		TEST_ASSERT_EQUAL(BLE_GQ_REQ_CHAR_DISCOVERY, multi_link_last_req[i].type);
+		TEST_ASSERT_EQUAL(srv1_start[i], multi_link_last_req[i].gattc_char_disc.start_handle);
+		TEST_ASSERT_EQUAL(srv1_start[i] + 2,
+				  multi_link_last_req[i].gattc_char_disc.end_handle);
+	}
+
+	/* The characteristic of service 1, then service 2 is discovered at each peer. */
+	for (int i = 0; i < CONFIG_BLE_DB_DISCOVERY_LINK_COUNT; i++) {
+		multi_link_char_disc_rsp_send(i, srv1_start[i]);
+		multi_link_srv_disc_req_check(i, &srv2_uuid, 3);
+	}
+
+	/* Service 2 is found at peers 0 and 2 only. Peers 1 and 3 are done. */
+	multi_link_prim_srvc_disc_rsp_send(3, NULL, 0);
+	multi_link_prim_srvc_disc_rsp_send(2, &srv2_uuid, srv2_start[2]);
+	multi_link_prim_srvc_disc_rsp_send(1, NULL, 0);
+	multi_link_prim_srvc_disc_rsp_send(0, &srv2_uuid, srv2_start[0]);
+	TEST_ASSERT_EQUAL(6, db_disc_evt_count);
+	TEST_ASSERT_EQUAL(4, multi_link_req_count[0]);
+	TEST_ASSERT_EQUAL(3, multi_link_req_count[1]);
+	TEST_ASSERT_EQUAL(4, multi_link_req_count[2]);
+	TEST_ASSERT_EQUAL(3, multi_link_req_count[3]);
+
+	/* A new peer takes the link and the service records of a peer that is done, while
+	 * peers 0 and 2 are still being discovered.
+	 */
+	__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+		&ble_gatt_queue, multi_link_conn_handles[new_peer], NRF_SUCCESS);
+
+	nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[new_peer]);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	multi_link_srv_disc_req_check(new_peer, &srv1_uuid, 1);
+
+	multi_link_char_disc_rsp_send(2, srv2_start[2]);
+	multi_link_char_disc_rsp_send(0, srv2_start[0]);
+	TEST_ASSERT_EQUAL(12, db_disc_evt_count);
+
+	/* Each peer got the result of its own discovery, then an available event. */
+	for (int i = 0; i < CONFIG_BLE_DB_DISCOVERY_LINK_COUNT; i++) {
+		evt_idx = multi_link_evt_idx_get(i);
+
+		TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_COMPLETE, db_disc_evt[evt_idx].evt_type);
+		TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv1_uuid, &db_disc_srv[evt_idx].srv_uuid));
+		TEST_ASSERT_EQUAL(srv1_start[i], db_disc_srv[evt_idx].handle_range.start_handle);
+		TEST_ASSERT_EQUAL(1, db_disc_srv[evt_idx].char_count);
+		TEST_ASSERT_EQUAL(srv1_start[i] + 2,
+				  db_disc_srv[evt_idx].characteristics[0].characteristic.handle_value);
+
+		evt_idx++;
+		TEST_ASSERT_EQUAL(multi_link_conn_handles[i], db_disc_evt[evt_idx].conn_handle);
+		if ((i % 2) == 0) {
+			TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_COMPLETE, db_disc_evt[evt_idx].evt_type);
+			TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv2_uuid, &db_disc_srv[evt_idx].srv_uuid));
+			TEST_ASSERT_EQUAL(srv2_start[i],
+					  db_disc_srv[evt_idx].handle_range.start_handle);
+		} else {
+			TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_SRV_NOT_FOUND,
+					  db_disc_evt[evt_idx].evt_type);
+			TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv2_uuid, &db_disc_evt[evt_idx].srv_uuid));
+		}
+
+		evt_idx++;
+		TEST_ASSERT_EQUAL(multi_link_conn_handles[i], db_disc_evt[evt_idx].conn_handle);
+		TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_AVAILABLE, db_disc_evt[evt_idx].evt_type);
+	}
+
+	/* Only the new peer holds service records. */
+	for (int i = 0; i < CONFIG_BLE_DB_DISCOVERY_LINK_COUNT; i++) {
+		srv_rec_count += db_discovery.links[i].srv_rec_count;
+	}
+	TEST_ASSERT_EQUAL(2, srv_rec_count);
+}
+
+void test_scenario_srv_pool_exhausted(void)
+{
+	uint32_t nrf_err;
+	ble_evt_t evt;
+
+	memset(multi_link_req_count, 0, sizeof(multi_link_req_count));
+	__cmock_ble_gq_item_add_Stub(stub_ble_gq_item_add_scenario_multi_link);
+
+	nrf_err = ble_db_discovery_init(&db_discovery, &db_disc_config);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv1_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv2_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	nrf_err = ble_db_discovery_service_register(&db_discovery, &srv3_uuid);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	/* The pool holds the three services of two peers. */
+	for (int i = 0; i < 2; i++) {
+		__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+			&ble_gatt_queue, multi_link_conn_handles[i], NRF_SUCCESS);
+
+		nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[i]);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+
+	__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+		&ble_gatt_queue, multi_link_conn_handles[2], NRF_SUCCESS);
+
+	nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[2]);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, nrf_err);
+	TEST_ASSERT_EQUAL(0, multi_link_req_count[2]);
+
+	/* Peer 0 disconnects, its records can be taken by peer 2. */
+	evt = (ble_evt_t) {
+		.header.evt_id = BLE_GAP_EVT_DISCONNECTED,
+		.evt.gap_evt = {
+			.conn_handle = multi_link_conn_handles[0],
+			.params.disconnected = {
+				.reason = BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION,
+			},
+		},
+	};
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+
+	__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+		&ble_gatt_queue, multi_link_conn_handles[2], NRF_SUCCESS);
+
+	nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[2]);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	multi_link_srv_disc_req_check(2, &srv1_uuid, 1);
+
+	/* Peer 1 is not affected. */
+	multi_link_prim_srvc_disc_rsp_send(1, NULL, 0);
+	multi_link_srv_disc_req_check(1, &srv2_uuid, 2);
+	TEST_ASSERT_EQUAL(0, db_disc_evt_count);
+}
+
+void test_scenario_cache_store(void)
+{
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	/* No services are stored for the peer yet. */
+	scenario_cache_start();
+
+	/* The Database Hash is read, the services are discovered. */
+	db_hash_read_rsp_evt_send(BLE_GATT_STATUS_SUCCESS, test_db_hash);
+	TEST_ASSERT_EQUAL(2, stub_ble_gq_item_add_success_num_calls);
+
+	scenario_cache_discover();
+
+	TEST_ASSERT_EQUAL(3, db_disc_evt_count);
+	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_COMPLETE, db_disc_evt[0].evt_type);
+	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_SRV_NOT_FOUND, db_disc_evt[1].evt_type);
+	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_AVAILABLE, db_disc_evt[2].evt_type);
+
+	/* The services are stored with the Database Hash. */
+	TEST_ASSERT_EQUAL(1, pm_peer_data_store_num_calls);
+	TEST_ASSERT_EQUAL(CACHE_RECORD_LEN, test_record_len);
+	TEST_ASSERT_EQUAL_MEMORY(test_db_hash, test_record.db_hash, sizeof(test_db_hash));
+	TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv1_uuid, &test_record.services[0].srv_uuid));
+	TEST_ASSERT_EQUAL(1, test_record.services[0].char_count);
+	TEST_ASSERT_EQUAL(0x0001, test_record.services[0].handle_range.start_handle);
+	TEST_ASSERT_EQUAL(0x0003, test_record.services[0].handle_range.end_handle);
+	TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv2_uuid, &test_record.services[1].srv_uuid));
+	TEST_ASSERT_EQUAL(BLE_GATT_HANDLE_INVALID,
+			  test_record.services[1].handle_range.start_handle);
+
+	/* The records are kept for the write, together with the one holding the hash. */
+	TEST_ASSERT_EQUAL(0, db_discovery.links[0].srv_rec_count);
+	TEST_ASSERT_EQUAL(test_peer_id, db_discovery.cache_stores[0].peer_id);
+	TEST_ASSERT_EQUAL(3, db_discovery.cache_stores[0].srv_rec_count);
+#else
+	TEST_IGNORE();
+#endif
+}
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+static void pm_peer_data_update_evt_send(uint16_t peer_id, enum pm_peer_data_id data_id,
+					 bool success)
+{
+	struct pm_evt evt = {
+		.evt_id = success ? PM_EVT_PEER_DATA_UPDATE_SUCCEEDED :
+				    PM_EVT_PEER_DATA_UPDATE_FAILED,
+		.peer_id = peer_id,
+	};
+
+	if (success) {
+		evt.peer_data_update_succeeded.data_id = data_id;
+		evt.peer_data_update_succeeded.action = PM_PEER_DATA_OP_UPDATE;
+	} else {
+		evt.peer_data_update_failed.data_id = data_id;
+		evt.peer_data_update_failed.action = PM_PEER_DATA_OP_UPDATE;
+	}
+
+	ble_db_discovery_on_pm_evt(&db_discovery, &evt);
+}
+#endif
+
+void test_scenario_cache_store_disconnect(void)
+{
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	uint32_t nrf_err;
+	ble_evt_t evt;
+
+	scenario_cache_start();
+	db_hash_read_rsp_evt_send(BLE_GATT_STATUS_SUCCESS, test_db_hash);
+	scenario_cache_discover();
+	TEST_ASSERT_EQUAL(1, pm_peer_data_store_num_calls);
+
+	/* The peer disconnects before the services are written. */
+	evt = (ble_evt_t) {
+		.header.evt_id = BLE_GAP_EVT_DISCONNECTED,
+		.evt.gap_evt = {
+			.conn_handle = test_conn_handle,
+			.params.disconnected = {
+				.reason = BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION,
+			},
+		},
+	};
+	ble_db_discovery_on_ble_evt(&evt, &db_discovery);
+	TEST_ASSERT_EQUAL(3, db_discovery.cache_stores[0].srv_rec_count);
+
+	/* Other peers take the remaining records of the pool, not the ones being written. */
+	memset(multi_link_req_count, 0, sizeof(multi_link_req_count));
+	__cmock_ble_gq_item_add_Stub(stub_ble_gq_item_add_scenario_multi_link);
+
+	for (int i = 0; i < 3; i++) {
+		__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+			&ble_gatt_queue, multi_link_conn_handles[i], NRF_SUCCESS);
+
+		nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[i]);
+		TEST_ASSERT_EQUAL((i < 2) ? NRF_SUCCESS : NRF_ERROR_NO_MEM, nrf_err);
+	}
+
+	TEST_ASSERT_EQUAL(3, db_discovery.links[0].srv_rec_idx);
+	TEST_ASSERT_EQUAL(5, db_discovery.links[1].srv_rec_idx);
+	TEST_ASSERT_EQUAL_MEMORY(test_db_hash, test_record.db_hash, sizeof(test_db_hash));
+
+	/* Events of other stores do not return the records. */
+	pm_peer_data_update_evt_send(test_peer_id, PM_PEER_DATA_ID_BONDING, true);
+	pm_peer_data_update_evt_send(test_peer_id + 1, PM_PEER_DATA_ID_GATT_REMOTE, true);
+	TEST_ASSERT_EQUAL(3, db_discovery.cache_stores[0].srv_rec_count);
+
+	/* The records are returned once the write is complete, whatever its result. */
+	pm_peer_data_update_evt_send(test_peer_id, PM_PEER_DATA_ID_GATT_REMOTE, false);
+	TEST_ASSERT_EQUAL(0, db_discovery.cache_stores[0].srv_rec_count);
+
+	__cmock_ble_gq_conn_handle_register_ExpectAndReturn(
+		&ble_gatt_queue, multi_link_conn_handles[2], NRF_SUCCESS);
+
+	nrf_err = ble_db_discovery_start(&db_discovery, multi_link_conn_handles[2]);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(0, db_discovery.links[2].srv_rec_idx);
+#else
+	TEST_IGNORE();
+#endif
+}
+
+void test_scenario_cache_restore(void)
+{
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	/* Services stored in an earlier connection. */
+	memset(&test_record, 0, sizeof(test_record));
+	memcpy(test_record.db_hash, test_db_hash, sizeof(test_db_hash));
+	test_record.services[0] = (struct ble_gatt_db_srv) {
+		.srv_uuid = srv1_uuid,
+		.char_count = 1,
+		.handle_range = {.start_handle = 0x0001, .end_handle = 0x0003},
+		.characteristics[0] = {
+			.characteristic = {
+				.uuid = srv1_char1_uuid,
+				.handle_decl = 0x0002,
+				.handle_value = 0x0003,
+			},
+			.cccd_handle = BLE_GATT_HANDLE_INVALID,
+		},
+	};
+	test_record.services[1].srv_uuid = srv2_uuid;
+	test_record_len = CACHE_RECORD_LEN;
+
+	scenario_cache_start();
+
+	/* The Database Hash is unchanged, the services are restored without discovery. */
+	db_hash_read_rsp_evt_send(BLE_GATT_STATUS_SUCCESS, test_db_hash);
+	TEST_ASSERT_EQUAL(1, stub_ble_gq_item_add_success_num_calls);
+	TEST_ASSERT_EQUAL(0, pm_peer_data_store_num_calls);
+
+	TEST_ASSERT_EQUAL(3, db_disc_evt_count);
+	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_COMPLETE, db_disc_evt[0].evt_type);
+	TEST_ASSERT_EQUAL(test_conn_handle, db_disc_evt[0].conn_handle);
+	TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv1_uuid, &db_disc_srv[0].srv_uuid));
+	TEST_ASSERT_EQUAL(1, db_disc_srv[0].char_count);
+	TEST_ASSERT_EQUAL(0x0003, db_disc_srv[0].handle_range.end_handle);
+	TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv1_char1_uuid,
+				     &db_disc_srv[0].characteristics[0].characteristic.uuid));
+	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_SRV_NOT_FOUND, db_disc_evt[1].evt_type);
+	TEST_ASSERT_TRUE(BLE_UUID_EQ(&srv2_uuid, &db_disc_evt[1].srv_uuid));
+	TEST_ASSERT_EQUAL(BLE_DB_DISCOVERY_AVAILABLE, db_disc_evt[2].evt_type);
+
+	/* Nothing is stored, the service records are returned to the pool. */
+	TEST_ASSERT_FALSE(db_discovery.links[0].discovery_in_progress);
+	TEST_ASSERT_EQUAL(0, db_discovery.links[0].srv_rec_count);
+#else
+	TEST_IGNORE();
+#endif
+}
+
+void test_scenario_cache_db_hash_changed(void)
+{
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	/* Services stored in an earlier connection, before the database of the peer changed. */
+	memset(&test_record, 0, sizeof(test_record));
+	test_record.services[0].srv_uuid = srv1_uuid;
+	test_record.services[1].srv_uuid = srv2_uuid;
+	test_record_len = CACHE_RECORD_LEN;
+
+	scenario_cache_start();
+
+	/* The Database Hash has changed, the services are discovered and stored again. */
+	db_hash_read_rsp_evt_send(BLE_GATT_STATUS_SUCCESS, test_db_hash);
+	TEST_ASSERT_EQUAL(2, stub_ble_gq_item_add_success_num_calls);
+
+	scenario_cache_discover();
+
+	TEST_ASSERT_EQUAL(3, db_disc_evt_count);
+	TEST_ASSERT_EQUAL(1, pm_peer_data_store_num_calls);
+	TEST_ASSERT_EQUAL_MEMORY(test_db_hash, test_record.db_hash, sizeof(test_db_hash));
+	TEST_ASSERT_EQUAL(0x0003, test_record.services[0].handle_range.end_handle);
+#else
+	TEST_IGNORE();
+#endif
+}
+
+void test_scenario_cache_no_db_hash(void)
+{
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	scenario_cache_start();
+
+	/* The peer has no Database Hash, the services are discovered but not stored. */
+	db_hash_read_rsp_evt_send(BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND, NULL);
+	TEST_ASSERT_EQUAL(2, stub_ble_gq_item_add_success_num_calls);
+
+	scenario_cache_discover();
+
+	TEST_ASSERT_EQUAL(3, db_disc_evt_count);
+	TEST_ASSERT_EQUAL(0, pm_peer_data_store_num_calls);
+	TEST_ASSERT_EQUAL(0, db_discovery.links[0].srv_rec_count);
+#else
+	TEST_IGNORE();
+#endif
+}
+
 void setUp(void)
 {
 	/* Zero the database discovery instance before each test. */
@@ -2006,6 +2704,14 @@ void setUp(void)
 	test_conn_handle++;
 
 	stub_ble_gq_item_add_success_num_calls = -1;
+
+#if defined(CONFIG_BLE_DB_DISCOVERY_CACHE)
+	/* The peer is not bonded unless the test says otherwise. */
+	test_peer_id = PM_PEER_ID_INVALID;
+	test_record_len = 0;
+	pm_peer_data_store_num_calls = 0;
+	__cmock_pm_peer_id_get_Stub(stub_pm_peer_id_get);
+#endif
 }
 void tearDown(void)
 {
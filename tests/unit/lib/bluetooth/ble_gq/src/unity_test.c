@@ -7,7 +7,9 @@
 #include <unity.h>
 #include <nrf_error.h>
 #include <stdint.h>
+#include <string.h>
 #include <bm/bluetooth/ble_gq.h>
+#include <zephyr/sys/printk.h>
 #include <zephyr/sys/util.h>
 
 #include "cmock_ble_gattc.h"
@@ -30,6 +32,8 @@
 #define BLE_GQ_HEAP_SIZE 1024
 
 BLE_GQ_CUSTOM_DEF(ble_gq, MAX_CONNS, BLE_GQ_HEAP_SIZE, MAX_CONNS * BLE_GQ_QUEUE_SIZE);
+/* Instance whose heap cannot hold the data of a long request. */
+BLE_GQ_CUSTOM_DEF(ble_gq_small_heap, 1, 128, BLE_GQ_QUEUE_SIZE + 1);
 
 static const uint16_t conn_handles[] = {LISTIFY(MAX_CONNS, CONN_HANDLE_FUNC, (,))};
 static uint16_t glob_conn_handle;
@@ -37,6 +41,20 @@ static uint32_t glob_error;
 static int stub_sd_ble_gattc_write_busy_busy_success_num_calls;
 static int stub_sd_ble_gatts_hvx_busy_busy_success_num_calls;
 
+/* SoftDevice TX queue model, for notifications and write commands. */
+#define SD_TX_QUEUE_SIZE 3
+static struct {
+	/* Packets in the TX queue, not yet transmitted. */
+	uint32_t queued;
+	/* Packets transmitted. */
+	uint32_t sent;
+	/* Calls to the SoftDevice, and calls that found the TX queue full. */
+	uint32_t calls;
+	uint32_t resources;
+	/* Packets of other users of the TX queue. */
+	uint32_t other;
+} sd_tx;
+
 static void ble_gq_error_handler(const struct ble_gq_req *req, struct ble_gq_evt *evt)
 {
 	glob_conn_handle = evt->conn_handle;
@@ -114,6 +132,59 @@ static uint32_t stub_sd_ble_gatts_hvx_busy_busy_success(
 	}
 }
 
+static uint32_t sd_tx_queue_put(void)
+{
+	sd_tx.calls++;
+
+	if (sd_tx.queued + sd_tx.other == SD_TX_QUEUE_SIZE) {
+		sd_tx.resources++;
+		return NRF_ERROR_RESOURCES;
+	}
+
+	sd_tx.queued++;
+	return NRF_SUCCESS;
+}
+
+static uint32_t stub_sd_ble_gatts_hvx_tx_queue(
+	uint16_t conn_handle, const ble_gatts_hvx_params_t *p_hvx_params, int cmock_num_calls)
+{
+	TEST_ASSERT_EQUAL(CONN_HANDLE_1, conn_handle);
+	TEST_ASSERT_EQUAL(BLE_GATT_HVX_NOTIFICATION, p_hvx_params->type);
+
+	return sd_tx_queue_put();
+}
+
+static uint32_t stub_sd_ble_gattc_write_tx_queue(
+	uint16_t conn_handle, const ble_gattc_write_params_t *p_write_params, int cmock_num_calls)
+{
+	TEST_ASSERT_EQUAL(CONN_HANDLE_1, conn_handle);
+	TEST_ASSERT_EQUAL(BLE_GATT_OP_WRITE_CMD, p_write_params->write_op);
+
+	return sd_tx_queue_put();
+}
+
+/* Transmit up to count packets of the TX queue, and send the TX complete event. */
+static void sd_tx_complete(uint16_t evt_id, uint32_t count)
+{
+	ble_evt_t ble_evt = {
+		.header.evt_id = evt_id,
+	};
+
+	count = MIN(count, sd_tx.queued);
+	sd_tx.queued -= count;
+	sd_tx.sent += count;
+
+	if (evt_id == BLE_GATTS_EVT_HVN_TX_COMPLETE) {
+		ble_evt.evt.gatts_evt.conn_handle = CONN_HANDLE_1;
+		ble_evt.evt.gatts_evt.params.hvn_tx_complete.count = count;
+	} else {
+		ble_evt.evt.gattc_evt.conn_handle = CONN_HANDLE_1;
+		ble_evt.evt.gattc_evt.params.write_cmd_tx_complete.count = count;
+	}
+
+	ble_gq_on_ble_evt(&ble_evt, (void *)&ble_gq);
+}
+
 void test_ble_gq_conn_handle_register_error_null(void)
 {
 	uint32_t nrf_err = ble_gq_conn_handle_register(NULL, 0);
@@ -227,6 +298,34 @@ void test_ble_gq_item_add_req_gatt_read_busy_success(void)
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
 }
 
+void test_ble_gq_item_add_req_gatt_read_by_uuid_success(void)
+{
+	uint32_t nrf_err;
+	ble_uuid_t uuid = {.uuid = 0x2B2A, .type = BLE_UUID_TYPE_BLE};
+	ble_gattc_handle_range_t handle_range = {.start_handle = 0x0001, .end_handle = 0xFFFF};
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_GATTC_READ_BY_UUID,
+		.evt_handler = ble_gq_error_handler,
+		.gattc_read_by_uuid = {
+			.uuid = uuid,
+			.handle_range = handle_range,
+		},
+	};
+
+	nrf_err = ble_gq_conn_handle_register(&ble_gq, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	__cmock_sd_ble_gattc_char_value_by_uuid_read_ExpectWithArrayAndReturn(
+		CONN_HANDLE_1, &uuid, 1, &handle_range, 1, NRF_ERROR_BUSY);
+	__cmock_sd_ble_gattc_char_value_by_uuid_read_ExpectWithArrayAndReturn(
+		CONN_HANDLE_1, &uuid, 1, &handle_range, 1, NRF_SUCCESS);
+
+	nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(BLE_CONN_HANDLE_INVALID, glob_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
+}
+
 void test_ble_gq_item_add_req_gatt_read_busy_error(void)
 {
 	uint32_t nrf_err;
@@ -642,6 +741,271 @@ void test_ble_gq_on_ble_evt_disconnected_event_item_purge(void)
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
 }
 
+void test_ble_gq_item_add_req_gatts_hvx_pipelined(void)
+{
+	const uint32_t notifications = 16;
+	uint32_t nrf_err;
+	uint32_t conn_events = 0;
+	uint16_t len = sizeof(TEST_DATA_1);
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_GATTS_HVX,
+		.evt_handler = ble_gq_error_handler,
+		.gatts_hvx = {
+			.type = BLE_GATT_HVX_NOTIFICATION,
+			.handle = ATTR_HANDLE_1,
+			.p_data = TEST_DATA_1,
+			.p_len = &len,
+		},
+	};
+
+	nrf_err = ble_gq_conn_handle_register(&ble_gq, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_tx_queue);
+
+	for (uint32_t i = 0; i < notifications; i++) {
+		nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+
+	/* The TX queue is full, and known to be. Other events do not make the queue retry. */
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE, sd_tx.queued);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE + 1, sd_tx.calls);
+
+	ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GATTS_EVT_WRITE,
+		.evt.gatts_evt.conn_handle = CONN_HANDLE_1,
+	};
+
+	ble_gq_on_ble_evt(&ble_evt, (void *)&ble_gq);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE + 1, sd_tx.calls);
+
+	/* Each connection event transmits the whole TX queue, which is filled again. */
+	while (sd_tx.sent < notifications && conn_events < notifications) {
+		sd_tx_complete(BLE_GATTS_EVT_HVN_TX_COMPLETE, SD_TX_QUEUE_SIZE);
+		conn_events++;
+	}
+
+	printk("ble_gq: %u notifications in %u connection events, %u SoftDevice calls\n",
+	       sd_tx.sent, conn_events, sd_tx.calls);
+
+	TEST_ASSERT_EQUAL(notifications, sd_tx.sent);
+	TEST_ASSERT_EQUAL(DIV_ROUND_UP(notifications, SD_TX_QUEUE_SIZE), conn_events);
+	TEST_ASSERT_EQUAL(notifications + 1, sd_tx.calls);
+	TEST_ASSERT_EQUAL(1, sd_tx.resources);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
+}
+
+void test_ble_gq_item_add_req_gatt_write_cmd_tx_credits(void)
+{
+	uint32_t nrf_err;
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_GATTC_WRITE,
+		.evt_handler = ble_gq_error_handler,
+		.gattc_write = {
+			.write_op = BLE_GATT_OP_WRITE_CMD,
+			.handle = ATTR_HANDLE_1,
+			.len = sizeof(TEST_STRING_1),
+			.p_value = TEST_STRING_1,
+		},
+	};
+
+	nrf_err = ble_gq_conn_handle_register(&ble_gq, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	__cmock_sd_ble_gattc_write_Stub(stub_sd_ble_gattc_write_tx_queue);
+
+	for (uint32_t i = 0; i < SD_TX_QUEUE_SIZE + 2; i++) {
+		nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE + 1, sd_tx.calls);
+
+	/* One credit is returned, one write command is submitted. */
+	sd_tx_complete(BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE, 1);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE + 2, sd_tx.calls);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE, sd_tx.queued);
+
+	sd_tx_complete(BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE, SD_TX_QUEUE_SIZE);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE + 3, sd_tx.calls);
+	TEST_ASSERT_EQUAL(1, sd_tx.queued);
+	TEST_ASSERT_EQUAL(1, sd_tx.resources);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
+}
+
+void test_ble_gq_item_add_req_gatts_hvx_tx_credits_probe(void)
+{
+	uint32_t nrf_err;
+	uint16_t len = sizeof(TEST_DATA_1);
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_GATTS_HVX,
+		.evt_handler = ble_gq_error_handler,
+		.gatts_hvx = {
+			.type = BLE_GATT_HVX_NOTIFICATION,
+			.handle = ATTR_HANDLE_1,
+			.p_data = TEST_DATA_1,
+			.p_len = &len,
+		},
+	};
+
+	nrf_err = ble_gq_conn_handle_register(&ble_gq, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_tx_queue);
+
+	/* Another user holds packets of the TX queue when it is first found full. */
+	sd_tx.other = SD_TX_QUEUE_SIZE - 1;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+	TEST_ASSERT_EQUAL(1, sd_tx.queued);
+	TEST_ASSERT_EQUAL(1, sd_tx.resources);
+	TEST_ASSERT_EQUAL(1, ble_gq.conn_tx[0].hvn.size);
+
+	/* The other user stops. Until the next probe, one packet at a time is submitted. */
+	sd_tx.other = 0;
+
+	for (uint32_t i = 0; i < CONFIG_BLE_GQ_TX_PROBE_INTERVAL - 1; i++) {
+		sd_tx_complete(BLE_GATTS_EVT_HVN_TX_COMPLETE, 1);
+		TEST_ASSERT_EQUAL(1, sd_tx.queued);
+
+		nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+		TEST_ASSERT_EQUAL(1, sd_tx.queued);
+	}
+
+	for (uint32_t i = 0; i < SD_TX_QUEUE_SIZE; i++) {
+		nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+
+	/* The probe is accepted, and the TX queue is filled until it is full again. */
+	sd_tx_complete(BLE_GATTS_EVT_HVN_TX_COMPLETE, 1);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE, sd_tx.queued);
+	TEST_ASSERT_EQUAL(2, sd_tx.resources);
+	TEST_ASSERT_EQUAL(SD_TX_QUEUE_SIZE, ble_gq.conn_tx[0].hvn.size);
+
+	/* The whole TX queue is used from now on. */
+	sd_tx_complete(BLE_GATTS_EVT_HVN_TX_COMPLETE, SD_TX_QUEUE_SIZE);
+	TEST_ASSERT_EQUAL(1, sd_tx.queued);
+	TEST_ASSERT_EQUAL(2, sd_tx.resources);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
+}
+
+static uint8_t long_data[CONFIG_BLE_GQ_INLINE_DATA_SIZE + 200];
+static uint32_t stub_sd_ble_gattc_write_long_num_calls;
+
+static uint32_t stub_sd_ble_gattc_write_long_busy_success(
+	uint16_t conn_handle, const ble_gattc_write_params_t *p_write_params, int cmock_num_calls)
+{
+	stub_sd_ble_gattc_write_long_num_calls = cmock_num_calls + 1;
+
+	TEST_ASSERT_EQUAL(sizeof(long_data), p_write_params->len);
+	TEST_ASSERT_EQUAL_MEMORY(long_data, p_write_params->p_value, sizeof(long_data));
+
+	return (cmock_num_calls == 0) ? NRF_ERROR_BUSY : NRF_SUCCESS;
+}
+
+static uint32_t stub_sd_ble_gatts_hvx_busy(
+	uint16_t conn_handle, const ble_gatts_hvx_params_t *p_hvx_params, int cmock_num_calls)
+{
+	TEST_ASSERT_EQUAL(sizeof(TEST_DATA_1), *(p_hvx_params->p_len));
+	TEST_ASSERT_EQUAL_MEMORY(TEST_DATA_1, p_hvx_params->p_data, sizeof(TEST_DATA_1));
+
+	return NRF_ERROR_BUSY;
+}
+
+void test_ble_gq_item_add_inline_data_no_heap(void)
+{
+	uint32_t nrf_err;
+	uint16_t len = sizeof(TEST_DATA_1);
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_GATTS_HVX,
+		.evt_handler = ble_gq_error_handler,
+		.gatts_hvx = {
+			.type = BLE_GATT_HVX_INDICATION,
+			.handle = ATTR_HANDLE_1,
+			.offset = TEST_OFFSET_1,
+			.p_data = TEST_DATA_1,
+			.p_len = &len,
+		},
+	};
+
+	nrf_err = ble_gq_conn_handle_register(&ble_gq_small_heap, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_busy);
+
+	for (uint32_t i = 0; i < BLE_GQ_QUEUE_SIZE; i++) {
+		nrf_err = ble_gq_item_add(&ble_gq_small_heap, &req, CONN_HANDLE_1);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+
+	/* The data is held by the request blocks, not the heap. A long write needs the heap. */
+	req = (struct ble_gq_req) {
+		.type = BLE_GQ_REQ_GATTC_WRITE,
+		.evt_handler = ble_gq_error_handler,
+		.gattc_write = {
+			.handle = ATTR_HANDLE_1,
+			.len = sizeof(long_data),
+			.p_value = long_data,
+		},
+	};
+
+	__cmock_sd_ble_gattc_write_Stub(NULL);
+	nrf_err = ble_gq_item_add(&ble_gq_small_heap, &req, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, nrf_err);
+
+	/* Deregister the connection to free the request blocks. */
+	ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GAP_EVT_DISCONNECTED,
+		.evt.gap_evt.conn_handle = CONN_HANDLE_1,
+	};
+
+	ble_gq_on_ble_evt(&ble_evt, (void *)&ble_gq_small_heap);
+	nrf_err = ble_gq_conn_handle_register(&ble_gq_small_heap, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+}
+
+void test_ble_gq_item_add_req_gatt_write_long_busy_success(void)
+{
+	uint32_t nrf_err;
+	struct ble_gq_req req = {
+		.type = BLE_GQ_REQ_GATTC_WRITE,
+		.evt_handler = ble_gq_error_handler,
+		.gattc_write = {
+			.handle = ATTR_HANDLE_1,
+			.len = sizeof(long_data),
+			.p_value = long_data,
+		},
+	};
+
+	for (size_t i = 0; i < sizeof(long_data); i++) {
+		long_data[i] = i;
+	}
+
+	nrf_err = ble_gq_conn_handle_register(&ble_gq, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	__cmock_sd_ble_gattc_write_Stub(stub_sd_ble_gattc_write_long_busy_success);
+
+	/* Data longer than CONFIG_BLE_GQ_INLINE_DATA_SIZE is stored in the heap. */
+	nrf_err = ble_gq_item_add(&ble_gq, &req, CONN_HANDLE_1);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GATTC_EVT_WRITE_RSP,
+		.evt.gattc_evt.conn_handle = CONN_HANDLE_1,
+	};
+
+	ble_gq_on_ble_evt(&ble_evt, (void *)&ble_gq);
+
+	TEST_ASSERT_EQUAL(2, stub_sd_ble_gattc_write_long_num_calls);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, glob_error);
+}
+
 void setUp(void)
 {
 	ble_evt_t ble_evt = {
@@ -658,6 +1022,7 @@ void setUp(void)
 	glob_error = NRF_SUCCESS;
 
 	stub_sd_ble_gattc_write_busy_busy_success_num_calls = 0;
+	memset(&sd_tx, 0, sizeof(sd_tx));
 }
 
 extern int unity_main(void);
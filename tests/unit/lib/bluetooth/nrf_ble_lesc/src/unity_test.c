@@ -13,6 +13,9 @@
 #include "cmock_nrf_sdh_ble.h"
 
 #include <bm/bluetooth/peer_manager/nrf_ble_lesc.h>
+#if defined(CONFIG_BM_SCHEDULER)
+#include <bm/bm_scheduler.h>
+#endif
 
 #define PTR_IGNORE NULL
 #define VAL_IGNORE 0
@@ -740,10 +743,195 @@ void test_nrf_ble_lesc_compute_and_give_dhkey_with_disconnect(void)
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 }
 
+static struct nrf_ble_lesc_dhkey_result dhkey_results[2];
+static uint32_t dhkey_results_count;
+
+static void dhkey_handler(const struct nrf_ble_lesc_dhkey_result *result)
+{
+	TEST_ASSERT_TRUE(dhkey_results_count < ARRAY_SIZE(dhkey_results));
+	dhkey_results[dhkey_results_count++] = *result;
+}
+
+#if defined(CONFIG_BM_SCHEDULER)
+static psa_status_t stub_psa_generate_key_any_failure(
+	const psa_key_attributes_t *attributes, mbedtls_svc_key_id_t *key, int cmock_num_calls)
+{
+	ARG_UNUSED(attributes);
+	ARG_UNUSED(key);
+	ARG_UNUSED(cmock_num_calls);
+
+	return PSA_ERROR_BAD_STATE;
+}
+
+/* Process the scheduled events, failing any key pair generation for the key pool. */
+static void scheduler_process_without_key_pool(void)
+{
+	key_attrs = NULL;
+
+	__cmock_psa_set_key_usage_flags_Stub(stub_psa_set_key_usage_flags);
+	__cmock_psa_set_key_lifetime_Stub(stub_psa_set_key_lifetime);
+	__cmock_psa_set_key_algorithm_Stub(stub_psa_set_key_algorithm);
+	__cmock_psa_set_key_type_Stub(stub_psa_set_key_type);
+	__cmock_psa_set_key_bits_Stub(stub_psa_set_key_bits);
+	__cmock_psa_generate_key_Stub(stub_psa_generate_key_any_failure);
+
+	TEST_ASSERT_EQUAL(0, bm_scheduler_process());
+
+	__cmock_psa_set_key_usage_flags_Stub(NULL);
+	__cmock_psa_set_key_lifetime_Stub(NULL);
+	__cmock_psa_set_key_algorithm_Stub(NULL);
+	__cmock_psa_set_key_type_Stub(NULL);
+	__cmock_psa_set_key_bits_Stub(NULL);
+	__cmock_psa_generate_key_Stub(NULL);
+
+	key_attrs = NULL;
+}
+#endif
+
+void test_nrf_ble_lesc_dhkey_handler_multiple_links(void)
+{
+	uint32_t nrf_err;
+	const uint16_t conn_handles[] = {0x32, 0x33};
+	ble_gap_lesc_p256_pk_t peer_lesc_key;
+	ble_evt_t evt = {
+		.header = {
+			.evt_id = BLE_GAP_EVT_LESC_DHKEY_REQUEST,
+		},
+		.evt.gap_evt.params.lesc_dhkey_request.p_pk_peer = &peer_lesc_key,
+	};
+	memcpy(peer_lesc_key.pk, peer_test_pub_key_sd, sizeof(peer_test_pub_key_sd));
+
+	generate_key_pair();
+
+	nrf_ble_lesc_dhkey_handler_set(dhkey_handler);
+
+	/* Two peers request a DH key at the same time. */
+	for (int i = 0; i < ARRAY_SIZE(conn_handles); i++) {
+		evt.evt.gap_evt.conn_handle = conn_handles[i];
+		__cmock_nrf_sdh_ble_idx_get_ExpectAndReturn(conn_handles[i], i);
+
+		/* Invoke on_dhkey_request(). */
+		nrf_ble_lesc_on_ble_evt(&evt);
+	}
+
+	TEST_ASSERT_EQUAL(0, dhkey_results_count);
+
+	__cmock_psa_raw_key_agreement_Stub(stub_psa_raw_key_agreement_success);
+	for (int i = 0; i < ARRAY_SIZE(conn_handles); i++) {
+		__cmock_sd_ble_gap_lesc_dhkey_reply_ExpectAndReturn(
+			conn_handles[i], BLE_GAP_SEC_STATUS_SUCCESS, PTR_IGNORE, VAL_IGNORE);
+		__cmock_sd_ble_gap_lesc_dhkey_reply_IgnoreArg_p_dhkey();
+	}
+	__cmock_sd_ble_gap_lesc_dhkey_reply_AddCallback(
+		callback_sd_ble_gap_lesc_dhkey_reply_success);
+
+#if defined(CONFIG_PM_LESC_DHKEY_DEFERRED)
+	/* Each DH key is computed in its own scheduler event. */
+	scheduler_process_without_key_pool();
+	TEST_ASSERT_EQUAL(ARRAY_SIZE(conn_handles), dhkey_results_count);
+#endif
+
+	/* Invoke compute_and_give_dhkey(), if the DH keys were not computed yet. */
+	nrf_err = nrf_ble_lesc_request_handler();
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	TEST_ASSERT_EQUAL(ARRAY_SIZE(conn_handles), dhkey_results_count);
+	for (int i = 0; i < ARRAY_SIZE(conn_handles); i++) {
+		TEST_ASSERT_EQUAL(conn_handles[i], dhkey_results[i].conn_handle);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, dhkey_results[i].nrf_err);
+		TEST_ASSERT_TRUE(dhkey_results[i].compute_us <= dhkey_results[i].latency_us);
+	}
+}
+
+static const mbedtls_svc_key_id_t pool_key_pair_id = 0x2B;
+
+static psa_status_t stub_psa_generate_key_pool(
+	const psa_key_attributes_t *attributes, mbedtls_svc_key_id_t *key, int cmock_num_calls)
+{
+	ARG_UNUSED(cmock_num_calls);
+
+	TEST_ASSERT_NOT_NULL(attributes);
+	TEST_ASSERT_EQUAL_PTR(key_attrs, attributes);
+
+	TEST_ASSERT_NOT_NULL(key);
+	*key = pool_key_pair_id;
+
+	return PSA_SUCCESS;
+}
+
+static psa_status_t stub_psa_export_public_key_pool(mbedtls_svc_key_id_t key,
+	uint8_t *data, size_t data_size, size_t *data_length, int cmock_num_calls)
+{
+	ARG_UNUSED(cmock_num_calls);
+
+	TEST_ASSERT_EQUAL(pool_key_pair_id, key);
+	TEST_ASSERT_EQUAL(sizeof(peer_test_pub_key_psa), data_size);
+
+	/* Use the peer test key as the public key of the key pair in the pool. */
+	TEST_ASSERT_NOT_NULL(data);
+	memcpy(data, peer_test_pub_key_psa, sizeof(peer_test_pub_key_psa));
+
+	TEST_ASSERT_NOT_NULL(data_length);
+	*data_length = sizeof(peer_test_pub_key_psa);
+
+	return PSA_SUCCESS;
+}
+
+void test_nrf_ble_lesc_keypair_generate_from_key_pool(void)
+{
+#if defined(CONFIG_PM_LESC_KEY_POOL)
+	uint32_t nrf_err;
+	ble_gap_lesc_p256_pk_t *pub_key;
+
+	/* The pool is empty, so a key pair is generated right away. */
+	generate_key_pair();
+
+	/* The next key pair is generated from the scheduler. */
+	key_attrs = NULL;
+	__cmock_psa_set_key_usage_flags_Stub(stub_psa_set_key_usage_flags);
+	__cmock_psa_set_key_lifetime_Stub(stub_psa_set_key_lifetime);
+	__cmock_psa_set_key_algorithm_Stub(stub_psa_set_key_algorithm);
+	__cmock_psa_set_key_type_Stub(stub_psa_set_key_type);
+	__cmock_psa_set_key_bits_Stub(stub_psa_set_key_bits);
+	__cmock_psa_generate_key_Stub(stub_psa_generate_key_pool);
+	__cmock_psa_export_public_key_Stub(stub_psa_export_public_key_pool);
+
+	TEST_ASSERT_EQUAL(0, bm_scheduler_process());
+
+	__cmock_psa_set_key_usage_flags_Stub(NULL);
+	__cmock_psa_set_key_lifetime_Stub(NULL);
+	__cmock_psa_set_key_algorithm_Stub(NULL);
+	__cmock_psa_set_key_type_Stub(NULL);
+	__cmock_psa_set_key_bits_Stub(NULL);
+	__cmock_psa_generate_key_Stub(NULL);
+	__cmock_psa_export_public_key_Stub(NULL);
+
+	/* The key pair is taken from the pool, without generating one. */
+	__cmock_psa_destroy_key_ExpectAndReturn(key_pair_id, PSA_SUCCESS);
+
+	nrf_err = nrf_ble_lesc_keypair_generate();
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	pub_key = nrf_ble_lesc_public_key_get();
+	TEST_ASSERT_NOT_NULL(pub_key);
+	TEST_ASSERT_EQUAL_MEMORY(peer_test_pub_key_sd, pub_key->pk, sizeof(peer_test_pub_key_sd));
+#else
+	TEST_IGNORE();
+#endif
+}
+
 void tearDown(void)
 {
 	uint32_t nrf_err;
 
+#if defined(CONFIG_BM_SCHEDULER)
+	/* Run the scheduled events, leaving the key pool empty for the next test. */
+	scheduler_process_without_key_pool();
+#endif
+
+	nrf_ble_lesc_dhkey_handler_set(NULL);
+	dhkey_results_count = 0;
+
 	key_attrs = NULL;
 	oobd = NULL;
 
@@ -169,6 +169,47 @@ static int stub_bm_zms_mount_success(struct bm_zms_fs *fs, const struct bm_zms_f
 	return 0;
 }
 
+static int stub_bm_zms_iter_init(struct bm_zms_fs *fs, struct bm_zms_iter *iter,
+				 uint32_t id_mask, uint32_t id_prefix, int cmock_num_calls)
+{
+	ARG_UNUSED(cmock_num_calls);
+	TEST_ASSERT_EQUAL_PTR(zms_fs, fs);
+	TEST_ASSERT_NOT_NULL(iter);
+
+	/* Peer data is iterated over for a single data ID. */
+	TEST_ASSERT_EQUAL(0xFFFF, id_mask);
+
+	iter->id_mask = id_mask;
+	iter->id_prefix = id_prefix;
+	iter->addr = 0;
+
+	return 0;
+}
+
+static int stub_bm_zms_iter_next(struct bm_zms_fs *fs, struct bm_zms_iter *iter, uint32_t *id,
+				 int cmock_num_calls)
+{
+	ARG_UNUSED(cmock_num_calls);
+	TEST_ASSERT_EQUAL_PTR(zms_fs, fs);
+	TEST_ASSERT_NOT_NULL(iter);
+	TEST_ASSERT_NOT_NULL(id);
+
+	/* Return the entry of every peer ID in turn, the mocked reads of the entries tell
+	 * which of them hold data.
+	 */
+	if (iter->addr >= PM_PEER_ID_N_AVAILABLE_IDS) {
+		return -ENOENT;
+	}
+
+	*id = ((union pm_entry_id) {.peer_id = iter->addr, .data_id = iter->id_prefix}).id;
+	iter->addr++;
+
+	return 0;
+}
+
+/* Bonding data found in storage on pm_init, per peer ID. */
+static const struct pm_peer_data_bonding *pm_init_bonds[PM_PEER_ID_N_AVAILABLE_IDS];
+
 static ssize_t stub_bm_zms_read_pm_init(struct bm_zms_fs *fs, uint32_t id, void *data, size_t len,
 					int cmock_num_calls)
 {
@@ -190,8 +231,14 @@ static ssize_t stub_bm_zms_read_pm_init(struct bm_zms_fs *fs, uint32_t id, void
 		TEST_ASSERT_NOT_NULL(data);
 		TEST_ASSERT_EQUAL(PM_PEER_DATA_MAX_SIZE, len);
 
-		/* Return -ENOENT to signal that no data exists for this entry_id. */
-		ret = -ENOENT;
+		if (pm_init_bonds[entry.peer_id] != NULL) {
+			memcpy(data, pm_init_bonds[entry.peer_id],
+			       sizeof(struct pm_peer_data_bonding));
+			ret = sizeof(struct pm_peer_data_bonding);
+		} else {
+			/* Return -ENOENT to signal that no data exists for this entry_id. */
+			ret = -ENOENT;
+		}
 	} else {
 		TEST_FAIL();
 	}
@@ -383,6 +430,55 @@ void peer_manager_initialize_success(void)
 	__cmock_bm_timer_init_Stub(NULL);
 }
 
+/* Initialize the Peer Manager with bonding data for the given peer already in storage. */
+static void peer_manager_initialize_with_bond(uint16_t peer_id,
+					      const struct pm_peer_data_bonding *bonding_data)
+{
+	pm_init_bonds[peer_id] = bonding_data;
+
+	peer_manager_initialize_success();
+}
+
+/**
+ * Expect the bonds to be searched for a peer. Without the bond index, the search reads the
+ * bonding data of the peer IDs from storage in turn. With the bond index, the bonds are
+ * searched in RAM and storage is not read.
+ *
+ * @param stored_peer_id  Peer ID holding bonding data in storage.
+ * @param bonding_data    The bonding data of @p stored_peer_id, or NULL if storage holds no bonds.
+ * @param match           Whether the search stops at @p stored_peer_id.
+ */
+static void expect_bonding_data_search(uint16_t stored_peer_id,
+				       const struct pm_peer_data_bonding *bonding_data, bool match)
+{
+#if defined(CONFIG_PM_BOND_INDEX)
+	ARG_UNUSED(stored_peer_id);
+	ARG_UNUSED(bonding_data);
+	ARG_UNUSED(match);
+#else
+	union pm_entry_id entry = {.data_id = PM_PEER_DATA_ID_BONDING};
+
+	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
+		entry.peer_id = i;
+		if ((bonding_data != NULL) && (i == stored_peer_id)) {
+			__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
+							    PM_PEER_DATA_MAX_SIZE,
+							    sizeof(*bonding_data));
+			__cmock_bm_zms_read_IgnoreArg_data();
+			__cmock_bm_zms_read_ReturnMemThruPtr_data((void *)bonding_data,
+								  sizeof(*bonding_data));
+			if (match) {
+				return;
+			}
+		} else {
+			__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
+							    PM_PEER_DATA_MAX_SIZE, -ENOENT);
+			__cmock_bm_zms_read_IgnoreArg_data();
+		}
+	}
+#endif
+}
+
 #define PM_EVT_CAPTURE_MAX 16
 
 /* Helper context for modifying behavior of the on_pm_evt handler function. */
@@ -883,7 +979,6 @@ void test_pm_sec_params_set_invalid_param(void)
 
 void test_pm_ble_event_connected_not_bonded_success(void)
 {
-	union pm_entry_id entry;
 	ble_evt_t evt = {.evt.gap_evt.conn_handle = CONN_HANDLE_1};
 
 	peer_manager_initialize_success();
@@ -891,18 +986,10 @@ void test_pm_ble_event_connected_not_bonded_success(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded. However, no bonding data is found for a peer with the given address.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
 	evt.evt.gap_evt.params.connected = (ble_gap_evt_connected_t) {
@@ -924,25 +1011,16 @@ void test_pm_ble_event_connected_already_bonded_success(void)
 	};
 	union local_gatt_db_with_data local_gatt_db = STORED_GATT_DATA_1;
 
-	peer_manager_initialize_success();
+	peer_manager_initialize_with_bond(1, &bonding_data);
 
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded and if so, what peer ID is associated with the peer.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	entry.peer_id++;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, PM_PEER_DATA_MAX_SIZE);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data((void *)&bonding_data,
-						  sizeof(struct pm_peer_data_bonding));
+	expect_bonding_data_search(1, &bonding_data, true);
+	entry.peer_id = 1;
 
 	/* Expect a storage read looking for local gatt data for the connected peer,
 	 * followed by a restoration of the local gatt database in the SoftDevice.
@@ -982,6 +1060,127 @@ void test_pm_ble_event_connected_already_bonded_success(void)
 	sdh_evt_dispatch_ble(&evt);
 }
 
+/* Bonding data found in storage by bonded_peers_connect(). */
+static struct pm_peer_data_bonding stored_bonds[33];
+/* Number of bonding data reads from storage. */
+static uint32_t bonding_data_reads;
+
+static ssize_t stub_bm_zms_read_count_bonding(struct bm_zms_fs *fs, uint32_t id, void *data,
+					      size_t len, int cmock_num_calls)
+{
+	union pm_entry_id entry = {.id = id};
+
+	ARG_UNUSED(cmock_num_calls);
+	TEST_ASSERT_EQUAL_PTR(zms_fs, fs);
+
+	if (entry.data_id == PM_PEER_DATA_ID_CENTRAL_ADDR_RES) {
+		/* Central address resolution is known, it is not read from the peer. */
+		*(uint32_t *)data = 1;
+		return sizeof(uint32_t);
+	} else if (entry.data_id != PM_PEER_DATA_ID_BONDING) {
+		return -ENOENT;
+	}
+
+	bonding_data_reads++;
+
+	if ((entry.peer_id >= ARRAY_SIZE(stored_bonds)) ||
+	    (stored_bonds[entry.peer_id].own_role == BLE_GAP_ROLE_INVALID)) {
+		return -ENOENT;
+	}
+
+	TEST_ASSERT_TRUE(len >= sizeof(struct pm_peer_data_bonding));
+	memcpy(data, &stored_bonds[entry.peer_id], sizeof(struct pm_peer_data_bonding));
+
+	return sizeof(struct pm_peer_data_bonding);
+}
+
+/* Initialize the Peer Manager with the given number of bonds in storage, and connect the peer
+ * that was bonded last. Return the number of bonding data reads done to identify the peer.
+ */
+static uint32_t bonded_peers_connect(uint16_t bond_count)
+{
+	uint32_t nrf_err;
+	const struct pm_evt *pm_evt;
+	ble_evt_t evt = {.evt.gap_evt.conn_handle = CONN_HANDLE_1};
+	uint16_t last_peer_id = bond_count - 1;
+
+	TEST_ASSERT_TRUE(bond_count <= ARRAY_SIZE(stored_bonds));
+
+	memset(stored_bonds, 0, sizeof(stored_bonds));
+	for (uint16_t i = 0; i < bond_count; i++) {
+		stored_bonds[i] = (struct pm_peer_data_bonding) {
+			.own_role = BLE_GAP_ROLE_PERIPH,
+			.peer_ble_id.id_addr_info = ADDRESS_PUBLIC_1,
+		};
+		/* Give each peer its own address. */
+		stored_bonds[i].peer_ble_id.id_addr_info.addr[0] = i;
+		pm_init_bonds[i] = &stored_bonds[i];
+	}
+
+	peer_manager_initialize_success();
+	TEST_ASSERT_EQUAL(bond_count, pm_peer_count());
+
+	nrf_err = pm_register(&on_pm_evt);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	on_pm_evt_capture_restart();
+
+	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
+	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
+	__cmock_bm_zms_read_Stub(stub_bm_zms_read_count_bonding);
+	bonding_data_reads = 0;
+
+	/* No local GATT data is stored, expect the SoftDevice to be told that none exists. */
+	__cmock_sd_ble_gatts_sys_attr_set_ExpectAndReturn(CONN_HANDLE_1, NULL, 0,
+							  BLE_GATTS_SYS_ATTR_FLAG_SYS_SRVCS |
+							  BLE_GATTS_SYS_ATTR_FLAG_USR_SRVCS,
+							  NRF_SUCCESS);
+
+	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
+	evt.evt.gap_evt.params.connected = (ble_gap_evt_connected_t) {
+		.peer_addr = stored_bonds[last_peer_id].peer_ble_id.id_addr_info,
+		.role = BLE_GAP_ROLE_PERIPH,
+	};
+
+	sdh_evt_dispatch_ble(&evt);
+
+	pm_evt = on_pm_evt_find_last(PM_EVT_BONDED_PEER_CONNECTED);
+	TEST_ASSERT_NOT_NULL(pm_evt);
+	TEST_ASSERT_EQUAL(last_peer_id, pm_evt->peer_id);
+
+	return bonding_data_reads;
+}
+
+/* With the bond index, bonded peers are identified without reading storage. Without it, the
+ * bonding data of every peer up to the connected one is read.
+ */
+void test_pm_ble_event_connected_8_bonds(void)
+{
+	TEST_ASSERT_EQUAL(IS_ENABLED(CONFIG_PM_BOND_INDEX) ? 0 : 8, bonded_peers_connect(8));
+}
+
+void test_pm_ble_event_connected_16_bonds(void)
+{
+	TEST_ASSERT_EQUAL(IS_ENABLED(CONFIG_PM_BOND_INDEX) ? 0 : 16, bonded_peers_connect(16));
+}
+
+void test_pm_ble_event_connected_32_bonds(void)
+{
+	TEST_ASSERT_EQUAL(IS_ENABLED(CONFIG_PM_BOND_INDEX) ? 0 : 32, bonded_peers_connect(32));
+}
+
+void test_pm_ble_event_connected_bond_index_full(void)
+{
+#if defined(CONFIG_PM_BOND_INDEX)
+	BUILD_ASSERT(CONFIG_PM_BOND_INDEX_SIZE < ARRAY_SIZE(stored_bonds));
+
+	/* The last bond does not fit in the index, so storage is searched up to it. */
+	TEST_ASSERT_EQUAL(CONFIG_PM_BOND_INDEX_SIZE + 1,
+			  bonded_peers_connect(CONFIG_PM_BOND_INDEX_SIZE + 1));
+#else
+	TEST_IGNORE();
+#endif
+}
+
 void test_pm_conn_secure_peripheral_pair_success(void)
 {
 	uint32_t nrf_err;
@@ -993,7 +1192,6 @@ void test_pm_conn_secure_peripheral_pair_success(void)
 		.kdist_own =  {.enc = 0, .id = 0},
 		.kdist_peer = {.enc = 0, .id = 0},
 	};
-	union pm_entry_id entry;
 	const struct pm_evt *pm_evt;
 	ble_evt_t evt = {.evt.gap_evt.conn_handle = CONN_HANDLE_1};
 
@@ -1009,18 +1207,10 @@ void test_pm_conn_secure_peripheral_pair_success(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded. However, no bonding data is found for a peer with the given address.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
 	evt.evt.gap_evt.params.connected = (ble_gap_evt_connected_t) {
@@ -1200,18 +1390,10 @@ void test_pm_conn_secure_peripheral_pair_and_bond_success(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded. However, no bonding data is found for a peer with the given address.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
 	evt.evt.gap_evt.params.connected = (ble_gap_evt_connected_t) {
@@ -1343,19 +1525,11 @@ void test_pm_conn_secure_peripheral_pair_and_bond_success(void)
 
 	/* On a BLE_GAP_EVT_AUTH_STATUS, expect peer manager to finish up the pairing request.
 	 *
-	 * Expect the bonding data storage to be iterated to check if the paired peer already have
+	 * Expect the bonds to be searched to check if the paired peer already have
 	 * bonding data. No duplicate bonding data is to be found.
 	 * Next, expect new bonding data to be stored.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
 	entry.peer_id = 0;
@@ -1412,7 +1586,7 @@ void test_pm_conn_secure_peripheral_with_bonding_data_success(void)
 	};
 	union local_gatt_db_with_data local_gatt_db = STORED_GATT_DATA_1;
 
-	peer_manager_initialize_success();
+	peer_manager_initialize_with_bond(1, &bonding_data);
 
 	nrf_err = pm_register(&on_pm_evt);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
@@ -1424,20 +1598,11 @@ void test_pm_conn_secure_peripheral_with_bonding_data_success(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded and if so, what peer ID is associated with the peer.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	entry.peer_id++;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, PM_PEER_DATA_MAX_SIZE);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data((void *)&bonding_data,
-						  sizeof(struct pm_peer_data_bonding));
+	expect_bonding_data_search(1, &bonding_data, true);
+	entry.peer_id = 1;
 
 	/* Expect a storage read looking for local gatt data for the connected peer,
 	 * followed by a restoration of the local gatt database in the SoftDevice.
@@ -1488,27 +1653,11 @@ void test_pm_conn_secure_peripheral_with_bonding_data_success(void)
 	TEST_ASSERT_EQUAL(3, on_pm_evt_test_ctx.capture.count);
 	on_pm_evt_capture_restart();
 
-	/* On a BLE_GAP_EVT_SEC_INFO_REQUEST event, expect the bonding data storage to be iterated
-	 * in search for a matching master ID. None found. Peer ID is found based on conn_handle.
+	/* On a BLE_GAP_EVT_SEC_INFO_REQUEST event, expect the bonds to be searched for a
+	 * matching master ID. None found. Peer ID is found based on conn_handle.
 	 * Next, expect a read of the stored bonding data based on the peer ID.
 	 */
-	entry = (union pm_entry_id) {.data_id = PM_PEER_DATA_ID_BONDING, .peer_id = 0};
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		if (i == 1) {
-			__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-							    PM_PEER_DATA_MAX_SIZE,
-							    PM_PEER_DATA_MAX_SIZE);
-			__cmock_bm_zms_read_IgnoreArg_data();
-			__cmock_bm_zms_read_ReturnMemThruPtr_data(
-				(void *)&bonding_data, sizeof(struct pm_peer_data_bonding));
-		} else {
-			__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-							    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-			__cmock_bm_zms_read_IgnoreArg_data();
-		}
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(1, &bonding_data, false);
 
 	entry = (union pm_entry_id) {.data_id = PM_PEER_DATA_ID_BONDING, .peer_id = 1};
 	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
@@ -1558,7 +1707,7 @@ void test_pm_conn_secure_peripheral_pair_again_with_bonding_data_present_success
 	};
 	union local_gatt_db_with_data local_gatt_db = STORED_GATT_DATA_1;
 
-	peer_manager_initialize_success();
+	peer_manager_initialize_with_bond(1, &bonding_data);
 
 	nrf_err = pm_register(&on_pm_evt);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
@@ -1570,20 +1719,11 @@ void test_pm_conn_secure_peripheral_pair_again_with_bonding_data_present_success
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded and if so, what peer ID is associated with the peer.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	entry.peer_id++;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, PM_PEER_DATA_MAX_SIZE);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data((void *)&bonding_data,
-						  sizeof(struct pm_peer_data_bonding));
+	expect_bonding_data_search(1, &bonding_data, true);
+	entry.peer_id = 1;
 
 	/* Expect a storage read looking for local gatt data for the connected peer,
 	 * followed by a restoration of the local gatt database in the SoftDevice.
@@ -1774,7 +1914,6 @@ void test_pm_conn_secure_central_pair_success(void)
 		.kdist_own =  {.enc = 0, .id = 0},
 		.kdist_peer = {.enc = 0, .id = 0},
 	};
-	union pm_entry_id entry;
 	const struct pm_evt *pm_evt;
 	ble_evt_t evt = {.evt.gap_evt.conn_handle = CONN_HANDLE_1};
 
@@ -1790,18 +1929,10 @@ void test_pm_conn_secure_central_pair_success(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded. However, no bonding data is found for a peer with the given address.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
 	evt.evt.gap_evt.params.connected = (ble_gap_evt_connected_t) {
@@ -1966,7 +2097,6 @@ void test_pm_conn_secure_central_pair_and_bond_success(void)
 		.kdist_own =  {.enc = 1, .id = 1},
 		.kdist_peer = {.enc = 1, .id = 1},
 	};
-	union pm_entry_id entry;
 	const struct pm_evt *pm_evt;
 	ble_evt_t evt = {.evt.gap_evt.conn_handle = CONN_HANDLE_1};
 
@@ -1982,18 +2112,10 @@ void test_pm_conn_secure_central_pair_and_bond_success(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	/* Expect the bonding data storage to be iterated to find out if the connected peer have
+	/* Expect the bonds to be searched to find out if the connected peer have
 	 * previously bonded. However, no bonding data is found for a peer with the given address.
 	 */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
 	evt.evt.gap_evt.params.connected = (ble_gap_evt_connected_t) {
@@ -2167,7 +2289,7 @@ void test_pm_conn_secure_central_with_bonding_data_success(void)
 	};
 	union local_gatt_db_with_data local_gatt_db = STORED_GATT_DATA_1;
 
-	peer_manager_initialize_success();
+	peer_manager_initialize_with_bond(1, &bonding_data);
 
 	nrf_err = pm_register(&on_pm_evt);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
@@ -2180,17 +2302,8 @@ void test_pm_conn_secure_central_with_bonding_data_success(void)
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
 	/* Find stored bonding for the connected peer address (peer id 1). */
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-	__cmock_bm_zms_read_IgnoreArg_data();
+	expect_bonding_data_search(1, &bonding_data, true);
 	entry.peer_id = 1;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-					    PM_PEER_DATA_MAX_SIZE, PM_PEER_DATA_MAX_SIZE);
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data((void *)&bonding_data,
-						  sizeof(struct pm_peer_data_bonding));
 
 	/* PM_EVT_BONDED_PEER_CONNECTED restores local GATT data and checks SC/CAR state. */
 	entry.data_id = PM_PEER_DATA_ID_GATT_LOCAL;
@@ -2408,7 +2521,6 @@ void test_pm_sec_is_sufficient_invalid_conn_handle(void)
 void test_pm_sec_is_sufficient_connected_unencrypted(void)
 {
 	bool sec_sufficient;
-	union pm_entry_id entry;
 	const ble_evt_t evt = {
 		.header.evt_id = BLE_GAP_EVT_CONNECTED,
 		.evt.gap_evt = {
@@ -2426,14 +2538,7 @@ void test_pm_sec_is_sufficient_connected_unencrypted(void)
 	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
 	__cmock_nrf_sdh_ble_conn_handle_get_Stub(stub_nrf_sdh_ble_conn_handle_get);
 
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	entry.peer_id = 0;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-		entry.peer_id++;
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	sdh_evt_dispatch_ble(&evt);
 
@@ -2632,6 +2737,135 @@ void test_pm_peer_id_get_null(void)
 	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
 }
 
+void test_pm_peer_id_get_by_addr_null(void)
+{
+	uint32_t nrf_err;
+	uint16_t peer_id;
+	ble_gap_addr_t addr = ADDRESS_PUBLIC_1;
+
+	peer_manager_initialize_success();
+
+	nrf_err = pm_peer_id_get_by_addr(NULL, &peer_id);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
+
+	nrf_err = pm_peer_id_get_by_addr(&addr, NULL);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
+}
+
+void test_pm_peer_id_get_by_addr_public(void)
+{
+	uint32_t nrf_err;
+	uint16_t peer_id;
+	ble_gap_addr_t addr = ADDRESS_PUBLIC_1;
+	const struct pm_peer_data_bonding bonding_data = {
+		.own_role = BLE_GAP_ROLE_PERIPH,
+		.peer_ble_id.id_addr_info = ADDRESS_PUBLIC_1,
+	};
+
+	peer_manager_initialize_with_bond(1, &bonding_data);
+
+	expect_bonding_data_search(1, &bonding_data, true);
+
+	nrf_err = pm_peer_id_get_by_addr(&addr, &peer_id);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(1, peer_id);
+}
+
+void test_pm_peer_id_get_by_addr_non_resolvable(void)
+{
+	uint32_t nrf_err;
+	uint16_t peer_id;
+	ble_gap_addr_t addr = {
+		.addr_type = BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_NON_RESOLVABLE,
+		.addr = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66},
+	};
+
+	peer_manager_initialize_success();
+
+	nrf_err = pm_peer_id_get_by_addr(&addr, &peer_id);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(PM_PEER_ID_INVALID, peer_id);
+}
+
+/* Number of encryptions done by stub_sd_ecb_block_encrypt_xor(). */
+static uint32_t ecb_encrypt_count;
+
+/* A stand-in for AES that depends on the key, so that an address resolves with one IRK only. */
+static uint32_t stub_sd_ecb_block_encrypt_xor(nrf_ecb_hal_data_t *p_ecb_data, int cmock_num_calls)
+{
+	ARG_UNUSED(cmock_num_calls);
+
+	for (uint32_t i = 0; i < SOC_ECB_KEY_LENGTH; i++) {
+		p_ecb_data->ciphertext[i] = p_ecb_data->cleartext[i] ^ p_ecb_data->key[i];
+	}
+	ecb_encrypt_count++;
+
+	return NRF_SUCCESS;
+}
+
+/* Make a resolvable private address that resolves with @p irk using the XOR encryption stub. */
+static ble_gap_addr_t rpa_make(const ble_gap_irk_t *irk, uint8_t prand)
+{
+	ble_gap_addr_t addr = {.addr_type = BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE};
+
+	for (uint32_t i = 0; i < 3; i++) {
+		addr.addr[3 + i] = prand + i;
+		addr.addr[i] = addr.addr[3 + i] ^ irk->irk[i];
+	}
+
+	return addr;
+}
+
+void test_pm_peer_id_get_by_addr_resolvable(void)
+{
+	uint32_t nrf_err;
+	uint16_t peer_id;
+	uint32_t first_count;
+	ble_gap_addr_t addr;
+
+	memset(stored_bonds, 0, sizeof(stored_bonds));
+	for (uint16_t i = 0; i < 4; i++) {
+		stored_bonds[i] = (struct pm_peer_data_bonding) {
+			.own_role = BLE_GAP_ROLE_PERIPH,
+			.peer_ble_id.id_addr_info = ADDRESS_RANDOM_STATIC,
+			.peer_ble_id.id_info.irk = {0x10 + i, 0x20 + i, 0x30 + i, 0x40 + i},
+		};
+		pm_init_bonds[i] = &stored_bonds[i];
+	}
+
+	peer_manager_initialize_success();
+
+	__cmock_bm_zms_read_Stub(stub_bm_zms_read_count_bonding);
+	__cmock_sd_ecb_block_encrypt_Stub(stub_sd_ecb_block_encrypt_xor);
+
+	/* The address is resolved with the IRK of the third peer only. */
+	addr = rpa_make(&stored_bonds[2].peer_ble_id.id_info, 0x50);
+	ecb_encrypt_count = 0;
+
+	nrf_err = pm_peer_id_get_by_addr(&addr, &peer_id);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(2, peer_id);
+	first_count = ecb_encrypt_count;
+	TEST_ASSERT_EQUAL(3, first_count);
+
+	/* A returning address is found in the cache, without any encryption. */
+	nrf_err = pm_peer_id_get_by_addr(&addr, &peer_id);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(2, peer_id);
+#if defined(CONFIG_PM_BOND_INDEX) && (CONFIG_PM_RPA_CACHE_SIZE > 0)
+	TEST_ASSERT_EQUAL(first_count, ecb_encrypt_count);
+#else
+	TEST_ASSERT_EQUAL(2 * first_count, ecb_encrypt_count);
+#endif
+
+	/* An address from another IRK is not resolved. */
+	addr = rpa_make(&(ble_gap_irk_t){.irk = {0xAA, 0xBB, 0xCC}}, 0x60);
+
+	nrf_err = pm_peer_id_get_by_addr(&addr, &peer_id);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(PM_PEER_ID_INVALID, peer_id);
+}
+
 void test_pm_conn_handle_get_and_peer_id_get_not_connected(void)
 {
 	uint32_t nrf_err;
@@ -2739,6 +2973,26 @@ void test_pm_peer_data_load_not_found(void)
 	TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, nrf_err);
 }
 
+void test_pm_peer_data_load_length(void)
+{
+	uint32_t nrf_err;
+	union pm_entry_id entry = {.peer_id = 0, .data_id = PM_PEER_DATA_ID_APPLICATION};
+	uint8_t app_data[] = {0x01, 0x02, 0x03, 0x04};
+	uint32_t len = PM_PEER_DATA_MAX_SIZE;
+	uint8_t data[PM_PEER_DATA_MAX_SIZE] = {0};
+
+	peer_manager_initialize_success();
+
+	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE, len, sizeof(app_data));
+	__cmock_bm_zms_read_IgnoreArg_data();
+	__cmock_bm_zms_read_ReturnMemThruPtr_data(app_data, sizeof(app_data));
+
+	nrf_err = pm_peer_data_load(entry.peer_id, entry.data_id, data, &len);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(sizeof(app_data), len);
+	TEST_ASSERT_EQUAL_MEMORY(app_data, data, sizeof(app_data));
+}
+
 void test_pm_peer_data_delete_bonding_invalid(void)
 {
 	uint32_t nrf_err;
@@ -2776,13 +3030,7 @@ void test_pm_peer_new_success(void)
 
 	peer_manager_initialize_success();
 
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 
 	entry.peer_id = 0;
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
@@ -2920,13 +3168,9 @@ void test_pm_local_database_has_changed_forwards_unexpected_error(void)
 
 	__cmock_nrf_sdh_ble_idx_get_IgnoreAndReturn(-1);
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3083,13 +3327,9 @@ void test_pm_peer_new_duplicate_returns_existing_peer(void)
 	peer_manager_initialize_success();
 
 	/* Create the first peer. */
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3098,11 +3338,7 @@ void test_pm_peer_new_duplicate_returns_existing_peer(void)
 	TEST_ASSERT_EQUAL(0, new_peer_id);
 
 	/* Search finds the existing bond at peer 0; no new write. */
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE, PM_PEER_DATA_MAX_SIZE,
-					    sizeof(bonding_data));
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data(&bonding_data, sizeof(bonding_data));
+	expect_bonding_data_search(0, &bonding_data, true);
 	nrf_err = pm_peer_new(&new_peer_id, &bonding_data, NULL);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 	TEST_ASSERT_EQUAL(0, new_peer_id);
@@ -3122,13 +3358,9 @@ void test_pm_peer_id_list_with_stored_peer(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3157,13 +3389,9 @@ void test_pm_peers_delete_with_stored_peer(void)
 	__cmock_nrf_sdh_ble_idx_get_IgnoreAndReturn(-1);
 
 	/* Add a bonded peer. */
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3210,24 +3438,16 @@ void test_pm_peer_data_bonding_store_duplicate_forbidden(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
 	nrf_err = pm_peer_new(&new_peer_id, &bonding_data, NULL);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE, PM_PEER_DATA_MAX_SIZE,
-					    sizeof(bonding_data));
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data(&bonding_data, sizeof(bonding_data));
+	expect_bonding_data_search(0, &bonding_data, true);
 
 	nrf_err = pm_peer_data_bonding_store(1, &bonding_data, NULL);
 	TEST_ASSERT_EQUAL(NRF_ERROR_FORBIDDEN, nrf_err);
@@ -3245,30 +3465,18 @@ void test_pm_peer_data_bonding_store_success(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
 	nrf_err = pm_peer_new(&new_peer_id, &bonding_data, NULL);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE, PM_PEER_DATA_MAX_SIZE,
-					    sizeof(bonding_data));
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data(&bonding_data, sizeof(bonding_data));
-	for (uint32_t i = 1; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
+	expect_bonding_data_search(0, &bonding_data, false);
+
+	entry.data_id = PM_PEER_DATA_ID_BONDING;
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3290,13 +3498,9 @@ void test_pm_peer_id_list_skip_no_irk_filters_peer(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3331,13 +3535,9 @@ void test_pm_peer_id_list_includes_peer_with_irk(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3384,13 +3584,9 @@ void test_pm_peer_id_list_skip_no_id_addr_filters_non_static_address(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3424,13 +3620,9 @@ void test_pm_peer_id_list_skip_no_id_addr_includes_public_address(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3466,13 +3658,9 @@ void test_pm_peer_id_list_skip_no_car_filters_zero(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3513,13 +3701,9 @@ void test_pm_peer_id_list_skip_no_car_includes_nonzero(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3565,30 +3749,18 @@ void test_pm_peer_id_list_starts_from_first_peer_id(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_0, sizeof(bonding_0),
 					       sizeof(bonding_0));
 	nrf_err = pm_peer_new(&peer_id_0, &bonding_0, NULL);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE, PM_PEER_DATA_MAX_SIZE,
-					    sizeof(bonding_0));
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data(&bonding_0, sizeof(bonding_0));
-	for (uint32_t i = 1; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
+	expect_bonding_data_search(0, &bonding_0, false);
+
+	entry.data_id = PM_PEER_DATA_ID_BONDING;
 	entry.peer_id = 1;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_1, sizeof(bonding_1),
 					       sizeof(bonding_1));
@@ -3621,30 +3793,18 @@ void test_pm_peer_id_list_list_size_limits_output(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_0, sizeof(bonding_0),
 					       sizeof(bonding_0));
 	nrf_err = pm_peer_new(&peer_id_0, &bonding_0, NULL);
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 
-	entry.peer_id = 0;
-	__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE, PM_PEER_DATA_MAX_SIZE,
-					    sizeof(bonding_0));
-	__cmock_bm_zms_read_IgnoreArg_data();
-	__cmock_bm_zms_read_ReturnMemThruPtr_data(&bonding_0, sizeof(bonding_0));
-	for (uint32_t i = 1; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
+	expect_bonding_data_search(0, &bonding_0, false);
+
+	entry.data_id = PM_PEER_DATA_ID_BONDING;
 	entry.peer_id = 1;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_1, sizeof(bonding_1),
 					       sizeof(bonding_1));
@@ -3672,13 +3832,9 @@ void test_pm_peer_id_list_bonding_read_error(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3709,13 +3865,9 @@ void test_pm_peer_id_list_skip_bonding_not_found(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3747,13 +3899,9 @@ void test_pm_peer_id_list_skip_no_id_addr_includes_random_static(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3788,13 +3936,9 @@ void test_pm_peer_id_list_skip_car_not_found(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3827,13 +3971,9 @@ void test_pm_peer_id_list_car_read_error(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3869,13 +4009,9 @@ void test_pm_peers_delete_async_sends_peers_delete_succeeded(void)
 
 	__cmock_nrf_sdh_ble_idx_get_IgnoreAndReturn(-1);
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3928,13 +4064,9 @@ void test_pm_peer_ranks_get_success_with_stored_rank(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -3975,13 +4107,7 @@ void test_pm_peer_rank_highest_success(void)
 
 	peer_manager_initialize_success();
 
-	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
 	entry.peer_id = 0;
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
@@ -4014,13 +4140,9 @@ void test_pm_peer_rank_highest_busy_while_store_pending(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -4061,13 +4183,9 @@ void test_pm_peer_rank_highest_already_highest_sends_event(void)
 
 	__cmock_nrf_sdh_ble_idx_get_IgnoreAndReturn(-1);
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -4112,13 +4230,9 @@ void test_pm_peer_rank_highest_store_failure(void)
 
 	peer_manager_initialize_success();
 
+	expect_bonding_data_search(PM_PEER_ID_INVALID, NULL, false);
+
 	entry.data_id = PM_PEER_DATA_ID_BONDING;
-	for (uint32_t i = 0; i < PM_PEER_ID_N_AVAILABLE_IDS; i++) {
-		entry.peer_id = i;
-		__cmock_bm_zms_read_ExpectAndReturn(zms_fs, entry.id, PTR_IGNORE,
-						    PM_PEER_DATA_MAX_SIZE, -ENOENT);
-		__cmock_bm_zms_read_IgnoreArg_data();
-	}
 	entry.peer_id = 0;
 	__cmock_bm_zms_write_ExpectAndReturn(zms_fs, entry.id, &bonding_data,
 					       sizeof(bonding_data), sizeof(bonding_data));
@@ -4139,6 +4253,8 @@ void test_pm_peer_rank_highest_store_failure(void)
 
 void setUp(void)
 {
+	__cmock_bm_zms_iter_init_Stub(stub_bm_zms_iter_init);
+	__cmock_bm_zms_iter_next_Stub(stub_bm_zms_iter_next);
 }
 
 void tearDown(void)
@@ -4148,6 +4264,8 @@ void tearDown(void)
 	/* Reset behavior for on_pm_evt function and pm_evt capture before the next test. */
 	memset(&on_pm_evt_test_ctx, 0, sizeof(on_pm_evt_test_ctx));
 
+	memset(pm_init_bonds, 0, sizeof(pm_init_bonds));
+
 	/* Reset values of zms test variables before the next test. */
 	if (zms_fs != NULL) {
 		zms_fs->init_flags.initialized = false;
@@ -8,10 +8,16 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
 #include <bm/bm_scheduler.h>
 
 #define MAX_RECORDED_CALLS 16
 
+#define BENCHMARK_ROUNDS 1000
+#define BENCHMARK_BATCH 8
+
 struct call_record {
 	bm_scheduler_fn_t handler;
 	size_t len;
@@ -202,6 +208,332 @@ void test_bm_scheduler_process_releases_memory(void)
 	TEST_ASSERT_EQUAL(0, err);
 }
 
+#if defined(CONFIG_BM_SCHEDULER_BACKEND_RING)
+void test_bm_scheduler_ring_oversize_keeps_order(void)
+{
+	int err;
+	uint8_t small[] = {0x11, 0x22};
+	uint8_t big[CONFIG_BM_SCHEDULER_RING_SLOT_SIZE + 1];
+
+	memset(big, 0x5A, sizeof(big));
+
+	/* Events that do not fit in a slot are stored on the heap,
+	 * but must still be dispatched in FIFO order.
+	 */
+	err = bm_scheduler_defer(handler_a, small, sizeof(small));
+	TEST_ASSERT_EQUAL(0, err);
+
+	err = bm_scheduler_defer(handler_b, big, sizeof(big));
+	TEST_ASSERT_EQUAL(0, err);
+
+	err = bm_scheduler_defer(handler_a, small, sizeof(small));
+	TEST_ASSERT_EQUAL(0, err);
+
+	(void)bm_scheduler_process();
+
+	TEST_ASSERT_EQUAL(3, call_count);
+	TEST_ASSERT_EQUAL_PTR(handler_a, call_log[0].handler);
+	TEST_ASSERT_EQUAL_PTR(handler_b, call_log[1].handler);
+	TEST_ASSERT_EQUAL(sizeof(big), call_log[1].len);
+	TEST_ASSERT_EQUAL_MEMORY(big, call_log[1].data, sizeof(big));
+	TEST_ASSERT_EQUAL_PTR(handler_a, call_log[2].handler);
+}
+
+void test_bm_scheduler_ring_full(void)
+{
+	int err;
+	uint8_t payload = 0;
+
+	for (size_t i = 0; i < CONFIG_BM_SCHEDULER_RING_SLOTS; i++) {
+		err = bm_scheduler_defer(handler_a, &payload, sizeof(payload));
+		TEST_ASSERT_EQUAL(0, err);
+	}
+
+	/* All slots are in use. */
+	err = bm_scheduler_defer(handler_a, &payload, sizeof(payload));
+	TEST_ASSERT_EQUAL(-ENOMEM, err);
+
+	(void)bm_scheduler_process();
+
+	/* Slots are released once the events are dispatched. */
+	err = bm_scheduler_defer(handler_a, &payload, sizeof(payload));
+	TEST_ASSERT_EQUAL(0, err);
+}
+#endif /* CONFIG_BM_SCHEDULER_BACKEND_RING */
+
+void test_bm_scheduler_defer_prio_einval(void)
+{
+	int err;
+
+	err = bm_scheduler_defer_prio(handler_a, NULL, 0, BM_SCHEDULER_PRIO_LOWEST + 1);
+	TEST_ASSERT_EQUAL(-EINVAL, err);
+}
+
+#if CONFIG_BM_SCHEDULER_PRIO_LEVELS > 1
+void test_bm_scheduler_process_prio_order(void)
+{
+	int err;
+	uint8_t low = 1;
+	uint8_t high = 2;
+
+	err = bm_scheduler_defer(handler_a, &low, sizeof(low));
+	TEST_ASSERT_EQUAL(0, err);
+
+	err = bm_scheduler_defer_prio(handler_b, &high, sizeof(high), BM_SCHEDULER_PRIO_HIGHEST);
+	TEST_ASSERT_EQUAL(0, err);
+
+	err = bm_scheduler_process();
+	TEST_ASSERT_EQUAL(0, err);
+
+	/* The higher priority event is dispatched first, although deferred last. */
+	TEST_ASSERT_EQUAL(2, call_count);
+	TEST_ASSERT_EQUAL_PTR(handler_b, call_log[0].handler);
+	TEST_ASSERT_EQUAL(high, call_log[0].data[0]);
+	TEST_ASSERT_EQUAL_PTR(handler_a, call_log[1].handler);
+	TEST_ASSERT_EQUAL(low, call_log[1].data[0]);
+}
+#endif
+
+static void slow_handler(void *evt, size_t len)
+{
+	record_call(slow_handler, evt, len);
+	k_busy_wait(100);
+}
+
+void test_bm_scheduler_process_budget(void)
+{
+	int err;
+
+	for (size_t i = 0; i < 4; i++) {
+		err = bm_scheduler_defer(slow_handler, NULL, 0);
+		TEST_ASSERT_EQUAL(0, err);
+	}
+
+	/* The budget is exceeded by the second event. */
+	err = bm_scheduler_process_budget(150);
+	TEST_ASSERT_EQUAL(-EAGAIN, err);
+	TEST_ASSERT_EQUAL(2, call_count);
+
+	/* The remaining events fit in the budget. */
+	err = bm_scheduler_process_budget(1000);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL(4, call_count);
+}
+
+void test_bm_scheduler_process_budget_dispatches_one(void)
+{
+	int err;
+
+	err = bm_scheduler_defer(slow_handler, NULL, 0);
+	TEST_ASSERT_EQUAL(0, err);
+	err = bm_scheduler_defer(slow_handler, NULL, 0);
+	TEST_ASSERT_EQUAL(0, err);
+
+	/* At least one event is dispatched, even if the budget is already exceeded. */
+	err = bm_scheduler_process_budget(1);
+	TEST_ASSERT_EQUAL(-EAGAIN, err);
+	TEST_ASSERT_EQUAL(1, call_count);
+
+	err = bm_scheduler_process_budget(1);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL(2, call_count);
+}
+
+static BM_SCHEDULER_COALESCE_DEFINE(coalesce_evt, handler_a, BM_SCHEDULER_PRIO_LOWEST);
+
+static void redefer_handler(void *evt, size_t len);
+static BM_SCHEDULER_COALESCE_DEFINE(redefer_evt, redefer_handler, BM_SCHEDULER_PRIO_LOWEST);
+
+static void redefer_handler(void *evt, size_t len)
+{
+	record_call(redefer_handler, evt, len);
+
+	if (call_count == 1) {
+		(void)bm_scheduler_defer_coalesce(&redefer_evt);
+	}
+}
+
+void test_bm_scheduler_defer_coalesce_efault(void)
+{
+	int err;
+	struct bm_scheduler_coalesce no_handler = {0};
+
+	err = bm_scheduler_defer_coalesce(NULL);
+	TEST_ASSERT_EQUAL(-EFAULT, err);
+
+	err = bm_scheduler_defer_coalesce(&no_handler);
+	TEST_ASSERT_EQUAL(-EFAULT, err);
+}
+
+void test_bm_scheduler_defer_coalesce(void)
+{
+	int err;
+
+	atomic_clear(&coalesce_evt.coalesced);
+	atomic_clear(&coalesce_evt.dispatched);
+
+	for (size_t i = 0; i < 3; i++) {
+		err = bm_scheduler_defer_coalesce(&coalesce_evt);
+		TEST_ASSERT_EQUAL(0, err);
+	}
+
+	(void)bm_scheduler_process();
+
+	/* Defers of a pending event collapse into one dispatch. */
+	TEST_ASSERT_EQUAL(1, call_count);
+	TEST_ASSERT_EQUAL_PTR(handler_a, call_log[0].handler);
+	TEST_ASSERT_EQUAL(0, call_log[0].len);
+	TEST_ASSERT_EQUAL(2, atomic_get(&coalesce_evt.coalesced));
+	TEST_ASSERT_EQUAL(1, atomic_get(&coalesce_evt.dispatched));
+
+	/* Once dispatched, the event can be deferred again. */
+	err = bm_scheduler_defer_coalesce(&coalesce_evt);
+	TEST_ASSERT_EQUAL(0, err);
+
+	(void)bm_scheduler_process();
+
+	TEST_ASSERT_EQUAL(2, call_count);
+	TEST_ASSERT_EQUAL(2, atomic_get(&coalesce_evt.dispatched));
+}
+
+void test_bm_scheduler_defer_coalesce_from_handler(void)
+{
+	int err;
+
+	err = bm_scheduler_defer_coalesce(&redefer_evt);
+	TEST_ASSERT_EQUAL(0, err);
+
+	(void)bm_scheduler_process();
+
+	/* Deferring from the handler itself is not lost. */
+	TEST_ASSERT_EQUAL(2, call_count);
+	TEST_ASSERT_EQUAL_PTR(redefer_handler, call_log[1].handler);
+}
+
+#if defined(CONFIG_BM_SCHEDULER_STATS)
+void test_bm_scheduler_stats(void)
+{
+	int err;
+	uint8_t payload[4] = {0};
+	struct bm_scheduler_stats stats;
+	struct bm_scheduler_handler_stats hs;
+	uint32_t hist_sum = 0;
+
+	bm_scheduler_stats_reset();
+
+	err = bm_scheduler_defer(slow_handler, NULL, 0);
+	TEST_ASSERT_EQUAL(0, err);
+	err = bm_scheduler_defer(handler_a, payload, sizeof(payload));
+	TEST_ASSERT_EQUAL(0, err);
+	err = bm_scheduler_defer(slow_handler, NULL, 0);
+	TEST_ASSERT_EQUAL(0, err);
+
+	err = bm_scheduler_stats_get(&stats);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL(3, stats.queue_depth);
+	TEST_ASSERT_EQUAL(3, stats.queue_depth_peak);
+	TEST_ASSERT_EQUAL(0, stats.dispatched);
+
+	k_busy_wait(10);
+	(void)bm_scheduler_process();
+
+	err = bm_scheduler_stats_get(&stats);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL(0, stats.queue_depth);
+	TEST_ASSERT_EQUAL(3, stats.queue_depth_peak);
+	TEST_ASSERT_EQUAL(3, stats.dispatched);
+	TEST_ASSERT_TRUE(stats.latency_max >= k_us_to_cyc_floor32(10));
+	TEST_ASSERT_TRUE(stats.latency_max >= stats.latency_avg);
+
+	/* Handlers are recorded in the order they are first dispatched. */
+	err = bm_scheduler_handler_stats_get(0, &hs);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL_PTR(slow_handler, hs.handler);
+	TEST_ASSERT_EQUAL(2, hs.count);
+	TEST_ASSERT_TRUE(hs.exec_max >= k_us_to_cyc_floor32(100));
+	for (size_t i = 0; i < BM_SCHEDULER_STATS_HIST_BUCKETS; i++) {
+		hist_sum += hs.hist[i];
+	}
+	TEST_ASSERT_EQUAL(2, hist_sum);
+
+	err = bm_scheduler_handler_stats_get(1, &hs);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL_PTR(handler_a, hs.handler);
+	TEST_ASSERT_EQUAL(1, hs.count);
+
+	err = bm_scheduler_handler_stats_get(2, &hs);
+	TEST_ASSERT_EQUAL(-ENOENT, err);
+
+	bm_scheduler_stats_reset();
+
+	err = bm_scheduler_stats_get(&stats);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL(0, stats.queue_depth_peak);
+	TEST_ASSERT_EQUAL(0, stats.dispatched);
+
+	err = bm_scheduler_handler_stats_get(0, &hs);
+	TEST_ASSERT_EQUAL(-ENOENT, err);
+}
+
+void test_bm_scheduler_stats_coalesce(void)
+{
+	int err;
+	struct bm_scheduler_handler_stats hs;
+
+	bm_scheduler_stats_reset();
+
+	err = bm_scheduler_defer_coalesce(&coalesce_evt);
+	TEST_ASSERT_EQUAL(0, err);
+
+	(void)bm_scheduler_process();
+
+	/* Coalescing events are accounted to the handler they wrap. */
+	err = bm_scheduler_handler_stats_get(0, &hs);
+	TEST_ASSERT_EQUAL(0, err);
+	TEST_ASSERT_EQUAL_PTR(handler_a, hs.handler);
+	TEST_ASSERT_EQUAL(1, hs.count);
+}
+#endif /* CONFIG_BM_SCHEDULER_STATS */
+
+static size_t bench_count;
+
+static void bench_handler(void *evt, size_t len)
+{
+	ARG_UNUSED(evt);
+	ARG_UNUSED(len);
+
+	bench_count++;
+}
+
+void test_bm_scheduler_benchmark(void)
+{
+	int err;
+	uint32_t start;
+	uint32_t cycles;
+	uint8_t payload[8] = {0};
+
+	bench_count = 0;
+
+	/* Defer and process events in small batches, like bursts of interrupts
+	 * drained by the main loop. Run the test once per backend to compare.
+	 */
+	start = k_cycle_get_32();
+	for (size_t round = 0; round < BENCHMARK_ROUNDS; round++) {
+		for (size_t i = 0; i < BENCHMARK_BATCH; i++) {
+			err = bm_scheduler_defer(bench_handler, payload, sizeof(payload));
+			TEST_ASSERT_EQUAL(0, err);
+		}
+		(void)bm_scheduler_process();
+	}
+	cycles = k_cycle_get_32() - start;
+
+	TEST_ASSERT_EQUAL(BENCHMARK_ROUNDS * BENCHMARK_BATCH, bench_count);
+
+	printk("bm_scheduler %s backend: %u events in %u cycles\n",
+	       IS_ENABLED(CONFIG_BM_SCHEDULER_BACKEND_RING) ? "ring" : "heap",
+	       BENCHMARK_ROUNDS * BENCHMARK_BATCH, cycles);
+}
+
 void setUp(void)
 {
 	/* Drain any deferred events that may have leaked from a previous
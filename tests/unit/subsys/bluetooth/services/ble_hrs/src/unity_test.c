@@ -628,6 +628,56 @@ void test_ble_hrs_heart_rate_measurement_send_cccd_read_error(void)
 	TEST_ASSERT_EQUAL(ERROR, nrf_err);
 }
 
+void test_ble_hrs_heart_rate_measurement_send_cccd_cached(void)
+{
+	/* The CCCD is read once per connection, and then tracked from the writes of the peer. */
+	uint32_t nrf_err;
+	struct ble_hrs hrs = {
+		.hrm_handles.cccd_handle = TEST_CCCD_HANDLE,
+	};
+	const ble_evt_t connect_evt = {
+		.header.evt_id = BLE_GAP_EVT_CONNECTED,
+		.evt.gap_evt.conn_handle = TEST_CONN_HANDLE,
+	};
+	uint8_t evt_buf[sizeof(ble_evt_t) + 2] = {0};
+	ble_evt_t *write_evt = (ble_evt_t *)evt_buf;
+
+	write_evt->header.evt_id = BLE_GATTS_EVT_WRITE;
+	write_evt->evt.gatts_evt.conn_handle = TEST_CONN_HANDLE;
+	write_evt->evt.gatts_evt.params.write.handle = TEST_CCCD_HANDLE;
+	write_evt->evt.gatts_evt.params.write.len = 2;
+
+	ble_hrs_on_ble_evt(&connect_evt, &hrs);
+
+	__cmock_sd_ble_gatts_value_get_Stub(stub_sd_ble_gatts_value_get_notif_enabled);
+	__cmock_sd_ble_gatts_hvx_IgnoreAndReturn(NRF_SUCCESS);
+
+	nrf_err = ble_hrs_heart_rate_measurement_send(&hrs, 72);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	/* Not read again. */
+	__cmock_sd_ble_gatts_value_get_Stub(NULL);
+
+	for (int i = 0; i < 16; i++) {
+		nrf_err = ble_hrs_heart_rate_measurement_send(&hrs, 72);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	}
+
+	/* The peer disables notifications. */
+	write_evt->evt.gatts_evt.params.write.data[0] = 0x00;
+	ble_hrs_on_ble_evt(write_evt, &hrs);
+
+	nrf_err = ble_hrs_heart_rate_measurement_send(&hrs, 72);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, nrf_err);
+
+	/* The peer enables notifications. */
+	write_evt->evt.gatts_evt.params.write.data[0] = BLE_GATT_HVX_NOTIFICATION;
+	ble_hrs_on_ble_evt(write_evt, &hrs);
+
+	nrf_err = ble_hrs_heart_rate_measurement_send(&hrs, 72);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+}
+
 void test_ble_hrs_heart_rate_measurement_send(void)
 {
 	uint32_t nrf_err;
@@ -14,13 +14,29 @@
 
 #include "cmock_ble_gatts.h"
 #include "cmock_ble.h"
+#include "cmock_nrf_sdh_ble.h"
+#include "cmock_ble_conn_params.h"
 
 /* An arbitrary error, to test forwarding of errors from SoftDevice calls */
 #define ERROR 0xbaadf00d
 
+/* Number of notifications the SoftDevice can queue in the TX stream tests. */
+#define SD_HVN_QUEUE_SIZE 2
+
 static struct ble_nus ble_nus;
 static uint16_t test_case_conn_handle = 0x1000;
 static bool evt_handler_called;
+static uint16_t test_case_att_mtu;
+
+/* Notifications received by the peer in the TX stream tests. */
+static struct {
+	bool notif_enabled;
+	uint8_t queued;
+	uint8_t data[2 * CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE];
+	size_t len;
+	uint16_t hvn_len[64];
+	size_t hvn_count;
+} peer;
 
 static uint32_t stub_sd_ble_gatts_service_add(uint8_t type, const ble_uuid_t *p_uuid,
 					      uint16_t *p_handle, int calls)
@@ -84,6 +100,90 @@ static uint32_t stub_sd_ble_gatts_value_get_err(uint16_t conn_handle, uint16_t h
 	}
 }
 
+static uint32_t stub_sd_ble_gatts_value_get_sys_attr_missing(uint16_t conn_handle,
+							    uint16_t handle,
+							    ble_gatts_value_t *p_value, int calls)
+{
+	return BLE_ERROR_GATTS_SYS_ATTR_MISSING;
+}
+
+static int stub_nrf_sdh_ble_idx_get(uint16_t conn_handle, int calls)
+{
+	return (conn_handle == test_case_conn_handle) ? 0 : -1;
+}
+
+static int stub_nrf_sdh_ble_idx_get_single_link(uint16_t conn_handle, int calls)
+{
+	/* With a single link, every connection handle has index 0. */
+	return 0;
+}
+
+static uint32_t stub_ble_conn_params_att_mtu_get(uint16_t conn_handle, uint16_t *att_mtu,
+						 int calls)
+{
+	TEST_ASSERT_EQUAL(test_case_conn_handle, conn_handle);
+
+	*att_mtu = test_case_att_mtu;
+
+	return NRF_SUCCESS;
+}
+
+static uint32_t stub_sd_ble_gatts_hvx_peer(uint16_t conn_handle,
+					   const ble_gatts_hvx_params_t *p_hvx_params, int calls)
+{
+	const uint16_t len = *p_hvx_params->p_len;
+
+	TEST_ASSERT_EQUAL(test_case_conn_handle, conn_handle);
+	TEST_ASSERT_EQUAL(BLE_GATT_HVX_NOTIFICATION, p_hvx_params->type);
+	TEST_ASSERT_EQUAL(ble_nus.tx_handles.value_handle, p_hvx_params->handle);
+
+	if (!peer.notif_enabled) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+	if (peer.queued == SD_HVN_QUEUE_SIZE) {
+		return NRF_ERROR_RESOURCES;
+	}
+
+	TEST_ASSERT_TRUE(len > 0);
+	TEST_ASSERT_TRUE(len <= BLE_NUS_MAX_DATA_LEN_CALC(test_case_att_mtu));
+	TEST_ASSERT_TRUE(peer.len + len <= sizeof(peer.data));
+	TEST_ASSERT_TRUE(peer.hvn_count < ARRAY_SIZE(peer.hvn_len));
+
+	memcpy(&peer.data[peer.len], p_hvx_params->p_data, len);
+	peer.len += len;
+	peer.hvn_len[peer.hvn_count++] = len;
+	peer.queued++;
+
+	return NRF_SUCCESS;
+}
+
+/* Complete all notifications queued in the SoftDevice. */
+static void peer_hvn_tx_complete(void)
+{
+	const ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GATTS_EVT_HVN_TX_COMPLETE,
+		.evt.gatts_evt = {
+			.conn_handle = test_case_conn_handle,
+			.params.hvn_tx_complete.count = peer.queued,
+		},
+	};
+
+	peer.queued = 0;
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+}
+
+/* Connect the test link, before the system attributes are set. */
+static void tx_stream_connect(void)
+{
+	const ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GAP_EVT_CONNECTED,
+		.evt.gap_evt.conn_handle = test_case_conn_handle,
+	};
+
+	__cmock_sd_ble_gatts_value_get_Stub(stub_sd_ble_gatts_value_get_sys_attr_missing);
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+}
+
 static void ble_nus_evt_handler_on_connect(struct ble_nus *nus, const struct ble_nus_evt *evt)
 {
 	TEST_ASSERT_EQUAL(BLE_NUS_EVT_COMM_STARTED, evt->evt_type);
@@ -306,6 +406,64 @@ void test_ble_nus_on_hvx_tx_complete(void)
 	TEST_ASSERT_TRUE(evt_handler_called);
 }
 
+static size_t tx_rdy_count;
+
+static void ble_nus_evt_handler_tx_rdy_count(struct ble_nus *nus, const struct ble_nus_evt *evt)
+{
+	if (evt->evt_type == BLE_NUS_EVT_TX_RDY) {
+		tx_rdy_count++;
+	}
+}
+
+void test_ble_nus_on_hvx_tx_complete_cccd_cached(void)
+{
+	ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GAP_EVT_CONNECTED,
+		.evt.gap_evt.conn_handle = test_case_conn_handle,
+	};
+	ble_evt_t write_evt = {
+		.header.evt_id = BLE_GATTS_EVT_WRITE,
+		.evt.gatts_evt = {
+			.conn_handle = test_case_conn_handle,
+			.params.write = {
+				.handle = 0x101,
+				.len = 2,
+			},
+		},
+	};
+	struct ble_nus_config nus_cfg = {.evt_handler = ble_nus_evt_handler_tx_rdy_count};
+
+	nus_init(&nus_cfg);
+	tx_rdy_count = 0;
+
+	/* The CCCD is read once, on connection. */
+	__cmock_sd_ble_gatts_value_get_Stub(stub_sd_ble_gatts_value_get);
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+	__cmock_sd_ble_gatts_value_get_Stub(NULL);
+
+	ble_evt.header.evt_id = BLE_GATTS_EVT_HVN_TX_COMPLETE;
+	ble_evt.evt.gatts_evt.conn_handle = test_case_conn_handle;
+	ble_evt.evt.gatts_evt.params.hvn_tx_complete.count = 1;
+	for (int i = 0; i < 16; i++) {
+		ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+	}
+	TEST_ASSERT_EQUAL(16, tx_rdy_count);
+
+	/* The peer disables notifications. */
+	*(uint16_t *)write_evt.evt.gatts_evt.params.write.data = 0;
+	ble_nus_on_ble_evt(&write_evt, &ble_nus);
+
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+	TEST_ASSERT_EQUAL(16, tx_rdy_count);
+
+	/* The peer enables notifications again. */
+	*(uint16_t *)write_evt.evt.gatts_evt.params.write.data = BLE_GATT_HVX_NOTIFICATION;
+	ble_nus_on_ble_evt(&write_evt, &ble_nus);
+
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+	TEST_ASSERT_EQUAL(17, tx_rdy_count);
+}
+
 void test_ble_nus_data_send_error_null(void)
 {
 	uint32_t nrf_err;
@@ -362,11 +520,313 @@ void test_ble_nus_data_send_success(void)
 	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
 }
 
+void test_ble_nus_write_error_null(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[2] = {0};
+	uint16_t length = sizeof(data);
+
+	nrf_err = ble_nus_write(NULL, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
+
+	nrf_err = ble_nus_write(&ble_nus, NULL, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
+
+	nrf_err = ble_nus_write(&ble_nus, data, NULL, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
+
+	nrf_err = ble_nus_flush(NULL, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_NULL, nrf_err);
+}
+
+void test_ble_nus_write_error_invalid_param(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[2];
+	uint16_t length = sizeof(data);
+	struct ble_nus_config nus_cfg = {.evt_handler = NULL};
+
+	nus_init(&nus_cfg);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle + 1);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+
+	nrf_err = ble_nus_flush(&ble_nus, test_case_conn_handle + 1);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+}
+
+void test_ble_nus_write_error_not_connected(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[2] = {0};
+	uint16_t length = sizeof(data);
+	struct ble_nus_config nus_cfg = {.evt_handler = NULL};
+
+	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get_single_link);
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_peer);
+
+	nus_init(&nus_cfg);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+
+	tx_stream_connect();
+
+	/* A stale connection handle has the index of the connected link. */
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle - 1);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+
+	nrf_err = ble_nus_flush(&ble_nus, test_case_conn_handle - 1);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(sizeof(data), length);
+}
+
+void test_ble_nus_write_packs_notifications(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[1000];
+	uint16_t length;
+	const uint16_t hvn_len_max = BLE_NUS_MAX_DATA_LEN_CALC(test_case_att_mtu);
+	struct ble_nus_config nus_cfg = {.evt_handler = NULL};
+
+	nus_init(&nus_cfg);
+	tx_stream_connect();
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_peer);
+	__cmock_sd_ble_gatts_value_get_Stub(stub_sd_ble_gatts_value_get);
+	peer.notif_enabled = true;
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	/* Write in small pieces, as a UART would. */
+	for (size_t i = 0; i < sizeof(data); i += 10) {
+		length = 10;
+		nrf_err = ble_nus_write(&ble_nus, &data[i], &length, test_case_conn_handle);
+		TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+		TEST_ASSERT_EQUAL(10, length);
+	}
+
+	while (peer.queued > 0) {
+		peer_hvn_tx_complete();
+	}
+
+	TEST_ASSERT_EQUAL(sizeof(data), peer.len);
+	TEST_ASSERT_EQUAL_MEMORY(data, peer.data, sizeof(data));
+
+	/* The first piece is sent right away, as the link is idle. The others are packed into
+	 * full notifications while the SoftDevice is busy, and the rest is sent when it is done.
+	 */
+	TEST_ASSERT_EQUAL(6, peer.hvn_count);
+	TEST_ASSERT_EQUAL(10, peer.hvn_len[0]);
+	for (size_t i = 1; i < peer.hvn_count - 1; i++) {
+		TEST_ASSERT_EQUAL(hvn_len_max, peer.hvn_len[i]);
+	}
+}
+
+void test_ble_nus_write_flush(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[60] = {0};
+	uint16_t length;
+	struct ble_nus_config nus_cfg = {.evt_handler = NULL};
+
+	nus_init(&nus_cfg);
+	tx_stream_connect();
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_peer);
+	peer.notif_enabled = true;
+
+	length = 10;
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(1, peer.hvn_count);
+
+	/* Held back while a notification is queued. */
+	length = 50;
+	nrf_err = ble_nus_write(&ble_nus, &data[10], &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(1, peer.hvn_count);
+
+	nrf_err = ble_nus_flush(&ble_nus, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(2, peer.hvn_count);
+	TEST_ASSERT_EQUAL(50, peer.hvn_len[1]);
+	TEST_ASSERT_EQUAL(sizeof(data), peer.len);
+}
+
+void test_ble_nus_write_buffer_full(void)
+{
+	uint32_t nrf_err;
+	static uint8_t data[CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE + 100];
+	uint16_t length;
+	ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GATTS_EVT_WRITE,
+		.evt.gatts_evt = {
+			.conn_handle = test_case_conn_handle,
+			.params.write = {
+				.handle = 0x101,
+				.len = 2,
+			},
+		},
+	};
+	struct ble_nus_config nus_cfg = {.evt_handler = NULL};
+
+	nus_init(&nus_cfg);
+	tx_stream_connect();
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_peer);
+	__cmock_sd_ble_gatts_value_get_Stub(stub_sd_ble_gatts_value_get);
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = i * 7;
+	}
+
+	/* Notifications are disabled, the data is buffered. */
+	length = CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE - 24;
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE - 24, length);
+
+	length = 100;
+	nrf_err = ble_nus_write(&ble_nus, &data[CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE - 24], &length,
+				test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(24, length);
+
+	length = 100;
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_RESOURCES, nrf_err);
+	TEST_ASSERT_EQUAL(0, length);
+	TEST_ASSERT_EQUAL(0, peer.len);
+
+	/* The peer enables notifications. */
+	peer.notif_enabled = true;
+	*(uint16_t *)ble_evt.evt.gatts_evt.params.write.data = BLE_GATT_HVX_NOTIFICATION;
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+	TEST_ASSERT_EQUAL(SD_HVN_QUEUE_SIZE, peer.hvn_count);
+
+	while (peer.queued > 0) {
+		peer_hvn_tx_complete();
+	}
+
+	TEST_ASSERT_EQUAL(CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE, peer.len);
+	TEST_ASSERT_EQUAL_MEMORY(data, peer.data, CONFIG_BLE_NUS_TX_STREAM_BUF_SIZE);
+}
+
+void test_ble_nus_write_disconnect(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[10] = {0};
+	uint16_t length = sizeof(data);
+	const ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GAP_EVT_DISCONNECTED,
+		.evt.gap_evt.conn_handle = test_case_conn_handle,
+	};
+	struct ble_nus_config nus_cfg = {.evt_handler = NULL};
+
+	nus_init(&nus_cfg);
+	tx_stream_connect();
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_peer);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+
+	/* The buffered data is discarded. */
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+
+	nrf_err = ble_nus_flush(&ble_nus, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, nrf_err);
+
+	tx_stream_connect();
+
+	peer.notif_enabled = true;
+	nrf_err = ble_nus_flush(&ble_nus, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(0, peer.hvn_count);
+}
+
+static void ble_nus_evt_handler_tx_error(struct ble_nus *nus, const struct ble_nus_evt *evt)
+{
+	TEST_ASSERT_EQUAL(BLE_NUS_EVT_ERROR, evt->evt_type);
+	TEST_ASSERT_EQUAL(ERROR, evt->error.reason);
+	evt_handler_called = true;
+}
+
+void test_ble_nus_write_hvx_error(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[10] = {0};
+	uint16_t length = sizeof(data);
+	struct ble_nus_config nus_cfg = {.evt_handler = ble_nus_evt_handler_tx_error};
+
+	nus_init(&nus_cfg);
+	tx_stream_connect();
+
+	__cmock_sd_ble_gatts_hvx_ExpectAnyArgsAndReturn(ERROR);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_TRUE(evt_handler_called);
+}
+
+static void ble_nus_evt_handler_no_error(struct ble_nus *nus, const struct ble_nus_evt *evt)
+{
+	TEST_ASSERT_NOT_EQUAL(BLE_NUS_EVT_ERROR, evt->evt_type);
+}
+
+void test_ble_nus_write_sys_attr_missing(void)
+{
+	uint32_t nrf_err;
+	uint8_t data[10] = {0};
+	uint16_t length = sizeof(data);
+	ble_evt_t ble_evt = {
+		.header.evt_id = BLE_GATTS_EVT_WRITE,
+		.evt.gatts_evt = {
+			.conn_handle = test_case_conn_handle,
+			.params.write = {
+				.handle = 0x101,
+				.len = 2,
+			},
+		},
+	};
+	struct ble_nus_config nus_cfg = {.evt_handler = ble_nus_evt_handler_no_error};
+
+	nus_init(&nus_cfg);
+	tx_stream_connect();
+
+	/* The system attributes are not set yet, the data is kept. */
+	__cmock_sd_ble_gatts_hvx_ExpectAnyArgsAndReturn(BLE_ERROR_GATTS_SYS_ATTR_MISSING);
+
+	nrf_err = ble_nus_write(&ble_nus, data, &length, test_case_conn_handle);
+	TEST_ASSERT_EQUAL(NRF_SUCCESS, nrf_err);
+	TEST_ASSERT_EQUAL(sizeof(data), length);
+
+	/* It is sent when the peer enables notifications. */
+	__cmock_sd_ble_gatts_hvx_Stub(stub_sd_ble_gatts_hvx_peer);
+	__cmock_sd_ble_gatts_value_get_Stub(stub_sd_ble_gatts_value_get);
+	peer.notif_enabled = true;
+	*(uint16_t *)ble_evt.evt.gatts_evt.params.write.data = BLE_GATT_HVX_NOTIFICATION;
+	ble_nus_on_ble_evt(&ble_evt, &ble_nus);
+
+	TEST_ASSERT_EQUAL(1, peer.hvn_count);
+	TEST_ASSERT_EQUAL(sizeof(data), peer.len);
+}
+
 void setUp(void)
 {
 	memset(&ble_nus, 0, sizeof(ble_nus));
+	memset(&peer, 0, sizeof(peer));
 	evt_handler_called = false;
 	test_case_conn_handle++;
+	test_case_att_mtu = 247;
+
+	__cmock_nrf_sdh_ble_idx_get_Stub(stub_nrf_sdh_ble_idx_get);
+	__cmock_ble_conn_params_att_mtu_get_Stub(stub_ble_conn_params_att_mtu_get);
 }
 
 extern int unity_main(void);
@@ -27,8 +27,8 @@ extern "C" {
 /**
  * @brief Dispatch a BLE event to all registered BLE observers.
  *
- * Iterates the nrf_sdh_ble_evt_observers iterable section and invokes
- * each observer's handler in priority order.
+ * Iterates the nrf_sdh_ble_evt_observers iterable section of the event group
+ * of the event and invokes each observer's handler in priority order.
  *
  * @param evt BLE event to dispatch.
  */
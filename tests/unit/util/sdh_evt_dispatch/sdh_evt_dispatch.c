@@ -9,11 +9,24 @@
 #include <bm/softdevice_handler/nrf_sdh_soc.h>
 #include <zephyr/sys/iterable_sections.h>
 
+#define EVT_GROUP_DISPATCH(_group, _evt)                                                          \
+	TYPE_SECTION_FOREACH(struct nrf_sdh_ble_evt_observer,                                      \
+			     nrf_sdh_ble_evt_observers_##_group, obs) {                            \
+		obs->handler(_evt, obs->context);                                                  \
+	}
+
 void sdh_evt_dispatch_ble(const ble_evt_t *evt)
 {
-	TYPE_SECTION_FOREACH(struct nrf_sdh_ble_evt_observer,
-			     nrf_sdh_ble_evt_observers, obs) {
-		obs->handler(evt, obs->context);
+	const uint16_t evt_id = evt->header.evt_id;
+
+	if (IN_RANGE(evt_id, BLE_GAP_EVT_BASE, BLE_GAP_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(GAP, evt);
+	} else if (IN_RANGE(evt_id, BLE_GATTS_EVT_BASE, BLE_GATTS_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(GATTS, evt);
+	} else if (IN_RANGE(evt_id, BLE_GATTC_EVT_BASE, BLE_GATTC_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(GATTC, evt);
+	} else if (IN_RANGE(evt_id, BLE_EVT_BASE, BLE_EVT_LAST)) {
+		EVT_GROUP_DISPATCH(COMMON, evt);
 	}
 }
 